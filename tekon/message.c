@@ -172,6 +172,115 @@ int tekon_resp_1c(struct message * self, uint8_t gateway, const uint32_t *values
     return 1;
 }
 
+static void soa_header(struct message_soa * self, uint8_t gateway, enum tekon_direction dir, enum tekon_message_type type, size_t size)
+{
+    self->gateway = gateway;
+    self->dir = dir;
+    self->type = type;
+    self->nelements = size;
+}
+
+int tekon_soa_req_11(struct message_soa * self, uint8_t gateway, uint8_t device, uint16_t address)
+{
+    assert(self);
+
+    if(gateway == TEKON_INVALID_DEV_ADDR ||
+            device == TEKON_INVALID_DEV_ADDR)
+        return 0;
+
+    soa_header(self, gateway, TEKON_DIR_OUT, TEKON_MSG_READEM_PAR_11, 1);
+    self->devices[0] = device;
+    self->addresses[0] = address;
+    self->indexes[0] = TEKON_INVALID_INDEX;
+    return 1;
+}
+
+int tekon_soa_req_19(struct message_soa * self, uint8_t gateway, uint8_t device, uint16_t address, uint16_t index, size_t size)
+{
+    assert(self);
+    size_t i;
+    if(gateway == TEKON_INVALID_DEV_ADDR || size > TEKON_PROTO_ILIST_SIZE)
+        return 0;
+
+    soa_header(self, gateway, TEKON_DIR_OUT, TEKON_MSG_READEM_IND_LIST_19, size);
+    for(i = 0; i < size; i++) {
+        self->devices[i] = device;
+        self->addresses[i] = address;
+        self->indexes[i] = index + i;
+    }
+    return 1;
+}
+
+int tekon_soa_req_1c(struct message_soa * self, uint8_t gateway, const uint8_t *devices, const uint16_t *addresses, const uint16_t *indexes, size_t size)
+{
+    assert(self);
+    size_t i;
+    if(gateway == TEKON_INVALID_DEV_ADDR || size > TEKON_PROTO_PLIST_SIZE)
+        return 0;
+
+    for(i = 0; i < size; i++) {
+        if(devices[i] == TEKON_INVALID_DEV_ADDR)
+            return 0;
+    }
+
+    soa_header(self, gateway, TEKON_DIR_OUT, TEKON_MSG_READEM_PAR_LIST_1C, size);
+    for(i = 0; i < size; i++) {
+        self->devices[i] = devices[i];
+        self->addresses[i] = addresses[i];
+        self->indexes[i] = indexes ? indexes[i] : TEKON_INVALID_INDEX;
+    }
+    return 1;
+}
+
+int tekon_soa_resp_11(struct message_soa * self, uint8_t gateway, uint32_t value)
+{
+    assert(self);
+
+    if(gateway == TEKON_INVALID_DEV_ADDR)
+        return 0;
+
+    soa_header(self, gateway, TEKON_DIR_IN, TEKON_MSG_READEM_PAR_11, 1);
+    self->values[0] = value;
+    self->quals[0] = 0;
+    return 1;
+}
+
+int tekon_soa_resp_19(struct message_soa * self, uint8_t gateway, const uint32_t *values, size_t size)
+{
+    assert(self);
+    if(gateway == TEKON_INVALID_DEV_ADDR || size > TEKON_PROTO_ILIST_SIZE)
+        return 0;
+
+    soa_header(self, gateway, TEKON_DIR_IN, TEKON_MSG_READEM_IND_LIST_19, size);
+    size_t i;
+    for(i = 0; i < size; i++) {
+        self->values[i] = values[i];
+        self->quals[i] = 0;
+    }
+    return 1;
+}
+
+int tekon_soa_resp_1c(struct message_soa * self, uint8_t gateway, const uint32_t *values, const uint8_t *quals, size_t size)
+{
+    assert(self);
+    if(gateway == TEKON_INVALID_DEV_ADDR || size > TEKON_PROTO_PLIST_SIZE)
+        return 0;
+
+    soa_header(self, gateway, TEKON_DIR_IN, TEKON_MSG_READEM_PAR_LIST_1C, size);
+    size_t i;
+    for(i = 0; i < size; i++) {
+        self->values[i] = values[i];
+        self->quals[i] = quals[i];
+    }
+    return 1;
+}
+
+int tekon_soa_resp_ack(struct message_soa * self, int positive)
+{
+    assert(self);
+    soa_header(self, 0, TEKON_DIR_IN, positive ? TEKON_MSG_POS_ACK : TEKON_MSG_NEG_ACK, 0);
+    return 1;
+}
 
 #ifdef __cplusplus
 }
@@ -10,6 +10,7 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
 #include "tekon/proto.h"
 
@@ -67,6 +68,39 @@ int tekon_resp_1c(struct message * self, uint8_t gateway, const uint32_t *values
 /* Квитанция */
 int tekon_resp_ack(struct message * self, int positive);
 
+/* Компактное представление сообщений 0x11 / 0x19 / 0x1C и квитанций
+ * (структура массивов). Поля параметров хранятся отдельными массивами, без
+ * выравнивания каждого элемента, а конструкторы заполняют только первые
+ * nelements элементов и только нужные для направления поля:
+ * запрос - devices, addresses, indexes; ответ - values, quals.
+ * Остальное содержимое массивов не определено. Сообщения 0x14
+ * представляются только struct message */
+struct message_soa {
+
+    enum tekon_message_type type;
+    enum tekon_direction dir;
+    uint8_t gateway;
+    uint8_t nelements;
+
+    uint8_t devices[TEKON_PROTO_ILIST_SIZE];
+    uint8_t quals[TEKON_PROTO_ILIST_SIZE];
+    uint16_t addresses[TEKON_PROTO_ILIST_SIZE];
+    uint16_t indexes[TEKON_PROTO_ILIST_SIZE];
+    uint32_t values[TEKON_PROTO_ILIST_SIZE];
+};
+
+/* Конструкторы компактных сообщений. Аргументы и ограничения те же, что у
+ * tekon_req_* / tekon_resp_*
+ * 1 - успешно
+ * 0 - ошибка */
+int tekon_soa_req_11(struct message_soa * self, uint8_t gateway, uint8_t device, uint16_t address);
+int tekon_soa_req_19(struct message_soa * self, uint8_t gateway, uint8_t device, uint16_t address, uint16_t index, size_t size);
+int tekon_soa_req_1c(struct message_soa * self, uint8_t gateway, const uint8_t *devices, const uint16_t *addresses, const uint16_t *indexes, size_t size);
+int tekon_soa_resp_11(struct message_soa * self, uint8_t gateway, uint32_t value);
+int tekon_soa_resp_19(struct message_soa * self, uint8_t gateway, const uint32_t *values, size_t size);
+int tekon_soa_resp_1c(struct message_soa * self, uint8_t gateway, const uint32_t *values, const uint8_t *quals, size_t size);
+int tekon_soa_resp_ack(struct message_soa * self, int positive);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,6 +8,7 @@ extern "C" {
 #endif
 
 #include "tekon/pack.h"
+#include "tekon/trace.h"
 #include <assert.h>
 #include <string.h>
 
@@ -23,6 +24,7 @@ static void buffer_writer_init(struct buffer_writer * self, void * buffer, size_
  * 0 - ошибка */
 static int buffer_writer_u8(struct buffer_writer * self, uint8_t u8);
 static int buffer_writer_u16(struct buffer_writer * self, uint16_t u16);
+static int buffer_writer_u32(struct buffer_writer * self, uint32_t u32);
 
 static ssize_t pack_readem_11(void * buffer, size_t size, const struct message * message, uint8_t number);
 static ssize_t pack_readem_14(void * buffer, size_t size, const struct message * message, uint8_t number);
@@ -30,7 +32,7 @@ static ssize_t pack_readem_19(void * buffer, size_t size, const struct message *
 static ssize_t pack_readem_list_1C(void * buffer, size_t size, const struct message * message, uint8_t number);
 
 
-ssize_t tekon_req_pack(void * buffer, size_t size, const struct message * message, uint8_t number)
+static ssize_t req_pack(void * buffer, size_t size, const struct message * message, uint8_t number)
 {
     assert(message);
     assert(buffer);
@@ -59,6 +61,128 @@ ssize_t tekon_req_pack(void * buffer, size_t size, const struct message * messag
     return 0;
 }
 
+ssize_t tekon_req_pack(void * buffer, size_t size, const struct message * message, uint8_t number)
+{
+    TEKON_TRACE_BEGIN(TEKON_TRACE_REQ_PACK);
+    const ssize_t result = req_pack(buffer, size, message, number);
+    TEKON_TRACE_END(TEKON_TRACE_REQ_PACK, result);
+    return result;
+}
+
+size_t tekon_req_pack_batch(void * buffer, size_t size, const struct message * const * messages,
+                            const uint8_t * numbers, size_t count, size_t * offsets)
+{
+    assert(buffer);
+    assert(messages);
+    assert(numbers);
+    assert(offsets);
+
+    TEKON_TRACE_BEGIN(TEKON_TRACE_REQ_PACK);
+    char * ptr = buffer;
+    size_t offset = 0;
+    size_t i;
+
+    offsets[0] = 0;
+    for(i = 0; i < count && offset < size; i++) {
+        const ssize_t len = req_pack(ptr + offset, size - offset, messages[i], numbers[i]);
+        if(len <= 0)
+            break;
+        offset += (size_t)len;
+        offsets[i + 1] = offset;
+    }
+    TEKON_TRACE_END(TEKON_TRACE_REQ_PACK, offset);
+    return i;
+}
+
+static ssize_t resp_pack(void * buffer, size_t size, const struct message * message, uint8_t number)
+{
+    assert(message);
+    assert(buffer);
+    assert(size);
+
+    const uint8_t max_number = 15;
+    const struct tekon_parameter * param = message->payload.parameters;
+    uint8_t * ptr = buffer;
+    size_t len = 0;
+    size_t i;
+
+    if(number > max_number)
+        return 0;
+
+    /* Длина данных ответа */
+    switch(message->type) {
+    case TEKON_MSG_POS_ACK:
+    case TEKON_MSG_NEG_ACK:
+        ptr[0] = message->type == TEKON_MSG_POS_ACK ? TEKON_PROTO_POS_ACK : TEKON_PROTO_NEG_ACK;
+        return 1;
+    case TEKON_MSG_READEM_PAR_11:
+        len = 4;
+        break;
+    case TEKON_MSG_WRITEM_PAR_14:
+        len = 1;
+        break;
+    case TEKON_MSG_READEM_IND_LIST_19:
+        if(message->nelements > TEKON_PROTO_ILIST_SIZE)
+            return 0;
+        len = message->nelements * 4;
+        break;
+    case TEKON_MSG_READEM_PAR_LIST_1C:
+        if(message->nelements > TEKON_PROTO_PLIST_SIZE)
+            return 0;
+        len = message->nelements * 5;
+        break;
+    case TEKON_MSG_UNK:
+        return 0;
+    }
+
+    const size_t frame_size = len + 8;
+    if(size < frame_size)
+        return 0;
+
+    struct buffer_writer writer;
+    buffer_writer_init(&writer, buffer, size);
+    buffer_writer_u8(&writer, TEKON_PROTO_VAR_PREFIX);
+    buffer_writer_u8(&writer, len + 2);
+    buffer_writer_u8(&writer, len + 2);
+    buffer_writer_u8(&writer, TEKON_PROTO_VAR_PREFIX);
+    buffer_writer_u8(&writer, 0x40 | number);
+    buffer_writer_u8(&writer, message->gateway);
+
+    switch(message->type) {
+    case TEKON_MSG_READEM_PAR_11:
+        buffer_writer_u32(&writer, param->value);
+        break;
+    case TEKON_MSG_WRITEM_PAR_14:
+        buffer_writer_u8(&writer, message->payload.bytes[0]);
+        break;
+    case TEKON_MSG_READEM_IND_LIST_19:
+        for(i = 0; i < message->nelements; i++)
+            buffer_writer_u32(&writer, param[i].value);
+        break;
+    case TEKON_MSG_READEM_PAR_LIST_1C:
+        for(i = 0; i < message->nelements; i++) {
+            buffer_writer_u32(&writer, param[i].value);
+            buffer_writer_u8(&writer, param[i].qual);
+        }
+        break;
+    default:
+        break;
+    }
+
+    const uint8_t crc = tekon_variable_crc(buffer, frame_size);
+    buffer_writer_u8(&writer, crc);
+    buffer_writer_u8(&writer, TEKON_PROTO_END);
+    return frame_size;
+}
+
+ssize_t tekon_resp_pack(void * buffer, size_t size, const struct message * message, uint8_t number)
+{
+    TEKON_TRACE_BEGIN(TEKON_TRACE_RESP_PACK);
+    const ssize_t result = resp_pack(buffer, size, message, number);
+    TEKON_TRACE_END(TEKON_TRACE_RESP_PACK, result);
+    return result;
+}
+
 static ssize_t pack_readem_11(void * buffer, size_t size, const struct message * message, uint8_t number)
 {
     /* Лимиты для этого типа сообщений */
@@ -234,6 +358,163 @@ static ssize_t pack_readem_list_1C(void * buffer, size_t size, const struct mess
 
 }
 
+static ssize_t soa_req_pack(void * buffer, size_t size, const struct message_soa * message, uint8_t number)
+{
+    assert(message);
+    assert(buffer);
+    assert(size);
+
+    const uint8_t max_number = 15;
+    const uint8_t nelem = message->nelements;
+    struct buffer_writer writer;
+    size_t frame_size;
+    size_t i;
+
+    if(number > max_number)
+        return 0;
+
+    buffer_writer_init(&writer, buffer, size);
+
+    switch(message->type) {
+    case TEKON_MSG_READEM_PAR_11:
+        frame_size = 9;
+        if(size < frame_size || nelem != 1)
+            return 0;
+        buffer_writer_u8(&writer, TEKON_PROTO_FIX_PREFIX);
+        buffer_writer_u8(&writer, 0x40 | number);
+        buffer_writer_u8(&writer, message->gateway);
+        buffer_writer_u8(&writer, 0x11);
+        buffer_writer_u8(&writer, message->devices[0]);
+        buffer_writer_u16(&writer, message->addresses[0]);
+        buffer_writer_u8(&writer, tekon_fixed_crc(buffer, frame_size));
+        buffer_writer_u8(&writer, TEKON_PROTO_END);
+        return frame_size;
+    case TEKON_MSG_READEM_IND_LIST_19:
+        frame_size = 15;
+        if(size < frame_size || nelem == 0 || nelem > TEKON_PROTO_ILIST_SIZE)
+            return 0;
+        buffer_writer_u8(&writer, TEKON_PROTO_VAR_PREFIX);
+        buffer_writer_u8(&writer, 9);
+        buffer_writer_u8(&writer, 9);
+        buffer_writer_u8(&writer, TEKON_PROTO_VAR_PREFIX);
+        buffer_writer_u8(&writer, 0x40 | number);
+        buffer_writer_u8(&writer, message->gateway);
+        buffer_writer_u8(&writer, 0x19);
+        buffer_writer_u8(&writer, message->devices[0]);
+        buffer_writer_u16(&writer, message->addresses[0]);
+        buffer_writer_u16(&writer, message->indexes[0]);
+        buffer_writer_u8(&writer, nelem);
+        break;
+    case TEKON_MSG_READEM_PAR_LIST_1C:
+        frame_size = nelem * 6 + 9;
+        if(size < frame_size || nelem > TEKON_PROTO_PLIST_SIZE)
+            return 0;
+        buffer_writer_u8(&writer, TEKON_PROTO_VAR_PREFIX);
+        buffer_writer_u8(&writer, nelem * 6 + 3);
+        buffer_writer_u8(&writer, nelem * 6 + 3);
+        buffer_writer_u8(&writer, TEKON_PROTO_VAR_PREFIX);
+        buffer_writer_u8(&writer, 0x40 | number);
+        buffer_writer_u8(&writer, message->gateway);
+        buffer_writer_u8(&writer, 0x1C);
+        for(i = 0; i < nelem; i++) {
+            const uint16_t index = message->indexes[i];
+            buffer_writer_u8(&writer, message->devices[i]);
+            buffer_writer_u16(&writer, message->addresses[i]);
+            buffer_writer_u16(&writer, index == TEKON_INVALID_INDEX ? 0 : index);
+            buffer_writer_u8(&writer, index == TEKON_INVALID_INDEX ? 0 : 1);
+        }
+        break;
+    default:
+        return 0;
+    }
+
+    buffer_writer_u8(&writer, tekon_variable_crc(buffer, frame_size));
+    buffer_writer_u8(&writer, TEKON_PROTO_END);
+    return frame_size;
+}
+
+ssize_t tekon_soa_req_pack(void * buffer, size_t size, const struct message_soa * message, uint8_t number)
+{
+    TEKON_TRACE_BEGIN(TEKON_TRACE_REQ_PACK);
+    const ssize_t result = soa_req_pack(buffer, size, message, number);
+    TEKON_TRACE_END(TEKON_TRACE_REQ_PACK, result);
+    return result;
+}
+
+static ssize_t soa_resp_pack(void * buffer, size_t size, const struct message_soa * message, uint8_t number)
+{
+    assert(message);
+    assert(buffer);
+    assert(size);
+
+    const uint8_t max_number = 15;
+    const uint8_t nelem = message->nelements;
+    uint8_t * ptr = buffer;
+    size_t len;
+    size_t i;
+
+    if(number > max_number)
+        return 0;
+
+    switch(message->type) {
+    case TEKON_MSG_POS_ACK:
+    case TEKON_MSG_NEG_ACK:
+        ptr[0] = message->type == TEKON_MSG_POS_ACK ? TEKON_PROTO_POS_ACK : TEKON_PROTO_NEG_ACK;
+        return 1;
+    case TEKON_MSG_READEM_PAR_11:
+        len = 4;
+        break;
+    case TEKON_MSG_READEM_IND_LIST_19:
+        if(nelem > TEKON_PROTO_ILIST_SIZE)
+            return 0;
+        len = nelem * 4;
+        break;
+    case TEKON_MSG_READEM_PAR_LIST_1C:
+        if(nelem > TEKON_PROTO_PLIST_SIZE)
+            return 0;
+        len = nelem * 5;
+        break;
+    default:
+        return 0;
+    }
+
+    const size_t frame_size = len + 8;
+    if(size < frame_size)
+        return 0;
+
+    struct buffer_writer writer;
+    buffer_writer_init(&writer, buffer, size);
+    buffer_writer_u8(&writer, TEKON_PROTO_VAR_PREFIX);
+    buffer_writer_u8(&writer, len + 2);
+    buffer_writer_u8(&writer, len + 2);
+    buffer_writer_u8(&writer, TEKON_PROTO_VAR_PREFIX);
+    buffer_writer_u8(&writer, 0x40 | number);
+    buffer_writer_u8(&writer, message->gateway);
+
+    if(message->type == TEKON_MSG_READEM_PAR_LIST_1C) {
+        for(i = 0; i < nelem; i++) {
+            buffer_writer_u32(&writer, message->values[i]);
+            buffer_writer_u8(&writer, message->quals[i]);
+        }
+    } else {
+        /* 0x11 - одно значение, 0x19 - значения подряд без качества */
+        for(i = 0; i < len / 4; i++)
+            buffer_writer_u32(&writer, message->values[i]);
+    }
+
+    buffer_writer_u8(&writer, tekon_variable_crc(buffer, frame_size));
+    buffer_writer_u8(&writer, TEKON_PROTO_END);
+    return frame_size;
+}
+
+ssize_t tekon_soa_resp_pack(void * buffer, size_t size, const struct message_soa * message, uint8_t number)
+{
+    TEKON_TRACE_BEGIN(TEKON_TRACE_RESP_PACK);
+    const ssize_t result = soa_resp_pack(buffer, size, message, number);
+    TEKON_TRACE_END(TEKON_TRACE_RESP_PACK, result);
+    return result;
+}
+
 /* Копирование в буфер везде сделано через memcpy.
  * во-первых это устраняет проблемы с невыровненным доступом к памяти (ARMv5 например)
  * во-вторых большинство компиляторов могут правильно понять и оптимизировать
@@ -278,7 +559,7 @@ static int buffer_writer_u16(struct buffer_writer * self, uint16_t u16)
 }
 
 
-/*static int buffer_writer_u32(struct buffer_writer * self, uint32_t u32)
+static int buffer_writer_u32(struct buffer_writer * self, uint32_t u32)
 {
     assert(self);
     const size_t size = sizeof(u32);
@@ -290,7 +571,7 @@ static int buffer_writer_u16(struct buffer_writer * self, uint16_t u16)
     self->pos+=size;
     self->avail-=size;
     return 1;
-}*/
+}
 
 
 #ifdef __cplusplus
@@ -20,6 +20,28 @@ extern "C" {
  * 0 - ошибка */
 ssize_t tekon_req_pack(void * buffer, size_t size, const struct message * message, uint8_t number);
 
+/* Записать count запросов подряд в один непрерывный буфер. Запрос messages[i]
+ * получает номер посылки numbers[i] и занимает байты с offsets[i] по
+ * offsets[i + 1] (в offsets должно быть count + 1 элементов). Пакет из n
+ * записанных запросов - это первые offsets[n] байт буфера, а каждую посылку
+ * можно передать в writev / sendmmsg без копирования.
+ * Упаковка прекращается на первом запросе, который не удалось записать
+ * (ошибка в запросе или нет места).
+ * Возвращает кол-во записанных запросов */
+size_t tekon_req_pack_batch(void * buffer, size_t size, const struct message * const * messages,
+                            const uint8_t * numbers, size_t count, size_t * offsets);
+
+/* Записать ответ в буфер (сторона шлюза). Используется эмулятором шлюза.
+ * В случае успеха возврщает кол-во записанных байт
+ * 0 - ошибка */
+ssize_t tekon_resp_pack(void * buffer, size_t size, const struct message * message, uint8_t number);
+
+/* То же для компактного представления struct message_soa
+ * В случае успеха возврщает кол-во записанных байт
+ * 0 - ошибка */
+ssize_t tekon_soa_req_pack(void * buffer, size_t size, const struct message_soa * message, uint8_t number);
+ssize_t tekon_soa_resp_pack(void * buffer, size_t size, const struct message_soa * message, uint8_t number);
+
 #ifdef __cplusplus
 }
 #endif
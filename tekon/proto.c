@@ -7,9 +7,23 @@
 extern "C" {
 #endif
 #include <assert.h>
+#include <string.h>
 #include "tekon/proto.h"
 
-uint8_t tekon_crc(const void * buffer, size_t size)
+#if !defined(TEKON_NO_SIMD) && defined(__SSE2__)
+#define TEKON_CRC_SSE2
+#include <emmintrin.h>
+#elif !defined(TEKON_NO_SIMD) && defined(__ARM_NEON)
+#define TEKON_CRC_NEON
+#include <arm_neon.h>
+#endif
+
+/* КС - сумма байт по модулю 256. Порядок сложения не важен, поэтому байты
+ * можно складывать блоками: SSE2 и NEON дают горизонтальную сумму 16 байт за
+ * шаг, на остальных платформах байты складываются по 8 за шаг в 16-битных
+ * полях 64-битного слова */
+
+uint8_t tekon_crc_bytes(const void * buffer, size_t size)
 {
     assert(buffer);
     assert(size);
@@ -23,6 +37,113 @@ uint8_t tekon_crc(const void * buffer, size_t size)
     return crc;
 }
 
+/* Сумма байт по 8 за шаг. Сумма двух байт не больше 510, поэтому 16-битное
+ * поле не переполняется за 128 шагов, после чего поля сворачиваются */
+static uint32_t sum_words(const uint8_t ** pptr, size_t * psize)
+{
+    const uint64_t mask = 0x00FF00FF00FF00FFull;
+    const uint8_t * ptr = *pptr;
+    size_t size = *psize;
+    uint32_t sum = 0;
+
+    while(size >= 8) {
+        uint64_t lanes = 0;
+        size_t n = size / 8 > 128 ? 128 : size / 8;
+        size -= n * 8;
+        while(n--) {
+            uint64_t word;
+            memcpy(&word, ptr, sizeof(word));
+            lanes += (word & mask) + ((word >> 8) & mask);
+            ptr += sizeof(word);
+        }
+        sum += (uint32_t)((lanes & 0xFFFF) + ((lanes >> 16) & 0xFFFF) +
+                          ((lanes >> 32) & 0xFFFF) + (lanes >> 48));
+    }
+
+    *pptr = ptr;
+    *psize = size;
+    return sum;
+}
+
+static uint32_t sum_bytes(const uint8_t * ptr, size_t size)
+{
+    uint32_t sum = 0;
+    while(size--)
+        sum += *ptr++;
+    return sum;
+}
+
+uint8_t tekon_crc_words(const void * buffer, size_t size)
+{
+    assert(buffer);
+    assert(size);
+
+    const uint8_t * ptr = buffer;
+    uint32_t sum = sum_words(&ptr, &size);
+    return (uint8_t)(sum + sum_bytes(ptr, size));
+}
+
+#if defined(TEKON_CRC_SSE2)
+
+uint8_t tekon_crc(const void * buffer, size_t size)
+{
+    assert(buffer);
+    assert(size);
+
+    const uint8_t * ptr = buffer;
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+
+    /* psadbw: две суммы по 8 байт в 64-битных половинах */
+    for(; size >= 16; ptr += 16, size -= 16)
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i *)ptr), zero));
+
+    uint32_t sum = (uint32_t)_mm_cvtsi128_si32(acc) +
+                   (uint32_t)_mm_cvtsi128_si32(_mm_unpackhi_epi64(acc, acc));
+    sum += sum_words(&ptr, &size);
+    return (uint8_t)(sum + sum_bytes(ptr, size));
+}
+
+#elif defined(TEKON_CRC_NEON)
+
+uint8_t tekon_crc(const void * buffer, size_t size)
+{
+    assert(buffer);
+    assert(size);
+
+    const uint8_t * ptr = buffer;
+    uint32x4_t acc = vdupq_n_u32(0);
+
+    /* Попарное сложение 8 -> 16 -> 32 бита */
+    for(; size >= 16; ptr += 16, size -= 16)
+        acc = vpadalq_u16(acc, vpaddlq_u8(vld1q_u8(ptr)));
+
+    uint32_t sum = vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) +
+                   vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+    sum += sum_words(&ptr, &size);
+    return (uint8_t)(sum + sum_bytes(ptr, size));
+}
+
+#else
+
+uint8_t tekon_crc(const void * buffer, size_t size)
+{
+    return tekon_crc_words(buffer, size);
+}
+
+#endif
+
+const char * tekon_crc_impl()
+{
+#if defined(TEKON_CRC_SSE2)
+    return "sse2";
+#elif defined(TEKON_CRC_NEON)
+    return "neon";
+#else
+    return "words";
+#endif
+}
+
 uint8_t tekon_fixed_crc(const void * buffer, size_t size)
 {
     assert(size >= 8);
@@ -60,7 +60,17 @@ struct tekon_parameter {
     uint8_t qual; /* значения байт качества (0 - ОК) */
 };
 
+/* Сумма байт по модулю 256. Использует SSE2 / NEON, если они доступны
+ * при сборке (и не задан TEKON_NO_SIMD), иначе складывает по 8 байт за шаг */
 uint8_t tekon_crc(const void * buffer, size_t size);
+
+/* Реализации без SIMD: побайтная (эталон) и по 8 байт за шаг.
+ * Нужны для тестов и замеров */
+uint8_t tekon_crc_bytes(const void * buffer, size_t size);
+uint8_t tekon_crc_words(const void * buffer, size_t size);
+
+/* Используемая tekon_crc реализация: "sse2", "neon" или "words" */
+const char * tekon_crc_impl();
 uint8_t tekon_fixed_crc(const void * buffer, size_t size);
 uint8_t tekon_variable_crc(const void * buffer, size_t size);
 
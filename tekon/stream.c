@@ -0,0 +1,161 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tekon/stream.h"
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include "tekon/proto.h"
+
+#define FIXED_SIZE 9
+
+/* Длина посылки в начале буфера.
+ * >0 - длина полной посылки
+ * 0 - посылка не полная
+ * <0 - в начале буфера не посылка */
+static ssize_t frame_length(const uint8_t * ptr, size_t len)
+{
+    size_t size;
+
+    if(!len)
+        return 0;
+
+    switch(ptr[0]) {
+    case TEKON_PROTO_POS_ACK:
+    case TEKON_PROTO_NEG_ACK:
+        return 1;
+
+    case TEKON_PROTO_FIX_PREFIX:
+        if(len < FIXED_SIZE)
+            return 0;
+        return ptr[FIXED_SIZE - 1] == TEKON_PROTO_END ? FIXED_SIZE : -1;
+
+    case TEKON_PROTO_VAR_PREFIX:
+        if(len < 4)
+            return 0;
+        if(ptr[1] != ptr[2] || ptr[3] != TEKON_PROTO_VAR_PREFIX)
+            return -1;
+        size = (size_t)ptr[1] + 6;
+        if(len < size)
+            return 0;
+        return ptr[size - 1] == TEKON_PROTO_END ? (ssize_t)size : -1;
+    }
+    return -1;
+}
+
+/* Найти полную посылку, отбросив мусор перед ней */
+static ssize_t frame_next(struct tekon_stream * self)
+{
+    for(;;) {
+        ssize_t size = frame_length(self->buffer + self->head, self->tail - self->head);
+        if(size >= 0)
+            return size;
+        self->head++;
+        self->skipped++;
+    }
+}
+
+void tekon_stream_init(struct tekon_stream * self)
+{
+    assert(self);
+    self->head = 0;
+    self->tail = 0;
+    self->skipped = 0;
+}
+
+void * tekon_stream_reserve(struct tekon_stream * self, size_t * size)
+{
+    assert(self);
+    assert(size);
+
+    /* Сдвинуть необработанные данные в начало буфера */
+    if(self->head) {
+        memmove(self->buffer, self->buffer + self->head, self->tail - self->head);
+        self->tail -= self->head;
+        self->head = 0;
+    }
+
+    if(self->tail == sizeof(self->buffer)) {
+        self->skipped += self->tail;
+        self->tail = 0;
+    }
+
+    *size = sizeof(self->buffer) - self->tail;
+    return self->buffer + self->tail;
+}
+
+void tekon_stream_commit(struct tekon_stream * self, size_t len)
+{
+    assert(self);
+    assert(self->tail + len <= sizeof(self->buffer));
+    self->tail += len;
+}
+
+size_t tekon_stream_push(struct tekon_stream * self, const void * data, size_t len)
+{
+    assert(self);
+    assert(data || !len);
+
+    const uint8_t * ptr = data;
+    size_t done = 0;
+
+    while(done < len) {
+        size_t size = 0;
+        void * tail = tekon_stream_reserve(self, &size);
+        if(size > len - done)
+            size = len - done;
+        memcpy(tail, ptr + done, size);
+        tekon_stream_commit(self, size);
+        done += size;
+    }
+    return done;
+}
+
+ssize_t tekon_stream_pop(struct tekon_stream * self, void * frame, size_t size)
+{
+    assert(self);
+    assert(frame);
+
+    ssize_t len = frame_next(self);
+
+    if(len == 0) {
+        /* Буфер пуст - запись снова пойдет с начала без сдвига */
+        if(self->head == self->tail)
+            self->head = self->tail = 0;
+        return 0;
+    }
+
+    const uint8_t * ptr = self->buffer + self->head;
+    self->head += len;
+
+    if((size_t)len > size)
+        return -EMSGSIZE;
+
+    memcpy(frame, ptr, len);
+    return len;
+}
+
+int tekon_stream_ready(const struct tekon_stream * self)
+{
+    assert(self);
+
+    /* Мусор перед посылкой будет отброшен при извлечении */
+    size_t head = self->head;
+    while(head < self->tail) {
+        ssize_t size = frame_length(self->buffer + head, self->tail - head);
+        if(size >= 0)
+            return size > 0;
+        head++;
+    }
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,64 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef TEKON_STREAM_H
+#define TEKON_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* Размер буфера сборки. Вмещает несколько посылок максимальной длины
+ * (TEKON_PROTO_MAX_ADU_SIZE + 6) */
+#define TEKON_STREAM_SIZE 1024
+
+/* Сборка посылок из потока байт (TCP).
+ * Поток может разрезать посылку на несколько частей или склеить несколько
+ * посылок в одну. Границы посылок определяются по заголовкам:
+ * - 0xA2/0xE5 - квитанция, 1 байт
+ * - 0x10 ... 0x16 - посылка фиксированной длины, 9 байт
+ * - 0x68 len len 0x68 ... 0x16 - посылка переменной длины, len + 6 байт
+ * Байты, не являющиеся началом посылки, отбрасываются до восстановления
+ * синхронизации. Контрольная сумма не проверяется - это делает разбор
+ * посылки */
+struct tekon_stream {
+    uint8_t buffer[TEKON_STREAM_SIZE];
+    size_t head;      /* начало необработанных данных */
+    size_t tail;      /* конец данных */
+    uint64_t skipped; /* отброшенные байты */
+};
+
+void tekon_stream_init(struct tekon_stream * self);
+
+/* Получить место для записи данных из потока (например, для recv).
+ * Если буфер заполнен, не разобранные данные отбрасываются.
+ * Размер свободного места записывается в size, он всегда больше 0 */
+void * tekon_stream_reserve(struct tekon_stream * self, size_t * size);
+
+/* Учесть len байт, записанных в место, полученное tekon_stream_reserve */
+void tekon_stream_commit(struct tekon_stream * self, size_t len);
+
+/* Добавить данные.
+ * Возвращает кол-во добавленных байт */
+size_t tekon_stream_push(struct tekon_stream * self, const void * data, size_t len);
+
+/* Извлечь очередную посылку в буфер frame.
+ * >0 - размер посылки
+ * 0 - полной посылки еще нет
+ * <0 - код ошибки (-EMSGSIZE - посылка не поместилась в буфер и отброшена) */
+ssize_t tekon_stream_pop(struct tekon_stream * self, void * frame, size_t size);
+
+/* 1 - в буфере есть полная посылка */
+int tekon_stream_ready(const struct tekon_stream * self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -14,6 +14,8 @@ extern "C" {
 #include "tekon/message.h"
 #include "tekon/pack.h"
 #include "tekon/proto.h"
+#include "tekon/stream.h"
+#include "tekon/trace.h"
 #include "tekon/unpack.h"
 
 #ifdef __cplusplus
@@ -9,6 +9,7 @@ extern "C" {
 
 #include "test/minunit.h"
 #include "tekon/pack.h"
+#include "tekon/unpack.h"
 
 MU_TEST(test_pack_nums)
 {
@@ -208,6 +209,224 @@ MU_TEST(test_pack_readem_list_1c)
     }
 }
 
+MU_TEST(test_pack_resp_1c)
+{
+    uint8_t buffer[256];
+    const uint32_t values[3] = {1, 0x3F800000, 0xFFFFFFFF};
+    const uint8_t quals[3] = {0, 1, 0};
+    struct message message;
+    struct message check;
+    uint8_t num = 0;
+    size_t i;
+
+    tekon_resp_1c(&message, 2, values, quals, 3);
+    int result = tekon_resp_pack(buffer, sizeof(buffer), &message, 5);
+    mu_assert_int_eq(3 * 5 + 8, result);
+
+    mu_assert_int_eq(result, tekon_resp_unpack(buffer, result, &check, TEKON_MSG_READEM_PAR_LIST_1C, &num));
+    mu_assert_int_eq(5, num);
+    mu_assert_int_eq(2, check.gateway);
+    mu_assert_int_eq(3, check.nelements);
+    for(i = 0; i < 3; i++) {
+        mu_assert_int_eq(values[i], check.payload.parameters[i].value);
+        mu_assert_int_eq(quals[i], check.payload.parameters[i].qual);
+    }
+
+    /* Буфер мал */
+    mu_assert_int_eq(0, tekon_resp_pack(buffer, 10, &message, 5));
+}
+
+MU_TEST(test_pack_resp_19)
+{
+    uint8_t buffer[256];
+    uint32_t values[TEKON_PROTO_ILIST_SIZE];
+    struct message message;
+    struct message check;
+    size_t i;
+
+    for(i = 0; i < TEKON_PROTO_ILIST_SIZE; i++)
+        values[i] = i * 3;
+
+    tekon_resp_19(&message, 9, values, TEKON_PROTO_ILIST_SIZE);
+    int result = tekon_resp_pack(buffer, sizeof(buffer), &message, 1);
+    mu_assert_int_eq(TEKON_PROTO_ILIST_SIZE * 4 + 8, result);
+
+    mu_assert_int_eq(result, tekon_resp_unpack(buffer, result, &check, TEKON_MSG_READEM_IND_LIST_19, NULL));
+    mu_assert_int_eq(TEKON_PROTO_ILIST_SIZE, check.nelements);
+    for(i = 0; i < TEKON_PROTO_ILIST_SIZE; i++)
+        mu_assert_int_eq(values[i], check.payload.parameters[i].value);
+}
+
+MU_TEST(test_pack_resp_11_14_ack)
+{
+    uint8_t buffer[256];
+    struct message message;
+    struct message check;
+
+    tekon_resp_11(&message, 2, 0x12345678);
+    int result = tekon_resp_pack(buffer, sizeof(buffer), &message, 0);
+    mu_assert_int_eq(12, result);
+    mu_assert_int_eq(12, tekon_resp_unpack(buffer, result, &check, TEKON_MSG_READEM_PAR_11, NULL));
+    mu_assert_int_eq(0x12345678, check.payload.parameters[0].value);
+
+    /* Ответ на установку уровня доступа */
+    memset(&message, 0, sizeof(message));
+    message.type = TEKON_MSG_WRITEM_PAR_14;
+    message.gateway = 2;
+    message.nelements = 1;
+    message.payload.bytes[0] = TEKON_PRIV_ADMIN;
+    result = tekon_resp_pack(buffer, sizeof(buffer), &message, 0);
+    mu_assert_int_eq(9, result);
+    mu_assert_int_eq(9, tekon_resp_unpack(buffer, result, &check, TEKON_MSG_WRITEM_PAR_14, NULL));
+    mu_assert_int_eq(TEKON_PRIV_ADMIN, check.payload.bytes[0]);
+
+    tekon_resp_ack(&message, 0);
+    mu_assert_int_eq(1, tekon_resp_pack(buffer, sizeof(buffer), &message, 0));
+    mu_assert_int_eq(TEKON_PROTO_NEG_ACK, buffer[0]);
+}
+
+/* Компактное представление упаковывается в те же байты, что и struct message */
+MU_TEST(test_pack_soa_req)
+{
+    uint8_t devices[TEKON_PROTO_PLIST_SIZE];
+    uint16_t addresses[TEKON_PROTO_PLIST_SIZE];
+    uint16_t indexes[TEKON_PROTO_PLIST_SIZE];
+    uint8_t expected[512];
+    uint8_t buffer[512];
+    struct message message;
+    struct message_soa soa;
+    ssize_t len;
+    size_t i;
+
+    for(i = 0; i < TEKON_PROTO_PLIST_SIZE; i++) {
+        devices[i] = 3 + i % 2;
+        addresses[i] = 0x8000 + i;
+        indexes[i] = i % 3 ? i : TEKON_INVALID_INDEX;
+    }
+
+    mu_check(tekon_req_11(&message, 2, 3, 0x8003));
+    mu_check(tekon_soa_req_11(&soa, 2, 3, 0x8003));
+    len = tekon_req_pack(expected, sizeof(expected), &message, 1);
+    mu_assert_int_eq(len, tekon_soa_req_pack(buffer, sizeof(buffer), &soa, 1));
+    mu_check(memcmp(expected, buffer, len) == 0);
+
+    mu_check(tekon_req_19(&message, 2, 3, 0xF017, 10, 24));
+    mu_check(tekon_soa_req_19(&soa, 2, 3, 0xF017, 10, 24));
+    mu_assert_int_eq(33, soa.indexes[23]);
+    len = tekon_req_pack(expected, sizeof(expected), &message, 2);
+    mu_assert_int_eq(len, tekon_soa_req_pack(buffer, sizeof(buffer), &soa, 2));
+    mu_check(memcmp(expected, buffer, len) == 0);
+
+    mu_check(tekon_req_1c(&message, 2, devices, addresses, indexes, TEKON_PROTO_PLIST_SIZE));
+    mu_check(tekon_soa_req_1c(&soa, 2, devices, addresses, indexes, TEKON_PROTO_PLIST_SIZE));
+    len = tekon_req_pack(expected, sizeof(expected), &message, 3);
+    mu_assert_int_eq(len, tekon_soa_req_pack(buffer, sizeof(buffer), &soa, 3));
+    mu_check(memcmp(expected, buffer, len) == 0);
+
+    /* Без индексов */
+    mu_check(tekon_req_1c(&message, 2, devices, addresses, NULL, 5));
+    mu_check(tekon_soa_req_1c(&soa, 2, devices, addresses, NULL, 5));
+    mu_assert_int_eq(TEKON_INVALID_INDEX, soa.indexes[4]);
+    len = tekon_req_pack(expected, sizeof(expected), &message, 4);
+    mu_assert_int_eq(len, tekon_soa_req_pack(buffer, sizeof(buffer), &soa, 4));
+    mu_check(memcmp(expected, buffer, len) == 0);
+
+    /* Ошибки: длинный список, неверный адрес, номер, малый буфер */
+    mu_assert_int_eq(0, tekon_soa_req_1c(&soa, 2, devices, addresses, indexes, TEKON_PROTO_PLIST_SIZE + 1));
+    devices[1] = TEKON_INVALID_DEV_ADDR;
+    mu_assert_int_eq(0, tekon_soa_req_1c(&soa, 2, devices, addresses, indexes, 2));
+    mu_assert_int_eq(0, tekon_soa_req_19(&soa, 2, 3, 0xF017, 0, TEKON_PROTO_ILIST_SIZE + 1));
+    mu_check(tekon_soa_req_1c(&soa, 2, devices, addresses, indexes, 1));
+    mu_assert_int_eq(0, tekon_soa_req_pack(buffer, sizeof(buffer), &soa, 16));
+    mu_assert_int_eq(0, tekon_soa_req_pack(buffer, 14, &soa, 1));
+    mu_check(tekon_soa_resp_ack(&soa, 1));
+    mu_assert_int_eq(0, tekon_soa_req_pack(buffer, sizeof(buffer), &soa, 1));
+}
+
+MU_TEST(test_pack_soa_resp)
+{
+    uint32_t values[TEKON_PROTO_ILIST_SIZE];
+    uint8_t quals[TEKON_PROTO_ILIST_SIZE];
+    uint8_t expected[512];
+    uint8_t buffer[512];
+    struct message message;
+    struct message_soa soa;
+    ssize_t len;
+    size_t i;
+
+    for(i = 0; i < TEKON_PROTO_ILIST_SIZE; i++) {
+        values[i] = 0x01020304 * (i + 1);
+        quals[i] = i % 4;
+    }
+
+    mu_check(tekon_resp_11(&message, 2, 0x12345678));
+    mu_check(tekon_soa_resp_11(&soa, 2, 0x12345678));
+    len = tekon_resp_pack(expected, sizeof(expected), &message, 5);
+    mu_assert_int_eq(len, tekon_soa_resp_pack(buffer, sizeof(buffer), &soa, 5));
+    mu_check(memcmp(expected, buffer, len) == 0);
+
+    mu_check(tekon_resp_19(&message, 2, values, TEKON_PROTO_ILIST_SIZE));
+    mu_check(tekon_soa_resp_19(&soa, 2, values, TEKON_PROTO_ILIST_SIZE));
+    len = tekon_resp_pack(expected, sizeof(expected), &message, 6);
+    mu_assert_int_eq(len, tekon_soa_resp_pack(buffer, sizeof(buffer), &soa, 6));
+    mu_check(memcmp(expected, buffer, len) == 0);
+
+    mu_check(tekon_resp_1c(&message, 2, values, quals, TEKON_PROTO_PLIST_SIZE));
+    mu_check(tekon_soa_resp_1c(&soa, 2, values, quals, TEKON_PROTO_PLIST_SIZE));
+    len = tekon_resp_pack(expected, sizeof(expected), &message, 7);
+    mu_assert_int_eq(len, tekon_soa_resp_pack(buffer, sizeof(buffer), &soa, 7));
+    mu_check(memcmp(expected, buffer, len) == 0);
+    mu_assert_int_eq(0, tekon_soa_resp_pack(buffer, len - 1, &soa, 7));
+
+    mu_check(tekon_soa_resp_ack(&soa, 1));
+    mu_assert_int_eq(1, tekon_soa_resp_pack(buffer, sizeof(buffer), &soa, 0));
+    mu_assert_int_eq(TEKON_PROTO_POS_ACK, buffer[0]);
+}
+
+MU_TEST(test_pack_batch)
+{
+    uint8_t devices[] = {3, 4, 3};
+    uint16_t addresses[] = {0x8000, 0x8001, 0x8002};
+    const uint8_t passwd[8] = {0x07, 0x3, 0x05, 0x02, 0x00, 0x00, 0x00, 0x01};
+    uint8_t expected[512];
+    uint8_t buffer[1024];
+    struct message messages[4];
+    const struct message * list[4];
+    uint8_t numbers[4] = {1, 2, 3, 4};
+    size_t offsets[5];
+    size_t offset = 0;
+    size_t i;
+
+    mu_check(tekon_req_11(&messages[0], 2, 3, 0x8003));
+    mu_check(tekon_req_19(&messages[1], 2, 3, 0xF017, 10, 24));
+    mu_check(tekon_req_1c(&messages[2], 2, devices, addresses, NULL, 3));
+    mu_check(tekon_req_14(&messages[3], 2, passwd, sizeof(passwd)));
+    for(i = 0; i < 4; i++)
+        list[i] = &messages[i];
+
+    /* Посылки идут подряд и совпадают с упакованными по одной */
+    mu_assert_int_eq(4, tekon_req_pack_batch(buffer, sizeof(buffer), list, numbers, 4, offsets));
+    mu_assert_int_eq(0, offsets[0]);
+    for(i = 0; i < 4; i++) {
+        const ssize_t len = tekon_req_pack(expected, sizeof(expected), list[i], numbers[i]);
+        mu_check(len > 0);
+        mu_assert_int_eq(offset + len, offsets[i + 1]);
+        mu_check(memcmp(expected, buffer + offsets[i], len) == 0);
+        offset += len;
+    }
+
+    /* Нет места: записаны только поместившиеся запросы */
+    mu_assert_int_eq(2, tekon_req_pack_batch(buffer, offsets[2] + 1, list, numbers, 4, offsets));
+    mu_assert_int_eq(1, tekon_req_pack_batch(buffer, offsets[1], list, numbers, 4, offsets));
+
+    /* Ошибка в запросе */
+    numbers[1] = 16;
+    mu_assert_int_eq(1, tekon_req_pack_batch(buffer, sizeof(buffer), list, numbers, 4, offsets));
+    mu_assert_int_eq(0, tekon_req_pack_batch(buffer, sizeof(buffer), list + 1, numbers + 1, 3, offsets));
+    mu_assert_int_eq(0, offsets[0]);
+    mu_assert_int_eq(0, tekon_req_pack_batch(buffer, sizeof(buffer), list, numbers, 0, offsets));
+}
+
 MU_TEST_SUITE(suite_pack_common)
 {
     MU_RUN_TEST(test_pack_nums);
@@ -249,6 +468,24 @@ MU_TEST_SUITE(suite_readem_list_1c_inv)
     MU_RUN_TEST(test_msg_readem_list_1c_inv_dev);
 }
 
+MU_TEST_SUITE(suite_pack_resp)
+{
+    MU_RUN_TEST(test_pack_resp_1c);
+    MU_RUN_TEST(test_pack_resp_19);
+    MU_RUN_TEST(test_pack_resp_11_14_ack);
+}
+
+MU_TEST_SUITE(suite_pack_soa)
+{
+    MU_RUN_TEST(test_pack_soa_req);
+    MU_RUN_TEST(test_pack_soa_resp);
+}
+
+MU_TEST_SUITE(suite_pack_batch)
+{
+    MU_RUN_TEST(test_pack_batch);
+}
+
 int main()
 {
     MU_RUN_SUITE(suite_pack_common);
@@ -258,6 +495,9 @@ int main()
     MU_RUN_SUITE(suite_readem_19);
     MU_RUN_SUITE(suite_readem_list_1c);
     MU_RUN_SUITE(suite_readem_list_1c_inv);
+    MU_RUN_SUITE(suite_pack_resp);
+    MU_RUN_SUITE(suite_pack_soa);
+    MU_RUN_SUITE(suite_pack_batch);
     MU_REPORT();
     return mu_get_fails();
 }
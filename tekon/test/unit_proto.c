@@ -9,6 +9,8 @@ extern "C" {
 
 #include "test/minunit.h"
 #include "tekon/time.h"
+#include "tekon/proto.h"
+#include <string.h>
 
 MU_TEST(test_unpack_time)
 {
@@ -66,6 +68,34 @@ MU_TEST(test_pack_date)
     }
 }
 
+/* Все реализации КС совпадают с побайтной на любых длинах и смещениях */
+MU_TEST(test_crc_impl)
+{
+    static uint8_t buffer[4096 + 16];
+    uint32_t seed = 12345;
+    size_t i, offset, size;
+
+    for(i = 0; i < sizeof(buffer); i++) {
+        seed = seed * 1103515245 + 12345;
+        buffer[i] = seed >> 16;
+    }
+
+    for(offset = 0; offset < 16; offset++) {
+        for(size = 1; size <= 300; size++) {
+            const uint8_t expected = tekon_crc_bytes(buffer + offset, size);
+            mu_assert_int_eq(expected, tekon_crc(buffer + offset, size));
+            mu_assert_int_eq(expected, tekon_crc_words(buffer + offset, size));
+        }
+    }
+
+    /* Длинный буфер из 0xFF: поля сумм сворачиваются без переполнения */
+    memset(buffer, 0xFF, sizeof(buffer));
+    mu_assert_int_eq(tekon_crc_bytes(buffer, 4096), tekon_crc(buffer, 4096));
+    mu_assert_int_eq(tekon_crc_bytes(buffer, 4096), tekon_crc_words(buffer, 4096));
+    mu_assert_int_eq(tekon_crc_bytes(buffer, 4095), tekon_crc_words(buffer + 1, 4095));
+    mu_check(strlen(tekon_crc_impl()) > 0);
+}
+
 MU_TEST_SUITE(suite_time)
 {
     MU_RUN_TEST(test_unpack_time);
@@ -78,10 +108,16 @@ MU_TEST_SUITE(suite_date)
     MU_RUN_TEST(test_pack_date);
 }
 
+MU_TEST_SUITE(suite_crc)
+{
+    MU_RUN_TEST(test_crc_impl);
+}
+
 int main()
 {
     MU_RUN_SUITE(suite_time);
     MU_RUN_SUITE(suite_date);
+    MU_RUN_SUITE(suite_crc);
     MU_REPORT();
     return mu_get_fails();
 }
@@ -0,0 +1,155 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "test/minunit.h"
+#include "tekon/stream.h"
+#include <errno.h>
+#include <string.h>
+
+/* Ответ на 0x1C с одним параметром и квитанция */
+static const uint8_t var[] = {0x68, 0x07, 0x07, 0x68, 0x41, 0x02, 0x00, 0x00, 0x80, 0x3f, 0x00, 0x02, 0x16};
+static const uint8_t fix[] = {0x10, 0x42, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x16};
+static const uint8_t ack[] = {0xA2};
+
+MU_TEST(test_whole)
+{
+    struct tekon_stream stream;
+    uint8_t frame[512];
+
+    tekon_stream_init(&stream);
+    mu_assert_int_eq(0, tekon_stream_pop(&stream, frame, sizeof(frame)));
+
+    tekon_stream_push(&stream, var, sizeof(var));
+    mu_check(tekon_stream_ready(&stream));
+    mu_assert_int_eq(sizeof(var), tekon_stream_pop(&stream, frame, sizeof(frame)));
+    mu_check(memcmp(frame, var, sizeof(var)) == 0);
+    mu_assert_int_eq(0, tekon_stream_pop(&stream, frame, sizeof(frame)));
+    mu_check(!tekon_stream_ready(&stream));
+}
+
+MU_TEST(test_partial)
+{
+    struct tekon_stream stream;
+    uint8_t frame[512];
+    size_t i;
+
+    tekon_stream_init(&stream);
+
+    /* По одному байту */
+    for(i = 0; i < sizeof(var) - 1; i++) {
+        tekon_stream_push(&stream, var + i, 1);
+        mu_check(!tekon_stream_ready(&stream));
+        mu_assert_int_eq(0, tekon_stream_pop(&stream, frame, sizeof(frame)));
+    }
+
+    tekon_stream_push(&stream, var + i, 1);
+    mu_assert_int_eq(sizeof(var), tekon_stream_pop(&stream, frame, sizeof(frame)));
+    mu_check(memcmp(frame, var, sizeof(var)) == 0);
+    mu_assert_int_eq(0, stream.skipped);
+}
+
+MU_TEST(test_coalesced)
+{
+    struct tekon_stream stream;
+    uint8_t frame[512];
+    uint8_t data[sizeof(var) * 2 + sizeof(fix) + sizeof(ack)];
+    size_t pos = 0;
+
+    memcpy(data + pos, var, sizeof(var));
+    pos += sizeof(var);
+    memcpy(data + pos, ack, sizeof(ack));
+    pos += sizeof(ack);
+    memcpy(data + pos, fix, sizeof(fix));
+    pos += sizeof(fix);
+    memcpy(data + pos, var, sizeof(var));
+    pos += sizeof(var);
+
+    tekon_stream_init(&stream);
+
+    /* Последняя посылка приходит не полностью */
+    tekon_stream_push(&stream, data, pos - 3);
+    mu_assert_int_eq(sizeof(var), tekon_stream_pop(&stream, frame, sizeof(frame)));
+    mu_assert_int_eq(sizeof(ack), tekon_stream_pop(&stream, frame, sizeof(frame)));
+    mu_assert_int_eq(0xA2, frame[0]);
+    mu_assert_int_eq(sizeof(fix), tekon_stream_pop(&stream, frame, sizeof(frame)));
+    mu_check(memcmp(frame, fix, sizeof(fix)) == 0);
+    mu_assert_int_eq(0, tekon_stream_pop(&stream, frame, sizeof(frame)));
+
+    tekon_stream_push(&stream, data + pos - 3, 3);
+    mu_assert_int_eq(sizeof(var), tekon_stream_pop(&stream, frame, sizeof(frame)));
+    mu_check(memcmp(frame, var, sizeof(var)) == 0);
+    mu_assert_int_eq(0, stream.skipped);
+}
+
+MU_TEST(test_resync)
+{
+    struct tekon_stream stream;
+    uint8_t frame[512];
+    const uint8_t garbage[] = {0x00, 0x68, 0x07, 0x05, 0x68, 0xFF};
+
+    tekon_stream_init(&stream);
+    tekon_stream_push(&stream, garbage, sizeof(garbage));
+    tekon_stream_push(&stream, var, sizeof(var));
+
+    mu_assert_int_eq(sizeof(var), tekon_stream_pop(&stream, frame, sizeof(frame)));
+    mu_check(memcmp(frame, var, sizeof(var)) == 0);
+    mu_assert_int_eq(sizeof(garbage), stream.skipped);
+}
+
+MU_TEST(test_small_buffer)
+{
+    struct tekon_stream stream;
+    uint8_t frame[4];
+
+    tekon_stream_init(&stream);
+    tekon_stream_push(&stream, var, sizeof(var));
+    tekon_stream_push(&stream, ack, sizeof(ack));
+
+    /* Не поместившаяся посылка отбрасывается, следующая доступна */
+    mu_assert_int_eq(-EMSGSIZE, tekon_stream_pop(&stream, frame, sizeof(frame)));
+    mu_assert_int_eq(sizeof(ack), tekon_stream_pop(&stream, frame, sizeof(frame)));
+}
+
+MU_TEST(test_overflow)
+{
+    struct tekon_stream stream;
+    uint8_t frame[512];
+    size_t i;
+
+    tekon_stream_init(&stream);
+
+    /* Буфер, заполненный неразобранными посылками, сбрасывается */
+    for(i = 0; i < TEKON_STREAM_SIZE / sizeof(var) + 1; i++)
+        tekon_stream_push(&stream, var, sizeof(var));
+
+    mu_check(stream.skipped > 0);
+    tekon_stream_push(&stream, var, sizeof(var));
+    mu_assert_int_eq(sizeof(var), tekon_stream_pop(&stream, frame, sizeof(frame)));
+}
+
+MU_TEST_SUITE(suite_stream)
+{
+    MU_RUN_TEST(test_whole);
+    MU_RUN_TEST(test_partial);
+    MU_RUN_TEST(test_coalesced);
+    MU_RUN_TEST(test_resync);
+    MU_RUN_TEST(test_small_buffer);
+    MU_RUN_TEST(test_overflow);
+}
+
+int main()
+{
+    MU_RUN_SUITE(suite_stream);
+    MU_REPORT();
+    return mu_get_fails();
+}
+
+#ifdef __cplusplus
+}
+#endif
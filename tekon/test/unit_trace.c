@@ -0,0 +1,104 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "test/minunit.h"
+#include "tekon/tekon.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_FILE "unit_trace.json"
+
+/* Прочитать выгруженный файл */
+static void read_dump(char * buffer, size_t size)
+{
+    FILE * file = fopen(TEST_FILE, "r");
+    mu_check(file != NULL);
+    const size_t len = fread(buffer, 1, size - 1, file);
+    buffer[len] = 0;
+    fclose(file);
+    remove(TEST_FILE);
+}
+
+MU_TEST(test_names)
+{
+    mu_check(strcmp(tekon_trace_name(TEKON_TRACE_REQ_PACK), "req_pack") == 0);
+    mu_check(strcmp(tekon_trace_name(TEKON_TRACE_CYCLE), "cycle") == 0);
+    mu_check(strcmp(tekon_trace_name(TEKON_TRACE_POINTS), "unknown") == 0);
+}
+
+MU_TEST(test_dump)
+{
+    static char dump[4096];
+    const uint8_t devices[1] = {3};
+    const uint16_t addresses[1] = {0x8003};
+    const uint16_t indexes[1] = {0};
+    struct message request;
+    uint8_t frame[512];
+
+    tekon_trace_clear();
+    mu_check(tekon_req_1c(&request, 2, devices, addresses, indexes, 1));
+    const ssize_t len = tekon_req_pack(frame, sizeof(frame), &request, 1);
+    mu_check(len > 0);
+
+    /* Без TEKON_TRACE точки трассировки в код не попадают */
+    if(!TEKON_TRACE_ENABLED) {
+        mu_assert_int_eq(-ENOTSUP, tekon_trace_dump(TEST_FILE));
+        return;
+    }
+
+    TEKON_TRACE_INSTANT(TEKON_TRACE_CYCLE, 7);
+    mu_assert_int_eq(0, tekon_trace_dump(TEST_FILE));
+    read_dump(dump, sizeof(dump));
+
+    mu_check(strncmp(dump, "{\"traceEvents\":[", 16) == 0);
+    mu_check(strstr(dump, "\"name\":\"req_pack\",\"cat\":\"tekon\",\"ph\":\"B\"") != NULL);
+    mu_check(strstr(dump, "\"name\":\"req_pack\",\"cat\":\"tekon\",\"ph\":\"E\"") != NULL);
+    mu_check(strstr(dump, "\"name\":\"cycle\",\"cat\":\"tekon\",\"ph\":\"i\"") != NULL);
+    mu_check(strstr(dump, "\"args\":{\"result\":7}") != NULL);
+    mu_check(strstr(dump, "\"overwritten\":0}}") != NULL);
+}
+
+MU_TEST(test_overwrite)
+{
+    static char dump[8 * 1024 * 1024];
+    size_t i;
+
+    if(!TEKON_TRACE_ENABLED)
+        return;
+
+    /* Старые события затираются новыми */
+    tekon_trace_clear();
+    for(i = 0; i < TEKON_TRACE_SIZE + 10; i++)
+        TEKON_TRACE_INSTANT(TEKON_TRACE_LINK_WAIT, i);
+
+    mu_assert_int_eq(0, tekon_trace_dump(TEST_FILE));
+    read_dump(dump, sizeof(dump));
+    mu_check(strstr(dump, "\"result\":9}") == NULL);
+    mu_check(strstr(dump, "\"result\":10}") != NULL);
+    mu_check(strstr(dump, "\"overwritten\":10}}") != NULL);
+}
+
+MU_TEST_SUITE(suite_trace)
+{
+    MU_RUN_TEST(test_names);
+    MU_RUN_TEST(test_dump);
+    MU_RUN_TEST(test_overwrite);
+}
+
+int main()
+{
+    MU_RUN_SUITE(suite_trace);
+    MU_REPORT();
+    return mu_get_fails();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -9,6 +9,7 @@ extern "C" {
 
 #include "test/minunit.h"
 #include "tekon/unpack.h"
+#include "tekon/pack.h"
 
 MU_TEST(test_read_pack)
 {
@@ -323,6 +324,396 @@ MU_TEST(test_read_readem_1C_inv_addr)
     mu_assert_int_eq(0, result);
 }
 
+MU_TEST(test_resp_view)
+{
+    const uint8_t resp_19[] = {0x68, 0x0e, 0x0e, 0x68, 0x06, 0x02, 0xd0,
+                               0x61, 0x29, 0x46, 0xba, 0x0d, 0x31, 0x46,
+                               0x3b, 0x65, 0x34, 0x46, 0x00, 0x16
+                              };
+    const uint32_t values[3] = {0x11223344, 0x55667788, 0x99AABBCC};
+    const uint8_t quals[3] = {0, 1, 2};
+    struct message message;
+    struct tekon_view view;
+    uint8_t frame[512];
+    uint8_t num = 0;
+    uint32_t value;
+    uint8_t qual;
+    size_t pos = 0;
+
+    /* Значения 0x19 берутся прямо из посылки */
+    mu_assert_int_eq(sizeof(resp_19), tekon_resp_view(&view, resp_19, sizeof(resp_19), TEKON_MSG_READEM_IND_LIST_19, &num));
+    mu_assert_int_eq(6, num);
+    mu_assert_int_eq(2, view.gateway);
+    mu_assert_int_eq(3, view.nelements);
+    mu_check(view.data == resp_19 + 6);
+    mu_assert_int_eq(0x462961d0, tekon_view_value(&view, 0));
+    mu_assert_int_eq(0, tekon_view_qual(&view, 2));
+
+    /* Перебор 0x1C */
+    mu_check(tekon_resp_1c(&message, 2, values, quals, 3));
+    const ssize_t len = tekon_resp_pack(frame, sizeof(frame), &message, 5);
+    mu_check(len > 0);
+    mu_assert_int_eq(len, tekon_resp_view(&view, frame, len, TEKON_MSG_READEM_PAR_LIST_1C, &num));
+    mu_assert_int_eq(5, num);
+    mu_assert_int_eq(TEKON_MSG_READEM_PAR_LIST_1C, view.type);
+    while(tekon_view_next(&view, &pos, &value, &qual)) {
+        mu_assert_int_eq(values[pos - 1], value);
+        mu_assert_int_eq(quals[pos - 1], qual);
+    }
+    mu_assert_int_eq(3, pos);
+
+    /* Поврежденная посылка и неподдерживаемый тип */
+    frame[len - 2] ^= 0xFF;
+    mu_assert_int_eq(0, tekon_resp_view(&view, frame, len, TEKON_MSG_READEM_PAR_LIST_1C, &num));
+    frame[len - 2] ^= 0xFF;
+    mu_assert_int_eq(0, tekon_resp_view(&view, frame, len, TEKON_MSG_READEM_PAR_11, &num));
+
+    /* Квитанция */
+    frame[0] = TEKON_PROTO_NEG_ACK;
+    mu_assert_int_eq(1, tekon_resp_view(&view, frame, 1, TEKON_MSG_READEM_PAR_LIST_1C, &num));
+    mu_assert_int_eq(TEKON_MSG_NEG_ACK, view.type);
+    mu_assert_int_eq(0, view.nelements);
+}
+
+MU_TEST(test_resp_view_overflow)
+{
+    /* Список длиннее допустимого для запроса: 45 значений 0x1C */
+    uint8_t frame[512];
+    struct tekon_view view;
+    struct message message;
+    const uint8_t len = 2 + 45 * 5;
+
+    memset(frame, 0, sizeof(frame));
+    frame[0] = frame[3] = TEKON_PROTO_VAR_PREFIX;
+    frame[1] = frame[2] = len;
+    frame[4] = 0x08;
+    frame[5] = 0x02;
+    frame[len + 4] = tekon_variable_crc(frame, len + 6);
+    frame[len + 5] = TEKON_PROTO_END;
+
+    mu_assert_int_eq(0, tekon_resp_view(&view, frame, len + 6, TEKON_MSG_READEM_PAR_LIST_1C, NULL));
+    mu_assert_int_eq(0, tekon_resp_unpack(frame, len + 6, &message, TEKON_MSG_READEM_PAR_LIST_1C, NULL));
+}
+
+struct sink_table {
+    uint32_t values[TEKON_PROTO_PLIST_SIZE];
+    uint8_t quals[TEKON_PROTO_PLIST_SIZE];
+    size_t count;
+};
+
+static void sink_value(void * ctx, size_t index, uint32_t value, uint8_t qual)
+{
+    struct sink_table * table = ctx;
+    table->values[index] = value;
+    table->quals[index] = qual;
+    table->count++;
+}
+
+MU_TEST(test_resp_sink)
+{
+    const uint8_t resp_11[] = {0x68, 0x06, 0x06, 0x68, 0x07, 0x02,
+                               0x00, 0x00, 0x16, 0x43, 0x62, 0x16
+                              };
+    const uint8_t ack = TEKON_PROTO_POS_ACK;
+    const uint32_t values[3] = {0x11223344, 0x55667788, 0x99AABBCC};
+    const uint8_t quals[3] = {0, 1, 2};
+    struct sink_table table;
+    struct message message;
+    uint8_t frame[512];
+    uint8_t num = 0;
+    size_t i;
+
+    /* 0x11 */
+    memset(&table, 0, sizeof(table));
+    mu_assert_int_eq(sizeof(resp_11), tekon_resp_unpack_sink(resp_11, sizeof(resp_11), TEKON_MSG_READEM_PAR_11, 1, sink_value, &table, &num));
+    mu_assert_int_eq(7, num);
+    mu_assert_int_eq(1, table.count);
+    mu_assert_int_eq(0x43160000, table.values[0]);
+
+    /* 0x1C */
+    memset(&table, 0, sizeof(table));
+    mu_check(tekon_resp_1c(&message, 2, values, quals, 3));
+    const ssize_t len = tekon_resp_pack(frame, sizeof(frame), &message, 5);
+    mu_check(len > 0);
+    mu_assert_int_eq(len, tekon_resp_unpack_sink(frame, len, TEKON_MSG_READEM_PAR_LIST_1C, 3, sink_value, &table, &num));
+    mu_assert_int_eq(5, num);
+    mu_assert_int_eq(3, table.count);
+    for(i = 0; i < 3; i++) {
+        mu_assert_int_eq(values[i], table.values[i]);
+        mu_assert_int_eq(quals[i], table.quals[i]);
+    }
+
+    /* Кол-во элементов не совпадает с запросом */
+    memset(&table, 0, sizeof(table));
+    mu_assert_int_eq(0, tekon_resp_unpack_sink(frame, len, TEKON_MSG_READEM_PAR_LIST_1C, 4, sink_value, &table, NULL));
+    mu_assert_int_eq(0, table.count);
+
+    /* Квитанция */
+    mu_assert_int_eq(0, tekon_resp_unpack_sink(&ack, sizeof(ack), TEKON_MSG_READEM_PAR_LIST_1C, 3, sink_value, &table, NULL));
+    mu_assert_int_eq(0, table.count);
+
+    /* Поврежденная посылка: ни одно значение не передается */
+    frame[len - 2] ^= 0xFF;
+    mu_assert_int_eq(0, tekon_resp_unpack_sink(frame, len, TEKON_MSG_READEM_PAR_LIST_1C, 3, sink_value, &table, NULL));
+    mu_assert_int_eq(0, table.count);
+}
+
+MU_TEST(test_soa_resp_unpack)
+{
+    const uint8_t resp_11[] = {0x68, 0x06, 0x06, 0x68, 0x07, 0x02,
+                               0x00, 0x00, 0x16, 0x43, 0x62, 0x16
+                              };
+    const uint8_t nack = TEKON_PROTO_NEG_ACK;
+    const uint32_t values[3] = {0x11223344, 0x55667788, 0x99AABBCC};
+    const uint8_t quals[3] = {0, 1, 2};
+    struct message_soa soa;
+    struct message message;
+    uint8_t frame[512];
+    uint8_t num = 0;
+    size_t i;
+
+    mu_assert_int_eq(sizeof(resp_11), tekon_soa_resp_unpack(resp_11, sizeof(resp_11), &soa, TEKON_MSG_READEM_PAR_11, &num));
+    mu_assert_int_eq(7, num);
+    mu_assert_int_eq(TEKON_DIR_IN, soa.dir);
+    mu_assert_int_eq(1, soa.nelements);
+    mu_assert_int_eq(0x43160000, soa.values[0]);
+
+    mu_check(tekon_resp_1c(&message, 2, values, quals, 3));
+    const ssize_t len = tekon_resp_pack(frame, sizeof(frame), &message, 5);
+    mu_assert_int_eq(len, tekon_soa_resp_unpack(frame, len, &soa, TEKON_MSG_READEM_PAR_LIST_1C, &num));
+    mu_assert_int_eq(5, num);
+    mu_assert_int_eq(TEKON_MSG_READEM_PAR_LIST_1C, soa.type);
+    mu_assert_int_eq(2, soa.gateway);
+    mu_assert_int_eq(3, soa.nelements);
+    for(i = 0; i < 3; i++) {
+        mu_assert_int_eq(values[i], soa.values[i]);
+        mu_assert_int_eq(quals[i], soa.quals[i]);
+    }
+
+    /* Тот же ответ как 0x19 не разбирается (длина не кратна 4) */
+    mu_assert_int_eq(0, tekon_soa_resp_unpack(frame, len, &soa, TEKON_MSG_READEM_IND_LIST_19, NULL));
+
+    mu_assert_int_eq(1, tekon_soa_resp_unpack(&nack, sizeof(nack), &soa, TEKON_MSG_READEM_PAR_LIST_1C, NULL));
+    mu_assert_int_eq(TEKON_MSG_NEG_ACK, soa.type);
+    mu_assert_int_eq(0, soa.nelements);
+
+    frame[len - 2] ^= 0xFF;
+    mu_assert_int_eq(0, tekon_soa_resp_unpack(frame, len, &soa, TEKON_MSG_READEM_PAR_LIST_1C, NULL));
+}
+
+MU_TEST(test_soa_req_unpack)
+{
+    const uint8_t devices[3] = {3, 4, 5};
+    const uint16_t addresses[3] = {0x8000, 0x8001, 0xF017};
+    const uint16_t indexes[3] = {TEKON_INVALID_INDEX, 7, 1000};
+    const uint8_t passwd[8] = {0x07, 0x03, 0x05, 0x02, 0x00, 0x00, 0x00, 0x01};
+    struct message_soa soa;
+    struct message message;
+    uint8_t frame[512];
+    uint8_t num = 0;
+    ssize_t len;
+    size_t i;
+
+    mu_check(tekon_req_1c(&message, 2, devices, addresses, indexes, 3));
+    len = tekon_req_pack(frame, sizeof(frame), &message, 9);
+    mu_assert_int_eq(len, tekon_soa_req_unpack(frame, len, &soa, &num));
+    mu_assert_int_eq(9, num);
+    mu_assert_int_eq(TEKON_DIR_OUT, soa.dir);
+    mu_assert_int_eq(TEKON_MSG_READEM_PAR_LIST_1C, soa.type);
+    mu_assert_int_eq(3, soa.nelements);
+    for(i = 0; i < 3; i++) {
+        mu_assert_int_eq(devices[i], soa.devices[i]);
+        mu_assert_int_eq(addresses[i], soa.addresses[i]);
+        mu_assert_int_eq(indexes[i], soa.indexes[i]);
+    }
+
+    mu_check(tekon_req_19(&message, 2, 3, 0xF017, 10, 12));
+    len = tekon_req_pack(frame, sizeof(frame), &message, 1);
+    mu_assert_int_eq(len, tekon_soa_req_unpack(frame, len, &soa, NULL));
+    mu_assert_int_eq(12, soa.nelements);
+    mu_assert_int_eq(21, soa.indexes[11]);
+
+    mu_check(tekon_req_11(&message, 2, 3, 0x8003));
+    len = tekon_req_pack(frame, sizeof(frame), &message, 2);
+    mu_assert_int_eq(9, tekon_soa_req_unpack(frame, len, &soa, &num));
+    mu_assert_int_eq(2, num);
+    mu_assert_int_eq(0x8003, soa.addresses[0]);
+
+    /* 0x14 в компактном виде не представляется */
+    mu_check(tekon_req_14(&message, 2, passwd, sizeof(passwd)));
+    len = tekon_req_pack(frame, sizeof(frame), &message, 3);
+    mu_check(len > 0);
+    mu_assert_int_eq(0, tekon_soa_req_unpack(frame, len, &soa, NULL));
+}
+
+/* Разбор списков за один проход: любое искажение посылки отвергается, а
+ * значения из 0xFF не переполняют суммы КС */
+MU_TEST(test_resp_list_fused)
+{
+    uint32_t values[TEKON_PROTO_ILIST_SIZE];
+    uint8_t quals[TEKON_PROTO_PLIST_SIZE];
+    struct message message;
+    struct message out;
+    struct message_soa soa;
+    uint8_t frame[512];
+    ssize_t len;
+    size_t i;
+
+    memset(values, 0xFF, sizeof(values));
+    memset(quals, 0xFF, sizeof(quals));
+
+    mu_check(tekon_resp_19(&message, 0xFF, values, TEKON_PROTO_ILIST_SIZE));
+    len = tekon_resp_pack(frame, sizeof(frame), &message, 15);
+    mu_assert_int_eq(len, tekon_resp_unpack(frame, len, &out, TEKON_MSG_READEM_IND_LIST_19, NULL));
+    mu_assert_int_eq(TEKON_PROTO_ILIST_SIZE, out.nelements);
+    mu_assert_int_eq(0xFFFFFFFF, out.payload.parameters[59].value);
+    mu_assert_int_eq(len, tekon_soa_resp_unpack(frame, len, &soa, TEKON_MSG_READEM_IND_LIST_19, NULL));
+    mu_assert_int_eq(0, soa.quals[59]);
+
+    mu_check(tekon_resp_1c(&message, 0xFF, values, quals, TEKON_PROTO_PLIST_SIZE));
+    len = tekon_resp_pack(frame, sizeof(frame), &message, 15);
+    mu_assert_int_eq(len, tekon_resp_unpack(frame, len, &out, TEKON_MSG_READEM_PAR_LIST_1C, NULL));
+    mu_assert_int_eq(0xFF, out.payload.parameters[39].qual);
+    mu_assert_int_eq(len, tekon_soa_resp_unpack(frame, len, &soa, TEKON_MSG_READEM_PAR_LIST_1C, NULL));
+    mu_assert_int_eq(0xFF, soa.quals[39]);
+
+    /* Искажение любого байта, кроме начального (меняет формат посылки) */
+    for(i = 1; i < (size_t)len; i++) {
+        frame[i] ^= 0x01;
+        mu_assert_int_eq(0, tekon_resp_unpack(frame, len, &out, TEKON_MSG_READEM_PAR_LIST_1C, NULL));
+        mu_assert_int_eq(0, tekon_soa_resp_unpack(frame, len, &soa, TEKON_MSG_READEM_PAR_LIST_1C, NULL));
+        frame[i] ^= 0x01;
+    }
+
+    /* Короткий буфер */
+    mu_assert_int_eq(0, tekon_resp_unpack(frame, len - 1, &out, TEKON_MSG_READEM_PAR_LIST_1C, NULL));
+    mu_assert_int_eq(0, tekon_soa_resp_unpack(frame, 8, &soa, TEKON_MSG_READEM_PAR_LIST_1C, NULL));
+}
+
+MU_TEST(test_resp_number)
+{
+    const uint8_t control_msg[] = {0x68, 0x0e, 0x0e, 0x68, 0x06, 0x02, 0xd0,
+                                   0x61, 0x29, 0x46, 0xba, 0x0d, 0x31, 0x46,
+                                   0x3b, 0x65, 0x34, 0x46, 0x00, 0x16
+                                  };
+    uint8_t num = 0;
+    int result = tekon_resp_number(control_msg, sizeof(control_msg), &num);
+    mu_assert_int_eq(1, result);
+    mu_assert_int_eq(6, num);
+}
+
+MU_TEST(test_resp_number_ack)
+{
+    const uint8_t ack = TEKON_PROTO_POS_ACK;
+    uint8_t num = 0;
+    int result = tekon_resp_number(&ack, sizeof(ack), &num);
+    mu_assert_int_eq(0, result);
+}
+
+MU_TEST(test_resp_number_inv_crc)
+{
+    const uint8_t control_msg[] = {0x68, 0x0e, 0x0e, 0x68, 0x06, 0x02, 0xd0,
+                                   0x61, 0x29, 0x46, 0xba, 0x0d, 0x31, 0x46,
+                                   0x3b, 0x65, 0x34, 0x46, 0x01, 0x16
+                                  };
+    uint8_t num = 0;
+    int result = tekon_resp_number(control_msg, sizeof(control_msg), &num);
+    mu_assert_int_eq(0, result);
+}
+
+MU_TEST(test_req_unpack_1c)
+{
+    uint8_t buffer[512];
+    const uint8_t devices[3] = {3, 3, 4};
+    const uint16_t addresses[3] = {0x8003, 0xF017, 0x100};
+    const uint16_t indexes[3] = {TEKON_INVALID_INDEX, 0, 1535};
+    struct message message;
+    struct message check;
+    uint8_t num = 0;
+    size_t i;
+
+    tekon_req_1c(&message, 9, devices, addresses, indexes, 3);
+    ssize_t size = tekon_req_pack(buffer, sizeof(buffer), &message, 7);
+    mu_assert_int_eq(size, tekon_req_unpack(buffer, size, &check, &num));
+    mu_assert_int_eq(7, num);
+    mu_assert_int_eq(TEKON_MSG_READEM_PAR_LIST_1C, check.type);
+    mu_assert_int_eq(9, check.gateway);
+    mu_assert_int_eq(3, check.nelements);
+    for(i = 0; i < 3; i++) {
+        mu_assert_int_eq(devices[i], check.payload.parameters[i].device);
+        mu_assert_int_eq(addresses[i], check.payload.parameters[i].address);
+        mu_assert_int_eq(indexes[i], check.payload.parameters[i].index);
+    }
+
+    /* Поврежденная посылка */
+    buffer[8]++;
+    mu_assert_int_eq(0, tekon_req_unpack(buffer, size, &check, &num));
+}
+
+MU_TEST(test_req_unpack_11_14_19)
+{
+    uint8_t buffer[512];
+    const uint8_t cmd[8] = {0x07, 3, 0x05, TEKON_PRIV_ADMIN, 0, 0, 0, 1};
+    struct message message;
+    struct message check;
+    uint8_t num = 0;
+
+    tekon_req_11(&message, 2, 3, 0x8003);
+    ssize_t size = tekon_req_pack(buffer, sizeof(buffer), &message, 1);
+    mu_assert_int_eq(9, tekon_req_unpack(buffer, size, &check, &num));
+    mu_assert_int_eq(TEKON_MSG_READEM_PAR_11, check.type);
+    mu_assert_int_eq(3, check.payload.parameters[0].device);
+    mu_assert_int_eq(0x8003, check.payload.parameters[0].address);
+    mu_assert_int_eq(1, num);
+
+    tekon_req_14(&message, 2, cmd, sizeof(cmd));
+    size = tekon_req_pack(buffer, sizeof(buffer), &message, 2);
+    mu_assert_int_eq(size, tekon_req_unpack(buffer, size, &check, &num));
+    mu_assert_int_eq(TEKON_MSG_WRITEM_PAR_14, check.type);
+    mu_assert_int_eq(sizeof(cmd), check.nelements);
+    mu_check(memcmp(cmd, check.payload.bytes, sizeof(cmd)) == 0);
+
+    tekon_req_19(&message, 2, 3, 0x800D, 100, TEKON_PROTO_ILIST_SIZE);
+    size = tekon_req_pack(buffer, sizeof(buffer), &message, 3);
+    mu_assert_int_eq(size, tekon_req_unpack(buffer, size, &check, &num));
+    mu_assert_int_eq(TEKON_MSG_READEM_IND_LIST_19, check.type);
+    mu_assert_int_eq(TEKON_PROTO_ILIST_SIZE, check.nelements);
+    mu_assert_int_eq(0x800D, check.payload.parameters[0].address);
+    mu_assert_int_eq(100, check.payload.parameters[0].index);
+    mu_assert_int_eq(3, num);
+
+    /* Ответ не является запросом */
+    const uint8_t ack = TEKON_PROTO_POS_ACK;
+    mu_assert_int_eq(0, tekon_req_unpack(&ack, 1, &check, &num));
+}
+
+MU_TEST_SUITE(suite_req_unpack)
+{
+    MU_RUN_TEST(test_req_unpack_1c);
+    MU_RUN_TEST(test_req_unpack_11_14_19);
+}
+
+MU_TEST_SUITE(suite_message_view)
+{
+    MU_RUN_TEST(test_resp_view);
+    MU_RUN_TEST(test_resp_view_overflow);
+    MU_RUN_TEST(test_resp_sink);
+}
+
+MU_TEST_SUITE(suite_message_soa)
+{
+    MU_RUN_TEST(test_soa_resp_unpack);
+    MU_RUN_TEST(test_soa_req_unpack);
+    MU_RUN_TEST(test_resp_list_fused);
+}
+
+MU_TEST_SUITE(suite_message_number)
+{
+    MU_RUN_TEST(test_resp_number);
+    MU_RUN_TEST(test_resp_number_ack);
+    MU_RUN_TEST(test_resp_number_inv_crc);
+}
+
 MU_TEST_SUITE(suite_message_pos_ack)
 {
     MU_RUN_TEST(test_read_pack);
@@ -385,6 +776,10 @@ int main()
     MU_RUN_SUITE(suite_message_readem_19);
     MU_RUN_SUITE(suite_message_readem_1C);
     MU_RUN_SUITE(suite_message_readem_1C_inv);
+    MU_RUN_SUITE(suite_message_view);
+    MU_RUN_SUITE(suite_message_soa);
+    MU_RUN_SUITE(suite_message_number);
+    MU_RUN_SUITE(suite_req_unpack);
     MU_REPORT();
     return mu_get_fails();
 }
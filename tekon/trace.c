@@ -0,0 +1,189 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tekon/trace.h"
+#include <assert.h>
+#include <errno.h>
+
+#ifdef TEKON_TRACE
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+static const char * names[TEKON_TRACE_POINTS] = {
+    "req_pack",
+    "resp_pack",
+    "req_unpack",
+    "resp_unpack",
+    "link_send",
+    "link_recv",
+    "link_send_batch",
+    "link_recv_batch",
+    "link_wait",
+    "cycle",
+};
+
+const char * tekon_trace_name(enum tekon_trace_point point)
+{
+    return (unsigned)point < TEKON_TRACE_POINTS ? names[point] : "unknown";
+}
+
+#ifdef TEKON_TRACE
+
+/* Кольцевой буфер потока. Пишет только поток-владелец */
+struct ring {
+    struct tekon_trace_event events[TEKON_TRACE_SIZE];
+    uint64_t head; /* кол-во записанных событий */
+    unsigned tid;
+};
+
+static struct ring * rings[TEKON_TRACE_MAX_THREADS];
+static unsigned nrings;
+
+static __thread struct ring * local;
+static __thread int local_failed;
+
+/* Буфер текущего потока. Создается при первом событии */
+static struct ring * ring_get(void)
+{
+    if(local || local_failed)
+        return local;
+
+    const unsigned n = __sync_fetch_and_add(&nrings, 1);
+    if(n >= TEKON_TRACE_MAX_THREADS || !(local = calloc(1, sizeof(*local)))) {
+        local_failed = 1;
+        return NULL;
+    }
+
+    local->tid = n + 1;
+    __sync_synchronize();
+    rings[n] = local;
+    return local;
+}
+
+void tekon_trace_record(enum tekon_trace_point point, enum tekon_trace_phase phase, int64_t arg)
+{
+    struct ring * ring = ring_get();
+    struct timespec ts;
+
+    if(!ring)
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    struct tekon_trace_event * event = &ring->events[ring->head & (TEKON_TRACE_SIZE - 1)];
+    event->time = (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    event->arg = arg;
+    event->point = (uint16_t)point;
+    event->phase = (uint8_t)phase;
+    ring->head++;
+}
+
+/* Первое сохранившееся событие буфера */
+static uint64_t ring_first(const struct ring * ring)
+{
+    return ring->head > TEKON_TRACE_SIZE ? ring->head - TEKON_TRACE_SIZE : 0;
+}
+
+int tekon_trace_dump(const char * path)
+{
+    assert(path);
+
+    const unsigned count = nrings < TEKON_TRACE_MAX_THREADS ? nrings : TEKON_TRACE_MAX_THREADS;
+    const int pid = (int)getpid();
+    int64_t base = INT64_MAX;
+    uint64_t overwritten = 0;
+    const char * sep = "";
+    unsigned i;
+    uint64_t j;
+
+    FILE * file = fopen(path, "w");
+    if(!file)
+        return -errno;
+
+    /* Время отсчитывается от самого раннего события */
+    for(i = 0; i < count; i++) {
+        const struct ring * ring = rings[i];
+        if(ring && ring->head) {
+            const int64_t time = ring->events[ring_first(ring) & (TEKON_TRACE_SIZE - 1)].time;
+            if(time < base)
+                base = time;
+        }
+    }
+
+    fprintf(file, "{\"traceEvents\":[");
+
+    for(i = 0; i < count; i++) {
+        const struct ring * ring = rings[i];
+        if(!ring)
+            continue;
+
+        const uint64_t head = ring->head;
+        overwritten += ring_first(ring);
+
+        for(j = ring_first(ring); j < head; j++) {
+            const struct tekon_trace_event * event = &ring->events[j & (TEKON_TRACE_SIZE - 1)];
+            const int64_t time = event->time - base;
+
+            fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"tekon\",\"ph\":\"%c\",\"ts\":%"PRId64".%03d,"
+                    "\"pid\":%d,\"tid\":%u",
+                    sep, tekon_trace_name((enum tekon_trace_point)event->point), event->phase,
+                    time / 1000, (int)(time % 1000), pid, ring->tid);
+
+            if(event->phase == TEKON_TRACE_INSTANT_PHASE)
+                fprintf(file, ",\"s\":\"t\"");
+            if(event->phase != TEKON_TRACE_BEGIN_PHASE)
+                fprintf(file, ",\"args\":{\"result\":%"PRId64"}", event->arg);
+            fprintf(file, "}");
+            sep = ",";
+        }
+    }
+
+    fprintf(file, "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"overwritten\":%"PRIu64"}}\n", overwritten);
+
+    const int result = ferror(file) ? -EIO : 0;
+    if(fclose(file) != 0 && result == 0)
+        return -errno;
+    return result;
+}
+
+void tekon_trace_clear(void)
+{
+    const unsigned count = nrings < TEKON_TRACE_MAX_THREADS ? nrings : TEKON_TRACE_MAX_THREADS;
+    unsigned i;
+
+    for(i = 0; i < count; i++)
+        if(rings[i])
+            rings[i]->head = 0;
+}
+
+#else
+
+void tekon_trace_record(enum tekon_trace_point point, enum tekon_trace_phase phase, int64_t arg)
+{
+}
+
+int tekon_trace_dump(const char * path)
+{
+    assert(path);
+    return -ENOTSUP;
+}
+
+void tekon_trace_clear(void)
+{
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,94 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef TEKON_TRACE_H
+#define TEKON_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Точки трассировки горячего пути. Включаются при сборке с TEKON_TRACE
+ * (cmake -DTEKON_TRACE=ON), иначе макросы ничего не делают и в код не
+ * попадают.
+ *
+ * Событие - идентификатор точки, фаза (начало/конец участка или отметка),
+ * монотонное время в нс и числовой аргумент (обычно результат вызова).
+ * События пишутся в кольцевой буфер своего потока без блокировок, при
+ * переполнении старые события затираются. Буферы всех потоков выгружаются
+ * в формате Chrome trace (chrome://tracing, Perfetto) */
+
+/* Точки трассировки */
+enum tekon_trace_point {
+    TEKON_TRACE_REQ_PACK,
+    TEKON_TRACE_RESP_PACK,
+    TEKON_TRACE_REQ_UNPACK,
+    TEKON_TRACE_RESP_UNPACK,
+    TEKON_TRACE_LINK_SEND,
+    TEKON_TRACE_LINK_RECV,
+    TEKON_TRACE_LINK_SEND_BATCH,
+    TEKON_TRACE_LINK_RECV_BATCH,
+    TEKON_TRACE_LINK_WAIT,
+    TEKON_TRACE_CYCLE,       /* итерация главного цикла утилиты */
+    TEKON_TRACE_POINTS
+};
+
+/* Фаза события (как в Chrome trace) */
+enum tekon_trace_phase {
+    TEKON_TRACE_BEGIN_PHASE = 'B',
+    TEKON_TRACE_END_PHASE = 'E',
+    TEKON_TRACE_INSTANT_PHASE = 'i'
+};
+
+/* Кол-во событий в буфере потока (степень двойки) */
+#define TEKON_TRACE_SIZE 65536
+
+/* Макс. кол-во потоков с собственным буфером. События остальных потоков не
+ * записываются */
+#define TEKON_TRACE_MAX_THREADS 16
+
+struct tekon_trace_event {
+    int64_t time;  /* монотонное время, нс */
+    int64_t arg;
+    uint16_t point;
+    uint8_t phase;
+};
+
+#ifdef TEKON_TRACE
+#define TEKON_TRACE_ENABLED 1
+#define TEKON_TRACE_BEGIN(point) tekon_trace_record((point), TEKON_TRACE_BEGIN_PHASE, 0)
+#define TEKON_TRACE_END(point, arg) tekon_trace_record((point), TEKON_TRACE_END_PHASE, (int64_t)(arg))
+#define TEKON_TRACE_INSTANT(point, arg) tekon_trace_record((point), TEKON_TRACE_INSTANT_PHASE, (int64_t)(arg))
+#else
+#define TEKON_TRACE_ENABLED 0
+#define TEKON_TRACE_BEGIN(point) ((void)0)
+#define TEKON_TRACE_END(point, arg) ((void)0)
+#define TEKON_TRACE_INSTANT(point, arg) ((void)0)
+#endif
+
+/* Записать событие в буфер текущего потока */
+void tekon_trace_record(enum tekon_trace_point point, enum tekon_trace_phase phase, int64_t arg);
+
+/* Имя точки трассировки */
+const char * tekon_trace_name(enum tekon_trace_point point);
+
+/* Выгрузить буферы всех потоков в файл в формате Chrome trace (JSON).
+ * Потоки, продолжающие запись во время выгрузки, могут дать несогласованные
+ * события, поэтому выгружать лучше из цикла утилиты, а не из обработчика
+ * сигнала.
+ * В случае успеха вернет 0. Иначе - код ошибки (-ENOTSUP - сборка без
+ * TEKON_TRACE) */
+int tekon_trace_dump(const char * path);
+
+/* Очистить буферы всех потоков */
+void tekon_trace_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
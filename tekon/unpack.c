@@ -8,32 +8,25 @@ extern "C" {
 #endif
 
 #include "tekon/unpack.h"
+#include "tekon/trace.h"
 #include <assert.h>
 #include <string.h>
 
-struct buffer_reader {
-    size_t avail;
-    char * pos;
-};
-
-static void buffer_reader_init(struct buffer_reader * self, const void * buffer, size_t size);
-
-/* Запись значений в буфер.
- * 1 - успешно
- * 0 - ошибка */
-static int buffer_reader_u8(struct buffer_reader * self, uint8_t * u8);
-static int buffer_reader_u32(struct buffer_reader * self, uint32_t * u32);
-
 static ssize_t unpack_readem_11(const void * buffer, size_t size, struct message * message);
+static ssize_t parse_11(const void * buffer, size_t size, uint8_t * gateway, uint32_t * value);
 static ssize_t unpack_readem_14(const void * buffer, size_t size, struct message * message);
-static ssize_t unpack_readem_19(const void * buffer, size_t size, struct message * message);
-static ssize_t unpack_readem_list_1C(const void * buffer, size_t size, struct message * message);
+static ssize_t unpack_readem_list(const void * buffer, size_t size, struct message * message, enum tekon_message_type type);
+static ssize_t view_list(struct tekon_view * view, const uint8_t * ptr, enum tekon_message_type type);
+static inline ssize_t decode_list(const uint8_t * ptr, size_t size, enum tekon_message_type type,
+                                  uint8_t * values, size_t vstride, uint8_t * quals, size_t qstride,
+                                  uint8_t * gateway, uint8_t * nelements);
 static int validate(const void * buffer, ssize_t ssize);
+static uint16_t read_u16(const uint8_t * ptr);
 
 /* Записть сообщение в буфер
  * В случае успеха возврщает кол-во прочитанных байт
  * 0 - ошибка */
-ssize_t tekon_resp_unpack(const void * buffer, size_t size, struct message * message, enum tekon_message_type type, uint8_t * number)
+static ssize_t resp_unpack(const void * buffer, size_t size, struct message * message, enum tekon_message_type type, uint8_t * number)
 {
     assert(buffer);
     assert(size);
@@ -44,13 +37,23 @@ ssize_t tekon_resp_unpack(const void * buffer, size_t size, struct message * mes
      * - номер посылки имеет фискированное положение (2 байт для фикс. сообщ. и 5
      * для переменныз сообщ.) */
 
+    const uint8_t * ptr = buffer;
+    const uint8_t start = ptr[0];
+
+    /* Списки значений проверяются и разбираются за один проход */
+    if(start == TEKON_PROTO_VAR_PREFIX &&
+            (type == TEKON_MSG_READEM_IND_LIST_19 || type == TEKON_MSG_READEM_PAR_LIST_1C)) {
+        const ssize_t len = unpack_readem_list(buffer, size, message, type);
+        if(len && number)
+            *number = ptr[4] & 0x0F;
+        return len;
+    }
+
     /* Грубая проверка - длина + КС */
     if(!validate(buffer,size))
         return 0;
 
     /* Самый простой вариант - подтверждение */
-    const uint8_t * ptr = buffer;
-    const uint8_t start = ptr[0];
 
     if(start == TEKON_PROTO_POS_ACK || start == TEKON_PROTO_NEG_ACK) {
         tekon_resp_ack(message, start == TEKON_PROTO_POS_ACK);
@@ -72,9 +75,8 @@ ssize_t tekon_resp_unpack(const void * buffer, size_t size, struct message * mes
     case TEKON_MSG_READEM_PAR_11:
         return unpack_readem_11(buffer, size, message);
     case TEKON_MSG_READEM_IND_LIST_19:
-        return unpack_readem_19(buffer, size, message);
     case TEKON_MSG_READEM_PAR_LIST_1C:
-        return unpack_readem_list_1C(buffer, size, message);
+        return unpack_readem_list(buffer, size, message, type);
     case TEKON_MSG_WRITEM_PAR_14:
         return unpack_readem_14(buffer, size, message);
     case TEKON_MSG_POS_ACK:
@@ -85,6 +87,328 @@ ssize_t tekon_resp_unpack(const void * buffer, size_t size, struct message * mes
     return 0;
 }
 
+ssize_t tekon_resp_unpack(const void * buffer, size_t size, struct message * message, enum tekon_message_type type, uint8_t * number)
+{
+    TEKON_TRACE_BEGIN(TEKON_TRACE_RESP_UNPACK);
+    const ssize_t result = resp_unpack(buffer, size, message, type, number);
+    TEKON_TRACE_END(TEKON_TRACE_RESP_UNPACK, result);
+    return result;
+}
+
+static ssize_t resp_view(struct tekon_view * view, const void * buffer, size_t size, enum tekon_message_type type, uint8_t * number)
+{
+    assert(view);
+    assert(buffer);
+
+    if(!(type == TEKON_MSG_READEM_IND_LIST_19 || type == TEKON_MSG_READEM_PAR_LIST_1C))
+        return 0;
+
+    if(!validate(buffer, size))
+        return 0;
+
+    const uint8_t * ptr = buffer;
+    if(ptr[0] == TEKON_PROTO_POS_ACK || ptr[0] == TEKON_PROTO_NEG_ACK) {
+        memset(view, 0, sizeof(*view));
+        view->type = ptr[0] == TEKON_PROTO_POS_ACK ? TEKON_MSG_POS_ACK : TEKON_MSG_NEG_ACK;
+        return 1;
+    }
+
+    const ssize_t len = view_list(view, ptr, type);
+    if(len && number)
+        *number = ptr[4] & 0x0F;
+    return len;
+}
+
+ssize_t tekon_resp_view(struct tekon_view * view, const void * buffer, size_t size, enum tekon_message_type type, uint8_t * number)
+{
+    TEKON_TRACE_BEGIN(TEKON_TRACE_RESP_UNPACK);
+    const ssize_t result = resp_view(view, buffer, size, type, number);
+    TEKON_TRACE_END(TEKON_TRACE_RESP_UNPACK, result);
+    return result;
+}
+
+static ssize_t resp_unpack_sink(const void * buffer, size_t size, enum tekon_message_type type, size_t nelements,
+                                tekon_sink_fn sink, void * ctx, uint8_t * number)
+{
+    struct tekon_view view;
+    uint8_t gateway;
+    uint32_t value;
+    ssize_t len = 0;
+    size_t i;
+
+    if(!validate(buffer, size))
+        return 0;
+
+    const uint8_t * ptr = buffer;
+    if(ptr[0] != TEKON_PROTO_VAR_PREFIX)
+        return 0;
+
+    switch(type) {
+    case TEKON_MSG_READEM_PAR_11:
+        if(nelements > 1 || !(len = parse_11(buffer, size, &gateway, &value)))
+            return 0;
+        sink(ctx, 0, value, 0);
+        break;
+    case TEKON_MSG_READEM_IND_LIST_19:
+    case TEKON_MSG_READEM_PAR_LIST_1C:
+        if(!(len = view_list(&view, ptr, type)) ||
+                (nelements && view.nelements != nelements))
+            return 0;
+        for(i = 0; i < view.nelements; i++)
+            sink(ctx, i, tekon_view_value(&view, i), tekon_view_qual(&view, i));
+        break;
+    default:
+        return 0;
+    }
+
+    if(number)
+        *number = ptr[4] & 0x0F;
+    return len;
+}
+
+ssize_t tekon_resp_unpack_sink(const void * buffer, size_t size, enum tekon_message_type type, size_t nelements,
+                               tekon_sink_fn sink, void * ctx, uint8_t * number)
+{
+    assert(buffer);
+    assert(sink);
+
+    TEKON_TRACE_BEGIN(TEKON_TRACE_RESP_UNPACK);
+    const ssize_t result = resp_unpack_sink(buffer, size, type, nelements, sink, ctx, number);
+    TEKON_TRACE_END(TEKON_TRACE_RESP_UNPACK, result);
+    return result;
+}
+
+static ssize_t soa_resp_unpack(const void * buffer, size_t size, struct message_soa * message, enum tekon_message_type type, uint8_t * number)
+{
+    assert(buffer);
+    assert(message);
+
+    const uint8_t * ptr = buffer;
+    uint8_t gateway;
+    uint8_t nelements;
+    uint32_t value;
+    ssize_t len;
+
+    /* Списки значений проверяются и разбираются за один проход */
+    if(size && ptr[0] == TEKON_PROTO_VAR_PREFIX &&
+            (type == TEKON_MSG_READEM_IND_LIST_19 || type == TEKON_MSG_READEM_PAR_LIST_1C)) {
+        len = decode_list(ptr, size, type, (uint8_t *)message->values, sizeof(*message->values),
+                          message->quals, sizeof(*message->quals), &gateway, &nelements);
+        if(!len)
+            return 0;
+        message->type = type;
+        message->dir = TEKON_DIR_IN;
+        message->gateway = gateway;
+        message->nelements = nelements;
+        if(number)
+            *number = ptr[4] & 0x0F;
+        return len;
+    }
+
+    if(!validate(buffer, size))
+        return 0;
+
+    if(ptr[0] == TEKON_PROTO_POS_ACK || ptr[0] == TEKON_PROTO_NEG_ACK) {
+        tekon_soa_resp_ack(message, ptr[0] == TEKON_PROTO_POS_ACK);
+        return 1;
+    }
+
+    if(ptr[0] != TEKON_PROTO_VAR_PREFIX || type != TEKON_MSG_READEM_PAR_11)
+        return 0;
+
+    if(!(len = parse_11(buffer, size, &gateway, &value)) ||
+            !tekon_soa_resp_11(message, gateway, value))
+        return 0;
+
+    if(number)
+        *number = ptr[4] & 0x0F;
+    return len;
+}
+
+ssize_t tekon_soa_resp_unpack(const void * buffer, size_t size, struct message_soa * message, enum tekon_message_type type, uint8_t * number)
+{
+    TEKON_TRACE_BEGIN(TEKON_TRACE_RESP_UNPACK);
+    const ssize_t result = soa_resp_unpack(buffer, size, message, type, number);
+    TEKON_TRACE_END(TEKON_TRACE_RESP_UNPACK, result);
+    return result;
+}
+
+int tekon_resp_number(const void * buffer, size_t size, uint8_t * number)
+{
+    assert(buffer);
+    assert(number);
+
+    if(!validate(buffer, size))
+        return 0;
+
+    const uint8_t * ptr = buffer;
+    switch(ptr[0]) {
+    case TEKON_PROTO_FIX_PREFIX:
+        *number = ptr[1] & 0x0F;
+        return 1;
+    case TEKON_PROTO_VAR_PREFIX:
+        *number = ptr[4] & 0x0F;
+        return 1;
+    }
+    return 0;
+}
+
+static ssize_t req_unpack(const void * buffer, size_t size, struct message * message, uint8_t * number)
+{
+    assert(buffer);
+    assert(message);
+
+    if(!validate(buffer, size))
+        return 0;
+
+    const uint8_t * ptr = buffer;
+
+    /* Фиксированная посылка: 0x10 C A 0x11 dev addr addr crc 0x16 */
+    if(ptr[0] == TEKON_PROTO_FIX_PREFIX) {
+        if(ptr[3] != 0x11 ||
+                !tekon_req_11(message, ptr[2], ptr[4], read_u16(ptr + 5)))
+            return 0;
+        if(number)
+            *number = ptr[1] & 0x0F;
+        return 9;
+    }
+
+    if(ptr[0] != TEKON_PROTO_VAR_PREFIX)
+        return 0;
+
+    /* Переменная посылка: 0x68 L L 0x68 C A code data... crc 0x16 */
+    const uint8_t len = ptr[1];
+    const uint8_t gateway = ptr[5];
+    const uint8_t * data = ptr + 7;
+    const size_t dlen = len - 3;
+    size_t i;
+
+    switch(ptr[6]) {
+    case 0x14:
+        if(dlen < 4 || !tekon_req_14(message, gateway, data, dlen))
+            return 0;
+        break;
+    case 0x19:
+        if(dlen != 6 || data[5] == 0 ||
+                !tekon_req_19(message, gateway, data[0], read_u16(data + 1), read_u16(data + 3), data[5]))
+            return 0;
+        break;
+    case 0x1C: {
+        const size_t nelem = dlen / 6;
+        uint8_t devices[TEKON_PROTO_PLIST_SIZE];
+        uint16_t addresses[TEKON_PROTO_PLIST_SIZE];
+        uint16_t indexes[TEKON_PROTO_PLIST_SIZE];
+
+        if(dlen % 6 != 0 || nelem == 0 || nelem > TEKON_PROTO_PLIST_SIZE)
+            return 0;
+
+        for(i = 0; i < nelem; i++, data += 6) {
+            devices[i] = data[0];
+            addresses[i] = read_u16(data + 1);
+            indexes[i] = data[5] ? read_u16(data + 3) : TEKON_INVALID_INDEX;
+        }
+
+        if(!tekon_req_1c(message, gateway, devices, addresses, indexes, nelem))
+            return 0;
+    }
+    break;
+    default:
+        return 0;
+    }
+
+    if(number)
+        *number = ptr[4] & 0x0F;
+    return len + 6;
+}
+
+ssize_t tekon_req_unpack(const void * buffer, size_t size, struct message * message, uint8_t * number)
+{
+    TEKON_TRACE_BEGIN(TEKON_TRACE_REQ_UNPACK);
+    const ssize_t result = req_unpack(buffer, size, message, number);
+    TEKON_TRACE_END(TEKON_TRACE_REQ_UNPACK, result);
+    return result;
+}
+
+static ssize_t soa_req_unpack(const void * buffer, size_t size, struct message_soa * message, uint8_t * number)
+{
+    assert(buffer);
+    assert(message);
+
+    if(!validate(buffer, size))
+        return 0;
+
+    const uint8_t * ptr = buffer;
+
+    if(ptr[0] == TEKON_PROTO_FIX_PREFIX) {
+        if(ptr[3] != 0x11 ||
+                !tekon_soa_req_11(message, ptr[2], ptr[4], read_u16(ptr + 5)))
+            return 0;
+        if(number)
+            *number = ptr[1] & 0x0F;
+        return 9;
+    }
+
+    if(ptr[0] != TEKON_PROTO_VAR_PREFIX)
+        return 0;
+
+    const uint8_t len = ptr[1];
+    const uint8_t gateway = ptr[5];
+    const uint8_t * data = ptr + 7;
+    const size_t dlen = len - 3;
+    size_t i;
+
+    switch(ptr[6]) {
+    case 0x19:
+        if(dlen != 6 || data[5] == 0 ||
+                !tekon_soa_req_19(message, gateway, data[0], read_u16(data + 1), read_u16(data + 3), data[5]))
+            return 0;
+        break;
+    case 0x1C: {
+        /* Элементы разбираются сразу в массивы сообщения */
+        const size_t nelem = dlen / 6;
+
+        if(dlen % 6 != 0 || nelem == 0 || nelem > TEKON_PROTO_PLIST_SIZE ||
+                gateway == TEKON_INVALID_DEV_ADDR)
+            return 0;
+
+        for(i = 0; i < nelem; i++, data += 6) {
+            if(data[0] == TEKON_INVALID_DEV_ADDR)
+                return 0;
+            message->devices[i] = data[0];
+            message->addresses[i] = read_u16(data + 1);
+            message->indexes[i] = data[5] ? read_u16(data + 3) : TEKON_INVALID_INDEX;
+        }
+
+        message->type = TEKON_MSG_READEM_PAR_LIST_1C;
+        message->dir = TEKON_DIR_OUT;
+        message->gateway = gateway;
+        message->nelements = nelem;
+    }
+    break;
+    default:
+        return 0;
+    }
+
+    if(number)
+        *number = ptr[4] & 0x0F;
+    return len + 6;
+}
+
+ssize_t tekon_soa_req_unpack(const void * buffer, size_t size, struct message_soa * message, uint8_t * number)
+{
+    TEKON_TRACE_BEGIN(TEKON_TRACE_REQ_UNPACK);
+    const ssize_t result = soa_req_unpack(buffer, size, message, number);
+    TEKON_TRACE_END(TEKON_TRACE_REQ_UNPACK, result);
+    return result;
+}
+
+static uint16_t read_u16(const uint8_t * ptr)
+{
+    uint16_t u16;
+    memcpy(&u16, ptr, sizeof(u16));
+    return u16;
+}
+
 static int validate(const void * buffer, ssize_t size)
 {
 
@@ -129,42 +453,37 @@ static int validate(const void * buffer, ssize_t size)
 }
 
 
-static ssize_t unpack_readem_11(const void * buffer, size_t size, struct message * message)
+/* Разобрать ответ 0x11: 0x68 L L 0x68 C A value crc 0x16 (value до 4 байт)
+ * В случае успеха возврщает кол-во прочитанных байт
+ * 0 - ошибка */
+static ssize_t parse_11(const void * buffer, size_t size, uint8_t * gateway, uint32_t * value)
 {
-    struct buffer_reader reader;
-    buffer_reader_init(&reader, buffer, size);
+    /* Посылка уже проверена validate: не короче 9 байт */
     const uint8_t * ptr = buffer;
-    uint8_t start1 = 0;
-    uint8_t start2 = 0;
-    uint8_t len1 = 0;
-    uint8_t len2 = 0;
-    uint8_t num = 0;
-    uint8_t gateway = 0;
-
-    uint32_t value = 0;
-
-    buffer_reader_u8(&reader, &start1);
-    buffer_reader_u8(&reader, &len1);
-    buffer_reader_u8(&reader, &len2);
-    buffer_reader_u8(&reader, &start2);
-    buffer_reader_u8(&reader, &num);
-    buffer_reader_u8(&reader, &gateway);
-
-    if(start1 != start2 || start1 != TEKON_PROTO_VAR_PREFIX)
+    const uint8_t len = ptr[1];
+
+    *gateway = ptr[5];
+    *value = 0;
+
+    if(ptr[0] != ptr[3] || ptr[0] != TEKON_PROTO_VAR_PREFIX)
         return 0;
 
-    if(len1 != len2 || len1 < 3)
+    if(len != ptr[2] || len < 3 || len - 2u > sizeof(*value))
         return 0;
 
-    len1 -= 2;
+    memcpy(value, ptr + 6, len - 2u);
+    return len + 6;
+}
 
-    if (len1 > sizeof(value))
-        return 0;
+static ssize_t unpack_readem_11(const void * buffer, size_t size, struct message * message)
+{
+    uint8_t gateway;
+    uint32_t value;
 
-    const uint8_t *data = &ptr[6];
-    memcpy(&value, data, len1);
-    tekon_resp_11(message, gateway, value);
-    return len1 + 8;
+    const ssize_t len = parse_11(buffer, size, &gateway, &value);
+    if(len)
+        tekon_resp_11(message, gateway, value);
+    return len;
 }
 
 static ssize_t unpack_readem_14(const void * buffer, size_t size, struct message * message)
@@ -173,179 +492,141 @@ static ssize_t unpack_readem_14(const void * buffer, size_t size, struct message
     if(size == 1) {
         tekon_resp_ack(message, *ptr == TEKON_MSG_POS_ACK);
         return 1;
-    } else {
-        struct buffer_reader reader;
-        buffer_reader_init(&reader, buffer, size);
-        uint8_t start1 = 0;
-        uint8_t start2 = 0;
-        uint8_t len1 = 0;
-        uint8_t len2 = 0;
-        uint8_t num = 0;
-        uint8_t gateway = 0;
-        uint8_t level = 0;
-
-        buffer_reader_u8(&reader, &start1);
-        buffer_reader_u8(&reader, &len1);
-        buffer_reader_u8(&reader, &len2);
-        buffer_reader_u8(&reader, &start2);
-        buffer_reader_u8(&reader, &num);
-        buffer_reader_u8(&reader, &gateway);
-        buffer_reader_u8(&reader, &level);
-
-        if(start1 == TEKON_PROTO_VAR_PREFIX &&
-                start1 == start2 &&
-                len1 == 3 &&
-                len1 == len2 &&
-                gateway != TEKON_INVALID_DEV_ADDR) {
-            message->gateway = gateway;
-            message->nelements = 1;
-            message->payload.bytes[0] = level;
-            message->type = TEKON_MSG_WRITEM_PAR_14;
-            message->dir = TEKON_DIR_IN;
-            return 9;
-        }
+    }
 
+    /* 0x68 3 3 0x68 C A level crc 0x16 */
+    if(ptr[0] == TEKON_PROTO_VAR_PREFIX &&
+            ptr[0] == ptr[3] &&
+            ptr[1] == 3 &&
+            ptr[1] == ptr[2] &&
+            ptr[5] != TEKON_INVALID_DEV_ADDR) {
+        message->gateway = ptr[5];
+        message->nelements = 1;
+        message->payload.bytes[0] = ptr[6];
+        message->type = TEKON_MSG_WRITEM_PAR_14;
+        message->dir = TEKON_DIR_IN;
+        return 9;
     }
 
     return 0;
-
 }
 
-static ssize_t unpack_readem_19(const void * buffer, size_t size, struct message * message)
+/* Разобрать список значений 0x19 / 0x1C проверенной посылки:
+ * 0x68 L L 0x68 C A data... crc 0x16, где data - значения по 4 байта (0x19)
+ * или значения с байтом качества по 5 байт (0x1C) */
+static ssize_t view_list(struct tekon_view * view, const uint8_t * ptr, enum tekon_message_type type)
 {
-    assert(buffer);
-    assert(message);
+    const size_t stride = type == TEKON_MSG_READEM_IND_LIST_19 ? 4 : 5;
+    const size_t limit = type == TEKON_MSG_READEM_IND_LIST_19 ? TEKON_PROTO_ILIST_SIZE : TEKON_PROTO_PLIST_SIZE;
+    const uint8_t len = ptr[1];
 
-    struct buffer_reader reader;
-    buffer_reader_init(&reader, buffer, size);
-    uint8_t start1 = 0;
-    uint8_t start2 = 0;
-    uint8_t len1 = 0;
-    uint8_t len2 = 0;
-    uint8_t num = 0;
-    uint8_t gateway = 0;
-
-    uint32_t values[TEKON_PROTO_ILIST_SIZE] = {0};
-
-    buffer_reader_u8(&reader, &start1);
-    buffer_reader_u8(&reader, &len1);
-    buffer_reader_u8(&reader, &len2);
-    buffer_reader_u8(&reader, &start2);
-    buffer_reader_u8(&reader, &num);
-    buffer_reader_u8(&reader, &gateway);
-
-    if(start1 != start2 || start1 != TEKON_PROTO_VAR_PREFIX)
+    if(ptr[0] != TEKON_PROTO_VAR_PREFIX || ptr[3] != TEKON_PROTO_VAR_PREFIX)
         return 0;
 
-    if(len1 != len2 || len1 < 8)
+    /* Минимальная длина посылки */
+    if(len < (stride == 4 ? 8 : 7))
         return 0;
 
-    len1 -= 2;
-
-    if (len1 % 4  != 0)
+    const size_t dlen = len - 2u;
+    if(dlen % stride != 0 || dlen / stride > limit)
         return 0;
 
-    size_t i;
-    const uint8_t nelem = len1 / 4;
-    for(i = 0; i < nelem; i++) {
-        buffer_reader_u32(&reader, &values [i]);
-    }
-
-    tekon_resp_19(message, gateway, values, nelem);
-    return len1 + 8;
+    if(ptr[5] == TEKON_INVALID_DEV_ADDR)
+        return 0;
 
+    view->data = ptr + 6;
+    view->type = type;
+    view->gateway = ptr[5];
+    view->nelements = dlen / stride;
+    view->stride = stride;
+    return len + 6;
 }
 
-static ssize_t unpack_readem_list_1C(const void * buffer, size_t size, struct message * message)
+/* Проверить и разобрать ответ 0x19 / 0x1C за один проход. В отличие от
+ * validate + view_list, КС считается по словам одновременно с чтением
+ * значений: сумма байт значения получается сложением его байт попарно в
+ * 16-битных полях (не больше 510 на элемент, 60 элементов не переполняют
+ * поле). Значения пишутся в values, байты качества в quals с шагом vstride /
+ * qstride байт, поэтому при неверной КС они уже изменены.
+ * В случае успеха возврщает кол-во прочитанных байт
+ * 0 - ошибка */
+static inline ssize_t decode_list(const uint8_t * ptr, size_t size, enum tekon_message_type type,
+                                  uint8_t * values, size_t vstride, uint8_t * quals, size_t qstride,
+                                  uint8_t * gateway, uint8_t * nelements)
 {
-    assert(buffer);
-    assert(message);
-    struct buffer_reader reader;
-    buffer_reader_init(&reader, buffer, size);
-    uint8_t start1 = 0;
-    uint8_t start2 = 0;
-    uint8_t len1 = 0;
-    uint8_t len2 = 0;
-    uint8_t num = 0;
-    uint8_t gateway = 0;
-
-    uint8_t quals[TEKON_PROTO_PLIST_SIZE] = {0};
-    uint32_t values[TEKON_PROTO_PLIST_SIZE] = {0};
-
-    buffer_reader_u8(&reader, &start1);
-    buffer_reader_u8(&reader, &len1);
-    buffer_reader_u8(&reader, &len2);
-    buffer_reader_u8(&reader, &start2);
-    buffer_reader_u8(&reader, &num);
-    buffer_reader_u8(&reader, &gateway);
-
-    if(start1 != start2 || start1 != TEKON_PROTO_VAR_PREFIX)
-        return 0;
+    const uint32_t mask = 0x00FF00FFu;
+    const size_t stride = type == TEKON_MSG_READEM_IND_LIST_19 ? 4 : 5;
+    const size_t limit = type == TEKON_MSG_READEM_IND_LIST_19 ? TEKON_PROTO_ILIST_SIZE : TEKON_PROTO_PLIST_SIZE;
 
-    if(len1 != len2 || len1 < 7)
+    if(size < 9 || ptr[0] != TEKON_PROTO_VAR_PREFIX || ptr[3] != TEKON_PROTO_VAR_PREFIX)
         return 0;
 
-    len1 -= 2;
+    const uint8_t len = ptr[1];
+    if(len != ptr[2] || size < len + 6u || len < (stride == 4 ? 8 : 7))
+        return 0;
 
-    if (len1 % 5  != 0)
+    const size_t dlen = len - 2u;
+    if(dlen % stride != 0 || dlen / stride > limit || ptr[5] == TEKON_INVALID_DEV_ADDR ||
+       ptr[len + 5] != TEKON_PROTO_END)
         return 0;
 
+    const size_t nelem = dlen / stride;
+    const uint8_t * data = ptr + 6;
+    uint32_t value;
     size_t i;
-    const uint8_t nelem = len1 / 5;
-    for(i = 0; i < nelem; i++) {
-        buffer_reader_u32(&reader, &values [i]);
-        buffer_reader_u8(&reader, &quals [i]);
+
+    if(stride == 4) {
+        uint32_t lanes = 0;
+        for(i = 0; i < nelem; i++, data += 4) {
+            memcpy(&value, data, sizeof(value));
+            lanes += (value & mask) + ((value >> 8) & mask);
+            memcpy(values + i * vstride, &value, sizeof(value));
+            quals[i * qstride] = 0;
+        }
+        const uint8_t crc = ptr[4] + ptr[5] + (lanes & 0xFFFF) + (lanes >> 16);
+        if(crc != ptr[len + 4])
+            return 0;
+    } else {
+        /* Элементы по 5 байт не ложатся на слова: КС данных считается
+         * векторно (tekon_crc) перед разбором, пока посылка в кэше */
+        if(tekon_crc(ptr + 4, len) != ptr[len + 4])
+            return 0;
+        for(i = 0; i < nelem; i++, data += 5) {
+            memcpy(&value, data, sizeof(value));
+            memcpy(values + i * vstride, &value, sizeof(value));
+            quals[i * qstride] = data[4];
+        }
     }
 
-    tekon_resp_1c(message, gateway, values, quals, nelem);
-    return len1 + 8;
+    *gateway = ptr[5];
+    *nelements = nelem;
+    return len + 6;
 }
 
-
-static void buffer_reader_init(struct buffer_reader * self, const void * buffer, size_t size)
+static ssize_t unpack_readem_list(const void * buffer, size_t size, struct message * message, enum tekon_message_type type)
 {
-    assert(self);
     assert(buffer);
-    assert(size);
-    self->pos = (char*)buffer;
-    self->avail = size;
-}
-
-/* Запись значений в буфер.
- * 1 - успешно
- * 0 - ошибка */
-static int buffer_reader_u8(struct buffer_reader * self, uint8_t * u8)
-{
-    assert(self);
-    assert(u8);
+    assert(message);
 
-    const size_t size = sizeof(*u8);
+    struct tekon_parameter * param = message->payload.parameters;
+    uint8_t gateway;
+    uint8_t nelements;
 
-    if(self->avail < size)
+    memset(message, 0, sizeof(*message));
+    const ssize_t len = decode_list(buffer, size, type,
+                                    (uint8_t *)&param->value, sizeof(*param),
+                                    &param->qual, sizeof(*param),
+                                    &gateway, &nelements);
+    if(!len)
         return 0;
 
-    memcpy(u8, self->pos, size);
-    self->pos+=size;
-    self->avail-=size;
-    return 1;
+    message->type = type;
+    message->dir = TEKON_DIR_IN;
+    message->gateway = gateway;
+    message->nelements = nelements;
+    return len;
 }
 
-static int buffer_reader_u32(struct buffer_reader * self, uint32_t * u32)
-{
-    assert(self);
-    assert(u32);
-
-    const size_t size = sizeof(*u32);
-
-    if(self->avail < size)
-        return 0;
-
-    memcpy(u32, self->pos, size);
-    self->pos+=size;
-    self->avail-=size;
-    return 1;
-
-}
 
 
 #ifdef __cplusplus
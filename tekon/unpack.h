@@ -10,6 +10,8 @@
 extern "C" {
 #endif
 
+#include <assert.h>
+#include <string.h>
 #include <sys/types.h>
 #include "tekon/message.h"
 
@@ -18,6 +20,93 @@ extern "C" {
  * 0 - ошибка */
 ssize_t tekon_resp_unpack(const void * buffer, size_t size, struct message * message, enum tekon_message_type type, uint8_t * number);
 
+/* Представление ответа 0x19 / 0x1C без копирования данных. Указывает на
+ * элементы в принятой посылке и действительно, пока жив ее буфер.
+ * Для квитанций type - TEKON_MSG_POS_ACK / TEKON_MSG_NEG_ACK, элементов нет */
+struct tekon_view {
+    const uint8_t * data;  /* первый элемент */
+    enum tekon_message_type type;
+    uint8_t gateway;
+    uint8_t nelements;
+    uint8_t stride;        /* размер элемента: 4 - 0x19, 5 - 0x1C */
+};
+
+/* Проверить ответ 0x19 / 0x1C (длина, КС, формат) и построить представление
+ * за один проход. Значения не копируются.
+ * В случае успеха возврщает кол-во прочитанных байт
+ * 0 - ошибка */
+ssize_t tekon_resp_view(struct tekon_view * view, const void * buffer, size_t size, enum tekon_message_type type, uint8_t * number);
+
+/* Доступ к элементам вызывается на каждое значение, поэтому функции
+ * встраиваемые */
+
+/* Значение и байт качества элемента index (< nelements). Для 0x19 качество
+ * всегда 0 */
+static inline uint32_t tekon_view_value(const struct tekon_view * self, size_t index)
+{
+    assert(index < self->nelements);
+    uint32_t value;
+    memcpy(&value, self->data + index * self->stride, sizeof(value));
+    return value;
+}
+
+static inline uint8_t tekon_view_qual(const struct tekon_view * self, size_t index)
+{
+    assert(index < self->nelements);
+    return self->stride == 5 ? self->data[index * 5 + 4] : 0;
+}
+
+/* Перебор элементов. pos - позиция перебора, перед первым вызовом 0.
+ * 1 - элемент прочитан
+ * 0 - элементы закончились */
+static inline int tekon_view_next(const struct tekon_view * self, size_t * pos, uint32_t * value, uint8_t * qual)
+{
+    if(*pos >= self->nelements)
+        return 0;
+
+    *value = tekon_view_value(self, *pos);
+    *qual = tekon_view_qual(self, *pos);
+    (*pos)++;
+    return 1;
+}
+
+/* Приемник значений ответа. Вызывается для каждого элемента ответа по
+ * порядку, index - номер элемента в ответе */
+typedef void (*tekon_sink_fn)(void * ctx, size_t index, uint32_t value, uint8_t qual);
+
+/* Разобрать ответ 0x11 / 0x19 / 0x1C, передавая значения приемнику sink
+ * прямо из посылки, без struct message. Посылка проверяется целиком до
+ * передачи первого значения. Если nelements не 0, то кол-во элементов
+ * ответа должно совпадать с ним (кол-вом элементов запроса).
+ * В случае успеха возврщает кол-во прочитанных байт
+ * 0 - ошибка или квитанция (значений нет) */
+ssize_t tekon_resp_unpack_sink(const void * buffer, size_t size, enum tekon_message_type type, size_t nelements,
+                               tekon_sink_fn sink, void * ctx, uint8_t * number);
+
+/* Разобрать ответ 0x11 / 0x19 / 0x1C или квитанцию в компактное
+ * представление. Заполняются только первые nelements значений и байт
+ * качества.
+ * В случае успеха возврщает кол-во прочитанных байт
+ * 0 - ошибка */
+ssize_t tekon_soa_resp_unpack(const void * buffer, size_t size, struct message_soa * message, enum tekon_message_type type, uint8_t * number);
+
+/* Извлечь номер посылки из ответа без его разбора. Нужен для сопоставления
+ * ответов и запросов, когда в сети одновременно находится несколько посылок.
+ * 1 - успешно
+ * 0 - ошибка или сообщение без номера (квитанция) */
+int tekon_resp_number(const void * buffer, size_t size, uint8_t * number);
+
+/* Разобрать запрос (сторона шлюза). Используется эмулятором шлюза.
+ * В случае успеха возврщает кол-во прочитанных байт
+ * 0 - ошибка */
+ssize_t tekon_req_unpack(const void * buffer, size_t size, struct message * message, uint8_t * number);
+
+/* Разобрать запрос 0x11 / 0x19 / 0x1C в компактное представление.
+ * Запросы 0x14 не поддерживаются
+ * В случае успеха возврщает кол-во прочитанных байт
+ * 0 - ошибка */
+ssize_t tekon_soa_req_unpack(const void * buffer, size_t size, struct message_soa * message, uint8_t * number);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,429 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+/* Скорость кодека: построение сообщений, упаковка запросов, разбор ответов и
+ * расчет контрольной суммы для всех типов сообщений и размеров списков.
+ *
+ * Результат выводится в формате CSV, по строке на операцию и размер:
+ * op,type,nelements,bytes,iterations,ns_per_frame,bytes_per_sec
+ * bytes - размер посылки, которую строит или разбирает операция. Операции
+ * req_pack8 и pack_batch пишут за вызов BENCH_BATCH посылок подряд, время
+ * приводится на одну посылку.
+ * Запуск: bench_codec [iterations] [op] */
+
+#include "tekon/tekon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_GATEWAY 2
+#define BENCH_DEVICE  3
+#define BENCH_BATCH   8
+
+/* Подготовленные данные одного замера */
+struct bench_ctx {
+    size_t nelements;
+    uint8_t devices[TEKON_PROTO_ILIST_SIZE];
+    uint16_t addresses[TEKON_PROTO_ILIST_SIZE];
+    uint16_t indexes[TEKON_PROTO_ILIST_SIZE];
+    uint32_t values[TEKON_PROTO_ILIST_SIZE];
+    uint8_t quals[TEKON_PROTO_ILIST_SIZE];
+    uint8_t cmd[9];
+    struct message request;
+    struct message response;
+    struct message out;
+    struct message_soa soa_request;
+    struct message_soa soa_out;
+    uint8_t req[512];
+    size_t reqlen;
+    uint8_t resp[512];
+    size_t resplen;
+    uint8_t buffer[512];
+    const struct message * batch[BENCH_BATCH];
+    uint8_t numbers[BENCH_BATCH];
+    size_t offsets[BENCH_BATCH + 1];
+    uint8_t packet[BENCH_BATCH * 512];
+};
+
+/* Операция. Возвращает значение, зависящее от результата, чтобы компилятор
+ * не выбросил вызов */
+typedef uint32_t (*bench_fn)(struct bench_ctx * ctx);
+
+struct bench_op {
+    const char * name;
+    enum tekon_message_type type;
+    int response; /* размер берется из ответа */
+    size_t min;   /* мин. кол-во элементов */
+    bench_fn run;
+    size_t frames; /* кол-во посылок за вызов */
+};
+
+static volatile uint32_t sink;
+
+static uint32_t build_req_11(struct bench_ctx * ctx)
+{
+    return tekon_req_11(&ctx->out, BENCH_GATEWAY, BENCH_DEVICE, 0x8000);
+}
+
+static uint32_t build_req_14(struct bench_ctx * ctx)
+{
+    return tekon_req_14(&ctx->out, BENCH_GATEWAY, ctx->cmd, sizeof(ctx->cmd));
+}
+
+static uint32_t build_req_19(struct bench_ctx * ctx)
+{
+    return tekon_req_19(&ctx->out, BENCH_GATEWAY, BENCH_DEVICE, 0x0100, 0, ctx->nelements);
+}
+
+static uint32_t build_req_1c(struct bench_ctx * ctx)
+{
+    return tekon_req_1c(&ctx->out, BENCH_GATEWAY, ctx->devices, ctx->addresses, ctx->indexes, ctx->nelements);
+}
+
+static uint32_t build_resp_ack(struct bench_ctx * ctx)
+{
+    return tekon_resp_ack(&ctx->out, 1);
+}
+
+static uint32_t build_resp_11(struct bench_ctx * ctx)
+{
+    return tekon_resp_11(&ctx->out, BENCH_GATEWAY, ctx->values[0]);
+}
+
+static uint32_t build_resp_19(struct bench_ctx * ctx)
+{
+    return tekon_resp_19(&ctx->out, BENCH_GATEWAY, ctx->values, ctx->nelements);
+}
+
+static uint32_t build_resp_1c(struct bench_ctx * ctx)
+{
+    return tekon_resp_1c(&ctx->out, BENCH_GATEWAY, ctx->values, ctx->quals, ctx->nelements);
+}
+
+/* Компактное представление struct message_soa */
+static uint32_t build_req_soa_19(struct bench_ctx * ctx)
+{
+    return tekon_soa_req_19(&ctx->soa_out, BENCH_GATEWAY, BENCH_DEVICE, 0x0100, 0, ctx->nelements);
+}
+
+static uint32_t build_req_soa_1c(struct bench_ctx * ctx)
+{
+    return tekon_soa_req_1c(&ctx->soa_out, BENCH_GATEWAY, ctx->devices, ctx->addresses, ctx->indexes, ctx->nelements);
+}
+
+static uint32_t build_resp_soa_1c(struct bench_ctx * ctx)
+{
+    return tekon_soa_resp_1c(&ctx->soa_out, BENCH_GATEWAY, ctx->values, ctx->quals, ctx->nelements);
+}
+
+static uint32_t soa_req_pack(struct bench_ctx * ctx)
+{
+    return tekon_soa_req_pack(ctx->buffer, sizeof(ctx->buffer), &ctx->soa_request, 1);
+}
+
+static uint32_t soa_resp_unpack(struct bench_ctx * ctx)
+{
+    return tekon_soa_resp_unpack(ctx->resp, ctx->resplen, &ctx->soa_out, ctx->request.type, NULL);
+}
+
+static uint32_t req_pack(struct bench_ctx * ctx)
+{
+    return tekon_req_pack(ctx->buffer, sizeof(ctx->buffer), &ctx->request, 1);
+}
+
+/* BENCH_BATCH запросов подряд в один буфер: по одному и пакетом */
+static uint32_t req_pack_loop(struct bench_ctx * ctx)
+{
+    size_t offset = 0;
+    size_t i;
+    for(i = 0; i < BENCH_BATCH; i++) {
+        const ssize_t len = tekon_req_pack(ctx->packet + offset, sizeof(ctx->packet) - offset, ctx->batch[i], ctx->numbers[i]);
+        if(len <= 0)
+            return 0;
+        offset += len;
+    }
+    return offset;
+}
+
+static uint32_t req_pack_batch(struct bench_ctx * ctx)
+{
+    const size_t n = tekon_req_pack_batch(ctx->packet, sizeof(ctx->packet), ctx->batch, ctx->numbers, BENCH_BATCH, ctx->offsets);
+    return n == BENCH_BATCH ? ctx->offsets[n] : 0;
+}
+
+static uint32_t resp_unpack(struct bench_ctx * ctx)
+{
+    return tekon_resp_unpack(ctx->resp, ctx->resplen, &ctx->out, ctx->request.type, NULL);
+}
+
+/* Разбор без копирования: проверка посылки и чтение всех значений */
+static uint32_t resp_view(struct bench_ctx * ctx)
+{
+    struct tekon_view view;
+    uint32_t acc = 0;
+    uint32_t value;
+    uint8_t qual;
+    size_t pos = 0;
+
+    if(!tekon_resp_view(&view, ctx->resp, ctx->resplen, ctx->request.type, NULL))
+        return 0;
+    while(tekon_view_next(&view, &pos, &value, &qual))
+        acc += value + qual;
+    return acc | 1;
+}
+
+static void sink_value(void * ctx, size_t index, uint32_t value, uint8_t qual)
+{
+    uint32_t * acc = ctx;
+    *acc += value + qual;
+}
+
+/* Разбор с передачей значений приемнику */
+static uint32_t resp_sink(struct bench_ctx * ctx)
+{
+    uint32_t acc = 0;
+
+    if(!tekon_resp_unpack_sink(ctx->resp, ctx->resplen, ctx->request.type, 0, sink_value, &acc, NULL))
+        return 0;
+    return acc | 1;
+}
+
+static uint32_t crc(struct bench_ctx * ctx)
+{
+    return tekon_variable_crc(ctx->resp, ctx->resplen);
+}
+
+/* КС без SIMD: побайтно и по 8 байт за шаг */
+static uint32_t crc_bytes(struct bench_ctx * ctx)
+{
+    return tekon_crc_bytes(ctx->resp + 4, ctx->resplen - 6);
+}
+
+static uint32_t crc_words(struct bench_ctx * ctx)
+{
+    return tekon_crc_words(ctx->resp + 4, ctx->resplen - 6);
+}
+
+static const struct bench_op ops[] = {
+    {"build_req",   TEKON_MSG_READEM_PAR_11,      0, 1, build_req_11, 1},
+    {"build_req",   TEKON_MSG_WRITEM_PAR_14,      0, 1, build_req_14, 1},
+    {"build_req",   TEKON_MSG_READEM_IND_LIST_19, 0, 1, build_req_19, 1},
+    {"build_req",   TEKON_MSG_READEM_PAR_LIST_1C, 0, 1, build_req_1c, 1},
+    {"build_resp",  TEKON_MSG_POS_ACK,            1, 1, build_resp_ack, 1},
+    {"build_resp",  TEKON_MSG_READEM_PAR_11,      1, 1, build_resp_11, 1},
+    {"build_resp",  TEKON_MSG_READEM_IND_LIST_19, 1, 1, build_resp_19, 1},
+    {"build_resp",  TEKON_MSG_READEM_PAR_LIST_1C, 1, 1, build_resp_1c, 1},
+    {"req_pack",    TEKON_MSG_READEM_PAR_11,      0, 1, req_pack, 1},
+    {"req_pack",    TEKON_MSG_WRITEM_PAR_14,      0, 1, req_pack, 1},
+    {"req_pack",    TEKON_MSG_READEM_IND_LIST_19, 0, 1, req_pack, 1},
+    {"req_pack",    TEKON_MSG_READEM_PAR_LIST_1C, 0, 1, req_pack, 1},
+    {"req_pack8",   TEKON_MSG_READEM_PAR_11,      0, 1, req_pack_loop, BENCH_BATCH},
+    {"req_pack8",   TEKON_MSG_READEM_IND_LIST_19, 0, 1, req_pack_loop, BENCH_BATCH},
+    {"req_pack8",   TEKON_MSG_READEM_PAR_LIST_1C, 0, 1, req_pack_loop, BENCH_BATCH},
+    {"pack_batch",  TEKON_MSG_READEM_PAR_11,      0, 1, req_pack_batch, BENCH_BATCH},
+    {"pack_batch",  TEKON_MSG_READEM_IND_LIST_19, 0, 1, req_pack_batch, BENCH_BATCH},
+    {"pack_batch",  TEKON_MSG_READEM_PAR_LIST_1C, 0, 1, req_pack_batch, BENCH_BATCH},
+    {"resp_unpack", TEKON_MSG_POS_ACK,            1, 1, resp_unpack, 1},
+    {"resp_unpack", TEKON_MSG_READEM_PAR_11,      1, 1, resp_unpack, 1},
+    {"resp_unpack", TEKON_MSG_WRITEM_PAR_14,      1, 1, resp_unpack, 1},
+    /* Ответ 0x19 разбирается начиная с 2-х значений */
+    {"resp_unpack", TEKON_MSG_READEM_IND_LIST_19, 1, 2, resp_unpack, 1},
+    {"resp_unpack", TEKON_MSG_READEM_PAR_LIST_1C, 1, 1, resp_unpack, 1},
+    {"resp_view",   TEKON_MSG_READEM_IND_LIST_19, 1, 2, resp_view, 1},
+    {"resp_view",   TEKON_MSG_READEM_PAR_LIST_1C, 1, 1, resp_view, 1},
+    {"resp_sink",   TEKON_MSG_READEM_PAR_11,      1, 1, resp_sink, 1},
+    {"resp_sink",   TEKON_MSG_READEM_IND_LIST_19, 1, 2, resp_sink, 1},
+    {"resp_sink",   TEKON_MSG_READEM_PAR_LIST_1C, 1, 1, resp_sink, 1},
+    {"soa_req",     TEKON_MSG_READEM_IND_LIST_19, 0, 1, build_req_soa_19, 1},
+    {"soa_req",     TEKON_MSG_READEM_PAR_LIST_1C, 0, 1, build_req_soa_1c, 1},
+    {"soa_resp",    TEKON_MSG_READEM_PAR_LIST_1C, 1, 1, build_resp_soa_1c, 1},
+    {"soa_pack",    TEKON_MSG_READEM_PAR_11,      0, 1, soa_req_pack, 1},
+    {"soa_pack",    TEKON_MSG_READEM_IND_LIST_19, 0, 1, soa_req_pack, 1},
+    {"soa_pack",    TEKON_MSG_READEM_PAR_LIST_1C, 0, 1, soa_req_pack, 1},
+    {"soa_unpack",  TEKON_MSG_READEM_PAR_11,      1, 1, soa_resp_unpack, 1},
+    {"soa_unpack",  TEKON_MSG_READEM_IND_LIST_19, 1, 2, soa_resp_unpack, 1},
+    {"soa_unpack",  TEKON_MSG_READEM_PAR_LIST_1C, 1, 1, soa_resp_unpack, 1},
+    {"crc",         TEKON_MSG_READEM_PAR_11,      1, 1, crc, 1},
+    {"crc",         TEKON_MSG_READEM_IND_LIST_19, 1, 1, crc, 1},
+    {"crc",         TEKON_MSG_READEM_PAR_LIST_1C, 1, 1, crc, 1},
+    {"crc_bytes",   TEKON_MSG_READEM_PAR_11,      1, 1, crc_bytes, 1},
+    {"crc_bytes",   TEKON_MSG_READEM_IND_LIST_19, 1, 1, crc_bytes, 1},
+    {"crc_bytes",   TEKON_MSG_READEM_PAR_LIST_1C, 1, 1, crc_bytes, 1},
+    {"crc_words",   TEKON_MSG_READEM_PAR_11,      1, 1, crc_words, 1},
+    {"crc_words",   TEKON_MSG_READEM_IND_LIST_19, 1, 1, crc_words, 1},
+    {"crc_words",   TEKON_MSG_READEM_PAR_LIST_1C, 1, 1, crc_words, 1},
+};
+
+static const char * type_name(enum tekon_message_type type)
+{
+    switch(type) {
+    case TEKON_MSG_POS_ACK:
+    case TEKON_MSG_NEG_ACK:
+        return "ACK";
+    case TEKON_MSG_READEM_PAR_11:
+        return "11";
+    case TEKON_MSG_WRITEM_PAR_14:
+        return "14";
+    case TEKON_MSG_READEM_IND_LIST_19:
+        return "19";
+    case TEKON_MSG_READEM_PAR_LIST_1C:
+        return "1C";
+    default:
+        return "UNK";
+    }
+}
+
+/* Макс. кол-во элементов для типа сообщения */
+static size_t max_elements(enum tekon_message_type type)
+{
+    switch(type) {
+    case TEKON_MSG_READEM_IND_LIST_19:
+        return TEKON_PROTO_ILIST_SIZE;
+    case TEKON_MSG_READEM_PAR_LIST_1C:
+        return TEKON_PROTO_PLIST_SIZE;
+    default:
+        return 1;
+    }
+}
+
+/* Подготовить запрос и ответ заданного типа.
+ * 0 - ошибка */
+static int prepare(struct bench_ctx * ctx, enum tekon_message_type type, size_t nelements)
+{
+    /* Запись регистра и установка уровня доступа */
+    const uint8_t write[9] = {0x08, BENCH_DEVICE, 0x03, 0x17, 0xF0, 0x01, 0x02, 0x03, 0x04};
+    const uint8_t login[8] = {0x07, BENCH_DEVICE, 0x05, 0x03, 0x00, 0x00, 0x00, 0x01};
+    size_t i;
+    int result = 0;
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->nelements = nelements;
+    memcpy(ctx->cmd, write, sizeof(write));
+
+    for(i = 0; i < nelements; i++) {
+        ctx->devices[i] = BENCH_DEVICE;
+        ctx->addresses[i] = 0x8000 + i;
+        ctx->indexes[i] = i;
+        ctx->values[i] = 0x3F800000 + i;
+        ctx->quals[i] = 0;
+    }
+
+    switch(type) {
+    case TEKON_MSG_POS_ACK:
+        result = tekon_req_14(&ctx->request, BENCH_GATEWAY, write, sizeof(write)) &&
+                 tekon_resp_ack(&ctx->response, 1);
+        break;
+    case TEKON_MSG_READEM_PAR_11:
+        result = tekon_req_11(&ctx->request, BENCH_GATEWAY, BENCH_DEVICE, 0x8000) &&
+                 tekon_soa_req_11(&ctx->soa_request, BENCH_GATEWAY, BENCH_DEVICE, 0x8000) &&
+                 tekon_resp_11(&ctx->response, BENCH_GATEWAY, ctx->values[0]);
+        break;
+    case TEKON_MSG_WRITEM_PAR_14:
+        /* Ответ с уровнем доступа */
+        result = tekon_req_14(&ctx->request, BENCH_GATEWAY, login, sizeof(login));
+        ctx->response.gateway = BENCH_GATEWAY;
+        ctx->response.type = TEKON_MSG_WRITEM_PAR_14;
+        ctx->response.nelements = 1;
+        ctx->response.payload.bytes[0] = login[3];
+        break;
+    case TEKON_MSG_READEM_IND_LIST_19:
+        result = tekon_req_19(&ctx->request, BENCH_GATEWAY, BENCH_DEVICE, 0x0100, 0, nelements) &&
+                 tekon_soa_req_19(&ctx->soa_request, BENCH_GATEWAY, BENCH_DEVICE, 0x0100, 0, nelements) &&
+                 tekon_resp_19(&ctx->response, BENCH_GATEWAY, ctx->values, nelements);
+        break;
+    case TEKON_MSG_READEM_PAR_LIST_1C:
+        result = tekon_req_1c(&ctx->request, BENCH_GATEWAY, ctx->devices, ctx->addresses, ctx->indexes, nelements) &&
+                 tekon_soa_req_1c(&ctx->soa_request, BENCH_GATEWAY, ctx->devices, ctx->addresses, ctx->indexes, nelements) &&
+                 tekon_resp_1c(&ctx->response, BENCH_GATEWAY, ctx->values, ctx->quals, nelements);
+        break;
+    default:
+        break;
+    }
+
+    if(!result)
+        return 0;
+
+    const ssize_t reqlen = tekon_req_pack(ctx->req, sizeof(ctx->req), &ctx->request, 1);
+    const ssize_t resplen = tekon_resp_pack(ctx->resp, sizeof(ctx->resp), &ctx->response, 1);
+    if(reqlen <= 0 || resplen <= 0)
+        return 0;
+
+    for(i = 0; i < BENCH_BATCH; i++) {
+        ctx->batch[i] = &ctx->request;
+        ctx->numbers[i] = i;
+    }
+
+    ctx->reqlen = reqlen;
+    ctx->resplen = resplen;
+    return 1;
+}
+
+static int64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Выполнить замер.
+ * 0 - операция завершилась ошибкой */
+static int bench(const struct bench_op * op, size_t nelements, size_t iterations)
+{
+    static struct bench_ctx ctx;
+    uint32_t acc = 0;
+    size_t i;
+
+    if(!prepare(&ctx, op->type, nelements)) {
+        printf("# %s %s %u: can't prepare\n", op->name, type_name(op->type), (unsigned)nelements);
+        return 0;
+    }
+
+    /* Проверка и прогрев */
+    if(!op->run(&ctx)) {
+        printf("# %s %s %u: failed\n", op->name, type_name(op->type), (unsigned)nelements);
+        return 0;
+    }
+
+    const int64_t start = now_ns();
+    for(i = 0; i < iterations; i++)
+        acc += op->run(&ctx);
+    const int64_t elapsed = now_ns() - start;
+
+    sink += acc;
+
+    const size_t bytes = op->response ? ctx.resplen : ctx.reqlen;
+    const double ns = (double)elapsed / (iterations * op->frames);
+    const double rate = ns > 0 ? bytes * 1e9 / ns : 0;
+
+    printf("%s,%s,%u,%u,%u,%.2f,%.0f\n", op->name, type_name(op->type), (unsigned)nelements,
+           (unsigned)bytes, (unsigned)iterations, ns, rate);
+    return 1;
+}
+
+int main(int argc, char * argv[])
+{
+    const size_t iterations = argc > 1 ? (size_t)atol(argv[1]) : 100000;
+    const char * filter = argc > 2 ? argv[2] : NULL;
+    size_t i;
+    size_t n;
+    int result = 1;
+
+    if(iterations == 0) {
+        printf("Usage: %s [iterations] [op]\n", argv[0]);
+        return 1;
+    }
+
+    printf("op,type,nelements,bytes,iterations,ns_per_frame,bytes_per_sec\n");
+
+    for(i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if(filter && strcmp(filter, ops[i].name) != 0)
+            continue;
+        for(n = ops[i].min; n <= max_elements(ops[i].type); n++)
+            result &= bench(&ops[i], n, iterations);
+    }
+
+    return !result;
+}
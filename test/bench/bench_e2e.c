@@ -0,0 +1,437 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+/* Сквозная производительность опроса: логика tekon_msr, tekon_arch и
+ * tekon_sync выполняется в одном процессе с эмулятором шлюзов (test/sim).
+ *
+ * - msr  - одновременный опрос params параметров на gateways шлюзах (poller)
+ * - arch - чтение архива из depth записей с каждого шлюза по очереди
+ *          (pipeline, окно window)
+ * - sync - чтение времени, установка уровня доступа и запись даты/времени
+ *          на каждом шлюзе по очереди
+ *
+ * Каждый сценарий выполняется rounds раз. Для сценария выводятся:
+ * параметров/с, посылок/с (запросы + ответы), p50/p99 задержки запроса и
+ * процессорное время потока опроса на параметр.
+ *
+ * Шлюзы отвечают сразу, поэтому результат отражает накладные расходы самих
+ * утилит и транспорта. Задержки канала можно добавить, запустив tekon_sim
+ * отдельным процессом.
+ * Запуск: bench_e2e [gateways] [params] [depth] [rounds] [window] */
+
+#include "tekon/tekon.h"
+#include "test/sim/sim.h"
+#include "utils/arch/arch.h"
+#include "utils/base/base.h"
+#include "utils/msr/poller.h"
+#include <arpa/inet.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_GATEWAY 2
+#define BENCH_DEVICE  3
+#define BENCH_TIMEOUT 1000
+
+/* Кол-во шлюзов, обслуживаемых одним потоком эмулятора */
+#define BENCH_GATEWAYS_PER_THREAD 25
+
+struct gateway {
+    int socket;
+    uint16_t port;
+    struct sim sim;
+};
+
+struct server {
+    struct gateway * gateways;
+    size_t size;
+    pthread_t thread;
+};
+
+struct result {
+    const char * name;
+    size_t params;
+    int64_t elapsed; /* нс */
+    int64_t cpu;     /* нс */
+    struct stats stats;
+};
+
+static volatile int stop = 0;
+
+static int64_t clock_ns(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void * server_run(void * data)
+{
+    struct server * self = data;
+    struct pollfd fds[BENCH_GATEWAYS_PER_THREAD];
+    uint8_t in[512];
+    uint8_t out[512];
+    struct sockaddr_in peer;
+    size_t i;
+
+    for(i = 0; i < self->size; i++) {
+        fds[i].fd = self->gateways[i].socket;
+        fds[i].events = POLLIN;
+    }
+
+    while(!stop) {
+        if(poll(fds, self->size, 50) <= 0)
+            continue;
+
+        for(i = 0; i < self->size; i++) {
+            struct gateway * gw = &self->gateways[i];
+            socklen_t plen = sizeof(peer);
+            ssize_t len;
+
+            if(!fds[i].revents)
+                continue;
+
+            while((len = recvfrom(gw->socket, in, sizeof(in), MSG_DONTWAIT, (struct sockaddr*)&peer, &plen)) > 0) {
+                const ssize_t rlen = sim_process(&gw->sim, in, len, out, sizeof(out));
+                if(rlen > 0)
+                    sendto(gw->socket, out, rlen, 0, (struct sockaddr*)&peer, plen);
+                plen = sizeof(peer);
+            }
+        }
+    }
+    return NULL;
+}
+
+static int gateway_init(struct gateway * self)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+
+    sim_init(&self->sim, BENCH_GATEWAY);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    self->socket = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if(self->socket < 0 ||
+            bind(self->socket, (struct sockaddr*)&addr, sizeof(addr)) ||
+            getsockname(self->socket, (struct sockaddr*)&addr, &len))
+        return 0;
+
+    self->port = ntohs(addr.sin_port);
+    return 1;
+}
+
+/* Ожидаемое значение параметра (см. sim_get) */
+static uint32_t expected(uint16_t address, uint16_t index)
+{
+    return (uint32_t)address << 16 | index;
+}
+
+static void result_begin(struct result * self, const char * name)
+{
+    memset(self, 0, sizeof(*self));
+    self->name = name;
+    stats_init(&self->stats);
+    self->elapsed = clock_ns(CLOCK_MONOTONIC);
+    self->cpu = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+static void result_end(struct result * self)
+{
+    self->elapsed = clock_ns(CLOCK_MONOTONIC) - self->elapsed;
+    self->cpu = clock_ns(CLOCK_THREAD_CPUTIME_ID) - self->cpu;
+}
+
+static void result_print(const struct result * self)
+{
+    const double sec = self->elapsed / 1e9;
+    const struct hist * latency = &self->stats.stage[STATS_TOTAL];
+    /* Каждый успешный запрос - посылка запроса и ответа */
+    const uint64_t frames = latency->count * 2;
+
+    printf("%-5s params: %-9u frames: %-8u time: %.3f s params/s: %-9.0f frames/s: %-8.0f "
+           "p50: %lld us p99: %lld us cpu/param: %.3f us\n",
+           self->name, (unsigned)self->params, (unsigned)frames, sec,
+           sec > 0 ? self->params / sec : 0, sec > 0 ? frames / sec : 0,
+           (long long)hist_percentile(latency, 50),
+           (long long)hist_percentile(latency, 99),
+           self->params ? self->cpu / 1e3 / self->params : 0);
+}
+
+/* Одновременный опрос всех шлюзов, как tekon_msr с несколькими -a */
+static int bench_msr(struct gateway * gateways, size_t ngateways, size_t nparams, size_t rounds, struct result * result)
+{
+    static struct msr_table table;
+    static struct msr_group groups[MEASURMENT_MAX_GATEWAYS];
+    static struct poller poller;
+    size_t i, j, round;
+    int ok = 1;
+
+    msr_table_init(&table);
+
+    for(i = 0; i < ngateways; i++) {
+        struct msr_group * group = &groups[i];
+        const size_t count = nparams / ngateways + (i < nparams % ngateways);
+
+        memset(group, 0, sizeof(*group));
+        strcpy(group->addr.ip, "127.0.0.1");
+        group->addr.port = gateways[i].port;
+        group->addr.type = LINK_UDP;
+        group->addr.gateway = BENCH_GATEWAY;
+        group->first = msr_table_size(&table);
+
+        for(j = 0; j < count; j++) {
+            struct msr msr;
+            msr_init(&msr, BENCH_GATEWAY, BENCH_DEVICE, 0x8000, j, TEKON_PARAM_U32, 0);
+            msr_table_add(&table, &msr);
+            group->count++;
+        }
+    }
+
+    if(poller_init(&poller, &table, groups, ngateways, BENCH_TIMEOUT) != 0)
+        return 0;
+
+    result_begin(result, "msr");
+    poller.stats = &result->stats;
+
+    for(round = 0; round < rounds && ok; round++)
+        ok = poller_run(&poller) == ngateways;
+
+    result_end(result);
+    poller_close(&poller);
+    result->params = msr_table_size(&table) * round;
+
+    for(i = 0; ok && i < msr_table_size(&table); i++) {
+        const struct msr * msr = msr_table_get(&table, i);
+        ok = msr->qual == Q_OK && msr->value.u32 == expected(msr->address, msr->index);
+    }
+    return ok;
+}
+
+struct arch_ctx {
+    struct archive * archive;
+    int ok;
+};
+
+static size_t chunk_size(size_t pos, size_t lim)
+{
+    const size_t diff = lim - pos;
+    return diff > TEKON_PROTO_PLIST_SIZE ? TEKON_PROTO_PLIST_SIZE : diff;
+}
+
+static int arch_prepare(void * data, size_t index, struct message * request)
+{
+    struct arch_ctx * ctx = data;
+    struct archive * archive = ctx->archive;
+    const size_t pos = index * TEKON_PROTO_PLIST_SIZE;
+    const size_t size = chunk_size(pos, archive_size(archive));
+    uint8_t devices[TEKON_PROTO_PLIST_SIZE];
+    uint16_t addresses[TEKON_PROTO_PLIST_SIZE];
+    uint16_t indexes[TEKON_PROTO_PLIST_SIZE];
+    size_t i;
+
+    for(i = 0; i < size; i++) {
+        devices[i] = archive->address.device;
+        addresses[i] = archive->address.address;
+        indexes[i] = archive_get(archive, pos + i)->index;
+    }
+    return tekon_req_1c(request, archive->address.gateway, devices, addresses, indexes, size);
+}
+
+static void arch_complete(void * data, size_t index, const struct message * response)
+{
+    struct arch_ctx * ctx = data;
+    struct archive * archive = ctx->archive;
+    const size_t pos = index * TEKON_PROTO_PLIST_SIZE;
+    const size_t size = chunk_size(pos, archive_size(archive));
+    size_t i;
+
+    if(!response) {
+        ctx->ok = 0;
+        return;
+    }
+
+    for(i = 0; i < size; i++) {
+        struct rec * rec = archive_get(archive, pos + i);
+        rec_update(rec, Q_OK, &response->payload.parameters[i].value, 4);
+        if(rec->value.u32 != expected(archive->address.address, rec->index))
+            ctx->ok = 0;
+    }
+}
+
+/* Чтение архива с каждого шлюза, как tekon_arch */
+static int bench_arch(struct gateway * gateways, size_t ngateways, size_t depth, size_t rounds, size_t window,
+                      struct result * result)
+{
+    static struct archive archive;
+    static struct pipeline pipeline;
+    struct arch_ctx ctx = {&archive, 1};
+    const size_t nchunks = (depth + TEKON_PROTO_PLIST_SIZE - 1) / TEKON_PROTO_PLIST_SIZE;
+    size_t i, round;
+
+    archive_init(&archive);
+    archive.address.gateway = BENCH_GATEWAY;
+    archive.address.device = BENCH_DEVICE;
+    archive.address.address = 0x0100;
+    if(!archive_alloc(&archive, depth))
+        return 0;
+
+    for(i = 0; i < depth; i++) {
+        struct rec rec;
+        rec_init(&rec, i);
+        if(!archive_add(&archive, &rec))
+            return 0;
+    }
+
+    result_begin(result, "arch");
+
+    for(round = 0; round < rounds && ctx.ok; round++) {
+        for(i = 0; i < ngateways && ctx.ok; i++) {
+            struct link link;
+            link_init_udp(&link, "127.0.0.1", gateways[i].port, BENCH_TIMEOUT);
+            if(link_up(&link) != 0)
+                return 0;
+
+            pipeline_init(&pipeline, &link, window);
+            pipeline.stats = &result->stats;
+            ctx.ok = pipeline_run(&pipeline, nchunks, arch_prepare, arch_complete, &ctx) == nchunks;
+            link_down(&link);
+            result->params += depth;
+        }
+    }
+
+    result_end(result);
+    archive_free(&archive);
+    return ctx.ok;
+}
+
+/* Синхронизация времени на каждом шлюзе, как tekon_sync */
+static int bench_sync(struct gateway * gateways, size_t ngateways, size_t rounds, struct result * result)
+{
+    static struct pipeline pipeline;
+    const uint8_t devices[2] = {BENCH_DEVICE, BENCH_DEVICE};
+    const uint16_t addresses[2] = {0xF017, 0xF018};
+    const uint16_t indexes[2] = {0, 0};
+    const uint8_t login[8] = {0x07, BENCH_DEVICE, 0x05, 0x03, 0x00, 0x00, 0x00, 0x01};
+    uint8_t write_date[9] = {0x08, BENCH_DEVICE, 0x03, 0x17, 0xF0, 0x00, 0x00, 0x00, 0x00};
+    uint8_t write_time[9] = {0x08, BENCH_DEVICE, 0x03, 0x18, 0xF0, 0x00, 0x00, 0x00, 0x00};
+    struct message request;
+    struct message response;
+    size_t i, round;
+    int ok = 1;
+
+    result_begin(result, "sync");
+
+    for(round = 0; round < rounds && ok; round++) {
+        for(i = 0; i < ngateways && ok; i++) {
+            struct link link;
+            link_init_udp(&link, "127.0.0.1", gateways[i].port, BENCH_TIMEOUT);
+            if(link_up(&link) != 0)
+                return 0;
+
+            pipeline_init(&pipeline, &link, 1);
+            pipeline.stats = &result->stats;
+
+            /* Чтение времени. Записывается оно же */
+            ok = tekon_req_1c(&request, BENCH_GATEWAY, devices, addresses, indexes, 2) &&
+                 pipeline_request(&pipeline, &request, &response);
+
+            if(ok) {
+                memcpy(write_date + 5, &response.payload.parameters[0].value, 4);
+                memcpy(write_time + 5, &response.payload.parameters[1].value, 4);
+            }
+
+            ok = ok &&
+                 tekon_req_14(&request, BENCH_GATEWAY, login, sizeof(login)) &&
+                 pipeline_request(&pipeline, &request, &response) &&
+                 tekon_req_14(&request, BENCH_GATEWAY, write_date, sizeof(write_date)) &&
+                 pipeline_request(&pipeline, &request, &response) &&
+                 response.type == TEKON_MSG_POS_ACK &&
+                 tekon_req_14(&request, BENCH_GATEWAY, write_time, sizeof(write_time)) &&
+                 pipeline_request(&pipeline, &request, &response) &&
+                 response.type == TEKON_MSG_POS_ACK;
+
+            link_down(&link);
+            result->params += 4;
+        }
+    }
+
+    result_end(result);
+    return ok;
+}
+
+int main(int argc, char * argv[])
+{
+    const size_t ngateways = argc > 1 ? (size_t)atol(argv[1]) : 100;
+    const size_t nparams = argc > 2 ? (size_t)atol(argv[2]) : 10000;
+    const size_t depth = argc > 3 ? (size_t)atol(argv[3]) : 8192;
+    const size_t rounds = argc > 4 ? (size_t)atol(argv[4]) : 3;
+    const size_t window = argc > 5 ? (size_t)atol(argv[5]) : PIPELINE_MAX_WINDOW;
+    struct result result;
+    size_t i;
+    int ok = 1;
+
+    if(ngateways == 0 || ngateways > MEASURMENT_MAX_GATEWAYS ||
+            nparams < ngateways || nparams > MEASURMENT_MAX_TABLE_SIZE ||
+            depth == 0 || depth > ARCHIVE_MAX_SIZE || rounds == 0 ||
+            window == 0 || window > PIPELINE_MAX_WINDOW) {
+        printf("Usage: %s [gateways 1..%d] [params gateways..%d] [depth 1..%d] [rounds] [window 1..%d]\n",
+               argv[0], MEASURMENT_MAX_GATEWAYS, MEASURMENT_MAX_TABLE_SIZE, ARCHIVE_MAX_SIZE, PIPELINE_MAX_WINDOW);
+        return 1;
+    }
+
+    const size_t nservers = (ngateways + BENCH_GATEWAYS_PER_THREAD - 1) / BENCH_GATEWAYS_PER_THREAD;
+    struct gateway * gateways = calloc(ngateways, sizeof(*gateways));
+    struct server * servers = calloc(nservers, sizeof(*servers));
+
+    if(!gateways || !servers)
+        return 1;
+
+    for(i = 0; i < ngateways; i++) {
+        if(!gateway_init(&gateways[i])) {
+            printf("can't create gateway %u\n", (unsigned)i);
+            return 1;
+        }
+    }
+
+    for(i = 0; i < nservers; i++) {
+        servers[i].gateways = gateways + i * BENCH_GATEWAYS_PER_THREAD;
+        servers[i].size = i + 1 < nservers ? BENCH_GATEWAYS_PER_THREAD : ngateways - i * BENCH_GATEWAYS_PER_THREAD;
+        pthread_create(&servers[i].thread, NULL, server_run, &servers[i]);
+    }
+
+    printf("gateways: %u params: %u depth: %u rounds: %u window: %u\n",
+           (unsigned)ngateways, (unsigned)nparams, (unsigned)depth, (unsigned)rounds, (unsigned)window);
+
+    if(bench_msr(gateways, ngateways, nparams, rounds, &result))
+        result_print(&result);
+    else
+        ok = !printf("msr   failed\n");
+
+    if(bench_arch(gateways, ngateways, depth, rounds, window, &result))
+        result_print(&result);
+    else
+        ok = !printf("arch  failed\n");
+
+    if(bench_sync(gateways, ngateways, rounds, &result))
+        result_print(&result);
+    else
+        ok = !printf("sync  failed\n");
+
+    stop = 1;
+    for(i = 0; i < nservers; i++)
+        pthread_join(servers[i].thread, NULL);
+    for(i = 0; i < ngateways; i++)
+        close(gateways[i].socket);
+
+    free(servers);
+    free(gateways);
+    return !ok;
+}
@@ -0,0 +1,215 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+/* Производительность опроса при искажениях ответов (utils/base/fault.h).
+ * Чтение params параметров запросами 0x1C через конвейер (как tekon_msr с
+ * одним шлюзом) у эмулятора шлюза в отдельном потоке. Ответы теряются с
+ * вероятностью 0, 1, 5 и 20%, последний сценарий - смесь всех видов
+ * искажений.
+ *
+ * Для сценария выводятся параметров/с, доля от скорости без искажений,
+ * счетчики запросов, повторов, таймаутов и искажений. Все значения
+ * проверяются. Программа завершается с ошибкой, если хотя бы один сценарий
+ * не прочитал все параметры: при достаточном числе повторов потери не должны
+ * приводить к отказу опроса.
+ * Запуск: bench_fault [params] [rounds] [window] [retries] [timeout] */
+
+#include "tekon/tekon.h"
+#include "test/sim/sim.h"
+#include "utils/base/base.h"
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_GATEWAY 2
+#define BENCH_DEVICE  3
+#define BENCH_ADDRESS 0x0100
+
+struct gateway {
+    int socket;
+    uint16_t port;
+    struct sim sim;
+    pthread_t thread;
+};
+
+static const struct {
+    const char * name;
+    const char * spec;
+} scenarios[] = {
+    {"none",   ""},
+    {"drop1",  "drop=1"},
+    {"drop5",  "drop=5"},
+    {"drop20", "drop=20"},
+    {"mixed",  "drop=5,dup=2,reorder=2,truncate=2,corrupt=2,delay=2:10"},
+};
+
+struct ctx {
+    size_t params;
+    int ok;
+};
+
+static void * gateway_run(void * data)
+{
+    struct gateway * self = data;
+    uint8_t in[512];
+    uint8_t out[512];
+    struct sockaddr_in peer;
+    socklen_t plen = sizeof(peer);
+    ssize_t len;
+
+    /* Завершается по shutdown сокета */
+    while((len = recvfrom(self->socket, in, sizeof(in), 0, (struct sockaddr*)&peer, &plen)) > 0) {
+        const ssize_t rlen = sim_process(&self->sim, in, len, out, sizeof(out));
+        if(rlen > 0)
+            sendto(self->socket, out, rlen, 0, (struct sockaddr*)&peer, plen);
+        plen = sizeof(peer);
+    }
+    return NULL;
+}
+
+static int gateway_init(struct gateway * self)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+
+    sim_init(&self->sim, BENCH_GATEWAY);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    self->socket = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if(self->socket < 0 ||
+            bind(self->socket, (struct sockaddr*)&addr, sizeof(addr)) ||
+            getsockname(self->socket, (struct sockaddr*)&addr, &len))
+        return 0;
+
+    self->port = ntohs(addr.sin_port);
+    return pthread_create(&self->thread, NULL, gateway_run, self) == 0;
+}
+
+static size_t chunk_size(const struct ctx * ctx, size_t index)
+{
+    const size_t diff = ctx->params - index * TEKON_PROTO_PLIST_SIZE;
+    return diff > TEKON_PROTO_PLIST_SIZE ? TEKON_PROTO_PLIST_SIZE : diff;
+}
+
+static int prepare(void * data, size_t index, struct message * request)
+{
+    const struct ctx * ctx = data;
+    const size_t size = chunk_size(ctx, index);
+    uint8_t devices[TEKON_PROTO_PLIST_SIZE];
+    uint16_t addresses[TEKON_PROTO_PLIST_SIZE];
+    uint16_t indexes[TEKON_PROTO_PLIST_SIZE];
+    size_t i;
+
+    for(i = 0; i < size; i++) {
+        devices[i] = BENCH_DEVICE;
+        addresses[i] = BENCH_ADDRESS;
+        indexes[i] = (uint16_t)(index * TEKON_PROTO_PLIST_SIZE + i);
+    }
+    return tekon_req_1c(request, BENCH_GATEWAY, devices, addresses, indexes, size);
+}
+
+static void complete(void * data, size_t index, const struct message * response)
+{
+    struct ctx * ctx = data;
+    const size_t size = chunk_size(ctx, index);
+    size_t i;
+
+    if(!response || response->nelements != size) {
+        ctx->ok = 0;
+        return;
+    }
+
+    /* Значение по умолчанию эмулятора: (адрес << 16) | индекс */
+    for(i = 0; i < size; i++) {
+        const uint32_t expected = (uint32_t)BENCH_ADDRESS << 16 | (uint32_t)(index * TEKON_PROTO_PLIST_SIZE + i);
+        if(response->payload.parameters[i].value != expected)
+            ctx->ok = 0;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    const size_t params = argc > 1 ? (size_t)atol(argv[1]) : 4000;
+    const size_t rounds = argc > 2 ? (size_t)atol(argv[2]) : 3;
+    const size_t window = argc > 3 ? (size_t)atol(argv[3]) : PIPELINE_MAX_WINDOW;
+    const size_t retries = argc > 4 ? (size_t)atol(argv[4]) : 10;
+    const int timeout = argc > 5 ? atoi(argv[5]) : 20;
+    const size_t nrequests = (params + TEKON_PROTO_PLIST_SIZE - 1) / TEKON_PROTO_PLIST_SIZE;
+    static struct gateway gateway;
+    static struct pipeline pipeline;
+    static struct fault fault;
+    double baseline = 0;
+    size_t i, round;
+    int ok = 1;
+
+    if(params == 0 || params > 0xFFFF || rounds == 0 || window == 0 ||
+            window > PIPELINE_MAX_WINDOW || timeout <= 0 || timeout > 60000) {
+        printf("Usage: %s [params 1..65535] [rounds] [window 1..%d] [retries] [timeout ms]\n",
+               argv[0], PIPELINE_MAX_WINDOW);
+        return 1;
+    }
+
+    if(!gateway_init(&gateway)) {
+        printf("can't create gateway\n");
+        return 1;
+    }
+
+    printf("params: %u rounds: %u window: %u retries: %u timeout: %d ms\n",
+           (unsigned)params, (unsigned)rounds, (unsigned)window, (unsigned)retries, timeout);
+
+    for(i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        struct fault_config config;
+        struct stats stats;
+        struct ctx ctx = {params, 1};
+        struct link link;
+        size_t done = 0;
+
+        if(!fault_config_from_string(&config, scenarios[i].spec))
+            return 1;
+        fault_init(&fault, &config);
+        stats_init(&stats);
+
+        const int64_t start = time_monotonic_us();
+        for(round = 0; round < rounds; round++) {
+            link_init_udp(&link, "127.0.0.1", gateway.port, (uint16_t)timeout);
+            link.fault = &fault;
+            if(link_up(&link) != 0)
+                return 1;
+
+            pipeline_init(&pipeline, &link, window);
+            pipeline.retries = retries;
+            pipeline.stats = &stats;
+            done += pipeline_run(&pipeline, nrequests, prepare, complete, &ctx);
+            link_down(&link);
+        }
+        const double sec = (time_monotonic_us() - start) / 1e6;
+        const double rate = sec > 0 ? params * rounds / sec : 0;
+
+        if(!baseline)
+            baseline = rate;
+
+        const int passed = ctx.ok && done == nrequests * rounds;
+        ok &= passed;
+
+        printf("%-7s params/s: %-9.0f ratio: %.2f requests: %-6u retries: %-5u timeouts: %-5u "
+               "failures: %-3u dropped: %-5u damaged: %-5u %s\n",
+               scenarios[i].name, rate, baseline > 0 ? rate / baseline : 0,
+               (unsigned)stats.requests, (unsigned)stats.retries, (unsigned)stats.timeouts,
+               (unsigned)stats.failures, (unsigned)fault.stat.dropped,
+               (unsigned)(fault.stat.truncated + fault.stat.corrupted),
+               passed ? "ok" : "failed");
+    }
+
+    shutdown(gateway.socket, SHUT_RDWR);
+    pthread_join(gateway.thread, NULL);
+    close(gateway.socket);
+    return !ok;
+}
@@ -0,0 +1,225 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+/* Кол-во системных вызовов обмена на один прочитанный параметр.
+ *
+ * Сравниваются два способа выполнения одних и тех же запросов 0x1C с окном
+ * window:
+ * - single - по одному вызову на каждую отправку, ожидание и прием
+ *   (link_send/link_wait/link_recv)
+ * - batch - pipeline_run, отправляющий и принимающий посылки пакетами
+ *   (link_send_batch/link_recv_batch)
+ *
+ * Шлюз эмулируется потоком, отвечающим на каждую порцию из window запросов.
+ * Запуск: bench_syscalls [chunks] [window] */
+
+#include "tekon/tekon.h"
+#include "utils/base/pipeline.h"
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_GATEWAY 2
+
+struct responder {
+    int socket;
+    uint16_t port;
+    size_t window;
+    size_t requests;
+};
+
+static size_t build_response(uint8_t * out, const uint8_t * in)
+{
+    const uint8_t nelem = (in[1] - 3) / 6;
+    const uint8_t len = nelem * 5 + 2;
+    size_t pos = 0;
+    size_t i;
+
+    out[pos++] = TEKON_PROTO_VAR_PREFIX;
+    out[pos++] = len;
+    out[pos++] = len;
+    out[pos++] = TEKON_PROTO_VAR_PREFIX;
+    out[pos++] = in[4];
+    out[pos++] = in[5];
+
+    for(i = 0; i < nelem; i++) {
+        memset(out + pos, 0, 5);
+        pos += 5;
+    }
+
+    out[pos] = tekon_variable_crc(out, len + 6);
+    pos++;
+    out[pos++] = TEKON_PROTO_END;
+    return pos;
+}
+
+static void * responder_run(void * data)
+{
+    struct responder * self = data;
+    uint8_t in[PIPELINE_MAX_WINDOW][512];
+    uint8_t out[512];
+    struct sockaddr_in peer;
+    socklen_t plen = sizeof(peer);
+    size_t done = 0;
+
+    while(done < self->requests) {
+        size_t n = self->requests - done < self->window ? self->requests - done : self->window;
+        size_t i;
+
+        for(i = 0; i < n; i++) {
+            if(recvfrom(self->socket, in[i], sizeof(in[i]), 0, (struct sockaddr*)&peer, &plen) <= 0)
+                return NULL;
+        }
+
+        for(i = 0; i < n; i++) {
+            size_t size = build_response(out, in[i]);
+            sendto(self->socket, out, size, 0, (struct sockaddr*)&peer, plen);
+        }
+        done += n;
+    }
+    return NULL;
+}
+
+static int responder_start(struct responder * self, pthread_t * thread, size_t window, size_t requests)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    memset(self, 0, sizeof(*self));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    self->socket = socket(AF_INET, SOCK_DGRAM, 0);
+    self->window = window;
+    self->requests = requests;
+
+    if(bind(self->socket, (struct sockaddr*)&addr, sizeof(addr)) ||
+            getsockname(self->socket, (struct sockaddr*)&addr, &len))
+        return 0;
+
+    self->port = ntohs(addr.sin_port);
+    return pthread_create(thread, NULL, responder_run, self) == 0;
+}
+
+static int prepare(void * ctx, size_t index, struct message * request)
+{
+    uint8_t devices[TEKON_PROTO_PLIST_SIZE];
+    uint16_t addresses[TEKON_PROTO_PLIST_SIZE];
+    uint16_t indexes[TEKON_PROTO_PLIST_SIZE];
+    size_t i;
+
+    for(i = 0; i < TEKON_PROTO_PLIST_SIZE; i++) {
+        devices[i] = 3;
+        addresses[i] = 0x8000;
+        indexes[i] = i;
+    }
+    return tekon_req_1c(request, BENCH_GATEWAY, devices, addresses, indexes, TEKON_PROTO_PLIST_SIZE);
+}
+
+static void complete(void * ctx, size_t index, const struct message * response)
+{
+    size_t * done = ctx;
+    if(response)
+        (*done)++;
+}
+
+/* Обмен по одной посылке на вызов. Воспроизводит прежнюю работу конвейера */
+static size_t run_single(struct link * link, size_t chunks, size_t window)
+{
+    struct message request;
+    char tx[512];
+    char rx[512];
+    size_t done = 0;
+    size_t sent = 0;
+    uint8_t number = 0;
+
+    while(sent < chunks) {
+        size_t n = chunks - sent < window ? chunks - sent : window;
+        size_t i;
+
+        for(i = 0; i < n; i++) {
+            prepare(NULL, sent + i, &request);
+            number = (number + 1) % PIPELINE_NUMBERS;
+            ssize_t len = tekon_req_pack(tx, sizeof(tx), &request, number);
+            if(link_send(link, tx, len) != len)
+                return done;
+        }
+
+        for(i = 0; i < n; i++) {
+            if(link_wait(link, link->timeout) <= 0)
+                return done;
+            if(link_recv(link, rx, sizeof(rx)) > 0)
+                done++;
+        }
+        sent += n;
+    }
+    return done;
+}
+
+static size_t run_batch(struct link * link, size_t chunks, size_t window)
+{
+    static struct pipeline pipeline;
+    size_t done = 0;
+    pipeline_init(&pipeline, link, window);
+    pipeline_run(&pipeline, chunks, prepare, complete, &done);
+    return done;
+}
+
+static int bench(const char * name, size_t (*run)(struct link*, size_t, size_t), size_t chunks, size_t window, double * result)
+{
+    struct responder responder;
+    pthread_t thread;
+    struct link link;
+
+    if(!responder_start(&responder, &thread, window, chunks))
+        return 0;
+
+    link_init_udp(&link, "127.0.0.1", responder.port, 1000);
+    if(link_up(&link) != 0)
+        return 0;
+
+    const size_t done = run(&link, chunks, window);
+    const size_t params = done * TEKON_PROTO_PLIST_SIZE;
+
+    link_down(&link);
+    pthread_join(thread, NULL);
+    close(responder.socket);
+
+    if(done != chunks) {
+        printf("%-8s failed: %u of %u chunks\n", name, (unsigned)done, (unsigned)chunks);
+        return 0;
+    }
+
+    *result = (double)link.stat.syscalls / params;
+    printf("%-8s params: %-8u syscalls: %-8llu syscalls/param: %.4f\n",
+           name, (unsigned)params, (unsigned long long)link.stat.syscalls, *result);
+    return 1;
+}
+
+int main(int argc, char * argv[])
+{
+    const size_t chunks = argc > 1 ? (size_t)atol(argv[1]) : 1000;
+    const size_t window = argc > 2 ? (size_t)atol(argv[2]) : PIPELINE_MAX_WINDOW;
+    double single = 0;
+    double batch = 0;
+
+    if(chunks == 0 || window == 0 || window > PIPELINE_MAX_WINDOW) {
+        printf("Usage: %s [chunks] [window 1..%d]\n", argv[0], PIPELINE_MAX_WINDOW);
+        return 1;
+    }
+
+    printf("chunks: %u window: %u params/request: %d\n", (unsigned)chunks, (unsigned)window, TEKON_PROTO_PLIST_SIZE);
+
+    if(!bench("single", run_single, chunks, window, &single) ||
+            !bench("batch", run_batch, chunks, window, &batch))
+        return 1;
+
+    printf("ratio: %.2f\n", single / batch);
+
+    /* При окне больше 1 пакетный обмен обязан быть экономнее */
+    return window > 1 && batch >= single;
+}
@@ -0,0 +1,169 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+/* Скорость построения последовательностей меток времени архивов
+ * (timestamp_seq_*) для всех типов и глубин архивов в разных часовых поясах,
+ * в том числе с переходом на летнее время.
+ *
+ * Результат выводится в формате CSV, по строке на вариант, пояс и дату:
+ * variant,depth,interval,tz,date,iterations,us_per_seq,budget_us,result
+ * result - ok, slow (превышен бюджет времени) или fail (последовательность не
+ * построена полностью). Программа завершается с ошибкой, если хотя бы один
+ * вариант превысил бюджет. Неполные последовательности только отмечаются:
+ * архив, пересекающий переход на летнее время, может не набрать глубину
+ * (пропущенный или повторенный час), это не вопрос скорости.
+ * Бюджеты заданы с запасом для armhf, scale позволяет ужесточить или
+ * ослабить их для конкретной платформы.
+ * Запуск: bench_tstamp [iterations] [scale] [variant] */
+
+#include "utils/base/tstamp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Часовые пояса в формате POSIX, чтобы не зависеть от базы tzdata */
+static const struct {
+    const char * name;
+    const char * tz;
+} zones[] = {
+    {"UTC",       "UTC0"},
+    {"Moscow",    "MSK-3"},
+    {"Kolkata",   "IST-5:30"},
+    {"Berlin",    "CET-1CEST,M3.5.0,M10.5.0/3"},
+    {"New_York",  "EST5EDT,M3.2.0,M11.1.0"},
+    {"Sydney",    "AEST-10AEDT,M10.1.0,M4.1.0/3"},
+};
+
+/* Опорные даты: весна и осень, чтобы глубокие архивы пересекали переходы на
+ * летнее время и обратно в обоих полушариях */
+static const struct {
+    struct tekon_date date;
+    struct tekon_time time;
+} dates[] = {
+    {{.year = 19, .month = 4, .day = 15}, {.hour = 12, .minute = 30, .second = 0}},
+    {{.year = 19, .month = 11, .day = 15}, {.hour = 12, .minute = 30, .second = 0}},
+};
+
+enum variant_type {SEQ_MONTH, SEQ_DAY, SEQ_HOUR, SEQ_INTERVAL};
+
+struct variant {
+    const char * name;
+    enum variant_type type;
+    size_t depth;
+    size_t interval; /* мин., только для интервальных архивов */
+    int64_t budget;  /* бюджет на одну последовательность, мкс */
+};
+
+/* Глубина интервального архива - целое кол-во суток. Бюджеты примерно в 20
+ * раз больше времени на x86 в поясе с переходом на летнее время */
+static const struct variant variants[] = {
+    {"month",    SEQ_MONTH,    12,   0,  500},
+    {"month",    SEQ_MONTH,    48,   0,  1000},
+    {"day",      SEQ_DAY,      366,  0,  5000},
+    {"hour",     SEQ_HOUR,     384,  0,  5000},
+    {"hour",     SEQ_HOUR,     768,  0,  10000},
+    {"hour",     SEQ_HOUR,     1536, 0,  20000},
+    {"interval", SEQ_INTERVAL, 1440, 5,  5000},
+    {"interval", SEQ_INTERVAL, 2880, 30, 10000},
+    {"interval", SEQ_INTERVAL, 4320, 1,  15000},
+    {"interval", SEQ_INTERVAL, 7200, 1,  25000},
+    {"interval", SEQ_INTERVAL, 8160, 15, 30000},
+    {"interval", SEQ_INTERVAL, 17280, 1, 60000},
+};
+
+static int64_t storage[TIMESTAMP_MAX_SEQ_SIZE];
+static struct timestamp_seq seq;
+
+static int run(const struct variant * variant, size_t date)
+{
+    const struct tekon_date * d = &dates[date].date;
+    const struct tekon_time * t = &dates[date].time;
+
+    switch(variant->type) {
+    case SEQ_MONTH:
+        return timestamp_seq_month(&seq, d, variant->depth);
+    case SEQ_DAY:
+        return timestamp_seq_day(&seq, d);
+    case SEQ_HOUR:
+        return timestamp_seq_hour(&seq, d, t, variant->depth);
+    case SEQ_INTERVAL:
+        return timestamp_seq_interval(&seq, d, t, variant->depth, variant->interval);
+    }
+    return 0;
+}
+
+static int64_t now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Выполнить замер.
+ * 0 - превышен бюджет времени */
+static int bench(const struct variant * variant, size_t zone, size_t date, size_t iterations, double scale)
+{
+    const struct tekon_date * d = &dates[date].date;
+    const int64_t budget = (int64_t)(variant->budget * scale);
+    int result = 1;
+    size_t i;
+
+    /* Проверка и прогрев */
+    result &= run(variant, date);
+
+    const int64_t start = now_us();
+    for(i = 0; i < iterations; i++)
+        result &= run(variant, date);
+    const int64_t elapsed = (now_us() - start) / (int64_t)iterations;
+
+    const char * status = !result ? "fail" : elapsed > budget ? "slow" : "ok";
+    printf("%s,%u,%u,%s,20%02u-%02u-%02u,%u,%lld,%lld,%s\n",
+           variant->name, (unsigned)variant->depth, (unsigned)variant->interval,
+           zones[zone].name, d->year, d->month, d->day,
+           (unsigned)iterations, (long long)elapsed, (long long)budget, status);
+
+    return elapsed <= budget;
+}
+
+int main(int argc, char * argv[])
+{
+    const size_t iterations = argc > 1 ? (size_t)atol(argv[1]) : 20;
+    const double scale = argc > 2 ? atof(argv[2]) : 1.0;
+    const char * filter = argc > 3 ? argv[3] : NULL;
+    size_t v;
+    size_t z;
+    size_t d;
+    int result = 1;
+    size_t slow = 0;
+    size_t total = 0;
+
+    if(iterations == 0 || scale <= 0) {
+        printf("Usage: %s [iterations] [scale] [variant]\n", argv[0]);
+        return 1;
+    }
+
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
+    printf("variant,depth,interval,tz,date,iterations,us_per_seq,budget_us,result\n");
+
+    for(z = 0; z < sizeof(zones) / sizeof(zones[0]); z++) {
+        setenv("TZ", zones[z].tz, 1);
+        tzset();
+
+        for(v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+            if(filter && strcmp(filter, variants[v].name) != 0)
+                continue;
+            for(d = 0; d < sizeof(dates) / sizeof(dates[0]); d++) {
+                const int ok = bench(&variants[v], z, d, iterations, scale);
+                slow += !ok;
+                result &= ok;
+                total++;
+            }
+        }
+    }
+
+    printf("# %u of %u variants exceeded the time budget\n", (unsigned)slow, (unsigned)total);
+    return !result;
+}
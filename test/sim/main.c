@@ -0,0 +1,592 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+/* Эмулятор шлюза Тэкон для нагрузочных испытаний и замеров задержек.
+ * Принимает запросы по UDP и TCP на локальных адресах и отвечает на них
+ * через модель канала (задержка, разброс, потери, последовательная шина).
+ * Ответы ожидают отправки в очереди по времени, поэтому задержка одного
+ * запроса не блокирует прием остальных */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "utils/base/base.h"
+#include "tekon/tekon.h"
+#include "test/sim/sim.h"
+
+#define APP_NAME "tekon_sim"
+#define APP_ERR  LOG_ERR  APP_NAME " : ERR"
+#define APP_WARN LOG_WARN APP_NAME " : WARN"
+#define APP_INFO LOG_INFO APP_NAME " : INFO"
+
+/* Макс. кол-во адресов для приема запросов */
+#define APP_MAX_LISTEN 8
+
+/* Макс. кол-во TCP клиентов */
+#define APP_MAX_CLIENTS 64
+
+/* Макс. кол-во ответов, ожидающих отправки */
+#define APP_MAX_PENDING 4096
+
+/* Макс. размер ответа */
+#define APP_MAX_REPLY 264
+
+struct listener {
+    int socket;
+    enum link_type type;
+};
+
+struct client {
+    int socket; /* -1 - свободен */
+    uint32_t generation;
+    struct tekon_stream stream;
+};
+
+/* Ответ, ожидающий отправки */
+struct pending {
+    int64_t due;
+    uint64_t order; /* порядок поступления для ответов с одним временем */
+    int socket;
+    int client;     /* индекс TCP клиента или -1 для UDP */
+    uint32_t generation;
+    struct sockaddr_in peer;
+    uint16_t len;
+    uint8_t data[APP_MAX_REPLY];
+};
+
+struct app {
+    struct sim sim;
+    struct netaddr addr[APP_MAX_LISTEN];
+    struct listener listeners[APP_MAX_LISTEN];
+    size_t nlisteners;
+    struct client clients[APP_MAX_CLIENTS];
+    struct pending pending[APP_MAX_PENDING];
+    size_t npending;
+    uint64_t order;
+    uint64_t dropped; /* очередь переполнена */
+};
+
+static volatile sig_atomic_t stop = 0;
+
+static void usage()
+{
+    printf("Usage: %s -a address [-a address ...] [-p values] [-f file] [-n depth]\n", APP_NAME);
+    printf("                 [-d datetime] [-u utc] [-l latency] [-j jitter] [-x loss] [-b baud] [-s seed] [-v verbosity]\n\n");
+    printf("  -a    address to listen in [type:ip:port@gateway] format.\n");
+    printf("        Several addresses could be set. All of them serve the same gateway.\n\n");
+    printf("  -p    list of parameter values in [device:parameter:index:value] format.\n");
+    printf("        Value with a dot is a 32-bit float. Other parameters are read as\n");
+    printf("        (parameter << 16) | index.\n\n");
+    printf("  -f    file with parameter values, one per line. '#' starts a comment.\n\n");
+    printf("  -n    depth of archives. Reading beyond it fails. Default is %d.\n\n", SIM_DEPTH);
+    printf("  -d    device's date/time address in [device:date:time] format. Default is 3:0xF017:0xF018.\n\n");
+    printf("  -u    initial device's time as UTC timestamp. Default is host's time.\n\n");
+    printf("  -l    round-trip latency in milliseconds (fractional allowed).\n\n");
+    printf("  -j    max random addition to latency in milliseconds (fractional allowed).\n\n");
+    printf("  -x    request loss in percents (fractional allowed).\n\n");
+    printf("  -b    serial bus speed in baud. Requests are served one by one.\n\n");
+    printf("  -s    random seed. Same seed gives same jitter and losses.\n\n");
+    printf("  -v    set verbose:\n");
+    printf("        0 - silent \n");
+    printf("        1 - error\n");
+    printf("        2 - warning \n");
+    printf("        3 - info \n\n");
+    printf("Example:\n");
+    printf("  %s -a udp:127.0.0.1:51960@9 -a tcp:127.0.0.1:51960@9 -p '3:0x8003:0:1.5' -l 5 -j 1 -b 9600\n", APP_NAME);
+}
+
+/* Прочитать время в мс (допускается дробная часть) в мкс.
+ * 0 - ошибка */
+static int read_ms(const char * str, uint32_t * us)
+{
+    char * end = NULL;
+    const double ms = strtod(str, &end);
+    if(end == str || *end != '\0' || ms < 0 || ms > 60000)
+        return 0;
+    *us = (uint32_t)(ms * 1000);
+    return 1;
+}
+
+static int read_values(struct app * app, char * str)
+{
+    char * token = NULL;
+    while((token = strtok_r(str, " \t\r\n", &str))) {
+        if(!sim_set_from_string(&app->sim, token)) {
+            printf("invalid parameter value %s\n\n", token);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int read_file(struct app * app, const char * path)
+{
+    char line[256];
+    FILE * file = fopen(path, "r");
+    int result = 1;
+
+    if(!file) {
+        printf("can't open file %s\n\n", path);
+        return 0;
+    }
+
+    while(result && fgets(line, sizeof(line), file)) {
+        char * comment = strchr(line, '#');
+        if(comment)
+            *comment = '\0';
+        result = read_values(app, line);
+    }
+
+    fclose(file);
+    return result;
+}
+
+/* Прочитать аргусенты командной строки
+ * 0 - в случае ошибки */
+static int read_args(struct app * app, int argc, char * const argv[])
+{
+    assert(app);
+
+    if(argc < 3)
+        return 0;
+
+    struct sim * sim = &app->sim;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "a:p:f:n:d:u:l:j:x:b:s:v:")) != -1) {
+        switch (opt) {
+        case 'a':
+            if(app->nlisteners == APP_MAX_LISTEN) {
+                printf("addresses overflow. Limit is %d\n\n", APP_MAX_LISTEN);
+                return 0;
+            }
+            if(!netaddr_from_string(&app->addr[app->nlisteners], optarg)) {
+                printf("invalid network address %s\n\n", optarg);
+                return 0;
+            }
+            if(app->nlisteners && app->addr[app->nlisteners].gateway != sim->gateway) {
+                printf("all addresses should serve the same gateway\n\n");
+                return 0;
+            }
+            sim->gateway = app->addr[app->nlisteners].gateway;
+            sim->clock.gateway = sim->gateway;
+            app->nlisteners++;
+            break;
+        case 'p':
+            if(!read_values(app, optarg))
+                return 0;
+            break;
+        case 'f':
+            if(!read_file(app, optarg))
+                return 0;
+            break;
+        case 'n': {
+            long input = atol(optarg);
+            if(input <= 0 || input > SIM_DEPTH) {
+                printf("invalid depth %s\n\n", optarg);
+                return 0;
+            }
+            sim->depth = input;
+        }
+        break;
+        case 'd': {
+            /* Адрес задается без шлюза */
+            char buffer[64];
+            snprintf(buffer, sizeof(buffer), "%u:%s", (unsigned)sim->gateway, optarg);
+            if(!dtaddr_from_string(&sim->clock, buffer)) {
+                printf("invalid date/time address %s\n\n", optarg);
+                return 0;
+            }
+        }
+        break;
+        case 'u': {
+            char * end = NULL;
+            long long input = strtoll(optarg, &end, 10);
+            if(end == optarg || *end != '\0' || input <= 0) {
+                printf("invalid time %s\n\n", optarg);
+                return 0;
+            }
+            sim->offset = input - time_now_utc();
+        }
+        break;
+        case 'l':
+            if(!read_ms(optarg, &sim->faults.latency)) {
+                printf("invalid latency %s\n\n", optarg);
+                return 0;
+            }
+            break;
+        case 'j':
+            if(!read_ms(optarg, &sim->faults.jitter)) {
+                printf("invalid jitter %s\n\n", optarg);
+                return 0;
+            }
+            break;
+        case 'x': {
+            char * end = NULL;
+            const double input = strtod(optarg, &end);
+            if(end == optarg || *end != '\0' || input < 0 || input > 100) {
+                printf("invalid loss %s\n\n", optarg);
+                return 0;
+            }
+            sim->faults.loss = (uint32_t)(input * 10000);
+        }
+        break;
+        case 'b': {
+            long input = atol(optarg);
+            if(input <= 0 || input > 10000000) {
+                printf("invalid baud %s\n\n", optarg);
+                return 0;
+            }
+            sim->faults.baud = input;
+        }
+        break;
+        case 's': {
+            unsigned long input = strtoul(optarg, NULL, 0);
+            /* Нулевое состояние xorshift не меняется */
+            sim->seed = input ? (uint32_t)input : 1;
+        }
+        break;
+        case 'v':
+            log_setlevel(atoi(optarg));
+            break;
+        default: /* '?' */
+            printf("invalid argument %c\n\n", opt);
+            return 0;
+        }
+    }
+
+    if(app->nlisteners == 0) {
+        printf("please enter address to listen\n\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+/* Очередь ответов - двоичная куча по времени отправки */
+static int pending_less(const struct pending * a, const struct pending * b)
+{
+    return a->due < b->due || (a->due == b->due && a->order < b->order);
+}
+
+static void pending_swap(struct app * app, size_t a, size_t b)
+{
+    struct pending tmp = app->pending[a];
+    app->pending[a] = app->pending[b];
+    app->pending[b] = tmp;
+}
+
+static struct pending * pending_alloc(struct app * app)
+{
+    if(app->npending == APP_MAX_PENDING) {
+        app->dropped++;
+        return NULL;
+    }
+    return &app->pending[app->npending];
+}
+
+static void pending_push(struct app * app)
+{
+    size_t pos = app->npending++;
+    app->pending[pos].order = app->order++;
+    while(pos) {
+        const size_t parent = (pos - 1) / 2;
+        if(!pending_less(&app->pending[pos], &app->pending[parent]))
+            break;
+        pending_swap(app, pos, parent);
+        pos = parent;
+    }
+}
+
+static void pending_pop(struct app * app)
+{
+    size_t pos = 0;
+    app->pending[0] = app->pending[--app->npending];
+    for(;;) {
+        const size_t left = pos * 2 + 1;
+        const size_t right = left + 1;
+        size_t min = pos;
+        if(left < app->npending && pending_less(&app->pending[left], &app->pending[min]))
+            min = left;
+        if(right < app->npending && pending_less(&app->pending[right], &app->pending[min]))
+            min = right;
+        if(min == pos)
+            break;
+        pending_swap(app, pos, min);
+        pos = min;
+    }
+}
+
+static void send_reply(struct app * app, const struct pending * reply)
+{
+    ssize_t result;
+    if(reply->client < 0) {
+        result = sendto(reply->socket, reply->data, reply->len, 0,
+                        (const struct sockaddr *)&reply->peer, sizeof(reply->peer));
+    } else {
+        const struct client * client = &app->clients[reply->client];
+        /* Клиент отключился, пока ответ ждал отправки */
+        if(client->socket != reply->socket || client->generation != reply->generation)
+            return;
+        result = send(reply->socket, reply->data, reply->len, MSG_NOSIGNAL);
+    }
+
+    if(result != reply->len)
+        log_print(APP_WARN " : send error %d\n", errno);
+}
+
+/* Отправить ответы, время которых наступило */
+static void flush(struct app * app, int64_t now)
+{
+    while(app->npending && app->pending[0].due <= now) {
+        send_reply(app, &app->pending[0]);
+        pending_pop(app);
+    }
+}
+
+/* Обработать запрос и поставить ответ в очередь */
+static void process(struct app * app, const void * request, size_t len, int socket, int client,
+                    const struct sockaddr_in * peer)
+{
+    struct pending * reply = pending_alloc(app);
+    if(!reply)
+        return;
+
+    const ssize_t result = sim_process(&app->sim, request, len, reply->data, sizeof(reply->data));
+    if(result <= 0) {
+        log_print(APP_WARN " : invalid request\n");
+        return;
+    }
+
+    const int64_t due = sim_schedule(&app->sim, len, result, time_monotonic_us());
+    if(due < 0)
+        return;
+
+    reply->due = due;
+    reply->socket = socket;
+    reply->client = client;
+    reply->generation = client >= 0 ? app->clients[client].generation : 0;
+    reply->len = result;
+    if(peer)
+        reply->peer = *peer;
+    pending_push(app);
+}
+
+static void on_udp(struct app * app, int socket)
+{
+    uint8_t buffer[512];
+    struct sockaddr_in peer;
+    socklen_t plen = sizeof(peer);
+    ssize_t len;
+
+    while((len = recvfrom(socket, buffer, sizeof(buffer), MSG_DONTWAIT,
+                          (struct sockaddr *)&peer, &plen)) > 0) {
+        process(app, buffer, len, socket, -1, &peer);
+        plen = sizeof(peer);
+    }
+}
+
+static void on_accept(struct app * app, int socket)
+{
+    const int fd = accept(socket, NULL, NULL);
+    size_t i;
+
+    if(fd < 0)
+        return;
+
+    for(i = 0; i < APP_MAX_CLIENTS; i++) {
+        struct client * client = &app->clients[i];
+        if(client->socket < 0) {
+            client->socket = fd;
+            client->generation++;
+            tekon_stream_init(&client->stream);
+            log_print(APP_INFO " : client %u connected\n", (unsigned)i);
+            return;
+        }
+    }
+
+    log_print(APP_WARN " : clients overflow. Limit is %d\n", APP_MAX_CLIENTS);
+    close(fd);
+}
+
+static void on_client(struct app * app, size_t index)
+{
+    struct client * client = &app->clients[index];
+    uint8_t frame[TEKON_STREAM_SIZE];
+    size_t size = 0;
+    void * buffer = tekon_stream_reserve(&client->stream, &size);
+    const ssize_t len = recv(client->socket, buffer, size, MSG_DONTWAIT);
+
+    if(len == 0 || (len < 0 && errno != EAGAIN && errno != EINTR)) {
+        log_print(APP_INFO " : client %u disconnected\n", (unsigned)index);
+        close(client->socket);
+        client->socket = -1;
+        return;
+    }
+
+    if(len < 0)
+        return;
+
+    tekon_stream_commit(&client->stream, len);
+
+    ssize_t flen;
+    while((flen = tekon_stream_pop(&client->stream, frame, sizeof(frame))) != 0) {
+        if(flen > 0)
+            process(app, frame, flen, client->socket, index, NULL);
+    }
+}
+
+static int open_listener(struct listener * self, const struct netaddr * addr)
+{
+    struct sockaddr_in sa;
+    const int yes = 1;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(addr->port);
+    if(inet_pton(AF_INET, addr->ip, &sa.sin_addr) != 1)
+        return -EINVAL;
+
+    self->type = addr->type;
+    self->socket = socket(AF_INET, addr->type == LINK_TCP ? SOCK_STREAM : SOCK_DGRAM, 0);
+    if(self->socket < 0)
+        return -errno;
+
+    setsockopt(self->socket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    if(bind(self->socket, (struct sockaddr *)&sa, sizeof(sa)) != 0 ||
+            (addr->type == LINK_TCP && listen(self->socket, APP_MAX_CLIENTS) != 0)) {
+        const int error = -errno;
+        close(self->socket);
+        self->socket = -1;
+        return error;
+    }
+    return 0;
+}
+
+/* Основной цикл. Ожидание ограничено временем ближайшего ответа */
+static int run(struct app * app)
+{
+    struct pollfd fds[APP_MAX_LISTEN + APP_MAX_CLIENTS];
+    int clients[APP_MAX_CLIENTS];
+    size_t i;
+
+    while(!stop) {
+        size_t nfds = 0;
+        size_t nclients = 0;
+
+        for(i = 0; i < app->nlisteners; i++, nfds++) {
+            fds[nfds].fd = app->listeners[i].socket;
+            fds[nfds].events = POLLIN;
+        }
+
+        for(i = 0; i < APP_MAX_CLIENTS; i++) {
+            if(app->clients[i].socket < 0)
+                continue;
+            fds[nfds].fd = app->clients[i].socket;
+            fds[nfds].events = POLLIN;
+            clients[nclients++] = i;
+            nfds++;
+        }
+
+        struct timespec timeout = {1, 0};
+        if(app->npending) {
+            int64_t wait = app->pending[0].due - time_monotonic_us();
+            if(wait < 0)
+                wait = 0;
+            if(wait < 1000000) {
+                timeout.tv_sec = 0;
+                timeout.tv_nsec = wait * 1000;
+            }
+        }
+
+        const int result = ppoll(fds, nfds, &timeout, NULL);
+        if(result < 0 && errno != EINTR)
+            return -errno;
+
+        for(i = 0; result > 0 && i < nfds; i++) {
+            if(!fds[i].revents)
+                continue;
+            if(i < app->nlisteners) {
+                if(app->listeners[i].type == LINK_TCP)
+                    on_accept(app, fds[i].fd);
+                else
+                    on_udp(app, fds[i].fd);
+            } else {
+                on_client(app, clients[i - app->nlisteners]);
+            }
+        }
+
+        flush(app, time_monotonic_us());
+    }
+    return 0;
+}
+
+static void sigint(int sig)
+{
+    stop = 1;
+}
+
+int main(int argc, char * argv[])
+{
+    static struct app app;
+    size_t i;
+
+    sim_init(&app.sim, TEKON_INVALID_DEV_ADDR);
+    for(i = 0; i < APP_MAX_CLIENTS; i++)
+        app.clients[i].socket = -1;
+
+    if(!read_args(&app, argc, argv)) {
+        usage();
+        return 1;
+    }
+
+    for(i = 0; i < app.nlisteners; i++) {
+        const int result = open_listener(&app.listeners[i], &app.addr[i]);
+        if(result != 0) {
+            log_print(APP_ERR " : can't listen %s:%"PRIu16" error %d\n", app.addr[i].ip, app.addr[i].port, result);
+            return 1;
+        }
+    }
+
+    signal(SIGINT, sigint);
+    signal(SIGTERM, sigint);
+
+    log_print(APP_INFO " : started. Gateway: %u\n", (unsigned)app.sim.gateway);
+    const int result = run(&app);
+    if(result != 0)
+        log_print(APP_ERR " : polling error %d\n", result);
+
+    for(i = 0; i < app.nlisteners; i++)
+        close(app.listeners[i].socket);
+    for(i = 0; i < APP_MAX_CLIENTS; i++)
+        if(app.clients[i].socket >= 0)
+            close(app.clients[i].socket);
+
+    const struct sim_stat * stat = &app.sim.stat;
+    log_print(APP_INFO " : stop. Requests %"PRIu64" replies %"PRIu64" lost %"PRIu64" invalid %"PRIu64" dropped %"PRIu64"\n",
+              stat->requests, stat->replies, stat->lost, stat->invalid, app.dropped);
+    return result != 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,136 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "test/sim/responder.h"
+#include <arpa/inet.h>
+#include <assert.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "tekon/tekon.h"
+
+#define RESPONDER_MAX_WINDOW 16
+
+static void * responder_run(void * data)
+{
+    struct sim_responder * self = data;
+    uint8_t in[RESPONDER_MAX_WINDOW][512];
+    ssize_t inlen[RESPONDER_MAX_WINDOW];
+    uint8_t out[512];
+    struct sockaddr_in peer;
+    socklen_t plen = sizeof(peer);
+    size_t round, i;
+
+    for(i = 0; i < self->drop; i++) {
+        if(recvfrom(self->socket, in[0], sizeof(in[0]), 0, (struct sockaddr*)&peer, &plen) <= 0)
+            return NULL;
+    }
+
+    for(round = 0; round < self->rounds; round++) {
+        for(i = 0; i < self->window; i++) {
+            inlen[i] = recvfrom(self->socket, in[i], sizeof(in[i]), 0, (struct sockaddr*)&peer, &plen);
+            if(inlen[i] <= 0)
+                return NULL;
+        }
+
+        for(i = self->window; i > 0; i--) {
+            ssize_t size = sim_process(&self->sim, in[i - 1], inlen[i - 1], out, sizeof(out));
+            if(size <= 0)
+                continue;
+
+            if(self->ack) {
+                out[0] = TEKON_PROTO_POS_ACK;
+                size = 1;
+            }
+
+            if(self->stale) {
+                /* Ответ с чужим номером должен быть отброшен */
+                uint8_t stale[512];
+                memcpy(stale, out, size);
+                stale[4] = 0x40 | ((stale[4] + 8) & 0x0F);
+                stale[size - 2] = tekon_variable_crc(stale, size);
+                sendto(self->socket, stale, size, 0, (struct sockaddr*)&peer, plen);
+            }
+
+            if(self->corrupt) {
+                /* Ответ с неверной КС должен быть запрошен повторно */
+                out[size - 2] ^= 0xFF;
+                self->corrupt--;
+            }
+
+            sendto(self->socket, out, size, 0, (struct sockaddr*)&peer, plen);
+        }
+    }
+    return NULL;
+}
+
+int sim_responder_init(struct sim_responder * self, uint8_t gateway, size_t window, size_t rounds)
+{
+    assert(self);
+    assert(window <= RESPONDER_MAX_WINDOW);
+
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    memset(self, 0, sizeof(*self));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    sim_init(&self->sim, gateway);
+    self->socket = socket(AF_INET, SOCK_DGRAM, 0);
+    self->window = window;
+    self->rounds = rounds;
+
+    if(self->socket < 0 ||
+            bind(self->socket, (struct sockaddr*)&addr, sizeof(addr)) ||
+            getsockname(self->socket, (struct sockaddr*)&addr, &len))
+        return 0;
+
+    self->port = ntohs(addr.sin_port);
+    return 1;
+}
+
+int sim_responder_fill(struct sim_responder * self, uint8_t device, uint16_t address, size_t count, uint32_t base)
+{
+    assert(self);
+
+    size_t i;
+    for(i = 0; i < count; i++) {
+        if(!sim_set(&self->sim, device, address, (uint16_t)i, base + (uint32_t)i))
+            return 0;
+    }
+    return 1;
+}
+
+int sim_responder_start(struct sim_responder * self)
+{
+    assert(self);
+
+    if(!self->rounds)
+        return 1;
+
+    self->running = pthread_create(&self->thread, NULL, responder_run, self) == 0;
+    return self->running;
+}
+
+void sim_responder_close(struct sim_responder * self)
+{
+    assert(self);
+
+    if(self->running) {
+        shutdown(self->socket, SHUT_RDWR);
+        pthread_join(self->thread, NULL);
+        self->running = 0;
+    }
+    close(self->socket);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,61 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef TEST_SIM_RESPONDER_H
+#define TEST_SIM_RESPONDER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "test/sim/sim.h"
+
+/* UDP шлюз для модульных тестов обмена. Поток принимает запросы на
+ * 127.0.0.1 и отвечает эмулятором sim.
+ *
+ * Запросы читаются порциями по window, ответы на порцию отправляются в
+ * обратном порядке - так проверяется сопоставление ответов по номеру
+ * посылки. Всего обрабатывается rounds порций. Шлюз с rounds == 0 молчит. */
+struct sim_responder {
+    struct sim sim;
+    int socket;
+    uint16_t port;
+    size_t window;
+    size_t rounds;
+    size_t drop;    /* кол-во первых запросов, оставляемых без ответа */
+    size_t corrupt; /* кол-во первых ответов, отправляемых с неверной КС */
+    int stale;      /* перед каждым ответом отправлять его копию с чужим
+                     * номером посылки */
+    int ack;        /* отвечать положительной квитанцией вместо данных */
+    pthread_t thread;
+    int running;
+};
+
+/* Открыть сокет шлюза gateway на свободном порту.
+ * 1 - успешно
+ * 0 - ошибка */
+int sim_responder_init(struct sim_responder * self, uint8_t gateway, size_t window, size_t rounds);
+
+/* Задать значения параметров device:address:[0, count): base + индекс.
+ * 1 - успешно
+ * 0 - таблица эмулятора заполнена */
+int sim_responder_fill(struct sim_responder * self, uint8_t device, uint16_t address, size_t count, uint32_t base);
+
+/* Запустить поток шлюза. Параметры (drop, stale...) задаются до запуска.
+ * 1 - успешно
+ * 0 - ошибка */
+int sim_responder_start(struct sim_responder * self);
+
+/* Прервать ожидание запросов, дождаться потока и закрыть сокет */
+void sim_responder_close(struct sim_responder * self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,354 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "test/sim/sim.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tekon/tekon.h"
+#include "utils/base/time.h"
+#include "utils/base/tstamp.h"
+
+/* Команды внешнего модуля (запрос 0x14) */
+#define SIM_CMD_WRITE 0x03
+#define SIM_CMD_LOGIN 0x05
+
+static uint64_t param_key(uint8_t device, uint16_t address, uint16_t index)
+{
+    return (uint64_t)device << 32 | (uint64_t)address << 16 | index;
+}
+
+/* Позиция параметра в отсортированной таблице или позиция для вставки */
+static size_t param_find(const struct sim * self, uint64_t key)
+{
+    size_t lo = 0;
+    size_t hi = self->size;
+    while(lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        const struct sim_param * p = &self->params[mid];
+        if(param_key(p->device, p->address, p->index) < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* Генератор xorshift32 */
+static uint32_t sim_random(struct sim * self)
+{
+    uint32_t x = self->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    self->seed = x;
+    return x;
+}
+
+/* Текущее время устройства */
+static int64_t clock_now(const struct sim * self)
+{
+    return time_now_utc() + self->offset;
+}
+
+/* Значение часов устройства в формате Тэкона.
+ * 1 - параметр является датой или временем */
+static int clock_read(const struct sim * self, uint8_t device, uint16_t address, uint32_t * value)
+{
+    struct tm local;
+
+    if(device != self->clock.device ||
+            (address != self->clock.date && address != self->clock.time) ||
+            !time_local_from_utc(clock_now(self), &local))
+        return 0;
+
+    if(address == self->clock.date) {
+        struct tekon_date date;
+        tekon_date_from_local(&date, &local);
+        tekon_date_pack(&date, value, sizeof(*value));
+    } else {
+        struct tekon_time time;
+        tekon_time_from_local(&time, &local);
+        tekon_time_pack(&time, value, sizeof(*value));
+    }
+    return 1;
+}
+
+/* Установить дату или время устройства, сохранив вторую половину часов.
+ * 1 - параметр является датой или временем */
+static int clock_write(struct sim * self, uint8_t device, uint16_t address, uint32_t value)
+{
+    struct tm local;
+
+    if(device != self->clock.device ||
+            (address != self->clock.date && address != self->clock.time) ||
+            !time_local_from_utc(clock_now(self), &local))
+        return 0;
+
+    if(address == self->clock.date) {
+        struct tekon_date date;
+        tekon_date_unpack(&date, &value, sizeof(value));
+        tekon_date_to_local(&date, &local);
+    } else {
+        struct tekon_time time;
+        tekon_time_unpack(&time, &value, sizeof(value));
+        tekon_time_to_local(&time, &local);
+    }
+
+    local.tm_isdst = -1;
+    self->offset = time_utc_from_local(&local) - time_now_utc();
+    return 1;
+}
+
+static uint32_t param_value(const struct sim * self, uint8_t device, uint16_t address, uint16_t index)
+{
+    uint32_t value;
+    if(clock_read(self, device, address, &value))
+        return value;
+    return sim_get(self, device, address, index);
+}
+
+/* Запрос 0x14: установка уровня доступа или запись регистра */
+static void process_14(struct sim * self, const struct message * request, struct message * response)
+{
+    const uint8_t * cmd = request->payload.bytes;
+    const uint8_t device = cmd[1];
+
+    switch(cmd[2]) {
+    case SIM_CMD_LOGIN:
+        /* Пароль не проверяется */
+        if(request->nelements != 8)
+            break;
+        self->level = cmd[3];
+        memset(response, 0, sizeof(*response));
+        response->gateway = self->gateway;
+        response->dir = TEKON_DIR_IN;
+        response->type = TEKON_MSG_WRITEM_PAR_14;
+        response->nelements = 1;
+        response->payload.bytes[0] = self->level;
+        return;
+    case SIM_CMD_WRITE: {
+        uint16_t address;
+        uint32_t value;
+        if(request->nelements != 9 || !self->level)
+            break;
+        memcpy(&address, cmd + 3, sizeof(address));
+        memcpy(&value, cmd + 5, sizeof(value));
+        if(!clock_write(self, device, address, value) &&
+                !sim_set(self, device, address, 0, value))
+            break;
+        tekon_resp_ack(response, 1);
+        return;
+    }
+    default:
+        break;
+    }
+
+    tekon_resp_ack(response, 0);
+}
+
+/* Запрос 0x19: чтение архива. Выход за глубину архива - отказ */
+static void process_19(struct sim * self, const struct message * request, struct message * response)
+{
+    const struct tekon_parameter * param = request->payload.parameters;
+    uint32_t values[TEKON_PROTO_ILIST_SIZE];
+    size_t i;
+
+    if((size_t)param->index + request->nelements > self->depth) {
+        tekon_resp_ack(response, 0);
+        return;
+    }
+
+    for(i = 0; i < request->nelements; i++)
+        values[i] = param_value(self, param[i].device, param[i].address, param[i].index);
+
+    tekon_resp_19(response, self->gateway, values, request->nelements);
+}
+
+/* Запрос 0x1C: чтение списка параметров. Выход за глубину архива - плохое
+ * качество значения */
+static void process_1c(struct sim * self, const struct message * request, struct message * response)
+{
+    const struct tekon_parameter * param = request->payload.parameters;
+    uint32_t values[TEKON_PROTO_PLIST_SIZE];
+    uint8_t quals[TEKON_PROTO_PLIST_SIZE];
+    size_t i;
+
+    for(i = 0; i < request->nelements; i++) {
+        const int valid = param[i].index == TEKON_INVALID_INDEX || param[i].index < self->depth;
+        values[i] = valid ? param_value(self, param[i].device, param[i].address, param[i].index) : 0;
+        quals[i] = valid ? 0 : 1;
+    }
+
+    tekon_resp_1c(response, self->gateway, values, quals, request->nelements);
+}
+
+void sim_init(struct sim * self, uint8_t gateway)
+{
+    assert(self);
+    memset(self, 0, sizeof(*self));
+    self->gateway = gateway;
+    self->depth = SIM_DEPTH;
+    self->clock.gateway = gateway;
+    self->clock.device = 3;
+    self->clock.date = 0xF017;
+    self->clock.time = 0xF018;
+    self->seed = 1;
+}
+
+int sim_set(struct sim * self, uint8_t device, uint16_t address, uint16_t index, uint32_t value)
+{
+    assert(self);
+
+    const uint64_t key = param_key(device, address, index);
+    const size_t pos = param_find(self, key);
+    struct sim_param * param = &self->params[pos];
+
+    if(pos < self->size && param_key(param->device, param->address, param->index) == key) {
+        param->value = value;
+        return 1;
+    }
+
+    if(self->size == SIM_MAX_PARAMS)
+        return 0;
+
+    memmove(param + 1, param, (self->size - pos) * sizeof(*param));
+    param->device = device;
+    param->address = address;
+    param->index = index;
+    param->value = value;
+    self->size++;
+    return 1;
+}
+
+uint32_t sim_get(const struct sim * self, uint8_t device, uint16_t address, uint16_t index)
+{
+    assert(self);
+
+    const uint64_t key = param_key(device, address, index);
+    const size_t pos = param_find(self, key);
+    const struct sim_param * param = &self->params[pos];
+
+    if(pos < self->size && param_key(param->device, param->address, param->index) == key)
+        return param->value;
+
+    /* Сгенерированное значение позволяет проверить, что ответ относится к
+     * запрошенному параметру */
+    return (uint32_t)address << 16 | (index == TEKON_INVALID_INDEX ? 0 : index);
+}
+
+int sim_set_from_string(struct sim * self, const char * str)
+{
+    assert(self);
+    assert(str);
+
+    unsigned long field[3];
+    char * end = NULL;
+    size_t i;
+
+    for(i = 0; i < 3; i++) {
+        field[i] = strtoul(str, &end, 0);
+        if(end == str || *end != ':')
+            return 0;
+        str = end + 1;
+    }
+
+    if(field[0] > 0xFF || field[1] > 0xFFFF || field[2] > 0xFFFF)
+        return 0;
+
+    uint32_t value;
+    if(strchr(str, '.')) {
+        const float f32 = strtof(str, &end);
+        memcpy(&value, &f32, sizeof(value));
+    } else {
+        value = strtoul(str, &end, 0);
+    }
+
+    if(end == str || *end != '\0')
+        return 0;
+
+    return sim_set(self, field[0], field[1], field[2], value);
+}
+
+ssize_t sim_process(struct sim * self, const void * request, size_t len, void * reply, size_t size)
+{
+    assert(self);
+    assert(request);
+    assert(reply);
+
+    struct message in;
+    struct message out;
+    uint8_t number = 0;
+
+    self->stat.requests++;
+
+    if(tekon_req_unpack(request, len, &in, &number) <= 0 || in.gateway != self->gateway) {
+        self->stat.invalid++;
+        return 0;
+    }
+
+    switch(in.type) {
+    case TEKON_MSG_READEM_PAR_11: {
+        const struct tekon_parameter * param = in.payload.parameters;
+        tekon_resp_11(&out, self->gateway, param_value(self, param->device, param->address, 0));
+    }
+    break;
+    case TEKON_MSG_WRITEM_PAR_14:
+        process_14(self, &in, &out);
+        break;
+    case TEKON_MSG_READEM_IND_LIST_19:
+        process_19(self, &in, &out);
+        break;
+    case TEKON_MSG_READEM_PAR_LIST_1C:
+        process_1c(self, &in, &out);
+        break;
+    default:
+        self->stat.invalid++;
+        return 0;
+    }
+
+    const ssize_t result = tekon_resp_pack(reply, size, &out, number);
+    if(result > 0)
+        self->stat.replies++;
+    return result;
+}
+
+int64_t sim_schedule(struct sim * self, size_t reqlen, size_t replen, int64_t now)
+{
+    assert(self);
+
+    const struct sim_faults * faults = &self->faults;
+
+    if(faults->loss && sim_random(self) % 1000000 < faults->loss) {
+        self->stat.lost++;
+        return -1;
+    }
+
+    /* Половина задержки - до шлюза, половина - обратно */
+    int64_t due = now + faults->latency / 2;
+
+    /* Шлюз обслуживает запросы по одному, шина занята на время передачи
+     * запроса и ответа: 10 бит на байт (старт, 8 бит данных, стоп) */
+    if(faults->baud) {
+        if(due < self->bus)
+            due = self->bus;
+        due += (int64_t)(reqlen + replen) * 10 * 1000000 / faults->baud;
+        self->bus = due;
+    }
+
+    due += faults->latency - faults->latency / 2;
+    if(faults->jitter)
+        due += sim_random(self) % (faults->jitter + 1);
+    return due;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,101 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef TEST_SIM_SIM_H
+#define TEST_SIM_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "utils/base/types.h"
+
+/* Макс. кол-во параметров с заданным значением */
+#define SIM_MAX_PARAMS 4096
+
+/* Глубина архивов по умолчанию (без ограничения) */
+#define SIM_DEPTH 0xFFFF
+
+/* Параметр с заданным значением */
+struct sim_param {
+    uint8_t device;
+    uint16_t address;
+    uint16_t index;
+    uint32_t value;
+};
+
+/* Модель канала и шины */
+struct sim_faults {
+    uint32_t latency; /* задержка сети туда-обратно, мкс */
+    uint32_t jitter;  /* случайная добавка [0, jitter], мкс */
+    uint32_t loss;    /* вероятность потери запроса, миллионные доли */
+    uint32_t baud;    /* скорость последовательной шины. 0 - без шины */
+};
+
+struct sim_stat {
+    uint64_t requests; /* принятые запросы */
+    uint64_t replies;  /* сформированные ответы */
+    uint64_t lost;     /* запросы, потерянные по модели канала */
+    uint64_t invalid;  /* поврежденные или чужие запросы */
+};
+
+/* Эмулятор шлюза Тэкон.
+ * Отвечает на запросы 0x11, 0x14, 0x19, 0x1C одного шлюза. Значения
+ * параметров берутся из таблицы, для остальных параметров генерируются:
+ * (адрес << 16) | индекс. Архивы - индексные параметры глубины depth.
+ * Часы устройства читаются и записываются по адресам clock и идут вместе с
+ * часами хоста со сдвигом offset.
+ *
+ * Модель канала: ответ задерживается на latency + [0, jitter], запрос
+ * теряется с вероятностью loss. Если задана скорость шины, запросы
+ * обслуживаются по одному, и каждый занимает шину на время передачи
+ * запроса и ответа (10 бит на байт). Случайные величины берутся из
+ * генератора с начальным значением seed, поэтому прогоны воспроизводимы */
+struct sim {
+    uint8_t gateway;
+    struct sim_param params[SIM_MAX_PARAMS];
+    size_t size;
+    uint16_t depth;
+    struct dtaddr clock;
+    int64_t offset; /* сдвиг часов устройства от часов хоста, сек */
+    uint8_t level;  /* текущий уровень доступа */
+    struct sim_faults faults;
+    uint32_t seed;
+    int64_t bus;    /* момент освобождения шины, мкс */
+    struct sim_stat stat;
+};
+
+void sim_init(struct sim * self, uint8_t gateway);
+
+/* Задать значение параметра.
+ * 1 - успешно
+ * 0 - таблица заполнена */
+int sim_set(struct sim * self, uint8_t device, uint16_t address, uint16_t index, uint32_t value);
+
+/* Значение параметра из таблицы или сгенерированное */
+uint32_t sim_get(const struct sim * self, uint8_t device, uint16_t address, uint16_t index);
+
+/* Прочитать значение параметра из строки dev:addr:index:value. Значение
+ * с точкой задает float.
+ * 1 - успешно
+ * 0 - ошибка */
+int sim_set_from_string(struct sim * self, const char * str);
+
+/* Обработать запрос и сформировать ответ.
+ * Возвращает размер ответа. 0 - запрос без ответа (поврежден, чужой шлюз) */
+ssize_t sim_process(struct sim * self, const void * request, size_t len, void * reply, size_t size);
+
+/* Рассчитать момент отправки ответа (мкс) для запроса, принятого в now.
+ * -1 - запрос потерян */
+int64_t sim_schedule(struct sim * self, size_t reqlen, size_t replen, int64_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
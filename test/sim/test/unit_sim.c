@@ -0,0 +1,196 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "test/minunit.h"
+#include "test/sim/sim.h"
+#include "tekon/tekon.h"
+#include "utils/base/time.h"
+#include <string.h>
+
+#define TEST_GATEWAY 9
+
+static struct sim sim;
+
+/* Отправить запрос эмулятору и разобрать ответ.
+ * Возвращает размер ответа */
+static ssize_t exchange(const struct message * request, struct message * response, uint8_t number)
+{
+    uint8_t in[512];
+    uint8_t out[512];
+    uint8_t rnumber = 0xFF;
+
+    const ssize_t len = tekon_req_pack(in, sizeof(in), request, number);
+    if(len <= 0)
+        return 0;
+
+    const ssize_t rlen = sim_process(&sim, in, len, out, sizeof(out));
+    if(rlen <= 0)
+        return rlen;
+
+    if(tekon_resp_unpack(out, rlen, response, request->type, &rnumber) <= 0)
+        return 0;
+
+    if(rlen > 1 && rnumber != number)
+        return 0;
+    return rlen;
+}
+
+MU_TEST(test_values)
+{
+    struct message request;
+    struct message response;
+    const uint8_t devices[3] = {3, 3, 4};
+    const uint16_t addresses[3] = {0x8003, 0x0100, 0x0200};
+    const uint16_t indexes[3] = {TEKON_INVALID_INDEX, 5, TEKON_INVALID_INDEX};
+    float f32;
+
+    sim_init(&sim, TEST_GATEWAY);
+    mu_check(sim_set_from_string(&sim, "3:0x8003:0xFFFF:1.5"));
+    mu_check(sim_set_from_string(&sim, "4:0x200:0xFFFF:42"));
+    mu_check(!sim_set_from_string(&sim, "4:0x200:42"));
+    mu_check(!sim_set_from_string(&sim, "256:0x200:0:42"));
+
+    /* Заданные и сгенерированные значения */
+    tekon_req_1c(&request, TEST_GATEWAY, devices, addresses, indexes, 3);
+    mu_check(exchange(&request, &response, 5) > 0);
+    mu_assert_int_eq(TEKON_MSG_READEM_PAR_LIST_1C, response.type);
+    mu_assert_int_eq(3, response.nelements);
+    memcpy(&f32, &response.payload.parameters[0].value, sizeof(f32));
+    mu_assert_double_eq(1.5, f32);
+    mu_assert_int_eq(0x01000005, response.payload.parameters[1].value);
+    mu_assert_int_eq(42, response.payload.parameters[2].value);
+
+    tekon_req_11(&request, TEST_GATEWAY, 4, 0x0300);
+    mu_check(exchange(&request, &response, 1) > 0);
+    mu_assert_int_eq(0x03000000, response.payload.parameters[0].value);
+
+    /* Чужой шлюз не отвечает */
+    tekon_req_11(&request, TEST_GATEWAY + 1, 4, 0x0300);
+    mu_assert_int_eq(0, exchange(&request, &response, 1));
+    mu_assert_int_eq(1, sim.stat.invalid);
+    mu_assert_int_eq(2, sim.stat.replies);
+}
+
+MU_TEST(test_archive)
+{
+    struct message request;
+    struct message response;
+    const uint8_t devices[2] = {3, 3};
+    const uint16_t addresses[2] = {0x0100, 0x0100};
+    const uint16_t indexes[2] = {9, 10};
+
+    sim_init(&sim, TEST_GATEWAY);
+    sim.depth = 10;
+
+    tekon_req_19(&request, TEST_GATEWAY, 3, 0x0100, 6, 4);
+    mu_check(exchange(&request, &response, 2) > 0);
+    mu_assert_int_eq(4, response.nelements);
+    mu_assert_int_eq(0x01000009, response.payload.parameters[3].value);
+
+    /* Выход за глубину архива */
+    tekon_req_19(&request, TEST_GATEWAY, 3, 0x0100, 7, 4);
+    mu_assert_int_eq(1, exchange(&request, &response, 3));
+    mu_assert_int_eq(TEKON_MSG_NEG_ACK, response.type);
+
+    tekon_req_1c(&request, TEST_GATEWAY, devices, addresses, indexes, 2);
+    mu_check(exchange(&request, &response, 4) > 0);
+    mu_assert_int_eq(0, response.payload.parameters[0].qual);
+    mu_check(response.payload.parameters[1].qual != 0);
+}
+
+MU_TEST(test_clock)
+{
+    struct message request;
+    struct message response;
+    const uint8_t devices[2] = {3, 3};
+    const uint16_t addresses[2] = {0xF017, 0xF018};
+    const uint16_t indexes[2] = {TEKON_INVALID_INDEX, TEKON_INVALID_INDEX};
+    const uint8_t login[8] = {0x07, 3, 0x05, 3, 0, 0, 0, 1};
+    uint8_t write[9] = {0x08, 3, 0x03, 0x18, 0xF0, 0, 0, 0, 0};
+    struct tekon_time time = {12, 34, 56};
+    struct tekon_time devtime;
+
+    sim_init(&sim, TEST_GATEWAY);
+
+    /* Запись без установки уровня доступа */
+    tekon_time_pack(&time, write + 5, 4);
+    tekon_req_14(&request, TEST_GATEWAY, write, sizeof(write));
+    mu_assert_int_eq(1, exchange(&request, &response, 1));
+    mu_assert_int_eq(TEKON_MSG_NEG_ACK, response.type);
+
+    tekon_req_14(&request, TEST_GATEWAY, login, sizeof(login));
+    mu_check(exchange(&request, &response, 2) > 1);
+
+    tekon_req_14(&request, TEST_GATEWAY, write, sizeof(write));
+    mu_assert_int_eq(1, exchange(&request, &response, 3));
+    mu_assert_int_eq(TEKON_MSG_POS_ACK, response.type);
+
+    tekon_req_1c(&request, TEST_GATEWAY, devices, addresses, indexes, 2);
+    mu_check(exchange(&request, &response, 4) > 0);
+    mu_check(tekon_time_unpack(&devtime, &response.payload.parameters[1].value, 4));
+    mu_assert_int_eq(12, devtime.hour);
+    mu_assert_int_eq(34, devtime.minute);
+    /* Часы идут */
+    mu_check(devtime.second >= 56 || devtime.second < 5);
+}
+
+MU_TEST(test_schedule)
+{
+    const int64_t now = 1000000;
+    int64_t due[8];
+    size_t i;
+
+    sim_init(&sim, TEST_GATEWAY);
+    sim.faults.latency = 2000;
+    mu_assert_int_eq(now + 2000, sim_schedule(&sim, 10, 10, now));
+
+    /* 20 байт на 9600 бод - 20833 мкс. Запросы обслуживаются по очереди */
+    sim.faults.baud = 9600;
+    due[0] = sim_schedule(&sim, 10, 10, now);
+    due[1] = sim_schedule(&sim, 10, 10, now);
+    mu_assert_int_eq(now + 2000 + 20833, due[0]);
+    mu_assert_int_eq(due[0] + 20833, due[1]);
+
+    /* Одно начальное значение - одна последовательность */
+    sim_init(&sim, TEST_GATEWAY);
+    sim.faults.jitter = 1000;
+    sim.faults.loss = 500000;
+    sim.seed = 7;
+    for(i = 0; i < 8; i++)
+        due[i] = sim_schedule(&sim, 10, 10, now);
+
+    sim_init(&sim, TEST_GATEWAY);
+    sim.faults.jitter = 1000;
+    sim.faults.loss = 500000;
+    sim.seed = 7;
+    for(i = 0; i < 8; i++) {
+        mu_assert_int_eq(due[i], sim_schedule(&sim, 10, 10, now));
+        mu_check(due[i] < 0 || (due[i] >= now && due[i] <= now + 1000));
+    }
+    mu_check(sim.stat.lost > 0 && sim.stat.lost < 8);
+}
+
+MU_TEST_SUITE(suite_sim)
+{
+    MU_RUN_TEST(test_values);
+    MU_RUN_TEST(test_archive);
+    MU_RUN_TEST(test_clock);
+    MU_RUN_TEST(test_schedule);
+}
+
+int main()
+{
+    MU_RUN_SUITE(suite_sim);
+    MU_REPORT();
+    return mu_get_fails();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,75 @@
+#!/bin/bash
+# Проверка утилит на эмуляторе шлюза
+OUT=/tmp/out
+BINDIR="$1"
+TEST_CNT=1
+SIM_PID=
+
+fail()
+{
+  echo $1
+  [ -n "${SIM_PID}" ] && kill ${SIM_PID}
+  exit 1
+}
+
+expect()
+{
+  grep "$1" ${OUT} > /dev/null || fail "Invalid output. Can't find $1"
+}
+
+start_test()
+{
+  echo -n "TEST #${TEST_CNT} : $1..."
+  TEST_CNT=$((TEST_CNT + 1))
+}
+
+echo "<-- SIMULATOR TEST SUITE -->"
+echo "Binary dir: ${BINDIR}"
+
+${BINDIR}/test/sim/tekon_sim -a udp:127.0.0.1:59161@2 -a tcp:127.0.0.1:59161@2 -p '3:0x8003:0:1.5 3:0x8004:0:77' -n 100 -l 1 -v0 &
+SIM_PID=$!
+sleep 0.5
+
+for TYPE in udp tcp; do
+  start_test "${TYPE} measurments"
+  ${BINDIR}/utils/msr/tekon_msr -a ${TYPE}:127.0.0.1:59161@2 -p '3:0x8003:0:F 3:0x8004:0:U 3:0x100:5:H' -t 500 > ${OUT} 2>/dev/null
+  expect '2:3:0x8003:0 F 1.500000 OK'
+  expect '2:3:0x8004:0 U 77 OK'
+  expect '2:3:0x100:5 H 0x1000005 OK'
+  echo "Done"
+done
+
+start_test "archive"
+${BINDIR}/utils/arch/tekon_arch -a udp:127.0.0.1:59161@2 -p '3:0x100:0:100:U' -w 4 -t 500 > ${OUT} 2>/dev/null
+LN=$(grep -c ' OK ' ${OUT})
+[ "$LN" -eq 100 ] || fail "Invalid output. Got ${LN} records instead of 100"
+expect '2:3:0x100:99 U 16777315 OK'
+echo "Done"
+
+start_test "time synchronization"
+DT=$(($(date -u +%s) + 7200))
+${BINDIR}/utils/sync/tekon_sync -a tcp:127.0.0.1:59161@2 -d 3:0xF017:0xF018 -p00000001 -u ${DT} -c none -t 500 > /dev/null 2>&1 || fail "Sync failed"
+${BINDIR}/utils/msr/tekon_msr -a udp:127.0.0.1:59161@2 -p '3:0xF018:0:T' -t 500 > ${OUT} 2>/dev/null
+EXPECT=$(date -d @${DT} +%H:%M)
+expect "T ${EXPECT}"
+echo "Done"
+
+start_test "capture"
+CAP=$(mktemp)
+${BINDIR}/utils/arch/tekon_arch -a tcp:127.0.0.1:59161@2 -p '3:0x100:0:100:U' -w 4 -t 500 --capture ${CAP} > ${OUT}.live 2>/dev/null || fail "Capture failed"
+echo "Done"
+
+start_test "faults"
+${BINDIR}/utils/arch/tekon_arch -a udp:127.0.0.1:59161@2 -p '3:0x100:0:100:U' -w 4 -t 100 -r 10 --fault 'drop=20,dup=5,reorder=5,truncate=5,corrupt=5,delay=5:20,seed=3' > ${OUT} 2>/dev/null || fail "Read with faults failed"
+cmp -s ${OUT} ${OUT}.live || fail "Output with faults differs"
+echo "Done"
+
+kill ${SIM_PID}
+wait ${SIM_PID} 2>/dev/null
+
+start_test "replay"
+${BINDIR}/utils/arch/tekon_arch -a tcp:127.0.0.1:59161@2 -p '3:0x100:0:100:U' -w 4 -t 500 --replay ${CAP} --speed 0 > ${OUT} 2>/dev/null || fail "Replay failed"
+cmp -s ${OUT} ${OUT}.live || fail "Replayed output differs"
+echo "Done"
+
+rm ${OUT} ${OUT}.live ${CAP}
@@ -70,16 +70,62 @@ void rec_update(struct rec * self, enum quality qual, const void * data, size_t
 }
 
 
+/* Кол-во индексов последовательности меток времени архива */
+static size_t seq_capacity(const struct intcfg * interval)
+{
+    switch(interval->type) {
+    case 'm':
+    case 'h':
+    case 'i':
+        return interval->depth;
+    case 'd':
+        return 366;
+    }
+    return 0;
+}
+
 void archive_init(struct archive * self)
 {
     assert(self);
     memset(self, 0, sizeof(*self));
 }
 
+int archive_alloc(struct archive * self, size_t capacity)
+{
+    assert(self);
+
+    if(capacity > ARCHIVE_MAX_SIZE)
+        return 0;
+
+    const size_t tcapacity = seq_capacity(&self->interval);
+
+    archive_free(self);
+    if(arena_init(&self->arena, arena_aligned(capacity * sizeof(struct rec)) +
+                  arena_aligned(tcapacity * sizeof(int64_t))) != 0)
+        return 0;
+
+    self->rec = capacity ? arena_alloc(&self->arena, capacity * sizeof(struct rec)) : NULL;
+    self->time = tcapacity ? arena_alloc(&self->arena, tcapacity * sizeof(int64_t)) : NULL;
+    self->capacity = capacity;
+    self->tcapacity = tcapacity;
+    return 1;
+}
+
+void archive_free(struct archive * self)
+{
+    assert(self);
+    arena_free(&self->arena);
+    self->rec = NULL;
+    self->time = NULL;
+    self->size = 0;
+    self->capacity = 0;
+    self->tcapacity = 0;
+}
+
 struct rec * archive_get(struct archive * self, size_t index)
 {
     assert(self);
-    return index < ARCHIVE_MAX_SIZE ? &self->rec[index] : NULL;
+    return index < self->capacity ? &self->rec[index] : NULL;
 }
 
 int archive_add(struct archive * self, const struct rec * rec)
@@ -87,7 +133,7 @@ int archive_add(struct archive * self, const struct rec * rec)
     assert(self);
     assert(rec);
 
-    if(self->size >= ARCHIVE_MAX_SIZE)
+    if(self->size >= self->capacity)
         return 0;
 
     self->rec[self->size++] = *rec;
@@ -128,7 +174,7 @@ int archive_index_to_utc(struct archive * self, const struct devtime * from, con
         return 0;
 
     struct timestamp_seq seq;
-    timestamp_seq_init(&seq);
+    timestamp_seq_init(&seq, self->time, self->tcapacity);
     switch(self->interval.type) {
     case 'm':
         timestamp_seq_month(&seq, &to->date, self->interval.depth);
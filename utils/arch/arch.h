@@ -13,6 +13,7 @@ extern "C" {
 #include <stdint.h>
 #include "tekon/proto.h"
 #include "tekon/time.h"
+#include "utils/base/arena.h"
 #include "utils/base/time.h"
 #include "utils/base/tstamp.h"
 #include "utils/base/types.h"
@@ -40,15 +41,28 @@ void rec_init(struct rec * self, uint16_t index);
 void rec_update(struct rec * self, enum quality qual, const void * data, size_t size);
 
 
+/* Записи архива и метки времени для них размещаются в одной арене,
+ * размер которой определяется кол-вом читаемых записей и глубиной архива */
 struct archive {
     struct paraddr address;
     struct intcfg interval;
     size_t size;
-    struct rec rec[ARCHIVE_MAX_SIZE];
+    size_t capacity;
+    struct rec * rec;
+    int64_t * time;    /* буфер последовательности меток времени */
+    size_t tcapacity;
+    struct arena arena;
 };
 
 void archive_init(struct archive * self);
 
+/* Выделить память под capacity записей и метки времени интервала
+ * (interval должен быть задан заранее).
+ * 0 - в случае ошибки */
+int archive_alloc(struct archive * self, size_t capacity);
+
+void archive_free(struct archive * self);
+
 struct rec * archive_get(struct archive * self, size_t index);
 
 int archive_add(struct archive * self, const struct rec * rec);
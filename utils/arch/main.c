@@ -8,6 +8,7 @@ extern "C" {
 #endif
 
 #include <assert.h>
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -24,11 +25,15 @@ extern "C" {
 #define APP_WARN LOG_WARN APP_NAME " : WARN"
 #define APP_INFO LOG_INFO APP_NAME " : INFO"
 
+/* Макс. кол-во повторов запроса */
+#define APP_MAX_RETRIES 10
+
 struct app {
 
     struct netaddr netcfg;
     struct dtaddr dtcfg;
     struct link link;
+    struct pipeline pipeline;
 
     struct archive archive;
 
@@ -37,7 +42,11 @@ struct app {
 
     int tzoffset;
     int timeout;
+    struct rttcfg rtt;
+    int retries;
+    int window;
     int use_tsc; /*time stamp converter*/
+    struct diag diag;
 };
 
 static void apply_noconn(struct rec * rec, void * data);
@@ -45,7 +54,8 @@ static void print(struct rec * self, void * data );
 
 static void usage()
 {
-    printf("Usage: %s -a address -p parameters [-t timeout] [-v verbosity]\n\n", APP_NAME);
+    printf("Usage: %s -a address -p parameters [-t timeout] [-T min:max] [-r retries] [-w window] [--stats] [-v verbosity]\n", APP_NAME);
+    printf("                 [--capture file] [--replay file [--speed N]] [--fault spec] [--trace file]\n\n");
     printf("  -a    gateway's address in [type:ip:port@gateway] format.\n\n");
     printf("  -p    parameter for reading in [device:parameter:index:count:type] format.\n");
     printf("        index - start index\n");
@@ -64,6 +74,11 @@ static void usage()
     printf("            h - hours [384, 768, 1536]\n");
     printf("            i - interval\n\n");
     printf("  -t    response timeout in milliseconds\n\n");
+    printf("  -T    adaptive response timeout bounds in [min:max] format, ms.\n");
+    printf("        Timeout follows measured round-trip time. -t sets initial value.\n\n");
+    printf("  -r    number of retries of a failed request [0, %d]. Default is 0.\n\n", APP_MAX_RETRIES);
+    printf("  -w    number of requests in flight [1, %d]. Default is 1.\n\n", PIPELINE_MAX_WINDOW);
+    diag_usage(stdout, 1);
     printf("  -v    set verbose:\n");
     printf("        0 - silent \n");
     printf("        1 - error\n");
@@ -84,54 +99,12 @@ static void init(struct app * self)
     archive_init(&self->archive);
     self->tzoffset = time_tzoffset();
     self->timeout = 1000;
-}
-
-/* Запрос - ответ
- * 0 - в случае ошибки */
-static int process_request(const struct message * request, struct message * response, struct link * link)
-{
-    assert(request);
-    assert(response);
-    assert(link);
-
-    char in[512];
-    char out[512];
-
-    uint8_t nin = 0;
-    static uint8_t nout = 0;
-    nout = (nout + 1) % 16;
-
-    int result = tekon_req_pack(out, sizeof(out), request, nout);
-
-    if(result <= 0) {
-        log_print(APP_ERR " : packing error\n");
-        return 0;
-    }
-
-    result = link_send(link, out, result);
-    if(result <= 0) {
-        log_print(APP_ERR " : sending error %d\n", result);
-        return 0;
-    }
-
-    result = link_recv(link, in, sizeof(in));
-    if(result <= 0) {
-        log_print(APP_ERR " : receiving error %d\n", result);
-        return 0;
-    }
-
-    result = tekon_resp_unpack(in, result, response, request->type, &nin);
-
-    if(result <= 0) {
-        log_print(APP_ERR " : unpacking error\n");
-        return 0;
-    }
-
-    return nin == nout && request->nelements == response->nelements;
+    self->window = 1;
+    diag_init(&self->diag, APP_NAME);
 }
 
 /* Прочитать время из устройства */
-static int read_time(struct tekon_date * date, struct tekon_time * time, const struct dtaddr * dtaddr, struct link * link)
+static int read_time(struct tekon_date * date, struct tekon_time * time, const struct dtaddr * dtaddr, struct pipeline * pipeline)
 {
 
     uint8_t size = 2;
@@ -148,7 +121,7 @@ static int read_time(struct tekon_date * date, struct tekon_time * time, const s
         return 0;
     }
 
-    result = process_request(&request, &response, link) > 0 &&
+    result = pipeline_request(pipeline, &request, &response) &&
              tekon_date_unpack(date, &response.payload.parameters[0].value, 4) &&
              tekon_time_unpack(time, &response.payload.parameters[1].value, 4);
 
@@ -158,21 +131,28 @@ static int read_time(struct tekon_date * date, struct tekon_time * time, const s
     return result;
 }
 
-/* Прочитать часть архива (<= 40 записей)
+/* Размер части архива, начинающейся с позиции pos */
+static size_t chunk_size(size_t pos, size_t lim)
+{
+    const size_t diff = lim - pos;
+    return diff > TEKON_PROTO_PLIST_SIZE ? TEKON_PROTO_PLIST_SIZE : diff;
+}
+
+/* Подготовить запрос на чтение части архива (<= 40 записей)
  * 0 - в случае ошибки */
-static int read_chunk(struct archive * archive, size_t pos, size_t size, struct link * link)
+static int prepare_chunk(void * ctx, size_t index, struct message * request)
 {
-    assert(size <= TEKON_PROTO_PLIST_SIZE);
+    struct archive * archive = ctx;
+    const size_t pos = index * TEKON_PROTO_PLIST_SIZE;
+    const size_t size = chunk_size(pos, archive_size(archive));
 
+    assert(size <= TEKON_PROTO_PLIST_SIZE);
 
     uint8_t gateway = archive->address.gateway;
     uint8_t devices[TEKON_PROTO_PLIST_SIZE];
     uint16_t addresses[TEKON_PROTO_PLIST_SIZE];
     uint16_t indexes[TEKON_PROTO_PLIST_SIZE];
 
-    struct message request;
-    struct message response;
-
     size_t i;
 
     for(i = 0; i < size; i++) {
@@ -181,31 +161,36 @@ static int read_chunk(struct archive * archive, size_t pos, size_t size, struct
         indexes[i] = archive_get(archive, pos + i)->index;
     }
 
-    int result = tekon_req_1c(&request, gateway, devices, addresses, indexes, size);
+    int result = tekon_req_1c(request, gateway, devices, addresses, indexes, size);
 
-    if(!result) {
+    if(!result)
         log_print(APP_ERR " : can't create request\n");
-        return 0;
-    }
 
-    result = process_request(&request, &response, link);
+    return result;
+}
 
-    const struct tekon_parameter * param = response.payload.parameters;
-    for(i = 0; i < size; i++, param++) {
+/* Записать значение ответа прямо в запись архива */
+static void sink_chunk(void * ctx, size_t index, size_t element, uint32_t value, uint8_t qual)
+{
+    struct archive * archive = ctx;
+    const size_t pos = index * TEKON_PROTO_PLIST_SIZE;
 
-        const uint32_t * value = NULL;
-        enum quality qual = Q_NOCONN;
-        size_t len = 0;
-        if(result > 0 ) {
-            value = &param->value;
-            qual = param->qual == 0 ? Q_OK : Q_INVALID;
-            len = 4;
-        }
+    rec_update(archive_get(archive, pos + element), qual == 0 ? Q_OK : Q_INVALID, &value, sizeof(value));
+}
 
-        rec_update(archive_get(archive, pos + i), qual, value, len);
+/* Завершить часть архива. Значения уже записаны sink_chunk, в случае
+ * ошибки (response == NULL) часть получает признак ошибки связи */
+static void complete_chunk(void * ctx, size_t index, const struct message * response)
+{
+    struct archive * archive = ctx;
+    const size_t pos = index * TEKON_PROTO_PLIST_SIZE;
+    const size_t size = chunk_size(pos, archive_size(archive));
 
+    size_t i;
+    if(!response) {
+        for(i = 0; i < size; i++)
+            rec_update(archive_get(archive, pos + i), Q_NOCONN, NULL, 0);
     }
-    return result > 0;
 }
 
 /* Прочитать весь архив
@@ -213,24 +198,17 @@ static int read_chunk(struct archive * archive, size_t pos, size_t size, struct
 static int read_archive(struct app * app)
 {
     const size_t lim = archive_size(&app->archive);
-    size_t pos = 0;
-
-    while(pos < lim) {
-        const size_t diff = lim - pos;
-        const size_t chunk = diff == 1 ? 1 :
-                             diff > TEKON_PROTO_PLIST_SIZE ? TEKON_PROTO_PLIST_SIZE :
-                             diff;
+    const size_t nchunks = (lim + TEKON_PROTO_PLIST_SIZE - 1) / TEKON_PROTO_PLIST_SIZE;
 
+    /* Архив читается частями по TEKON_PROTO_PLIST_SIZE записей, в сети
+     * одновременно может находиться до window запросов. Если часть архива
+     * была прочитана с ошибкой, то остальные не запрашиваются и остаются
+     * с ошибкой связи. */
+    const size_t done = pipeline_run_sink(&app->pipeline, nchunks, prepare_chunk, sink_chunk, complete_chunk, &app->archive);
 
-        /* Если порция данных была прочитана с ошибкой, то нет смысла читать
-         * остальные. Просто стивим всем оставшимся ошибку связи. Чтобы
-         * сделать это с минимальным трудом, кладем коннект и пытаемся
-         * вычитать данные на отключенном линке. */
-        if(!read_chunk(&app->archive, pos, chunk, &app->link)) {
-            log_print(APP_ERR " : archive reading failed at %zd:%zd:%zd\n", pos, chunk, lim);
-            return 0;
-        }
-        pos += chunk;
+    if(done != nchunks) {
+        log_print(APP_ERR " : archive reading failed at %zd:%zd:%d\n", done, lim, app->pipeline.error);
+        return 0;
     }
     return 1;
 }
@@ -248,6 +226,11 @@ static int read_data(struct app * app)
     else if(app->netcfg.type == LINK_UDP)
         link_init_udp(&app->link, app->netcfg.ip, app->netcfg.port, app->timeout);
 
+    if(app->rtt.max)
+        rtt_init(&app->link.rtt, app->timeout, app->rtt.min, app->rtt.max);
+
+    diag_attach(&app->diag, &app->link);
+
     /* Установить подключение и флаг нет связи */
     int result = link_up(&app->link);
 
@@ -258,9 +241,13 @@ static int read_data(struct app * app)
         return 0;
     }
 
+    pipeline_init(&app->pipeline, &app->link, app->window);
+    app->pipeline.retries = app->retries;
+    app->pipeline.stats = diag_stats(&app->diag);
+
     /* Прочитать время с утсройства */
     if(app->use_tsc) {
-        if(!read_time(&app->begin_at.date, &app->begin_at.time, &app->dtcfg, &app->link)) {
+        if(!read_time(&app->begin_at.date, &app->begin_at.time, &app->dtcfg, &app->pipeline)) {
             link_down(&app->link);
             return 0;
         }
@@ -277,13 +264,16 @@ static int read_data(struct app * app)
 
     /* Прочитать время с утсройства */
     if(app->use_tsc) {
-        if(!read_time(&app->end_at.date, &app->end_at.time, &app->dtcfg, &app->link)) {
+        if(!read_time(&app->end_at.date, &app->end_at.time, &app->dtcfg, &app->pipeline)) {
             link_down(&app->link);
             return 0;
         }
 
     }
 
+    if(app->link.stat.discarded)
+        log_print(APP_WARN " : discarded replies %"PRIu64"\n", app->link.stat.discarded);
+
     /* Закрыть коннект */
     link_down(&app->link);
     return 1;
@@ -302,7 +292,7 @@ static int read_args(struct app * app, int argc, char * const argv[])
     uint8_t gateway = 0;
 
 
-    while ((opt = getopt(argc, argv, "t:a:p:i:d:v:")) != -1) {
+    while ((opt = getopt_long(argc, argv, "t:T:a:p:i:d:r:v:w:", diag_options, NULL)) != -1) {
         switch (opt) {
         case 't': {
             long input  = atol(optarg);
@@ -314,6 +304,16 @@ static int read_args(struct app * app, int argc, char * const argv[])
             }
         }
         break;
+        case 'w': {
+            long input  = atol(optarg);
+            if(input <= 0 || input > PIPELINE_MAX_WINDOW) {
+                printf("invalid window %s\n\n", optarg);
+                return 0;
+            } else {
+                app->window = (int)input;
+            }
+        }
+        break;
         case 'p':
             if(gateway == 0) {
                 printf("enter address before parameters list\n\n");
@@ -345,12 +345,34 @@ static int read_args(struct app * app, int argc, char * const argv[])
                 return 0;
             }
             break;
+        case 'T':
+            if(!rttcfg_from_string(&app->rtt, optarg)) {
+                printf("invalid timeout bounds %s\n\n", optarg);
+                return 0;
+            }
+            break;
+        case 'r': {
+            long input  = atol(optarg);
+            if(input < 0 || input > APP_MAX_RETRIES || !isdigit((unsigned char)*optarg)) {
+                printf("invalid retries %s\n\n", optarg);
+                return 0;
+            } else {
+                app->retries = (int)input;
+            }
+        }
+        break;
         case 'v':
             log_setlevel(atoi(optarg));
             break;
-        default: /* '?' */
-            printf("invalid argument %c\n\n", opt);
-            return 0;
+        default: {
+            /* Опции диагностики обмена или '?' */
+            const int result = diag_option(&app->diag, opt, optarg);
+            if(result < 0)
+                printf("invalid argument %c\n\n", opt);
+            if(result <= 0)
+                return 0;
+        }
+        break;
         }
     }
 
@@ -395,11 +417,6 @@ static int read_args(struct app * app, int argc, char * const argv[])
         return 0;
     }
 
-    if(size > ARCHIVE_MAX_SIZE) {
-        printf("archive overflow. Can't read more than %d values\n\n", ARCHIVE_MAX_SIZE);
-        return 0;
-    }
-
     if(limit !=0 &&
             start + size > limit) {
         printf("please enter valid parameter and interval\n");
@@ -415,6 +432,12 @@ static int fill_acrhive(struct archive * archive)
 {
     assert(archive);
 
+    /* Память выделяется под заданное кол-во записей и глубину архива */
+    if(!archive_alloc(archive, archive->address.count)) {
+        log_print(APP_ERR " : can't allocate archive of %u records\n", (unsigned)archive->address.count);
+        return 0;
+    }
+
     /* Заполнить архив */
     size_t i;
     for(i = 0; i < archive->address.count; i++) {
@@ -545,7 +568,7 @@ static void sigint(int sig)
 int main(int argc, char * argv[])
 {
 
-    struct app app;
+    static struct app app;
 
     init(&app);
 
@@ -561,14 +584,24 @@ int main(int argc, char * argv[])
     if(!fill_acrhive(&app.archive))
         return 1;
 
+    if(diag_open(&app.diag) != 0)
+        return 1;
+
     /* Прочитать данные из утсройства */
+    TEKON_TRACE_BEGIN(TEKON_TRACE_CYCLE);
     int result = read_data(&app);
+    TEKON_TRACE_END(TEKON_TRACE_CYCLE, result);
+    diag_close(&app.diag);
 
     /* Перевести индексы в метки времени */
     archive_index_to_utc(&app.archive, &app.begin_at, &app.end_at);
 
     /* Вывести результат */
     archive_foreach(&app.archive, print, &app);
+
+    diag_print(&app.diag, &app.link.stat, stderr);
+
+    archive_free(&app.archive);
     return result == 0;
 }
 
@@ -39,6 +39,7 @@ MU_TEST(test_msr_table_init)
     struct archive archive;
     struct rec rec;
     archive_init(&archive);
+    mu_check(archive_alloc(&archive, ARCHIVE_MAX_SIZE));
     uint32_t i;
 
     for(i = 0; i <= ARCHIVE_MAX_SIZE * 2; i++) {
@@ -65,6 +66,8 @@ MU_TEST(test_msr_table_init)
             mu_assert(check == NULL, "Noooo....");
         }
     }
+    archive_free(&archive);
+    mu_check(!archive_alloc(&archive, ARCHIVE_MAX_SIZE + 1));
 }
 
 void test_visitor(struct rec * rec, void * data)
@@ -79,6 +82,7 @@ MU_TEST(test_msr_table_foreach)
     struct rec rec;
     int cnt = 0;
     archive_init(&archive);
+    mu_check(archive_alloc(&archive, ARCHIVE_MAX_SIZE));
     uint32_t i;
     uint32_t tv = 1;
     for(i = 0; i <= ARCHIVE_MAX_SIZE * 2; i++) {
@@ -88,6 +92,65 @@ MU_TEST(test_msr_table_foreach)
     }
     archive_foreach(&archive, test_visitor, &cnt);
     mu_assert_int_eq(ARCHIVE_MAX_SIZE, cnt);
+    archive_free(&archive);
+}
+
+MU_TEST(test_msr_table_alloc)
+{
+    struct archive archive;
+    struct rec rec;
+
+    /* Память выделяется под запрошенное кол-во записей и глубину архива */
+    archive_init(&archive);
+    archive.interval.type = 'm';
+    archive.interval.depth = 12;
+    mu_check(archive_alloc(&archive, 12));
+    mu_assert_int_eq(12, archive.capacity);
+    mu_assert_int_eq(12, archive.tcapacity);
+    mu_check(archive.arena.size < 12 * (sizeof(struct rec) + sizeof(int64_t)) + 2 * ARENA_ALIGN);
+
+    rec_init(&rec, 0);
+    size_t i;
+    for(i = 0; i < 12; i++)
+        mu_assert_int_eq(1, archive_add(&archive, &rec));
+    mu_assert_int_eq(0, archive_add(&archive, &rec));
+    mu_check(archive_get(&archive, 12) == NULL);
+
+    /* Без архива нет и записей */
+    mu_check(archive_alloc(&archive, 0));
+    mu_assert_int_eq(0, archive_size(&archive));
+    mu_assert_int_eq(0, archive_add(&archive, &rec));
+    archive_free(&archive);
+}
+
+MU_TEST(test_msr_table_deep)
+{
+    /* Интервальный архив глубже 8192 записей: 12 суток по 1 мин */
+    const struct devtime end = {{.year = 20, .month = 3, .day = 15}, {.hour = 12, .minute = 30}};
+    const size_t depth = 12 * 1440;
+    struct archive archive;
+    struct rec rec;
+    size_t i;
+
+    archive_init(&archive);
+    archive.interval.type = 'i';
+    archive.interval.depth = depth;
+    archive.interval.interval = 1;
+    mu_check(archive_alloc(&archive, depth));
+
+    for(i = 0; i < depth; i++) {
+        rec_init(&rec, (uint16_t)i);
+        mu_assert_int_eq(1, archive_add(&archive, &rec));
+    }
+
+    mu_assert_int_eq(1, archive_index_to_utc(&archive, &end, &end));
+    for(i = 0; i < depth; i++)
+        mu_check(archive_get(&archive, i)->timestamp != TIME_INVALID);
+
+    /* Соседние индексы отличаются на интервал (кроме стыка архива) */
+    const int64_t diff = archive_get(&archive, 100)->timestamp - archive_get(&archive, 99)->timestamp;
+    mu_check(diff == 60 || diff == 60 - (int64_t)depth * 60);
+    archive_free(&archive);
 }
 
 MU_TEST_SUITE(suite_msr)
@@ -100,6 +163,8 @@ MU_TEST_SUITE(suite_msr_table)
 {
     MU_RUN_TEST(test_msr_table_init);
     MU_RUN_TEST(test_msr_table_foreach);
+    MU_RUN_TEST(test_msr_table_alloc);
+    MU_RUN_TEST(test_msr_table_deep);
 }
 
 int main()
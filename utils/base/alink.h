@@ -0,0 +1,86 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_BASE_ALINK_H
+#define UTILS_BASE_ALINK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "utils/base/link.h"
+#include "utils/base/reactor.h"
+
+/* Состояния асинхронного линка
+ *
+ *  DOWN --up--> CONNECTING --connected--> IDLE --request--> WAIT
+ *    ^               |                     ^ ^                |
+ *    |           timeout/error             | +--reply/timeout-+
+ *    +----down-------+---------------------+
+ */
+enum alink_state {
+    ALINK_DOWN,
+    ALINK_CONNECTING,
+    ALINK_IDLE,
+    ALINK_WAIT
+};
+
+struct alink;
+
+/* Завершение операции.
+ * error - 0 в случае успеха, иначе код ошибки (-ETIMEDOUT для таймаута)
+ * data, len - принятые данные (только для запросов) */
+typedef void (*alink_fn)(struct alink * self, int error, const void * data, size_t len);
+
+/* Неблокирующий линк, работающий в цикле событий reactor.
+ * Адрес, тип и таймаут хранятся в обычном struct link. Результат каждой
+ * операции передается в обработчик, переданный при ее запуске. Датаграммы,
+ * пришедшие вне ожидания ответа, отбрасываются. Из TCP потока в обработчик
+ * передаются целые посылки, по одной на вызов. */
+struct alink {
+    struct reactor_handler handler;
+    struct link link;
+    struct reactor * reactor;
+    enum alink_state state;
+    struct wheel_timer timer;
+    int64_t sent;     /* время отправки последнего запроса */
+    int64_t deadline;
+    alink_fn callback;
+    void * data; /* данные владельца */
+    char rx[512];
+};
+
+/* Выполнить инициализацию.
+ * В случае успеха вернет 0. Иначе - код ошибки */
+int alink_init_udp(struct alink * self, struct reactor * reactor, const char * ip, uint16_t port, uint16_t timeout);
+int alink_init_tcp(struct alink * self, struct reactor * reactor, const char * ip, uint16_t port, uint16_t timeout);
+
+/* Начать подключение. Результат будет передан в callback.
+ * 0 - подключение начато. Иначе - код ошибки */
+int alink_up(struct alink * self, alink_fn callback);
+
+/* Отправить запрос и ждать ответ не более timeout мс (или таймаут оценки
+ * link.rtt, если она включена). Ответ будет передан в callback. Обновлять
+ * оценку должен владелец, т.к. только он может сопоставить ответ с запросом.
+ * Если посылка ушла не полностью, линк закрывается (ALINK_DOWN).
+ * 0 - запрос отправлен. Иначе - код ошибки */
+int alink_request(struct alink * self, const void * data, size_t len, alink_fn callback);
+
+/* Продолжить ожидание ответа на последний запрос до истечения его таймаута.
+ * Используется, если принятые данные не являются ответом на запрос.
+ * 0 - в случае успеха. Иначе - код ошибки */
+int alink_resume(struct alink * self);
+
+/* Закрыть линк. Обработчик незавершенной операции не вызывается */
+void alink_down(struct alink * self);
+
+enum alink_state alink_state(const struct alink * self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
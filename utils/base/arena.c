@@ -0,0 +1,69 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/base/arena.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+
+size_t arena_aligned(size_t size)
+{
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+int arena_init(struct arena * self, size_t size)
+{
+    assert(self);
+
+    self->data = NULL;
+    self->size = 0;
+    self->used = 0;
+
+    if(size == 0)
+        return 0;
+
+    size = arena_aligned(size);
+    if(!(self->data = malloc(size)))
+        return -ENOMEM;
+
+    self->size = size;
+    return 0;
+}
+
+void arena_free(struct arena * self)
+{
+    assert(self);
+    free(self->data);
+    self->data = NULL;
+    self->size = 0;
+    self->used = 0;
+}
+
+void * arena_alloc(struct arena * self, size_t size)
+{
+    assert(self);
+
+    size = arena_aligned(size);
+    if(size == 0 || size > self->size - self->used)
+        return NULL;
+
+    void * ptr = self->data + self->used;
+    self->used += size;
+    return ptr;
+}
+
+void arena_reset(struct arena * self)
+{
+    assert(self);
+    self->used = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
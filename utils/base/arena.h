@@ -0,0 +1,49 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_BASE_ARENA_H
+#define UTILS_BASE_ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Выравнивание выделяемых блоков */
+#define ARENA_ALIGN 8
+
+/* Линейный распределитель памяти. Один блок выделяется в куче при
+ * инициализации под все буферы владельца, части выдаются последовательно и
+ * освобождаются только все сразу. Память не обнуляется: владелец сам
+ * заполняет то, что использует */
+struct arena {
+    uint8_t * data;
+    size_t size;
+    size_t used;
+};
+
+/* Размер блока size с учетом выравнивания. Для расчета размера арены */
+size_t arena_aligned(size_t size);
+
+/* Выделить блок размером size (0 - пустая арена).
+ * В случае успеха вернет 0. Иначе - код ошибки */
+int arena_init(struct arena * self, size_t size);
+
+/* Освободить блок арены */
+void arena_free(struct arena * self);
+
+/* Выделить из арены size байт. NULL - недостаточно места */
+void * arena_alloc(struct arena * self, size_t size);
+
+/* Вернуть в арену все выделенные части */
+void arena_reset(struct arena * self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
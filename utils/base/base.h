@@ -10,8 +10,15 @@
 extern "C" {
 #endif
 
+#include "utils/base/arena.h"
+#include "utils/base/capture.h"
+#include "utils/base/diag.h"
+#include "utils/base/fault.h"
+#include "utils/base/hist.h"
 #include "utils/base/link.h"
 #include "utils/base/log.h"
+#include "utils/base/pipeline.h"
+#include "utils/base/stats.h"
 #include "utils/base/time.h"
 #include "utils/base/tstamp.h"
 #include "utils/base/types.h"
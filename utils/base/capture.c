@@ -0,0 +1,278 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/base/capture.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils/base/time.h"
+
+static void put_u16(uint8_t * dst, uint16_t value)
+{
+    dst[0] = value & 0xFF;
+    dst[1] = value >> 8;
+}
+
+static void put_u32(uint8_t * dst, uint32_t value)
+{
+    put_u16(dst, value & 0xFFFF);
+    put_u16(dst + 2, value >> 16);
+}
+
+static uint16_t get_u16(const uint8_t * src)
+{
+    return (uint16_t)(src[0] | (src[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t * src)
+{
+    return get_u16(src) | ((uint32_t)get_u16(src + 2) << 16);
+}
+
+int capture_open(struct capture * self, const char * path)
+{
+    assert(self);
+    assert(path);
+
+    uint8_t header[CAPTURE_HEADER] = {0};
+    memset(self, 0, sizeof(*self));
+    memcpy(header, CAPTURE_MAGIC, 4);
+    header[4] = CAPTURE_VERSION;
+
+    self->file = fopen(path, "wb");
+    if(!self->file)
+        return -errno;
+
+    if(fwrite(header, sizeof(header), 1, self->file) != 1) {
+        capture_close(self);
+        return -EIO;
+    }
+
+    self->last = time_monotonic_us();
+    return 0;
+}
+
+void capture_close(struct capture * self)
+{
+    assert(self);
+    if(self->file)
+        fclose(self->file);
+    self->file = NULL;
+}
+
+int capture_frame(struct capture * self, enum capture_dir dir, const void * data, size_t len)
+{
+    assert(self);
+    assert(data || !len);
+
+    if(!self->file)
+        return -EBADF;
+
+    if(len > CAPTURE_MAX_FRAME)
+        return -EMSGSIZE;
+
+    const int64_t now = time_monotonic_us();
+    const int64_t delta = now - self->last;
+    uint8_t record[CAPTURE_RECORD];
+
+    put_u32(record, delta > UINT32_MAX ? UINT32_MAX : (uint32_t)delta);
+    put_u16(record + 4, (uint16_t)(len | (dir == CAPTURE_RX ? 0x8000 : 0)));
+
+    if(fwrite(record, sizeof(record), 1, self->file) != 1 ||
+            (len && fwrite(data, len, 1, self->file) != 1))
+        return -EIO;
+
+    self->last = now;
+    self->frames++;
+    return 0;
+}
+
+/* Прочитать файл целиком */
+static int read_file(const char * path, uint8_t ** data, size_t * size)
+{
+    FILE * file = fopen(path, "rb");
+    if(!file)
+        return -errno;
+
+    long end = -1;
+    if(fseek(file, 0, SEEK_END) == 0)
+        end = ftell(file);
+
+    if(end < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return -EIO;
+    }
+
+    *size = (size_t)end;
+    *data = malloc(*size ? *size : 1);
+    if(!*data) {
+        fclose(file);
+        return -ENOMEM;
+    }
+
+    const int result = fread(*data, 1, *size, file) == *size ? 0 : -EIO;
+    fclose(file);
+    if(result != 0) {
+        free(*data);
+        *data = NULL;
+    }
+    return result;
+}
+
+int replay_open(struct replay * self, const char * path, uint32_t speed)
+{
+    assert(self);
+    assert(path);
+
+    size_t size = 0;
+    memset(self, 0, sizeof(*self));
+
+    int result = read_file(path, &self->data, &size);
+    if(result != 0)
+        return result;
+
+    if(size < CAPTURE_HEADER ||
+            memcmp(self->data, CAPTURE_MAGIC, 4) != 0 ||
+            self->data[4] != CAPTURE_VERSION) {
+        replay_close(self);
+        return -EINVAL;
+    }
+
+    /* Посылок не больше, чем записей минимального размера */
+    self->frames = malloc((size - CAPTURE_HEADER) / CAPTURE_RECORD * sizeof(*self->frames) + sizeof(*self->frames));
+    if(!self->frames) {
+        replay_close(self);
+        return -ENOMEM;
+    }
+
+    size_t pos = CAPTURE_HEADER;
+    size_t request = SIZE_MAX;
+    int64_t time = 0;
+
+    while(pos < size) {
+        if(size - pos < CAPTURE_RECORD) {
+            replay_close(self);
+            return -EINVAL;
+        }
+
+        const uint16_t word = get_u16(self->data + pos + 4);
+        struct replay_frame * frame = &self->frames[self->size];
+
+        time += get_u32(self->data + pos);
+        frame->time = time;
+        frame->sent = 0;
+        frame->len = word & CAPTURE_MAX_FRAME;
+        frame->dir = word & 0x8000 ? CAPTURE_RX : CAPTURE_TX;
+        frame->offset = pos + CAPTURE_RECORD;
+        frame->request = request;
+
+        if(frame->len > size - frame->offset) {
+            replay_close(self);
+            return -EINVAL;
+        }
+
+        if(frame->dir == CAPTURE_TX)
+            request = self->size;
+
+        pos = frame->offset + frame->len;
+        self->size++;
+    }
+
+    self->speed = speed;
+    return 0;
+}
+
+void replay_close(struct replay * self)
+{
+    assert(self);
+    free(self->frames);
+    free(self->data);
+    memset(self, 0, sizeof(*self));
+}
+
+/* Найти следующую посылку направления dir, начиная с pos */
+static size_t next_frame(const struct replay * self, size_t pos, uint8_t dir)
+{
+    while(pos < self->size && self->frames[pos].dir != dir)
+        pos++;
+    return pos;
+}
+
+/* Время выдачи ответа, мкс. -1 - запрос для него еще не отправлен */
+static int64_t due_time(const struct replay * self, const struct replay_frame * frame)
+{
+    if(frame->request == SIZE_MAX)
+        return 0;
+
+    if(frame->request >= self->tx)
+        return -1;
+
+    const struct replay_frame * request = &self->frames[frame->request];
+    if(!self->speed)
+        return request->sent;
+
+    return request->sent + (frame->time - request->time) / self->speed;
+}
+
+ssize_t replay_send(struct replay * self, const void * data, size_t len)
+{
+    assert(self);
+
+    const size_t pos = next_frame(self, self->tx, CAPTURE_TX);
+    if(pos < self->size) {
+        self->frames[pos].sent = time_monotonic_us();
+        self->tx = pos + 1;
+    }
+    return (ssize_t)len;
+}
+
+ssize_t replay_recv(struct replay * self, void * data, size_t len)
+{
+    assert(self);
+    assert(data);
+
+    const size_t pos = next_frame(self, self->rx, CAPTURE_RX);
+    if(pos == self->size)
+        return -EAGAIN;
+
+    const struct replay_frame * frame = &self->frames[pos];
+    const int64_t due = due_time(self, frame);
+    if(due < 0 || due > time_monotonic_us())
+        return -EAGAIN;
+
+    /* Как и recv, лишние байты датаграммы отбрасываются */
+    const size_t n = frame->len < len ? frame->len : len;
+    memcpy(data, self->data + frame->offset, n);
+    self->rx = pos + 1;
+    return (ssize_t)n;
+}
+
+int replay_wait(struct replay * self, int timeout)
+{
+    assert(self);
+
+    const int64_t now = time_monotonic_us();
+    const int64_t deadline = now + (int64_t)(timeout < 0 ? 0 : timeout) * 1000;
+    const size_t pos = next_frame(self, self->rx, CAPTURE_RX);
+    const int64_t due = pos < self->size ? due_time(self, &self->frames[pos]) : -1;
+
+    /* Ответа не будет: ожидание длится весь таймаут, как у молчащего шлюза */
+    if(due < 0 || due > deadline) {
+        time_sleep_us(deadline - now);
+        return 0;
+    }
+
+    time_sleep_us(due - now);
+    return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
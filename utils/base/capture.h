@@ -0,0 +1,98 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_BASE_CAPTURE_H
+#define UTILS_BASE_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+/* Формат файла захвата (все числа little-endian):
+ * заголовок - "TKCP", версия (1 байт), 3 байта резерва;
+ * запись    - интервал от предыдущей записи, мкс (4 байта, при переполнении
+ *             ограничивается), длина посылки (2 байта, старший бит -
+ *             направление: 0 - отправлена, 1 - принята), данные посылки */
+#define CAPTURE_MAGIC   "TKCP"
+#define CAPTURE_VERSION 1
+#define CAPTURE_HEADER  8
+#define CAPTURE_RECORD  6
+
+/* Макс. размер посылки в записи */
+#define CAPTURE_MAX_FRAME 0x7FFF
+
+/* Направление посылки */
+enum capture_dir {CAPTURE_TX, CAPTURE_RX};
+
+/* Запись посылок линка в файл */
+struct capture {
+    FILE * file;
+    int64_t last;    /* время предыдущей записи, мкс */
+    uint64_t frames; /* кол-во записанных посылок */
+};
+
+/* Создать файл захвата.
+ * В случае успеха вернет 0. Иначе - код ошибки */
+int capture_open(struct capture * self, const char * path);
+
+void capture_close(struct capture * self);
+
+/* Записать посылку. Время записи - текущее монотонное время.
+ * В случае успеха вернет 0. Иначе - код ошибки */
+int capture_frame(struct capture * self, enum capture_dir dir, const void * data, size_t len);
+
+/* Посылка воспроизводимого захвата */
+struct replay_frame {
+    int64_t time;      /* время от начала захвата, мкс */
+    int64_t sent;      /* время отправки запроса при воспроизведении, мкс */
+    size_t offset;     /* смещение данных в буфере */
+    size_t request;    /* предшествующий отправленный запрос (для принятых) */
+    uint16_t len;
+    uint8_t dir;
+};
+
+/* Воспроизведение захвата вместо обмена по сети.
+ * Принятые посылки выдаются в записанном порядке. Время выдачи отсчитывается
+ * от момента, когда воспроизводящая сторона отправила предшествующий посылке
+ * запрос, поэтому задержки шлюза сохраняются, даже если клиент работает
+ * медленнее или быстрее, чем при записи. Ответ на еще не отправленный
+ * запрос не выдается. Содержимое отправляемых посылок не сравнивается с
+ * записанными */
+struct replay {
+    struct replay_frame * frames;
+    size_t size;
+    uint8_t * data;
+    size_t tx;      /* следующая отправляемая посылка */
+    size_t rx;      /* следующая принимаемая посылка */
+    uint32_t speed; /* ускорение: 1 - как при записи, 0 - без задержек */
+};
+
+/* Загрузить файл захвата в память.
+ * В случае успеха вернет 0. Иначе - код ошибки */
+int replay_open(struct replay * self, const char * path, uint32_t speed);
+
+void replay_close(struct replay * self);
+
+/* Отметить отправку запроса. Возвращает len */
+ssize_t replay_send(struct replay * self, const void * data, size_t len);
+
+/* Выдать очередной ответ, если время его поступления наступило.
+ * Возвращает размер посылки или -EAGAIN */
+ssize_t replay_recv(struct replay * self, void * data, size_t len);
+
+/* Ожидать очередного ответа не более timeout мс.
+ * >0 - есть ответ, 0 - таймаут */
+int replay_wait(struct replay * self, int timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,174 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/base/diag.h"
+#include <assert.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tekon/trace.h"
+#include "utils/base/log.h"
+
+/* Макс. ускорение воспроизведения */
+#define DIAG_MAX_SPEED 1000000
+
+const struct option diag_options[] = {
+    DIAG_OPTIONS,
+    {NULL, 0, NULL, 0}
+};
+
+void diag_init(struct diag * self, const char * name)
+{
+    assert(self);
+    assert(name);
+
+    memset(self, 0, sizeof(*self));
+    self->name = name;
+    stats_init(&self->stats);
+    self->speed = 1;
+}
+
+int diag_option(struct diag * self, int opt, const char * arg)
+{
+    assert(self);
+
+    switch(opt) {
+    case DIAG_OPT_STATS:
+        self->use_stats = 1;
+        return 1;
+    case DIAG_OPT_CAPTURE:
+        self->capture_path = arg;
+        return 1;
+    case DIAG_OPT_REPLAY:
+        self->replay_path = arg;
+        return 1;
+    case DIAG_OPT_SPEED: {
+        long input  = atol(arg);
+        if(input < 0 || input > DIAG_MAX_SPEED || !isdigit((unsigned char)*arg)) {
+            printf("invalid speed %s\n\n", arg);
+            return 0;
+        }
+        self->speed = (uint32_t)input;
+        return 1;
+    }
+    case DIAG_OPT_FAULT: {
+        struct fault_config config;
+        if(!fault_config_from_string(&config, arg)) {
+            printf("invalid fault spec %s\n\n", arg);
+            return 0;
+        }
+        fault_init(&self->fault, &config);
+        self->use_fault = 1;
+        return 1;
+    }
+    case DIAG_OPT_TRACE:
+        if(!TEKON_TRACE_ENABLED) {
+            printf("tracing is not built in, rebuild with -DTEKON_TRACE=ON\n\n");
+            return 0;
+        }
+        self->trace_path = arg;
+        return 1;
+    default:
+        return -1;
+    }
+}
+
+int diag_link_used(const struct diag * self)
+{
+    assert(self);
+    return self->capture_path || self->replay_path || self->use_fault;
+}
+
+void diag_usage(FILE * out, int link)
+{
+    assert(out);
+
+    fprintf(out, "  --stats print exchange statistics to stderr at exit.\n\n");
+    if(link) {
+        fprintf(out, "  --capture file\n");
+        fprintf(out, "        write sent and received frames to file.\n\n");
+        fprintf(out, "  --replay file\n");
+        fprintf(out, "        take replies from capture file instead of the gateway.\n\n");
+        fprintf(out, "  --speed N\n");
+        fprintf(out, "        replay N times faster than recorded. 0 - without delays. Default is 1.\n\n");
+        fprintf(out, "  --fault spec\n");
+        fprintf(out, "        inject faults into received frames, e.g. drop=5,dup=1,reorder=1,\n");
+        fprintf(out, "        truncate=1,corrupt=1,delay=5:50,seed=7 (percents, delay max in ms).\n\n");
+    }
+    fprintf(out, "  --trace file\n");
+    fprintf(out, "        write hot-path trace in Chrome trace format (built with TEKON_TRACE).\n\n");
+}
+
+int diag_open(struct diag * self)
+{
+    assert(self);
+
+    int result = 0;
+
+    if(self->capture_path && (result = capture_open(&self->capture, self->capture_path)) != 0)
+        log_print(LOG_ERR "%s : ERR : %s capture error %d\n", self->name, self->capture_path, result);
+    else if(self->replay_path && (result = replay_open(&self->replay, self->replay_path, self->speed)) != 0)
+        log_print(LOG_ERR "%s : ERR : %s replay error %d\n", self->name, self->replay_path, result);
+
+    return result;
+}
+
+void diag_attach(struct diag * self, struct link * link)
+{
+    assert(self);
+    assert(link);
+
+    link->capture = self->capture_path ? &self->capture : NULL;
+    link->replay = self->replay_path ? &self->replay : NULL;
+    link->fault = self->use_fault ? &self->fault : NULL;
+}
+
+struct stats * diag_stats(struct diag * self)
+{
+    assert(self);
+    return self->use_stats ? &self->stats : NULL;
+}
+
+void diag_trace(const struct diag * self)
+{
+    assert(self);
+
+    int result;
+
+    if(self->trace_path && (result = tekon_trace_dump(self->trace_path)) != 0)
+        log_print(LOG_ERR "%s : ERR : %s trace writing error %d\n", self->name, self->trace_path, result);
+}
+
+void diag_close(struct diag * self)
+{
+    assert(self);
+
+    if(self->capture_path)
+        capture_close(&self->capture);
+    if(self->replay_path)
+        replay_close(&self->replay);
+    diag_trace(self);
+}
+
+void diag_print(const struct diag * self, const struct link_stat * link, FILE * out)
+{
+    assert(self);
+    assert(out);
+
+    if(!self->use_stats)
+        return;
+
+    stats_print(&self->stats, link, out);
+    if(self->use_fault)
+        fault_print(&self->fault, out);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,106 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_BASE_DIAG_H
+#define UTILS_BASE_DIAG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "utils/base/capture.h"
+#include "utils/base/fault.h"
+#include "utils/base/link.h"
+#include "utils/base/stats.h"
+
+/* Длинные опции диагностики обмена. Коды начинаются с DIAG_OPT_FIRST, чтобы
+ * не пересекаться с короткими опциями утилиты */
+#define DIAG_OPT_FIRST   0x100
+#define DIAG_OPT_STATS   (DIAG_OPT_FIRST + 0)
+#define DIAG_OPT_CAPTURE (DIAG_OPT_FIRST + 1)
+#define DIAG_OPT_REPLAY  (DIAG_OPT_FIRST + 2)
+#define DIAG_OPT_SPEED   (DIAG_OPT_FIRST + 3)
+#define DIAG_OPT_FAULT   (DIAG_OPT_FIRST + 4)
+#define DIAG_OPT_TRACE   (DIAG_OPT_FIRST + 5)
+#define DIAG_OPT_LAST    DIAG_OPT_TRACE
+
+/* Записи getopt_long для опций диагностики. Утилита со своими длинными
+ * опциями включает их в свою таблицу, коды своих опций начинает после
+ * DIAG_OPT_LAST */
+#define DIAG_OPTIONS \
+    {"stats", no_argument, NULL, DIAG_OPT_STATS}, \
+    {"capture", required_argument, NULL, DIAG_OPT_CAPTURE}, \
+    {"replay", required_argument, NULL, DIAG_OPT_REPLAY}, \
+    {"speed", required_argument, NULL, DIAG_OPT_SPEED}, \
+    {"fault", required_argument, NULL, DIAG_OPT_FAULT}, \
+    {"trace", required_argument, NULL, DIAG_OPT_TRACE}
+
+/* Таблица для getopt_long из одних опций диагностики. Завершается нулевой
+ * записью */
+extern const struct option diag_options[];
+
+/* Диагностика обмена утилиты: статистика, захват и воспроизведение посылок,
+ * внесение искажений и трассировка. Захват, воспроизведение и искажения
+ * работают на синхронном линке (struct link).
+ * Порядок работы: diag_init -> diag_option (на каждую опцию) -> diag_open ->
+ * diag_attach (после инициализации линка) -> ... -> diag_close -> diag_print */
+struct diag {
+    const char * name; /* имя утилиты для сообщений в лог */
+    struct stats stats;
+    int use_stats;
+    const char * capture_path;
+    const char * replay_path;
+    uint32_t speed;
+    struct capture capture;
+    struct replay replay;
+    int use_fault;
+    struct fault fault;
+    const char * trace_path;
+};
+
+void diag_init(struct diag * self, const char * name);
+
+/* Разобрать опцию opt (результат getopt_long) с аргументом arg.
+ * Ошибка в аргументе выводится в stdout, как и у остальных опций.
+ * 1 - опция разобрана
+ * 0 - неверный аргумент
+ * -1 - опция не относится к диагностике */
+int diag_option(struct diag * self, int opt, const char * arg);
+
+/* Захват, воспроизведение или искажения заданы */
+int diag_link_used(const struct diag * self);
+
+/* Вывести описание опций диагностики для usage. link - описать и опции
+ * линка (захват, воспроизведение, искажения) */
+void diag_usage(FILE * out, int link);
+
+/* Открыть файлы захвата и воспроизведения. Ошибка пишется в лог.
+ * В случае успеха вернет 0. Иначе - код ошибки */
+int diag_open(struct diag * self);
+
+/* Подключить захват, воспроизведение и искажения к инициализированному линку */
+void diag_attach(struct diag * self, struct link * link);
+
+/* Статистика для конвейера/опроса. NULL, если не собирается */
+struct stats * diag_stats(struct diag * self);
+
+/* Выгрузить трассировку, если она задана */
+void diag_trace(const struct diag * self);
+
+/* Закрыть файлы захвата и выгрузить трассировку, если она задана */
+void diag_close(struct diag * self);
+
+/* Вывести статистику обмена и искажений, если задано --stats. link - счетчики
+ * линка, NULL - не выводятся */
+void diag_print(const struct diag * self, const struct link_stat * link, FILE * out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,261 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/base/fault.h"
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Прочитать вероятность в процентах */
+static int read_percent(const char * str, char ** end, uint32_t * value)
+{
+    const double percent = strtod(str, end);
+    if(*end == str || percent < 0 || percent > 100)
+        return 0;
+    *value = (uint32_t)(percent * (FAULT_SCALE / 100) + 0.5);
+    return 1;
+}
+
+int fault_config_from_string(struct fault_config * config, const char * str)
+{
+    assert(config);
+    assert(str);
+
+    static const struct {
+        const char * name;
+        size_t offset;
+    } names[] = {
+        {"drop", offsetof(struct fault_config, drop)},
+        {"dup", offsetof(struct fault_config, duplicate)},
+        {"reorder", offsetof(struct fault_config, reorder)},
+        {"truncate", offsetof(struct fault_config, truncate)},
+        {"corrupt", offsetof(struct fault_config, corrupt)},
+        {"delay", offsetof(struct fault_config, delay)},
+    };
+
+    memset(config, 0, sizeof(*config));
+    config->seed = 1;
+
+    while(*str) {
+        const char * eq = strchr(str, '=');
+        char * end = NULL;
+        size_t i;
+
+        if(!eq)
+            return 0;
+
+        const size_t len = (size_t)(eq - str);
+        if(len == 4 && strncmp(str, "seed", 4) == 0) {
+            config->seed = strtoull(eq + 1, &end, 10);
+            if(end == eq + 1)
+                return 0;
+        } else {
+            for(i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+                if(strlen(names[i].name) == len && strncmp(str, names[i].name, len) == 0)
+                    break;
+
+            if(i == sizeof(names) / sizeof(names[0]) ||
+                    !read_percent(eq + 1, &end, (uint32_t *)((char *)config + names[i].offset)))
+                return 0;
+
+            if(names[i].offset == offsetof(struct fault_config, delay)) {
+                if(*end != ':')
+                    return 0;
+                const char * start = end + 1;
+                const unsigned long max = strtoul(start, &end, 10);
+                if(end == start || max == 0 || max > 60000)
+                    return 0;
+                config->delay_max = (uint32_t)max;
+            }
+        }
+
+        if(*end == ',')
+            end++;
+        else if(*end)
+            return 0;
+        str = end;
+    }
+    return 1;
+}
+
+void fault_init(struct fault * self, const struct fault_config * config)
+{
+    assert(self);
+    assert(config);
+
+    memset(self, 0, sizeof(*self));
+    self->config = *config;
+    /* xorshift не работает с нулевым состоянием */
+    self->state = config->seed * 0x9E3779B97F4A7C15ull | 1;
+}
+
+void fault_clear(struct fault * self)
+{
+    assert(self);
+    self->size = 0;
+}
+
+/* xorshift64* */
+static uint64_t next_random(struct fault * self)
+{
+    self->state ^= self->state >> 12;
+    self->state ^= self->state << 25;
+    self->state ^= self->state >> 27;
+    return self->state * 0x2545F4914F6CDD1Dull;
+}
+
+static uint32_t next_value(struct fault * self, uint32_t limit)
+{
+    return (uint32_t)((next_random(self) >> 32) % limit);
+}
+
+/* Поместить посылку в очередь перед первой ожидающей перестановки. Ожидающие
+ * посылки освобождаются и выдаются за ней */
+static void enqueue(struct fault * self, const uint8_t * data, size_t len, int64_t due, int held)
+{
+    if(self->size == FAULT_MAX_QUEUE) {
+        self->stat.overflow++;
+        return;
+    }
+
+    size_t pos = self->size;
+    size_t i;
+
+    if(!held) {
+        for(i = 0; i < self->size; i++) {
+            if(self->queue[i].held) {
+                pos = i;
+                break;
+            }
+        }
+        for(i = pos; i < self->size; i++) {
+            self->queue[i].held = 0;
+            if(self->queue[i].due < due)
+                self->queue[i].due = due;
+        }
+        memmove(&self->queue[pos + 1], &self->queue[pos], (self->size - pos) * sizeof(self->queue[0]));
+    }
+
+    struct fault_frame * frame = &self->queue[pos];
+    frame->due = due;
+    frame->held = held;
+    frame->len = (uint16_t)len;
+    memcpy(frame->data, data, len);
+    self->size++;
+}
+
+void fault_push(struct fault * self, const void * data, size_t len, int64_t now)
+{
+    assert(self);
+    assert(data || !len);
+
+    const struct fault_config * cfg = &self->config;
+    uint8_t frame[FAULT_MAX_FRAME];
+
+    /* Решения принимаются всегда в одном порядке и независимо от предыдущих,
+     * чтобы расписание зависело только от seed и номера посылки */
+    const uint32_t drop = next_value(self, FAULT_SCALE);
+    const uint32_t truncate = next_value(self, FAULT_SCALE);
+    const uint32_t corrupt = next_value(self, FAULT_SCALE);
+    const uint32_t delay = next_value(self, FAULT_SCALE);
+    const uint32_t reorder = next_value(self, FAULT_SCALE);
+    const uint32_t duplicate = next_value(self, FAULT_SCALE);
+    const uint64_t random = next_random(self);
+
+    self->stat.frames++;
+    if(len > sizeof(frame))
+        len = sizeof(frame);
+
+    if(drop < cfg->drop) {
+        self->stat.dropped++;
+        return;
+    }
+
+    memcpy(frame, data, len);
+
+    if(truncate < cfg->truncate && len > 1) {
+        len = 1 + (size_t)(random % (len - 1));
+        self->stat.truncated++;
+    }
+
+    /* Предпоследний байт посылки (фиксированной и переменной длины) - КС */
+    if(corrupt < cfg->corrupt && len > 1) {
+        frame[len - 2] ^= 0xFF;
+        self->stat.corrupted++;
+    }
+
+    int64_t due = now;
+    if(delay < cfg->delay && cfg->delay_max) {
+        due += (int64_t)(1 + (random >> 32) % cfg->delay_max) * 1000;
+        self->stat.delayed++;
+    }
+
+    const int held = reorder < cfg->reorder;
+    if(held)
+        self->stat.reordered++;
+    enqueue(self, frame, len, due, held);
+
+    if(duplicate < cfg->duplicate) {
+        enqueue(self, frame, len, due, 0);
+        self->stat.duplicated++;
+    }
+}
+
+ssize_t fault_pop(struct fault * self, void * data, size_t len, int64_t now)
+{
+    assert(self);
+    assert(data);
+
+    size_t i;
+    for(i = 0; i < self->size; i++) {
+        const struct fault_frame * frame = &self->queue[i];
+        if(frame->held || frame->due > now)
+            continue;
+
+        const size_t n = frame->len < len ? frame->len : len;
+        memcpy(data, frame->data, n);
+        memmove(&self->queue[i], &self->queue[i + 1], (self->size - i - 1) * sizeof(self->queue[0]));
+        self->size--;
+        return (ssize_t)n;
+    }
+    return -EAGAIN;
+}
+
+int64_t fault_next(const struct fault * self)
+{
+    assert(self);
+
+    int64_t next = -1;
+    size_t i;
+    for(i = 0; i < self->size; i++) {
+        const struct fault_frame * frame = &self->queue[i];
+        if(!frame->held && (next < 0 || frame->due < next))
+            next = frame->due;
+    }
+    return next;
+}
+
+void fault_print(const struct fault * self, FILE * out)
+{
+    assert(self);
+    assert(out);
+
+    const struct fault_stat * st = &self->stat;
+    fprintf(out, "fault frames: %"PRIu64" dropped: %"PRIu64" duplicated: %"PRIu64
+            " reordered: %"PRIu64" truncated: %"PRIu64" corrupted: %"PRIu64
+            " delayed: %"PRIu64" overflow: %"PRIu64"\n",
+            st->frames, st->dropped, st->duplicated, st->reordered,
+            st->truncated, st->corrupted, st->delayed, st->overflow);
+}
+
+#ifdef __cplusplus
+}
+#endif
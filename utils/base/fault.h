@@ -0,0 +1,106 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_BASE_FAULT_H
+#define UTILS_BASE_FAULT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+/* Вероятности задаются в миллионных долях: 1% = 10000 */
+#define FAULT_SCALE 1000000
+
+/* Макс. кол-во задержанных посылок. При переполнении посылка теряется */
+#define FAULT_MAX_QUEUE 32
+
+/* Макс. размер посылки. Длинные посылки обрезаются */
+#define FAULT_MAX_FRAME 512
+
+/* Искажения принятых посылок. Вероятности независимы и проверяются для
+ * каждой посылки */
+struct fault_config {
+    uint32_t drop;      /* потеря */
+    uint32_t duplicate; /* повтор */
+    uint32_t reorder;   /* посылка выдается после следующей */
+    uint32_t truncate;  /* обрезка до случайной длины */
+    uint32_t corrupt;   /* порча байта КС */
+    uint32_t delay;     /* задержка на случайное время [1, delay_max] мс */
+    uint32_t delay_max;
+    uint64_t seed;      /* одинаковый seed - одинаковые искажения */
+};
+
+struct fault_stat {
+    uint64_t frames;     /* посылки, прошедшие через искажения */
+    uint64_t dropped;
+    uint64_t duplicated;
+    uint64_t reordered;
+    uint64_t truncated;
+    uint64_t corrupted;
+    uint64_t delayed;
+    uint64_t overflow;   /* потеряны из-за переполнения очереди */
+};
+
+struct fault_frame {
+    int64_t due;   /* время выдачи, мкс */
+    int held;      /* ждет следующую посылку (перестановка) */
+    uint16_t len;
+    uint8_t data[FAULT_MAX_FRAME];
+};
+
+/* Прослойка между линком и приложением, искажающая принятые посылки по
+ * детерминированному расписанию. Решения принимаются генератором
+ * псевдослучайных чисел, поэтому при том же seed и той же
+ * последовательности посылок искажения повторяются.
+ *
+ * Принятые посылки проходят через очередь: задержанная посылка выдается, когда
+ * наступит ее время, переставленная - после следующей принятой посылки.
+ * Отправляемые посылки не искажаются: потеря ответа для клиента неотличима от
+ * потери запроса */
+struct fault {
+    struct fault_config config;
+    struct fault_stat stat;
+    uint64_t state;
+    struct fault_frame queue[FAULT_MAX_QUEUE];
+    size_t size;
+};
+
+/* Прочитать настройки из строки вида
+ * drop=5,dup=1,reorder=1,truncate=1,corrupt=1,delay=10:50,seed=7
+ * Вероятности задаются в процентах, для delay через двоеточие указывается
+ * макс. задержка в мс. Пропущенные искажения выключены.
+ * 1 - успешно
+ * 0 - ошибка */
+int fault_config_from_string(struct fault_config * config, const char * str);
+
+void fault_init(struct fault * self, const struct fault_config * config);
+
+/* Удалить посылки из очереди. Расписание искажений продолжается */
+void fault_clear(struct fault * self);
+
+/* Пропустить принятую посылку через искажения и поместить в очередь */
+void fault_push(struct fault * self, const void * data, size_t len, int64_t now);
+
+/* Выдать первую посылку, время выдачи которой наступило. Как и recv, лишние
+ * байты отбрасываются.
+ * Возвращает размер посылки или -EAGAIN */
+ssize_t fault_pop(struct fault * self, void * data, size_t len, int64_t now);
+
+/* Время выдачи ближайшей посылки, мкс. -1 - выдавать нечего */
+int64_t fault_next(const struct fault * self);
+
+/* Вывести счетчики искажений */
+void fault_print(const struct fault * self, FILE * out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,145 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/base/hist.h"
+#include <assert.h>
+#include <string.h>
+
+/* Номер интервала. Значения [2^k, 2^(k+1)) делятся на HIST_SUB равных
+ * интервалов */
+static size_t bucket_index(uint64_t value)
+{
+    if(value < HIST_SUB)
+        return (size_t)value;
+
+    unsigned msb = HIST_SUB_BITS;
+    while(msb < 63 && (value >> (msb + 1)))
+        msb++;
+
+    if(msb >= HIST_MAX_BITS)
+        return HIST_SIZE - 1;
+
+    const unsigned shift = msb - HIST_SUB_BITS;
+    return (size_t)(shift + 1) * HIST_SUB + (size_t)((value >> shift) - HIST_SUB);
+}
+
+/* Наибольшее значение интервала */
+static int64_t bucket_upper(size_t index)
+{
+    if(index < HIST_SUB)
+        return (int64_t)index;
+
+    const unsigned shift = (unsigned)(index / HIST_SUB) - 1;
+    const uint64_t sub = index % HIST_SUB + HIST_SUB;
+    return (int64_t)(((sub + 1) << shift) - 1);
+}
+
+void hist_init(struct hist * self)
+{
+    assert(self);
+    memset(self, 0, sizeof(*self));
+}
+
+void hist_add(struct hist * self, int64_t value)
+{
+    assert(self);
+
+    if(value < 0)
+        value = 0;
+
+    self->counts[bucket_index((uint64_t)value)]++;
+
+    if(!self->count || value < self->min)
+        self->min = value;
+    if(!self->count || value > self->max)
+        self->max = value;
+
+    self->count++;
+    /* Сумма насыщается, чтобы очень большие значения не переполняли ее */
+    self->sum = value > INT64_MAX - self->sum ? INT64_MAX : self->sum + value;
+}
+
+void hist_merge(struct hist * self, const struct hist * other)
+{
+    assert(self);
+    assert(other);
+
+    if(!other->count)
+        return;
+
+    size_t i;
+    for(i = 0; i < HIST_SIZE; i++)
+        self->counts[i] += other->counts[i];
+
+    if(!self->count || other->min < self->min)
+        self->min = other->min;
+    if(!self->count || other->max > self->max)
+        self->max = other->max;
+
+    self->count += other->count;
+    self->sum = other->sum > INT64_MAX - self->sum ? INT64_MAX : self->sum + other->sum;
+}
+
+int64_t hist_percentile(const struct hist * self, double percentile)
+{
+    assert(self);
+
+    if(!self->count)
+        return 0;
+
+    if(percentile < 0)
+        percentile = 0;
+    if(percentile > 100)
+        percentile = 100;
+
+    /* Кол-во значений, которое должно оказаться не больше результата */
+    uint64_t rank = (uint64_t)(percentile / 100.0 * self->count + 0.5);
+    if(rank < 1)
+        rank = 1;
+
+    uint64_t seen = 0;
+    size_t i;
+    for(i = 0; i < HIST_SIZE; i++) {
+        seen += self->counts[i];
+        if(seen >= rank) {
+            /* Последний интервал не ограничен сверху */
+            const int64_t upper = i < HIST_SIZE - 1 ? bucket_upper(i) : self->max;
+            return upper < self->max ? upper : self->max;
+        }
+    }
+    return self->max;
+}
+
+int64_t hist_mean(const struct hist * self)
+{
+    assert(self);
+    return self->count ? self->sum / (int64_t)self->count : 0;
+}
+
+uint64_t hist_count_le(const struct hist * self, int64_t value)
+{
+    assert(self);
+
+    if(value < 0)
+        return 0;
+
+    if(value >= self->max)
+        return self->count;
+
+    const size_t last = bucket_index((uint64_t)value);
+    uint64_t count = 0;
+    size_t i;
+    for(i = 0; i <= last; i++)
+        count += self->counts[i];
+    return count;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,62 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_BASE_HIST_H
+#define UTILS_BASE_HIST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Кол-во интервалов на каждую степень двойки (2^HIST_SUB_BITS) */
+#define HIST_SUB_BITS 5
+#define HIST_SUB      (1 << HIST_SUB_BITS)
+
+/* Значения от 2^HIST_MAX_BITS и больше попадают в последний интервал */
+#define HIST_MAX_BITS 40
+
+#define HIST_SIZE ((HIST_MAX_BITS - HIST_SUB_BITS + 1) * HIST_SUB)
+
+/* Гистограмма задержек с логарифмически-линейными интервалами (как в HDR
+ * Histogram). Значения до HIST_SUB учитываются точно, остальные - с
+ * относительной погрешностью не более 1/HIST_SUB (~3%). Добавление значения
+ * не выделяет память и занимает несколько операций, поэтому гистограмму
+ * можно вести на каждый запрос.
+ *
+ * Единицы измерения выбирает владелец (обычно мкс). Отрицательные значения
+ * учитываются как 0 */
+struct hist {
+    uint64_t counts[HIST_SIZE];
+    uint64_t count;
+    int64_t min;
+    int64_t max;
+    int64_t sum;
+};
+
+void hist_init(struct hist * self);
+
+void hist_add(struct hist * self, int64_t value);
+
+/* Добавить все значения other */
+void hist_merge(struct hist * self, const struct hist * other);
+
+/* Значение, не превышаемое percentile % значений [0, 100].
+ * Возвращает верхнюю границу интервала (не более max). 0 - пустая гистограмма */
+int64_t hist_percentile(const struct hist * self, double percentile);
+
+/* Среднее значение. 0 - пустая гистограмма */
+int64_t hist_mean(const struct hist * self);
+
+/* Кол-во значений, не превышающих value. Интервал, в который попадает
+ * value, учитывается целиком (погрешность как у hist_percentile) */
+uint64_t hist_count_le(const struct hist * self, int64_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
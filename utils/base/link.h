@@ -11,6 +11,8 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include "tekon/stream.h"
+#include "utils/base/rtt.h"
 
 #if defined(__unix__) || defined(__linux__)
 /* UNIX or LINUX */
@@ -29,6 +31,29 @@ typedef SOCKET socket_t;
 /* Тип связи */
 enum link_type {LINK_UDP, LINK_TCP};
 
+/* Макс. кол-во посылок, передаваемых одним системным вызовом */
+#define LINK_MAX_BATCH 16
+
+/* Счетчики обмена */
+struct link_stat {
+    uint64_t syscalls;  /* системные вызовы обмена (отправка, прием, ожидание) */
+    uint64_t tx;        /* отправленные посылки */
+    uint64_t rx;        /* принятые посылки */
+    uint64_t discarded; /* отброшенные ответы (опоздавшие, с чужим номером) */
+};
+
+struct uring;
+struct capture;
+struct replay;
+struct fault;
+
+/* Буфер для пакетного обмена */
+struct link_buffer {
+    void * data;
+    size_t size; /* размер буфера */
+    size_t len;  /* кол-во данных */
+};
+
 /* Нам требуется простая реализация сетевого обмена. Под простой я имею ввиду:
  * - синхронную
  * - без лишних наворотов, т.к. требуется сделать банальный запрос <-> ответ
@@ -39,6 +64,13 @@ struct link {
     struct sockaddr remote;
     enum link_type type;
     uint16_t timeout;
+    struct rtt rtt; /* адаптивный таймаут ответа. По умолчанию выключен */
+    struct link_stat stat;
+    struct tekon_stream stream; /* сборка посылок из TCP потока */
+    struct uring * uring;       /* обмен через io_uring. NULL - обычные вызовы */
+    struct capture * capture;   /* запись посылок в файл. NULL - выключена */
+    struct replay * replay;     /* воспроизведение захвата вместо сети */
+    struct fault * fault;       /* искажение принятых посылок. NULL - выключено */
 };
 
 /* Выполнить инициализацию для работы по TCP.
@@ -49,7 +81,9 @@ int link_init_tcp(struct link * self, const char * ip, uint16_t port, uint16_t t
  * В случае успеха вернет 0. Иначе - код ошибки */
 int link_init_udp(struct link * self, const char * ip, uint16_t port, uint16_t timeout);
 
-/* Поднять линк.
+/* Поднять линк. Поля capture, replay и fault задаются после инициализации, до
+ * подъема линка. При воспроизведении сокет не создается. Искажения
+ * поддерживаются только в Linux.
  * В случае успеха вернет 0. Иначе - код ошибки */
 int link_up(struct link * self);
 
@@ -61,9 +95,30 @@ void link_down(struct link * self);
 /* Отправить данные */
 ssize_t link_send(struct link * self, const void * data, size_t len);
 
-/* Получить данные */
+/* Получить данные. Для TCP возвращается ровно одна посылка: поток
+ * дочитывается, пока посылка не будет собрана, а лишние данные сохраняются
+ * для следующих вызовов */
 ssize_t link_recv(struct link * self, void * data, size_t len);
 
+/* Отправить count посылок (len байт из каждого буфера). Для UDP каждая
+ * посылка уходит отдельной датаграммой. Если посылка ушла в TCP поток не
+ * полностью, линк закрывается.
+ * Возвращает кол-во отправленных посылок или код ошибки */
+int link_send_batch(struct link * self, const struct link_buffer * buffers, size_t count);
+
+/* Принять без ожидания до count посылок, уже находящихся в очереди. Размер
+ * каждой принятой посылки записывается в len. Для TCP посылки вырезаются из
+ * потока, поэтому несколько ответов одного сегмента принимаются разом.
+ * Возвращает кол-во принятых посылок (0 - очередь пуста) или код ошибки */
+int link_recv_batch(struct link * self, struct link_buffer * buffers, size_t count);
+
+/* Ожидать поступления данных не более timeout мс. Собранная, но еще не
+ * прочитанная посылка TCP считается поступившими данными.
+ * >0 - есть данные для чтения
+ * 0 - таймаут
+ * <0 - код ошибки */
+int link_wait(struct link * self, int timeout);
+
 
 #ifdef __cplusplus
 }
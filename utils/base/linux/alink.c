@@ -0,0 +1,285 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/base/alink.h"
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "utils/base/time.h"
+
+/* Завершить текущую операцию. Состояние меняется до вызова обработчика,
+ * поэтому из обработчика можно запускать следующую операцию */
+static void finish(struct alink * self, enum alink_state state, int error, const void * data, size_t len)
+{
+    wheel_cancel(&self->reactor->wheel, &self->timer);
+
+    if(state == ALINK_DOWN)
+        alink_down(self);
+    else
+        self->state = state;
+
+    if(self->callback)
+        self->callback(self, error, data, len);
+}
+
+static void on_timer(struct wheel_timer * timer, void * data)
+{
+    struct alink * self = data;
+
+    switch(self->state) {
+    case ALINK_CONNECTING:
+        finish(self, ALINK_DOWN, -ETIMEDOUT, NULL, 0);
+        break;
+    case ALINK_WAIT:
+        finish(self, ALINK_IDLE, -ETIMEDOUT, NULL, 0);
+        break;
+    case ALINK_DOWN:
+    case ALINK_IDLE:
+        break;
+    }
+}
+
+static void on_connect(struct alink * self)
+{
+    int error = 0;
+    socklen_t len = sizeof(error);
+
+    if(getsockopt(self->link.socket, SOL_SOCKET, SO_ERROR, &error, &len) != 0)
+        error = errno;
+
+    if(error) {
+        finish(self, ALINK_DOWN, -error, NULL, 0);
+        return;
+    }
+
+    int result = reactor_modify(self->reactor, self->link.socket, REACTOR_IN, &self->handler);
+    if(result != 0) {
+        finish(self, ALINK_DOWN, result, NULL, 0);
+        return;
+    }
+
+    finish(self, ALINK_IDLE, 0, NULL, 0);
+}
+
+/* Посылки вырезаются из TCP потока и передаются по одной, пока ожидается
+ * ответ. Остаток потока хранится до следующего запроса */
+static void on_read_stream(struct alink * self)
+{
+    struct tekon_stream * stream = &self->link.stream;
+    size_t room = 0;
+    void * tail = tekon_stream_reserve(stream, &room);
+    ssize_t result = recv(self->link.socket, tail, room, MSG_DONTWAIT);
+
+    if(result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return;
+
+    if(result <= 0) {
+        const int error = result == 0 ? -ECONNRESET : -errno;
+        if(self->state == ALINK_WAIT)
+            finish(self, ALINK_DOWN, error, NULL, 0);
+        else
+            alink_down(self);
+        return;
+    }
+
+    tekon_stream_commit(stream, result);
+
+    while(self->state == ALINK_WAIT) {
+        result = tekon_stream_pop(stream, self->rx, sizeof(self->rx));
+        if(result == 0)
+            break;
+
+        if(result < 0)
+            finish(self, ALINK_IDLE, (int)result, NULL, 0);
+        else
+            finish(self, ALINK_IDLE, 0, self->rx, (size_t)result);
+    }
+}
+
+static void on_read(struct alink * self)
+{
+    if(self->link.type == LINK_TCP) {
+        on_read_stream(self);
+        return;
+    }
+
+    ssize_t result = recv(self->link.socket, self->rx, sizeof(self->rx), MSG_DONTWAIT);
+
+    if(result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return;
+
+    const int closed = result == 0 && self->link.type == LINK_TCP;
+
+    /* Данные и ошибки вне запроса отбрасываются. Закрытое соединение
+     * приводит к сбросу линка */
+    if(self->state != ALINK_WAIT) {
+        if(closed)
+            alink_down(self);
+        return;
+    }
+
+    if(closed)
+        finish(self, ALINK_DOWN, -ECONNRESET, NULL, 0);
+    else if(result < 0)
+        finish(self, ALINK_IDLE, -errno, NULL, 0);
+    else
+        finish(self, ALINK_IDLE, 0, self->rx, (size_t)result);
+}
+
+static void on_event(struct reactor_handler * handler, uint32_t events)
+{
+    struct alink * self = (struct alink *)handler;
+
+    switch(self->state) {
+    case ALINK_CONNECTING:
+        on_connect(self);
+        break;
+    case ALINK_IDLE:
+    case ALINK_WAIT:
+        on_read(self);
+        break;
+    case ALINK_DOWN:
+        break;
+    }
+}
+
+static int base_init(struct alink * self, struct reactor * reactor)
+{
+    self->handler.callback = on_event;
+    self->reactor = reactor;
+    self->state = ALINK_DOWN;
+    wheel_timer_init(&self->timer, on_timer, self);
+    return 0;
+}
+
+int alink_init_udp(struct alink * self, struct reactor * reactor, const char * ip, uint16_t port, uint16_t timeout)
+{
+    assert(self);
+    assert(reactor);
+
+    memset(self, 0, sizeof(*self));
+    int err = link_init_udp(&self->link, ip, port, timeout);
+    return err ? err : base_init(self, reactor);
+}
+
+int alink_init_tcp(struct alink * self, struct reactor * reactor, const char * ip, uint16_t port, uint16_t timeout)
+{
+    assert(self);
+    assert(reactor);
+
+    memset(self, 0, sizeof(*self));
+    int err = link_init_tcp(&self->link, ip, port, timeout);
+    return err ? err : base_init(self, reactor);
+}
+
+int alink_up(struct alink * self, alink_fn callback)
+{
+    assert(self);
+
+    if(self->state != ALINK_DOWN)
+        return -EISCONN;
+
+    struct link * link = &self->link;
+    socket_t s = socket(AF_INET,
+                        (link->type == LINK_UDP ? SOCK_DGRAM : SOCK_STREAM) | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                        0);
+
+    if (s == TEKON_INVALID_SOCKET)
+        return -errno;
+
+    if(connect(s, &link->remote, sizeof(link->remote)) != 0 && errno != EINPROGRESS) {
+        int err = -errno;
+        close(s);
+        return err;
+    }
+
+    /* Завершение подключения определяется по готовности к записи. Для UDP
+     * это произойдет на ближайшей итерации цикла */
+    int err = reactor_add(self->reactor, s, REACTOR_OUT, &self->handler);
+    if(err) {
+        close(s);
+        return err;
+    }
+
+    link->socket = s;
+    self->state = ALINK_CONNECTING;
+    self->callback = callback;
+    self->deadline = time_monotonic_ms() + link->timeout;
+    wheel_add(&self->reactor->wheel, &self->timer, self->deadline);
+    return 0;
+}
+
+int alink_request(struct alink * self, const void * data, size_t len, alink_fn callback)
+{
+    assert(self);
+    assert(data);
+    assert(len);
+
+    if(self->state == ALINK_DOWN || self->state == ALINK_CONNECTING)
+        return -ENOTCONN;
+
+    if(self->state == ALINK_WAIT)
+        return -EBUSY;
+
+    ssize_t result = send(self->link.socket, data, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+    if(result < 0)
+        return -errno;
+
+    /* Часть посылки уже ушла в поток, повтор целой посылки нарушил бы его.
+     * Линк закрывается, следующий запрос начнется с нового подключения */
+    if((size_t)result != len) {
+        alink_down(self);
+        return -EIO;
+    }
+
+    self->state = ALINK_WAIT;
+    self->callback = callback;
+    self->sent = time_monotonic_ms();
+    self->deadline = self->sent + rtt_timeout(&self->link.rtt, self->link.timeout);
+    wheel_add(&self->reactor->wheel, &self->timer, self->deadline);
+    return 0;
+}
+
+int alink_resume(struct alink * self)
+{
+    assert(self);
+
+    if(self->state != ALINK_IDLE)
+        return self->state == ALINK_WAIT ? -EBUSY : -ENOTCONN;
+
+    self->state = ALINK_WAIT;
+    wheel_add(&self->reactor->wheel, &self->timer, self->deadline);
+    return 0;
+}
+
+void alink_down(struct alink * self)
+{
+    assert(self);
+
+    wheel_cancel(&self->reactor->wheel, &self->timer);
+
+    if(self->link.socket != TEKON_INVALID_SOCKET) {
+        reactor_remove(self->reactor, self->link.socket);
+        link_down(&self->link);
+    }
+    self->state = ALINK_DOWN;
+}
+
+enum alink_state alink_state(const struct alink * self)
+{
+    assert(self);
+    return self->state;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -11,10 +11,64 @@ extern "C" {
 #include <assert.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <poll.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/time.h>
 #include <string.h>
 #include <unistd.h>
+#include "utils/base/capture.h"
+#include "utils/base/fault.h"
+#include "utils/base/time.h"
+#include "tekon/trace.h"
+
+#ifdef TEKON_IO_URING
+#include "utils/base/linux/uring.h"
+#endif
+
+/* Принять одну посылку из TCP потока, дочитывая его при необходимости.
+ * 0 - соединение закрыто */
+static ssize_t stream_recv(struct link * self, void * data, size_t len, int flags)
+{
+    for(;;) {
+        ssize_t result = tekon_stream_pop(&self->stream, data, len);
+        if(result != 0) {
+            if(result > 0)
+                self->stat.rx++;
+            return result;
+        }
+
+        size_t room = 0;
+        void * tail = tekon_stream_reserve(&self->stream, &room);
+        result = recv(self->socket, tail, room, flags);
+        self->stat.syscalls++;
+
+        if(result <= 0)
+            return result == 0 ? 0 : -errno;
+
+        tekon_stream_commit(&self->stream, result);
+    }
+}
+
+/* Записать посылки в файл захвата, если он задан */
+static void capture(struct link * self, enum capture_dir dir, const void * data, ssize_t len)
+{
+    if(self->capture && len > 0)
+        capture_frame(self->capture, dir, data, (size_t)len);
+}
+
+/* Принять посылку из захвата. Как и recv с SO_RCVTIMEO, ждет не дольше
+ * таймаута линка */
+static ssize_t replay_recv_timed(struct link * self, void * data, size_t len)
+{
+    ssize_t result = replay_recv(self->replay, data, len);
+    if(result == -EAGAIN && replay_wait(self->replay, self->timeout) > 0)
+        result = replay_recv(self->replay, data, len);
+
+    if(result > 0)
+        self->stat.rx++;
+    return result;
+}
 
 static int base_init(struct link * self, const char * ip, uint16_t port, uint16_t timeout)
 {
@@ -67,6 +121,9 @@ int link_up(struct link * self)
 {
     assert(self);
 
+    if(self->replay)
+        return 0;
+
     if(self->socket != TEKON_INVALID_SOCKET)
         return -EISCONN;
 
@@ -98,6 +155,12 @@ int link_up(struct link * self)
         goto error;
 
     self->socket = s;
+
+#ifdef TEKON_IO_URING
+    /* Если io_uring недоступен, используются обычные вызовы */
+    if(self->type == LINK_UDP)
+        self->uring = uring_open(s);
+#endif
     return 0;
 
 error:
@@ -107,39 +170,88 @@ error:
 
 void link_down(struct link * self)
 {
+#ifdef TEKON_IO_URING
+    uring_close(self->uring);
+    self->uring = NULL;
+#endif
+
     if(self->socket != TEKON_INVALID_SOCKET) {
         shutdown(self->socket, SHUT_RDWR);
         close(self->socket);
         self->socket = TEKON_INVALID_SOCKET;
     }
+    tekon_stream_init(&self->stream);
+
+    if(self->fault)
+        fault_clear(self->fault);
 }
 
-ssize_t link_send(struct link * self, const void * data, size_t len)
+static ssize_t raw_send(struct link * self, const void * data, size_t len)
 {
     assert(self);
     assert(data);
     assert(len);
+
+    if(self->replay) {
+        self->stat.tx++;
+        return replay_send(self->replay, data, len);
+    }
+
     if(self->socket == TEKON_INVALID_SOCKET)
         return -EBADF;
 
     ssize_t result = send(self->socket, data, len, MSG_NOSIGNAL);
+    self->stat.syscalls++;
 
-    if(result >= 0)
+    if(result >= 0) {
+        self->stat.tx++;
+        capture(self, CAPTURE_TX, data, result);
         return result;
+    }
     else
         return -errno;
 }
 
-ssize_t link_recv(struct link * self, void * data, size_t len)
+static ssize_t raw_recv(struct link * self, void * data, size_t len)
 {
     assert(self);
     assert(data);
     assert(len);
 
+    if(self->replay)
+        return replay_recv_timed(self, data, len);
+
     if(self->socket == TEKON_INVALID_SOCKET)
         return -EBADF;
 
+    if(self->type == LINK_TCP) {
+        ssize_t result = stream_recv(self, data, len, MSG_NOSIGNAL);
+        capture(self, CAPTURE_RX, data, result);
+        return result;
+    }
+
+#ifdef TEKON_IO_URING
+    /* Датаграммы принимает кольцо, поэтому обычный recv не используется */
+    if(self->uring) {
+        struct link_buffer buffer = {data, len, 0};
+        int result = uring_wait(self->uring, &self->stat, self->timeout);
+        if(result > 0)
+            result = uring_recv_batch(self->uring, &self->stat, &buffer, 1);
+        if(result == 0)
+            return -EAGAIN;
+        if(result > 0)
+            capture(self, CAPTURE_RX, data, (ssize_t)buffer.len);
+        return result < 0 ? result : (ssize_t)buffer.len;
+    }
+#endif
+
     ssize_t result = recv(self->socket, data, len, MSG_NOSIGNAL);
+    self->stat.syscalls++;
+
+    if(result > 0) {
+        self->stat.rx++;
+        capture(self, CAPTURE_RX, data, result);
+    }
 
     if(result >= 0)
         return result;
@@ -147,6 +259,309 @@ ssize_t link_recv(struct link * self, void * data, size_t len)
         return -errno;
 }
 
+static int raw_send_batch(struct link * self, const struct link_buffer * buffers, size_t count)
+{
+    assert(self);
+    assert(buffers);
+
+    size_t sent = 0;
+
+    if(self->replay) {
+        for(sent = 0; sent < count; sent++) {
+            const ssize_t result = replay_send(self->replay, buffers[sent].data, buffers[sent].len);
+            if(result < 0)
+                return sent ? (int)sent : (int)result;
+            self->stat.tx++;
+        }
+        return (int)count;
+    }
+
+    if(self->socket == TEKON_INVALID_SOCKET)
+        return -EBADF;
+
+#ifdef TEKON_IO_URING
+    if(self->uring) {
+        while(sent < count) {
+            int result = uring_send_batch(self->uring, &self->stat, buffers + sent, count - sent);
+            if(result <= 0)
+                return sent ? (int)sent : result;
+            for(; result > 0; result--, sent++)
+                capture(self, CAPTURE_TX, buffers[sent].data, (ssize_t)buffers[sent].len);
+        }
+        return (int)sent;
+    }
+#endif
+
+    struct mmsghdr msgs[LINK_MAX_BATCH];
+    struct iovec iov[LINK_MAX_BATCH];
+
+    while(sent < count) {
+        const size_t n = count - sent > LINK_MAX_BATCH ? LINK_MAX_BATCH : count - sent;
+        size_t i;
+
+        memset(msgs, 0, n * sizeof(msgs[0]));
+        for(i = 0; i < n; i++) {
+            iov[i].iov_base = buffers[sent + i].data;
+            iov[i].iov_len = buffers[sent + i].len;
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int result = sendmmsg(self->socket, msgs, n, MSG_NOSIGNAL);
+        self->stat.syscalls++;
+
+        if(result < 0)
+            return sent ? (int)sent : -errno;
+
+        for(i = 0; i < (size_t)result; i++) {
+            /* Посылка ушла в TCP поток не полностью (истек таймаут отправки).
+             * Поток нарушен, линк закрывается */
+            if(msgs[i].msg_len != iov[i].iov_len) {
+                link_down(self);
+                return sent ? (int)sent : -EIO;
+            }
+            self->stat.tx++;
+            capture(self, CAPTURE_TX, iov[i].iov_base, (ssize_t)iov[i].iov_len);
+            sent++;
+        }
+
+        if((size_t)result < n)
+            break;
+    }
+    return (int)sent;
+}
+
+static int raw_recv_batch(struct link * self, struct link_buffer * buffers, size_t count)
+{
+    assert(self);
+    assert(buffers);
+
+    size_t i;
+
+    if(count > LINK_MAX_BATCH)
+        count = LINK_MAX_BATCH;
+
+    if(self->replay) {
+        size_t n = 0;
+        ssize_t result;
+        while(n < count && (result = replay_recv(self->replay, buffers[n].data, buffers[n].size)) > 0)
+            buffers[n++].len = result;
+        self->stat.rx += n;
+        return (int)n;
+    }
+
+    if(self->socket == TEKON_INVALID_SOCKET)
+        return -EBADF;
+
+    if(self->type == LINK_TCP) {
+        size_t n = 0;
+        while(n < count) {
+            ssize_t result = stream_recv(self, buffers[n].data, buffers[n].size, MSG_DONTWAIT);
+            if(result == 0)
+                return n ? (int)n : -ECONNRESET;
+            if(result < 0) {
+                if(result == -EAGAIN || result == -EWOULDBLOCK)
+                    break;
+                return n ? (int)n : (int)result;
+            }
+            capture(self, CAPTURE_RX, buffers[n].data, result);
+            buffers[n++].len = result;
+        }
+        return (int)n;
+    }
+
+#ifdef TEKON_IO_URING
+    if(self->uring) {
+        int result = uring_recv_batch(self->uring, &self->stat, buffers, count);
+        for(i = 0; i < (size_t)(result > 0 ? result : 0); i++)
+            capture(self, CAPTURE_RX, buffers[i].data, (ssize_t)buffers[i].len);
+        return result;
+    }
+#endif
+
+    struct mmsghdr msgs[LINK_MAX_BATCH];
+    struct iovec iov[LINK_MAX_BATCH];
+
+    memset(msgs, 0, count * sizeof(msgs[0]));
+    for(i = 0; i < count; i++) {
+        iov[i].iov_base = buffers[i].data;
+        iov[i].iov_len = buffers[i].size;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int result = recvmmsg(self->socket, msgs, count, MSG_DONTWAIT, NULL);
+    self->stat.syscalls++;
+
+    if(result < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -errno;
+
+    for(i = 0; i < (size_t)result; i++) {
+        buffers[i].len = msgs[i].msg_len;
+        capture(self, CAPTURE_RX, buffers[i].data, (ssize_t)buffers[i].len);
+    }
+
+    self->stat.rx += result;
+    return result;
+}
+
+static int raw_wait(struct link * self, int timeout)
+{
+    assert(self);
+
+    if(self->replay)
+        return replay_wait(self->replay, timeout);
+
+    if(self->socket == TEKON_INVALID_SOCKET)
+        return -EBADF;
+
+    if(self->type == LINK_TCP && tekon_stream_ready(&self->stream))
+        return 1;
+
+#ifdef TEKON_IO_URING
+    if(self->uring)
+        return uring_wait(self->uring, &self->stat, timeout);
+#endif
+
+    struct pollfd pfd = {
+        .fd = self->socket,
+        .events = POLLIN
+    };
+
+    int result = poll(&pfd, 1, timeout < 0 ? 0 : timeout);
+    self->stat.syscalls++;
+
+    if(result >= 0)
+        return result;
+    else
+        return -errno;
+}
+
+/* Принять все посылки, уже находящиеся в очереди линка, и пропустить их через
+ * искажения */
+static int fault_pump(struct link * self)
+{
+    struct link_buffer buffers[LINK_MAX_BATCH];
+    char data[LINK_MAX_BATCH][FAULT_MAX_FRAME];
+    size_t i;
+
+    for(i = 0; i < LINK_MAX_BATCH; i++) {
+        buffers[i].data = data[i];
+        buffers[i].size = sizeof(data[i]);
+        buffers[i].len = 0;
+    }
+
+    for(;;) {
+        const int result = raw_recv_batch(self, buffers, LINK_MAX_BATCH);
+        if(result < 0)
+            return result;
+
+        const int64_t now = time_monotonic_us();
+        for(i = 0; i < (size_t)result; i++)
+            fault_push(self->fault, buffers[i].data, buffers[i].len, now);
+
+        if(result < LINK_MAX_BATCH)
+            return 0;
+    }
+}
+
+/* Ожидать посылку, время выдачи которой наступило */
+static int fault_wait(struct link * self, int timeout)
+{
+    const int64_t deadline = time_monotonic_us() + (int64_t)(timeout < 0 ? 0 : timeout) * 1000;
+
+    for(;;) {
+        int result = fault_pump(self);
+        if(result < 0)
+            return result;
+
+        const int64_t now = time_monotonic_us();
+        const int64_t next = fault_next(self->fault);
+        if(next >= 0 && next <= now)
+            return 1;
+        if(now >= deadline)
+            return 0;
+
+        /* Ждать новых посылок, но не дольше, чем до выдачи задержанной */
+        const int64_t until = next >= 0 && next < deadline ? next : deadline;
+        result = raw_wait(self, (int)((until - now + 999) / 1000));
+        if(result < 0)
+            return result;
+    }
+}
+
+static ssize_t fault_recv(struct link * self, void * data, size_t len)
+{
+    /* Как и recv с SO_RCVTIMEO, ждет не дольше таймаута линка */
+    const int result = fault_wait(self, self->timeout);
+    if(result <= 0)
+        return result == 0 ? -EAGAIN : result;
+    return fault_pop(self->fault, data, len, time_monotonic_us());
+}
+
+static int fault_recv_batch(struct link * self, struct link_buffer * buffers, size_t count)
+{
+    const int result = fault_pump(self);
+    if(result < 0)
+        return result;
+
+    const int64_t now = time_monotonic_us();
+    size_t n = 0;
+    ssize_t len;
+    while(n < count && (len = fault_pop(self->fault, buffers[n].data, buffers[n].size, now)) > 0)
+        buffers[n++].len = (size_t)len;
+    return (int)n;
+}
+
+ssize_t link_send(struct link * self, const void * data, size_t len)
+{
+    TEKON_TRACE_BEGIN(TEKON_TRACE_LINK_SEND);
+    const ssize_t result = raw_send(self, data, len);
+    TEKON_TRACE_END(TEKON_TRACE_LINK_SEND, result);
+    return result;
+}
+
+int link_send_batch(struct link * self, const struct link_buffer * buffers, size_t count)
+{
+    TEKON_TRACE_BEGIN(TEKON_TRACE_LINK_SEND_BATCH);
+    const int result = raw_send_batch(self, buffers, count);
+    TEKON_TRACE_END(TEKON_TRACE_LINK_SEND_BATCH, result);
+    return result;
+}
+
+ssize_t link_recv(struct link * self, void * data, size_t len)
+{
+    assert(self);
+    assert(data);
+    assert(len);
+
+    TEKON_TRACE_BEGIN(TEKON_TRACE_LINK_RECV);
+    const ssize_t result = self->fault ? fault_recv(self, data, len) : raw_recv(self, data, len);
+    TEKON_TRACE_END(TEKON_TRACE_LINK_RECV, result);
+    return result;
+}
+
+int link_recv_batch(struct link * self, struct link_buffer * buffers, size_t count)
+{
+    assert(self);
+    assert(buffers);
+
+    TEKON_TRACE_BEGIN(TEKON_TRACE_LINK_RECV_BATCH);
+    const int result = self->fault ? fault_recv_batch(self, buffers, count) : raw_recv_batch(self, buffers, count);
+    TEKON_TRACE_END(TEKON_TRACE_LINK_RECV_BATCH, result);
+    return result;
+}
+
+int link_wait(struct link * self, int timeout)
+{
+    assert(self);
+
+    TEKON_TRACE_BEGIN(TEKON_TRACE_LINK_WAIT);
+    const int result = self->fault ? fault_wait(self, timeout) : raw_wait(self, timeout);
+    TEKON_TRACE_END(TEKON_TRACE_LINK_WAIT, result);
+    return result;
+}
+
 #ifdef __cplusplus
 }
 #endif
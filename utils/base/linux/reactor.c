@@ -0,0 +1,137 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/base/reactor.h"
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include "utils/base/time.h"
+
+#define REACTOR_MAX_EVENTS 64
+
+static uint32_t to_epoll(uint32_t events)
+{
+    uint32_t result = 0;
+    if(events & REACTOR_IN)
+        result |= EPOLLIN;
+    if(events & REACTOR_OUT)
+        result |= EPOLLOUT;
+    return result;
+}
+
+static uint32_t from_epoll(uint32_t events)
+{
+    uint32_t result = 0;
+    if(events & EPOLLIN)
+        result |= REACTOR_IN;
+    if(events & EPOLLOUT)
+        result |= REACTOR_OUT;
+    if(events & (EPOLLERR | EPOLLHUP))
+        result |= REACTOR_ERR;
+    return result;
+}
+
+static int control(struct reactor * self, int op, socket_t socket, uint32_t events, struct reactor_handler * handler)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = to_epoll(events);
+    ev.data.ptr = handler;
+
+    if(epoll_ctl(self->epoll, op, socket, &ev) != 0)
+        return -errno;
+    return 0;
+}
+
+int reactor_init(struct reactor * self)
+{
+    assert(self);
+    memset(self, 0, sizeof(*self));
+
+    self->epoll = epoll_create1(EPOLL_CLOEXEC);
+    if(self->epoll < 0)
+        return -errno;
+
+    wheel_init(&self->wheel, time_monotonic_ms());
+    return 0;
+}
+
+void reactor_close(struct reactor * self)
+{
+    assert(self);
+    if(self->epoll >= 0) {
+        close(self->epoll);
+        self->epoll = -1;
+    }
+}
+
+int reactor_add(struct reactor * self, socket_t socket, uint32_t events, struct reactor_handler * handler)
+{
+    assert(self);
+    assert(handler);
+    return control(self, EPOLL_CTL_ADD, socket, events, handler);
+}
+
+int reactor_modify(struct reactor * self, socket_t socket, uint32_t events, struct reactor_handler * handler)
+{
+    assert(self);
+    assert(handler);
+    return control(self, EPOLL_CTL_MOD, socket, events, handler);
+}
+
+void reactor_remove(struct reactor * self, socket_t socket)
+{
+    assert(self);
+    epoll_ctl(self->epoll, EPOLL_CTL_DEL, socket, NULL);
+}
+
+int reactor_poll(struct reactor * self, int timeout)
+{
+    assert(self);
+
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    const int next = wheel_next(&self->wheel);
+
+    if(timeout < 0 || (next >= 0 && next < timeout))
+        timeout = next;
+
+    int count = epoll_wait(self->epoll, events, REACTOR_MAX_EVENTS, timeout);
+
+    if(count < 0) {
+        if(errno != EINTR)
+            return -errno;
+        count = 0;
+    }
+
+    int i;
+    for(i = 0; i < count; i++) {
+        struct reactor_handler * handler = events[i].data.ptr;
+        handler->callback(handler, from_epoll(events[i].events));
+    }
+
+    return count + (int)wheel_advance(&self->wheel, time_monotonic_ms());
+}
+
+int reactor_run(struct reactor * self)
+{
+    assert(self);
+
+    while(wheel_size(&self->wheel)) {
+        int result = reactor_poll(self, -1);
+        if(result < 0)
+            return result;
+    }
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -9,6 +9,7 @@ extern "C" {
 
 #include "utils/base/time.h"
 #include <assert.h>
+#include <errno.h>
 
 int64_t time_now_utc()
 {
@@ -34,6 +35,35 @@ int32_t time_tzoffset()
     return ldt.tm_gmtoff;
 }
 
+int64_t time_monotonic_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int64_t time_monotonic_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void time_sleep_us(int64_t us)
+{
+    if(us <= 0)
+        return;
+
+    struct timespec ts = {
+        .tv_sec = us / 1000000,
+        .tv_nsec = (us % 1000000) * 1000
+    };
+
+    /* Прерванный сигналом сон продолжается */
+    while(nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+}
+
 int time_local_from_utc(int64_t utc, struct tm * local)
 {
     assert(local);
@@ -0,0 +1,370 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/base/linux/uring.h"
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define URING_ENTRIES     64
+#define URING_BUFFERS     32  /* степень двойки */
+#define URING_BUFFER_SIZE 512
+#define URING_GROUP       0
+
+/* Метки запросов */
+#define TAG_RECV 1
+#define TAG_SEND 2
+
+/* Принятая датаграмма (или ошибка приема), еще не забранная владельцем */
+struct uring_ready {
+    int32_t result;
+    uint16_t bid;
+};
+
+struct uring {
+    int fd;
+    socket_t socket;
+
+    void * sq_ring;
+    size_t sq_ring_size;
+    unsigned * sq_tail;
+    unsigned * sq_mask;
+    unsigned * sq_array;
+    struct io_uring_sqe * sqes;
+    size_t sqes_size;
+    unsigned sq_local;   /* хвост очереди с учетом еще не переданных */
+    unsigned sq_pending; /* кол-во подготовленных, но не переданных */
+
+    unsigned * cq_head;
+    unsigned * cq_tail;
+    unsigned * cq_mask;
+    struct io_uring_cqe * cqes;
+
+    struct io_uring_buf_ring * bufring;
+    size_t bufring_size;
+    uint16_t buftail;
+
+    struct uring_ready ready[URING_BUFFERS];
+    size_t ready_head;
+    size_t ready_count;
+
+    int armed; /* многоразовый прием запущен */
+    uint8_t buffers[URING_BUFFERS][URING_BUFFER_SIZE];
+};
+
+static int sys_setup(unsigned entries, struct io_uring_params * params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int sys_enter(int fd, unsigned submit, unsigned complete, unsigned flags, void * arg, size_t size)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, submit, complete, flags, arg, size);
+}
+
+static int sys_register(int fd, unsigned opcode, void * arg, unsigned count)
+{
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, count);
+}
+
+static struct io_uring_sqe * sqe_get(struct uring * self)
+{
+    const unsigned index = self->sq_local & *self->sq_mask;
+    struct io_uring_sqe * sqe = &self->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    self->sq_array[index] = index;
+    self->sq_local++;
+    self->sq_pending++;
+    return sqe;
+}
+
+/* Передать подготовленные запросы и/или дождаться завершений */
+static int enter(struct uring * self, struct link_stat * stat, unsigned complete, unsigned flags, void * arg, size_t size)
+{
+    __atomic_store_n(self->sq_tail, self->sq_local, __ATOMIC_RELEASE);
+
+    int result = sys_enter(self->fd, self->sq_pending, complete, flags, arg, size);
+    stat->syscalls++;
+
+    if(result < 0)
+        return -errno;
+
+    self->sq_pending -= (unsigned)result < self->sq_pending ? (unsigned)result : self->sq_pending;
+    return 0;
+}
+
+static void buffer_recycle(struct uring * self, uint16_t bid)
+{
+    struct io_uring_buf * buf = &self->bufring->bufs[self->buftail & (URING_BUFFERS - 1)];
+    buf->addr = (uint64_t)(uintptr_t)self->buffers[bid];
+    buf->len = URING_BUFFER_SIZE;
+    buf->bid = bid;
+    self->buftail++;
+    __atomic_store_n(&self->bufring->tail, self->buftail, __ATOMIC_RELEASE);
+}
+
+static void recv_arm(struct uring * self)
+{
+    struct io_uring_sqe * sqe = sqe_get(self);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = self->socket;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_GROUP;
+    sqe->user_data = TAG_RECV;
+    self->armed = 1;
+}
+
+/* Разобрать кольцо завершений. Принятые датаграммы откладываются в очередь
+ * ready, результаты отправок складываются в sent/failed */
+static void reap(struct uring * self, size_t * sends, size_t * sent, int * failed)
+{
+    unsigned head = *self->cq_head;
+    const unsigned tail = __atomic_load_n(self->cq_tail, __ATOMIC_ACQUIRE);
+
+    while(head != tail) {
+        const struct io_uring_cqe * cqe = &self->cqes[head & *self->cq_mask];
+
+        if(cqe->user_data == TAG_RECV) {
+            if(!(cqe->flags & IORING_CQE_F_MORE))
+                self->armed = 0;
+
+            /* Кончились буферы - прием будет перезапущен после их возврата */
+            if(cqe->res != -ENOBUFS && self->ready_count < URING_BUFFERS) {
+                struct uring_ready * ready = &self->ready[(self->ready_head + self->ready_count) % URING_BUFFERS];
+                ready->result = cqe->res;
+                ready->bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+                if(cqe->res >= 0 && !(cqe->flags & IORING_CQE_F_BUFFER))
+                    ready->result = -EIO;
+                self->ready_count++;
+            }
+        } else if(cqe->user_data == TAG_SEND && sends) {
+            (*sends)++;
+            if(cqe->res >= 0 && !*failed)
+                (*sent)++;
+            else if(!*failed)
+                *failed = cqe->res;
+        }
+        head++;
+    }
+
+    __atomic_store_n(self->cq_head, head, __ATOMIC_RELEASE);
+
+    if(!self->armed && self->ready_count < URING_BUFFERS)
+        recv_arm(self);
+}
+
+struct uring * uring_open(socket_t socket)
+{
+    struct io_uring_params params;
+    struct uring * self = calloc(1, sizeof(*self));
+    if(!self)
+        return NULL;
+
+    memset(&params, 0, sizeof(params));
+    self->fd = sys_setup(URING_ENTRIES, &params);
+    self->socket = socket;
+    if(self->fd < 0) {
+        free(self);
+        return NULL;
+    }
+
+    if(!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG))
+        goto error;
+
+    /* Очереди запросов и завершений отображаются одним блоком */
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    self->sq_ring_size = sq_size > cq_size ? sq_size : cq_size;
+    self->sq_ring = mmap(NULL, self->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         self->fd, IORING_OFF_SQ_RING);
+    if(self->sq_ring == MAP_FAILED) {
+        self->sq_ring = NULL;
+        goto error;
+    }
+
+    self->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    self->sqes = mmap(NULL, self->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      self->fd, IORING_OFF_SQES);
+    if(self->sqes == MAP_FAILED) {
+        self->sqes = NULL;
+        goto error;
+    }
+
+    uint8_t * ring = self->sq_ring;
+    self->sq_tail = (unsigned *)(ring + params.sq_off.tail);
+    self->sq_mask = (unsigned *)(ring + params.sq_off.ring_mask);
+    self->sq_array = (unsigned *)(ring + params.sq_off.array);
+    self->sq_local = *self->sq_tail;
+    self->cq_head = (unsigned *)(ring + params.cq_off.head);
+    self->cq_tail = (unsigned *)(ring + params.cq_off.tail);
+    self->cq_mask = (unsigned *)(ring + params.cq_off.ring_mask);
+    self->cqes = (struct io_uring_cqe *)(ring + params.cq_off.cqes);
+
+    /* Буферы приема, предоставляемые ядру */
+    self->bufring_size = URING_BUFFERS * sizeof(struct io_uring_buf);
+    self->bufring = mmap(NULL, self->bufring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(self->bufring == MAP_FAILED) {
+        self->bufring = NULL;
+        goto error;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)self->bufring;
+    reg.ring_entries = URING_BUFFERS;
+    reg.bgid = URING_GROUP;
+    if(sys_register(self->fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+        goto error;
+
+    uint16_t i;
+    for(i = 0; i < URING_BUFFERS; i++)
+        buffer_recycle(self, i);
+
+    recv_arm(self);
+    __atomic_store_n(self->sq_tail, self->sq_local, __ATOMIC_RELEASE);
+    if(sys_enter(self->fd, 1, 0, 0, NULL, 0) != 1)
+        goto error;
+
+    self->sq_pending = 0;
+    return self;
+
+error:
+    uring_close(self);
+    return NULL;
+}
+
+void uring_close(struct uring * self)
+{
+    if(!self)
+        return;
+
+    if(self->bufring)
+        munmap(self->bufring, self->bufring_size);
+    if(self->sqes)
+        munmap(self->sqes, self->sqes_size);
+    if(self->sq_ring)
+        munmap(self->sq_ring, self->sq_ring_size);
+    close(self->fd);
+    free(self);
+}
+
+int uring_send_batch(struct uring * self, struct link_stat * stat, const struct link_buffer * buffers, size_t count)
+{
+    assert(self);
+    assert(buffers);
+
+    if(count > LINK_MAX_BATCH)
+        count = LINK_MAX_BATCH;
+
+    if(!count)
+        return 0;
+
+    /* Посылки связаны в цепочку: уходят по порядку, ошибка отменяет
+     * оставшиеся, как у sendmmsg */
+    size_t i;
+    for(i = 0; i < count; i++) {
+        struct io_uring_sqe * sqe = sqe_get(self);
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = self->socket;
+        sqe->addr = (uint64_t)(uintptr_t)buffers[i].data;
+        sqe->len = buffers[i].len;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = TAG_SEND;
+        if(i + 1 < count)
+            sqe->flags = IOSQE_IO_LINK;
+    }
+
+    size_t sends = 0;
+    size_t sent = 0;
+    int failed = 0;
+
+    while(sends < count) {
+        int result = enter(self, stat, count - sends, IORING_ENTER_GETEVENTS, NULL, 0);
+        if(result != 0 && result != -EINTR)
+            return sent ? (int)sent : result;
+        reap(self, &sends, &sent, &failed);
+    }
+
+    stat->tx += sent;
+    return sent ? (int)sent : (failed ? failed : 0);
+}
+
+int uring_recv_batch(struct uring * self, struct link_stat * stat, struct link_buffer * buffers, size_t count)
+{
+    assert(self);
+    assert(buffers);
+
+    reap(self, NULL, NULL, NULL);
+
+    size_t n = 0;
+    while(n < count && self->ready_count) {
+        struct uring_ready * ready = &self->ready[self->ready_head];
+
+        if(ready->result < 0) {
+            /* Ошибка возвращается, только если перед ней нет данных */
+            if(n)
+                break;
+            self->ready_head = (self->ready_head + 1) % URING_BUFFERS;
+            self->ready_count--;
+            return ready->result;
+        }
+
+        size_t len = (size_t)ready->result;
+        if(len > buffers[n].size)
+            len = buffers[n].size;
+        memcpy(buffers[n].data, self->buffers[ready->bid], len);
+        buffers[n].len = len;
+        buffer_recycle(self, ready->bid);
+
+        self->ready_head = (self->ready_head + 1) % URING_BUFFERS;
+        self->ready_count--;
+        n++;
+    }
+
+    stat->rx += n;
+    return (int)n;
+}
+
+int uring_wait(struct uring * self, struct link_stat * stat, int timeout)
+{
+    assert(self);
+
+    reap(self, NULL, NULL, NULL);
+    if(self->ready_count)
+        return 1;
+
+    struct __kernel_timespec ts = {
+        .tv_sec = timeout > 0 ? timeout / 1000 : 0,
+        .tv_nsec = timeout > 0 ? (timeout % 1000) * 1000000L : 0
+    };
+
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = (uint64_t)(uintptr_t)&ts;
+
+    int result = enter(self, stat, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    if(result != 0 && result != -ETIME && result != -EINTR)
+        return result;
+
+    reap(self, NULL, NULL, NULL);
+    return self->ready_count ? 1 : 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,42 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_BASE_LINUX_URING_H
+#define UTILS_BASE_LINUX_URING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/base/link.h"
+
+/* Обмен UDP линка через io_uring (сборка с TEKON_IO_URING).
+ *
+ * Прием выполняется одним многоразовым (multishot) запросом с буферами,
+ * предоставленными ядру заранее: датаграммы попадают в кольцо завершений
+ * без системных вызовов, а link_recv_batch лишь забирает их из общей с
+ * ядром памяти. Пакет отправок и ожидание ответа выполняются одним вызовом
+ * io_uring_enter.
+ *
+ * Требуется ядро 5.19+. Если кольцо создать не удалось, линк работает
+ * через обычные вызовы */
+struct uring;
+
+/* Создать кольцо для подключенного сокета и запустить прием.
+ * NULL - io_uring недоступен */
+struct uring * uring_open(socket_t socket);
+
+void uring_close(struct uring * self);
+
+/* Аналоги link_send_batch, link_recv_batch, link_wait */
+int uring_send_batch(struct uring * self, struct link_stat * stat, const struct link_buffer * buffers, size_t count);
+int uring_recv_batch(struct uring * self, struct link_stat * stat, struct link_buffer * buffers, size_t count);
+int uring_wait(struct uring * self, struct link_stat * stat, int timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
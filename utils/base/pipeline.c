@@ -0,0 +1,445 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/base/pipeline.h"
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include "utils/base/time.h"
+
+/* Состояние выполнения pipeline_run */
+struct run {
+    pipeline_complete_fn complete;
+    pipeline_sink_fn sink;
+    void * ctx;
+    size_t inflight;
+    size_t done;
+    int failed;
+};
+
+struct single {
+    const struct message * request;
+    struct message * response;
+};
+
+/* Приемник значений ответа на запрос index */
+struct run_sink {
+    const struct run * run;
+    size_t index;
+};
+
+/* Проверить соответствие ответа запросу */
+static int response_is_valid(const struct message * request, const struct message * response)
+{
+    switch(response->type) {
+    /* Квитанцией подтверждается только запись, чтение без данных - ошибка */
+    case TEKON_MSG_POS_ACK:
+        return request->type == TEKON_MSG_WRITEM_PAR_14;
+    case TEKON_MSG_NEG_ACK:
+        return 0;
+    case TEKON_MSG_WRITEM_PAR_14:
+        return request->type == TEKON_MSG_WRITEM_PAR_14;
+    default:
+        return request->type == response->type &&
+               request->nelements == response->nelements;
+    }
+}
+
+/* Найти свободный номер посылки. Номера выдаются по кругу, чтобы недавно
+ * освободившиеся номера использовались как можно позже */
+static struct pipeline_slot * slot_acquire(struct pipeline * self)
+{
+    size_t i;
+    for(i = 0; i < PIPELINE_NUMBERS; i++) {
+        self->number = (self->number + 1) % PIPELINE_NUMBERS;
+        struct pipeline_slot * slot = &self->slot[self->number];
+        if(!slot->busy)
+            return slot;
+    }
+    return NULL;
+}
+
+static uint8_t slot_number(const struct pipeline * self, const struct pipeline_slot * slot)
+{
+    return (uint8_t)(slot - self->slot);
+}
+
+/* Запрос с ближайшим таймаутом */
+static struct pipeline_slot * slot_earliest(struct pipeline * self)
+{
+    struct pipeline_slot * result = NULL;
+    size_t i;
+    for(i = 0; i < PIPELINE_NUMBERS; i++) {
+        struct pipeline_slot * slot = &self->slot[i];
+        if(slot->busy && (!result || slot->deadline < result->deadline))
+            result = slot;
+    }
+    return result;
+}
+
+/* Единственный запрос в сети. Нужен для квитанций, т.к. они не содержат
+ * номера посылки */
+static struct pipeline_slot * slot_single(struct pipeline * self, size_t inflight)
+{
+    return inflight == 1 ? slot_earliest(self) : NULL;
+}
+
+void pipeline_init(struct pipeline * self, struct link * link, size_t window)
+{
+    assert(self);
+    assert(link);
+
+    memset(self, 0, sizeof(*self));
+    self->link = link;
+
+    if(window < 1)
+        window = 1;
+
+    if(window > PIPELINE_MAX_WINDOW)
+        window = PIPELINE_MAX_WINDOW;
+
+    self->window = window;
+}
+
+/* Завершить запрос с ошибкой. Новые запросы после этого не отправляются */
+static void run_fail(struct pipeline * self, struct run * run, size_t index, int error)
+{
+    self->error = error;
+    run->failed = 1;
+    if(self->stats)
+        self->stats->failures++;
+    run->complete(run->ctx, index, NULL);
+}
+
+/* Отправить одним пакетом запросы, помещающиеся в окно. Посылки пишутся
+ * подряд в self->tx (tekon_req_pack_batch) и отправляются без копирования */
+static size_t fill_window(struct pipeline * self, struct run * run, size_t next, size_t count, pipeline_prepare_fn prepare)
+{
+    struct pipeline_slot * prepared[PIPELINE_MAX_WINDOW];
+    const struct message * requests[PIPELINE_MAX_WINDOW];
+    uint8_t numbers[PIPELINE_MAX_WINDOW];
+    size_t offsets[PIPELINE_MAX_WINDOW + 1];
+    struct pipeline_slot * batch[PIPELINE_MAX_WINDOW];
+    struct link_buffer buffers[PIPELINE_MAX_WINDOW];
+    size_t nprepared = 0;
+    size_t packed = 0;
+    size_t offset = 0;
+    size_t n = 0;
+    size_t i;
+
+    while(!run->failed && next < count && run->inflight + nprepared < self->window) {
+        struct pipeline_slot * slot = slot_acquire(self);
+        assert(slot);
+
+        slot->index = next++;
+        slot->attempts = 0;
+
+        if(!prepare(run->ctx, slot->index, &slot->request)) {
+            run_fail(self, run, slot->index, -EINVAL);
+            continue;
+        }
+
+        /* Номер занят до окончания отправки пакета */
+        slot->busy = 1;
+        prepared[nprepared] = slot;
+        requests[nprepared] = &slot->request;
+        numbers[nprepared++] = slot_number(self, slot);
+    }
+
+    /* Запрос, который не удалось упаковать, завершается с ошибкой, остальные
+     * дописываются следом */
+    while(packed < nprepared) {
+        const int64_t start = stats_now(self->stats);
+        const size_t k = tekon_req_pack_batch(self->tx + offset, sizeof(self->tx) - offset,
+                                              requests + packed, numbers + packed,
+                                              nprepared - packed, offsets);
+        stats_stage_batch(self->stats, STATS_PACK, start, k < nprepared - packed ? k + 1 : k);
+
+        for(i = 0; i < k; i++) {
+            buffers[n].data = self->tx + offset + offsets[i];
+            buffers[n].size = offsets[i + 1] - offsets[i];
+            buffers[n].len = buffers[n].size;
+            batch[n++] = prepared[packed + i];
+        }
+        offset += offsets[k];
+        packed += k;
+
+        if(packed < nprepared) {
+            prepared[packed]->busy = 0;
+            run_fail(self, run, prepared[packed]->index, -EINVAL);
+            packed++;
+        }
+    }
+
+    if(!n)
+        return next;
+
+    struct link * link = self->link;
+    const int64_t now = time_monotonic_ms();
+    const int64_t start = stats_now(self->stats);
+    const int64_t deadline = now + rtt_timeout(&link->rtt, link->timeout);
+    const int sent = link_send_batch(link, buffers, n);
+
+    stats_stage(self->stats, STATS_SEND, start);
+    if(self->stats && sent > 0)
+        self->stats->requests += (uint64_t)sent;
+
+    for(i = 0; i < n; i++) {
+        struct pipeline_slot * slot = batch[i];
+        if(sent > 0 && i < (size_t)sent) {
+            slot->sent = now;
+            slot->start = start;
+            slot->deadline = deadline;
+            run->inflight++;
+        } else {
+            slot->busy = 0;
+            run_fail(self, run, slot->index, sent < 0 ? sent : -EIO);
+        }
+    }
+    return next;
+}
+
+/* Повторить запрос с новым номером посылки. Поздний ответ на предыдущую
+ * посылку будет отброшен как ответ на неизвестный запрос.
+ * 1 - запрос отправлен повторно
+ * 0 - бюджет повторов исчерпан или ошибка отправки */
+static int slot_retry(struct pipeline * self, struct pipeline_slot * old)
+{
+    if(old->attempts >= self->retries)
+        return 0;
+
+    struct pipeline_slot * slot = slot_acquire(self);
+    assert(slot);
+
+    slot->request = old->request;
+    slot->index = old->index;
+    slot->attempts = old->attempts + 1;
+    slot->start = old->start;
+    old->busy = 0;
+
+    struct link * link = self->link;
+    struct link_buffer buffer = {self->tx, sizeof(self->tx), 0};
+    ssize_t len = tekon_req_pack(self->tx, sizeof(self->tx), &slot->request, slot_number(self, slot));
+
+    if(len <= 0)
+        return 0;
+
+    buffer.len = (size_t)len;
+    if(link_send_batch(link, &buffer, 1) != 1)
+        return 0;
+
+    slot->sent = time_monotonic_ms();
+    slot->deadline = slot->sent + rtt_timeout(&link->rtt, link->timeout);
+    slot->busy = 1;
+    self->resent++;
+    if(self->stats)
+        self->stats->retries++;
+    return 1;
+}
+
+static void sink_value(void * ctx, size_t element, uint32_t value, uint8_t qual)
+{
+    const struct run_sink * sink = ctx;
+    sink->run->sink(sink->run->ctx, sink->index, element, value, qual);
+}
+
+/* Разобрать ответ на запрос slot. Если задан приемник значений, то значения
+ * передаются ему, а в response заносится только заголовок. Квитанции и
+ * поврежденные ответы разбираются как обычно */
+static ssize_t unpack_response(struct pipeline * self, const struct run * run, const struct pipeline_slot * slot,
+                               const void * data, size_t size)
+{
+    struct message * response = &self->response;
+    const struct message * request = &slot->request;
+
+    if(run->sink) {
+        struct run_sink sink = {run, slot->index};
+        const ssize_t len = tekon_resp_unpack_sink(data, size, request->type, request->nelements, sink_value, &sink, NULL);
+        if(len > 0) {
+            response->gateway = request->gateway;
+            response->dir = TEKON_DIR_IN;
+            response->type = request->type;
+            response->nelements = request->nelements;
+            return len;
+        }
+    }
+    return tekon_resp_unpack(data, size, response, request->type, NULL);
+}
+
+/* Сопоставить ответ с запросом и завершить его */
+static void handle_response(struct pipeline * self, struct run * run, const void * data, size_t size)
+{
+    uint8_t number = 0;
+    struct pipeline_slot * slot = NULL;
+
+    if(tekon_resp_number(data, size, &number))
+        slot = self->slot[number].busy ? &self->slot[number] : NULL;
+    else
+        slot = slot_single(self, run->inflight);
+
+    /* Ответ на неизвестный запрос (например, опоздавший ответ на
+     * запрос с истекшим таймаутом) */
+    if(!slot) {
+        self->link->stat.discarded++;
+        return;
+    }
+
+    /* Для повторенного запроса неизвестно, на какую посылку пришел ответ,
+     * поэтому RTT не учитывается (алгоритм Карна) */
+    if(!slot->attempts)
+        rtt_sample(&self->link->rtt, time_monotonic_ms() - slot->sent);
+
+    struct message * response = &self->response;
+    const int64_t start = stats_now(self->stats);
+    const ssize_t len = unpack_response(self, run, slot, data, size);
+    stats_stage(self->stats, STATS_UNPACK, start);
+
+    if(len <= 0) {
+        /* Поврежденный ответ */
+        if(slot_retry(self, slot))
+            return;
+        slot->busy = 0;
+        run->inflight--;
+        run_fail(self, run, slot->index, -EBADMSG);
+        return;
+    }
+
+    slot->busy = 0;
+    run->inflight--;
+
+    if(response_is_valid(&slot->request, response)) {
+        stats_stage(self->stats, STATS_TOTAL, slot->start);
+        run->done++;
+        run->complete(run->ctx, slot->index, response);
+    } else {
+        run_fail(self, run, slot->index, -EBADMSG);
+    }
+}
+
+static size_t run_requests(struct pipeline * self, size_t count, pipeline_prepare_fn prepare, pipeline_sink_fn sink,
+                           pipeline_complete_fn complete, void * ctx)
+{
+    assert(self);
+    assert(prepare);
+    assert(complete);
+
+    struct run run = {complete, sink, ctx, 0, 0, 0};
+    struct link_buffer buffers[PIPELINE_MAX_WINDOW];
+    size_t next = 0;
+    size_t i;
+
+    self->error = 0;
+
+    for(i = 0; i < PIPELINE_MAX_WINDOW; i++) {
+        buffers[i].data = self->rx[i];
+        buffers[i].size = sizeof(self->rx[i]);
+    }
+
+    while(run.inflight || (next < count && !run.failed)) {
+
+        /* 1. Заполнить окно */
+        next = fill_window(self, &run, next, count, prepare);
+
+        if(!run.inflight)
+            break;
+
+        /* 2. Проверить таймауты */
+        struct pipeline_slot * first = slot_earliest(self);
+        const int64_t remain = first->deadline - time_monotonic_ms();
+
+        if(remain <= 0) {
+            if(self->stats)
+                self->stats->timeouts++;
+            rtt_backoff(&self->link->rtt);
+            if(slot_retry(self, first))
+                continue;
+            first->busy = 0;
+            run.inflight--;
+            run_fail(self, &run, first->index, -ETIMEDOUT);
+            continue;
+        }
+
+        /* 3. Дождаться и прочитать все пришедшие ответы */
+        const int64_t start = stats_now(self->stats);
+        int result = link_wait(self->link, (int)remain);
+        stats_stage(self->stats, STATS_WAIT, start);
+        if(result == 0)
+            continue;
+
+        if(result > 0)
+            result = link_recv_batch(self->link, buffers, run.inflight);
+
+        if(result < 0) {
+            /* Линк неработоспособен. Ждать остальные ответы нет смысла */
+            self->error = result;
+            run.failed = 1;
+            while(run.inflight) {
+                first = slot_earliest(self);
+                first->busy = 0;
+                run.inflight--;
+                if(self->stats)
+                    self->stats->failures++;
+                complete(ctx, first->index, NULL);
+            }
+            continue;
+        }
+
+        /* 4. Сопоставить ответы с запросами */
+        for(i = 0; i < (size_t)result; i++) {
+            if(buffers[i].len)
+                handle_response(self, &run, buffers[i].data, buffers[i].len);
+        }
+    }
+
+    /* Запросы, которые не были отправлены */
+    for(; next < count; next++)
+        complete(ctx, next, NULL);
+
+    return run.done;
+}
+
+size_t pipeline_run(struct pipeline * self, size_t count, pipeline_prepare_fn prepare, pipeline_complete_fn complete, void * ctx)
+{
+    return run_requests(self, count, prepare, NULL, complete, ctx);
+}
+
+size_t pipeline_run_sink(struct pipeline * self, size_t count, pipeline_prepare_fn prepare, pipeline_sink_fn sink,
+                         pipeline_complete_fn complete, void * ctx)
+{
+    assert(sink);
+    return run_requests(self, count, prepare, sink, complete, ctx);
+}
+
+static int single_prepare(void * ctx, size_t index, struct message * request)
+{
+    const struct single * single = ctx;
+    *request = *single->request;
+    return 1;
+}
+
+static void single_complete(void * ctx, size_t index, const struct message * response)
+{
+    struct single * single = ctx;
+    if(response)
+        *single->response = *response;
+}
+
+int pipeline_request(struct pipeline * self, const struct message * request, struct message * response)
+{
+    assert(self);
+    assert(request);
+    assert(response);
+
+    struct single single = {request, response};
+    return pipeline_run(self, 1, single_prepare, single_complete, &single) == 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,106 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_BASE_PIPELINE_H
+#define UTILS_BASE_PIPELINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "tekon/tekon.h"
+#include "utils/base/link.h"
+#include "utils/base/stats.h"
+
+/* Номер посылки занимает 4 бита -> одновременно может быть не более 16
+ * запросов. Окно ограничено половиной диапазона, чтобы номер запроса, по
+ * которому истек таймаут, не переиспользовался сразу же и поздний ответ на него
+ * не был принят за ответ на новый запрос. */
+#define PIPELINE_NUMBERS    16
+#define PIPELINE_MAX_WINDOW 8
+
+/* Подготовить запрос с порядковым номером index.
+ * 1 - успешно
+ * 0 - ошибка */
+typedef int (*pipeline_prepare_fn)(void * ctx, size_t index, struct message * request);
+
+/* Обработать ответ на запрос index. При ошибке response == NULL */
+typedef void (*pipeline_complete_fn)(void * ctx, size_t index, const struct message * response);
+
+/* Принять значение element ответа на запрос index (pipeline_run_sink) */
+typedef void (*pipeline_sink_fn)(void * ctx, size_t index, size_t element, uint32_t value, uint8_t qual);
+
+struct pipeline_slot {
+    struct message request;
+    size_t index;
+    size_t attempts; /* кол-во выполненных повторов */
+    int64_t sent;
+    int64_t deadline;
+    int64_t start;   /* время первой отправки, мкс. Для замера задержки */
+    int busy;
+};
+
+/* Конвейер запросов. Держит в сети до window запросов одновременно и
+ * сопоставляет ответы с запросами по номеру посылки. Это позволяет не ждать
+ * полный RTT на каждый запрос, что заметно на медленных каналах.
+ *
+ * Запросы, помещающиеся в окно, отправляются одним пакетом, ответы также
+ * принимаются пакетами (link_send_batch/link_recv_batch).
+ *
+ * Если для линка включена оценка RTT (link->rtt), таймаут запроса берется из
+ * нее, а каждый ответ и таймаут обновляют оценку.
+ *
+ * Запрос, по которому истек таймаут или пришел поврежденный ответ,
+ * повторяется до retries раз без разрыва связи. Остальные запросы окна при
+ * этом продолжают обрабатываться.
+ *
+ * Если бюджет повторов исчерпан, поведение повторяет последовательный обмен:
+ * новые запросы не отправляются, но ответы на уже отправленные ожидаются.
+ *
+ * Если задана статистика stats, в нее заносятся длительности этапов обмена и
+ * время выполнения каждого успешного запроса (от первой отправки до ответа, с
+ * учетом повторов). */
+struct pipeline {
+    struct link * link;
+    size_t window;
+    size_t retries; /* бюджет повторов на запрос. По умолчанию 0 */
+    size_t resent;  /* кол-во выполненных повторов */
+    struct stats * stats; /* статистика обмена. NULL - не собирается */
+    uint8_t number;
+    int error;
+    struct pipeline_slot slot[PIPELINE_NUMBERS];
+    struct message response;
+    char rx[PIPELINE_MAX_WINDOW][512];
+    char tx[PIPELINE_MAX_WINDOW * 512]; /* посылки пакета, подряд */
+};
+
+/* Окно ограничивается [1, PIPELINE_MAX_WINDOW] */
+void pipeline_init(struct pipeline * self, struct link * link, size_t window);
+
+/* Выполнить count запросов.
+ * Возвращает кол-во успешно выполненных запросов. Код последней ошибки
+ * сохраняется в поле error */
+size_t pipeline_run(struct pipeline * self, size_t count, pipeline_prepare_fn prepare, pipeline_complete_fn complete, void * ctx);
+
+/* То же, что pipeline_run, но значения ответов на запросы 0x11 / 0x19 / 0x1C
+ * передаются приемнику sink прямо из принятых посылок, без разбора в
+ * struct message (tekon_resp_unpack_sink). complete вызывается после всех
+ * значений ответа; при успехе в response заполнен только заголовок (тип,
+ * шлюз, кол-во элементов) */
+size_t pipeline_run_sink(struct pipeline * self, size_t count, pipeline_prepare_fn prepare, pipeline_sink_fn sink,
+                         pipeline_complete_fn complete, void * ctx);
+
+/* Выполнить одиночный запрос-ответ
+ * 1 - успешно
+ * 0 - ошибка */
+int pipeline_request(struct pipeline * self, const struct message * request, struct message * response);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,65 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_BASE_REACTOR_H
+#define UTILS_BASE_REACTOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "utils/base/link.h"
+#include "utils/base/wheel.h"
+
+/* События сокета */
+#define REACTOR_IN  1
+#define REACTOR_OUT 2
+#define REACTOR_ERR 4
+
+struct reactor_handler;
+
+typedef void (*reactor_fn)(struct reactor_handler * handler, uint32_t events);
+
+/* Обработчик событий. Встраивается в структуру владельца сокета */
+struct reactor_handler {
+    reactor_fn callback;
+};
+
+/* Цикл обработки событий. Объединяет ожидание событий на множестве сокетов
+ * (epoll) и колесо таймеров для таймаутов. Позволяет одному процессу
+ * обслуживать сотни шлюзов без потоков.
+ * Реализация есть только для Linux */
+struct reactor {
+    int epoll;
+    struct wheel wheel;
+};
+
+/* В случае успеха вернет 0. Иначе - код ошибки */
+int reactor_init(struct reactor * self);
+
+void reactor_close(struct reactor * self);
+
+/* Подписаться на события сокета (REACTOR_IN | REACTOR_OUT).
+ * В случае успеха вернет 0. Иначе - код ошибки */
+int reactor_add(struct reactor * self, socket_t socket, uint32_t events, struct reactor_handler * handler);
+int reactor_modify(struct reactor * self, socket_t socket, uint32_t events, struct reactor_handler * handler);
+void reactor_remove(struct reactor * self, socket_t socket);
+
+/* Одна итерация цикла: ждать события не более timeout мс (-1 - до ближайшего
+ * таймера), вызвать обработчики событий и сработавших таймеров.
+ * Возвращает кол-во обработанных событий и таймеров или код ошибки */
+int reactor_poll(struct reactor * self, int timeout);
+
+/* Выполнять цикл, пока есть взведенные таймеры. Таймер взведен на время
+ * каждой незавершенной операции, поэтому цикл завершится, когда будут
+ * выполнены все операции */
+int reactor_run(struct reactor * self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,89 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/base/rtt.h"
+#include <assert.h>
+#include <string.h>
+
+static uint16_t clamp(const struct rtt * self, int64_t value)
+{
+    if(value < self->min)
+        return self->min;
+    if(value > self->max)
+        return self->max;
+    return (uint16_t)value;
+}
+
+void rtt_init(struct rtt * self, uint16_t initial, uint16_t min, uint16_t max)
+{
+    assert(self);
+    assert(min > 0);
+    assert(min <= max);
+
+    memset(self, 0, sizeof(*self));
+    self->min = min;
+    self->max = max;
+    self->rto = clamp(self, initial);
+}
+
+int rtt_enabled(const struct rtt * self)
+{
+    assert(self);
+    return self->max != 0;
+}
+
+void rtt_sample(struct rtt * self, int64_t rtt)
+{
+    assert(self);
+
+    if(!rtt_enabled(self))
+        return;
+
+    if(rtt < 0)
+        rtt = 0;
+
+    if(rtt > self->max)
+        rtt = self->max;
+
+    if(self->samples == 0) {
+        /* srtt = R, rttvar = R / 2 */
+        self->srtt = (int32_t)rtt << 3;
+        self->rttvar = (int32_t)rtt << 1;
+    } else {
+        /* srtt += (R - srtt) / 8, rttvar += (|R - srtt| - rttvar) / 4 */
+        int32_t delta = (int32_t)rtt - (self->srtt >> 3);
+        self->srtt += delta;
+        if(delta < 0)
+            delta = -delta;
+        self->rttvar += delta - (self->rttvar >> 2);
+    }
+
+    self->samples++;
+    self->rto = clamp(self, (self->srtt >> 3) + self->rttvar);
+}
+
+void rtt_backoff(struct rtt * self)
+{
+    assert(self);
+
+    if(!rtt_enabled(self))
+        return;
+
+    self->rto = clamp(self, (int64_t)self->rto * 2);
+}
+
+uint16_t rtt_timeout(const struct rtt * self, uint16_t fallback)
+{
+    assert(self);
+    return rtt_enabled(self) ? self->rto : fallback;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,55 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_BASE_RTT_H
+#define UTILS_BASE_RTT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Оценка времени ответа (алгоритм Джекобсона/Карелса, как в TCP).
+ * По измеренным RTT ведутся сглаженное среднее и отклонение, из которых
+ * вычисляется таймаут ответа:
+ *
+ *   rto = srtt + 4 * rttvar,  min <= rto <= max
+ *
+ * Быстрый шлюз в локальной сети получает таймаут в десятки мс, медленный
+ * (GSM) - таймаут, превышающий его обычное время ответа. После истечения
+ * таймаута он удваивается (не более max) до следующего успешного замера.
+ *
+ * Нулевая структура соответствует выключенной оценке: используется
+ * статический таймаут линка. */
+struct rtt {
+    int32_t srtt;    /* сглаженное RTT, мс * 8 */
+    int32_t rttvar;  /* отклонение RTT, мс * 4 */
+    uint16_t rto;    /* текущий таймаут, мс */
+    uint16_t min;
+    uint16_t max;
+    uint32_t samples;
+};
+
+/* Включить оценку. initial - таймаут до первого замера */
+void rtt_init(struct rtt * self, uint16_t initial, uint16_t min, uint16_t max);
+
+int rtt_enabled(const struct rtt * self);
+
+/* Учесть RTT успешного запроса, мс. Запросы, по которым выполнялся повтор,
+ * учитывать нельзя: неизвестно, на какую из посылок пришел ответ */
+void rtt_sample(struct rtt * self, int64_t rtt);
+
+/* Учесть истекший таймаут */
+void rtt_backoff(struct rtt * self);
+
+/* Текущий таймаут ответа, мс. Если оценка выключена - fallback */
+uint16_t rtt_timeout(const struct rtt * self, uint16_t fallback);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
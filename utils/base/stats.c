@@ -0,0 +1,82 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/base/stats.h"
+#include <assert.h>
+#include <inttypes.h>
+#include <string.h>
+#include "utils/base/time.h"
+
+static const char * stage_names[STATS_STAGES] = {"pack", "send", "wait", "unpack", "total"};
+
+void stats_init(struct stats * self)
+{
+    assert(self);
+    memset(self, 0, sizeof(*self));
+
+    size_t i;
+    for(i = 0; i < STATS_STAGES; i++)
+        hist_init(&self->stage[i]);
+}
+
+int64_t stats_now(const struct stats * self)
+{
+    return self ? time_monotonic_us() : 0;
+}
+
+void stats_stage(struct stats * self, enum stats_stage stage, int64_t start)
+{
+    if(!self)
+        return;
+
+    assert(stage < STATS_STAGES);
+    hist_add(&self->stage[stage], time_monotonic_us() - start);
+}
+
+void stats_stage_batch(struct stats * self, enum stats_stage stage, int64_t start, size_t count)
+{
+    if(!self || !count)
+        return;
+
+    assert(stage < STATS_STAGES);
+    const int64_t share = (time_monotonic_us() - start) / (int64_t)count;
+    while(count--)
+        hist_add(&self->stage[stage], share);
+}
+
+void stats_print(const struct stats * self, const struct link_stat * link, FILE * out)
+{
+    assert(self);
+    assert(out);
+
+    size_t i;
+
+    fprintf(out, "requests: %"PRIu64" retries: %"PRIu64" timeouts: %"PRIu64" failures: %"PRIu64,
+            self->requests, self->retries, self->timeouts, self->failures);
+
+    if(link)
+        fprintf(out, " discarded: %"PRIu64" syscalls: %"PRIu64" tx: %"PRIu64" rx: %"PRIu64,
+                link->discarded, link->syscalls, link->tx, link->rx);
+
+    fprintf(out, "\n%-8s %10s %10s %10s %10s %10s %10s %10s\n",
+            "stage,us", "count", "min", "mean", "p50", "p90", "p99", "max");
+
+    for(i = 0; i < STATS_STAGES; i++) {
+        const struct hist * hist = &self->stage[i];
+        if(!hist->count)
+            continue;
+        fprintf(out, "%-8s %10"PRIu64" %10"PRIi64" %10"PRIi64" %10"PRIi64" %10"PRIi64" %10"PRIi64" %10"PRIi64"\n",
+                stage_names[i], hist->count, hist->min, hist_mean(hist),
+                hist_percentile(hist, 50), hist_percentile(hist, 90), hist_percentile(hist, 99), hist->max);
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,61 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_BASE_STATS_H
+#define UTILS_BASE_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include "utils/base/hist.h"
+#include "utils/base/link.h"
+
+/* Этапы обмена */
+enum stats_stage { STATS_PACK,   /* упаковка запроса */
+                   STATS_SEND,   /* отправка */
+                   STATS_WAIT,   /* ожидание ответа */
+                   STATS_UNPACK, /* разбор ответа */
+                   STATS_TOTAL,  /* запрос целиком: от первой отправки до ответа */
+                   STATS_STAGES
+                 };
+
+/* Статистика обмена за время работы утилиты.
+ * Для каждого этапа ведется гистограмма длительностей (мкс). При
+ * последовательном обмене этап соответствует одному запросу, при конвейерном
+ * отправка и ожидание учитываются на вызов, т.е. на пакет запросов.
+ *
+ * Функции принимают NULL - статистика не собирается. В этом случае время не
+ * запрашивается, и накладных расходов нет */
+struct stats {
+    struct hist stage[STATS_STAGES];
+    uint64_t requests; /* отправленные запросы (без повторов) */
+    uint64_t retries;  /* повторы */
+    uint64_t timeouts; /* истекшие таймауты */
+    uint64_t failures; /* запросы, завершенные с ошибкой */
+};
+
+void stats_init(struct stats * self);
+
+/* Момент начала этапа, мкс. 0, если статистика не собирается */
+int64_t stats_now(const struct stats * self);
+
+/* Учесть этап, начавшийся в start (stats_now) */
+void stats_stage(struct stats * self, enum stats_stage stage, int64_t start);
+
+/* Учесть count этапов, выполненных одним вызовом, начавшимся в start.
+ * Каждому этапу приписывается равная доля времени */
+void stats_stage_batch(struct stats * self, enum stats_stage stage, int64_t start, size_t count);
+
+/* Вывести сводку. link - счетчики линка, может быть NULL */
+void stats_print(const struct stats * self, const struct link_stat * link, FILE * out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,242 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "test/minunit.h"
+#include "utils/base/alink.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+struct result {
+    int calls;
+    int error;
+    char data[64];
+    size_t len;
+};
+
+static void on_done(struct alink * self, int error, const void * data, size_t len)
+{
+    struct result * result = self->data;
+    result->calls++;
+    result->error = error;
+    result->len = len;
+    if(data && len <= sizeof(result->data))
+        memcpy(result->data, data, len);
+}
+
+static int server_init(int type, uint16_t * port)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    int s = socket(AF_INET, type, 0);
+    if(bind(s, (struct sockaddr*)&addr, sizeof(addr)) ||
+            getsockname(s, (struct sockaddr*)&addr, &len))
+        return -1;
+
+    if(type == SOCK_STREAM)
+        listen(s, 4);
+
+    *port = ntohs(addr.sin_port);
+    return s;
+}
+
+static void run_until(struct reactor * reactor, const struct result * result, int calls)
+{
+    int i;
+    for(i = 0; i < 100 && result->calls < calls; i++)
+        reactor_poll(reactor, 10);
+}
+
+MU_TEST(test_udp_request)
+{
+    struct reactor reactor;
+    struct alink link;
+    struct result result = {0};
+    uint16_t port;
+    char buffer[64];
+    struct sockaddr_in peer;
+    socklen_t plen = sizeof(peer);
+
+    int server = server_init(SOCK_DGRAM, &port);
+    mu_check(server >= 0);
+    mu_assert_int_eq(0, reactor_init(&reactor));
+    mu_assert_int_eq(0, alink_init_udp(&link, &reactor, "127.0.0.1", port, 500));
+    link.data = &result;
+
+    mu_assert_int_eq(0, alink_up(&link, on_done));
+    mu_assert_int_eq(-EISCONN, alink_up(&link, on_done));
+    mu_assert_int_eq(ALINK_CONNECTING, alink_state(&link));
+    run_until(&reactor, &result, 1);
+    mu_assert_int_eq(1, result.calls);
+    mu_assert_int_eq(0, result.error);
+    mu_assert_int_eq(ALINK_IDLE, alink_state(&link));
+
+    mu_assert_int_eq(0, alink_request(&link, "ping", 4, on_done));
+    mu_assert_int_eq(-EBUSY, alink_request(&link, "ping", 4, on_done));
+    mu_assert_int_eq(ALINK_WAIT, alink_state(&link));
+
+    int size = recvfrom(server, buffer, sizeof(buffer), 0, (struct sockaddr*)&peer, &plen);
+    mu_assert_int_eq(4, size);
+    sendto(server, "pong", 4, 0, (struct sockaddr*)&peer, plen);
+
+    mu_assert_int_eq(0, reactor_run(&reactor));
+    mu_assert_int_eq(2, result.calls);
+    mu_assert_int_eq(0, result.error);
+    mu_assert_int_eq(4, result.len);
+    mu_check(memcmp(result.data, "pong", 4) == 0);
+    mu_assert_int_eq(ALINK_IDLE, alink_state(&link));
+
+    alink_down(&link);
+    mu_assert_int_eq(ALINK_DOWN, alink_state(&link));
+    reactor_close(&reactor);
+    close(server);
+}
+
+MU_TEST(test_udp_timeout)
+{
+    struct reactor reactor;
+    struct alink link;
+    struct result result = {0};
+    uint16_t port;
+
+    int server = server_init(SOCK_DGRAM, &port);
+    reactor_init(&reactor);
+    alink_init_udp(&link, &reactor, "127.0.0.1", port, 50);
+    link.data = &result;
+
+    alink_up(&link, on_done);
+    run_until(&reactor, &result, 1);
+
+    mu_assert_int_eq(0, alink_request(&link, "ping", 4, on_done));
+    mu_assert_int_eq(0, reactor_run(&reactor));
+    mu_assert_int_eq(2, result.calls);
+    mu_assert_int_eq(-ETIMEDOUT, result.error);
+    mu_assert_int_eq(ALINK_IDLE, alink_state(&link));
+
+    alink_down(&link);
+    reactor_close(&reactor);
+    close(server);
+}
+
+MU_TEST(test_tcp_connect)
+{
+    struct reactor reactor;
+    struct alink link;
+    struct result result = {0};
+    uint16_t port;
+
+    int server = server_init(SOCK_STREAM, &port);
+    reactor_init(&reactor);
+    alink_init_tcp(&link, &reactor, "127.0.0.1", port, 500);
+    link.data = &result;
+
+    mu_assert_int_eq(0, alink_up(&link, on_done));
+    run_until(&reactor, &result, 1);
+    mu_assert_int_eq(0, result.error);
+    mu_assert_int_eq(ALINK_IDLE, alink_state(&link));
+
+    alink_down(&link);
+    reactor_close(&reactor);
+    close(server);
+}
+
+MU_TEST(test_tcp_short_send)
+{
+    static char frame[1 << 20];
+    struct reactor reactor;
+    struct alink link;
+    struct result result = {0};
+    uint16_t port;
+    int size = 4096;
+
+    /* Шлюз не читает запросы, буферы малы: посылка уходит не полностью */
+    int server = server_init(SOCK_STREAM, &port);
+    setsockopt(server, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    reactor_init(&reactor);
+    alink_init_tcp(&link, &reactor, "127.0.0.1", port, 500);
+    link.data = &result;
+
+    mu_assert_int_eq(0, alink_up(&link, on_done));
+    run_until(&reactor, &result, 1);
+    mu_assert_int_eq(ALINK_IDLE, alink_state(&link));
+    setsockopt(link.link.socket, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+    mu_assert_int_eq(-EIO, alink_request(&link, frame, sizeof(frame), on_done));
+    mu_assert_int_eq(ALINK_DOWN, alink_state(&link));
+    mu_check(link.link.socket == TEKON_INVALID_SOCKET);
+
+    reactor_close(&reactor);
+    close(server);
+}
+
+MU_TEST(test_tcp_refused)
+{
+    struct reactor reactor;
+    struct alink link;
+    struct result result = {0};
+    uint16_t port;
+
+    /* Порт освобождается сразу после получения */
+    int server = server_init(SOCK_STREAM, &port);
+    close(server);
+
+    reactor_init(&reactor);
+    alink_init_tcp(&link, &reactor, "127.0.0.1", port, 500);
+    link.data = &result;
+
+    int err = alink_up(&link, on_done);
+    if(err == 0) {
+        run_until(&reactor, &result, 1);
+        err = result.error;
+    }
+    mu_assert_int_eq(-ECONNREFUSED, err);
+    mu_assert_int_eq(ALINK_DOWN, alink_state(&link));
+    reactor_close(&reactor);
+}
+
+MU_TEST(test_invalid_usage)
+{
+    struct reactor reactor;
+    struct alink link;
+
+    reactor_init(&reactor);
+    mu_assert_int_eq(-EINVAL, alink_init_udp(&link, &reactor, "bbzzz", 8888, 100));
+
+    alink_init_udp(&link, &reactor, "127.0.0.1", 8888, 100);
+    mu_assert_int_eq(-ENOTCONN, alink_request(&link, "ping", 4, on_done));
+    mu_assert_int_eq(-ENOTCONN, alink_resume(&link));
+    alink_down(&link);
+    reactor_close(&reactor);
+}
+
+MU_TEST_SUITE(suite_alink)
+{
+    MU_RUN_TEST(test_udp_request);
+    MU_RUN_TEST(test_udp_timeout);
+    MU_RUN_TEST(test_tcp_connect);
+    MU_RUN_TEST(test_tcp_short_send);
+    MU_RUN_TEST(test_tcp_refused);
+    MU_RUN_TEST(test_invalid_usage);
+}
+
+int main()
+{
+    MU_RUN_SUITE(suite_alink);
+    MU_REPORT();
+    return mu_get_fails();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,63 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "test/minunit.h"
+#include "utils/base/arena.h"
+
+MU_TEST(test_alloc)
+{
+    struct arena arena;
+    mu_assert_int_eq(0, arena_init(&arena, 100));
+    mu_assert_int_eq(104, arena.size);
+
+    /* Части выдаются подряд с выравниванием */
+    uint8_t * first = arena_alloc(&arena, 3);
+    uint8_t * second = arena_alloc(&arena, 16);
+    mu_check(first != NULL && second != NULL);
+    mu_assert_int_eq(ARENA_ALIGN, second - first);
+    mu_assert_int_eq(0, (uintptr_t)second % ARENA_ALIGN);
+    mu_assert_int_eq(24, arena.used);
+
+    /* Места не хватает */
+    mu_check(arena_alloc(&arena, 81) == NULL);
+    mu_check(arena_alloc(&arena, 80) != NULL);
+    mu_check(arena_alloc(&arena, 1) == NULL);
+    mu_check(arena_alloc(&arena, 0) == NULL);
+
+    arena_reset(&arena);
+    mu_check(arena_alloc(&arena, 104) == first);
+    arena_free(&arena);
+    mu_check(arena.data == NULL);
+}
+
+MU_TEST(test_empty)
+{
+    struct arena arena;
+    mu_assert_int_eq(0, arena_init(&arena, 0));
+    mu_check(arena_alloc(&arena, 1) == NULL);
+    arena_free(&arena);
+}
+
+MU_TEST_SUITE(suite_arena)
+{
+    MU_RUN_TEST(test_alloc);
+    MU_RUN_TEST(test_empty);
+}
+
+int main()
+{
+    MU_RUN_SUITE(suite_arena);
+    MU_REPORT();
+    return mu_get_fails();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,148 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include "test/minunit.h"
+#include "utils/base/capture.h"
+#include "utils/base/link.h"
+#include "utils/base/time.h"
+
+#define TEST_FILE "unit_capture.bin"
+
+static const char request[] = {0x10, 0x40, 0x02, 0x42, 0x16};
+static const char reply[] = {0x68, 0x03, 0x03, 0x68, 0x40, 0x02, 0x00, 0x42, 0x16};
+
+/* Записать обмен: запрос, через delay мкс ответ, затем опоздавший ответ */
+static void write_capture(int64_t delay)
+{
+    struct capture capture;
+
+    mu_assert_int_eq(0, capture_open(&capture, TEST_FILE));
+    mu_assert_int_eq(0, capture_frame(&capture, CAPTURE_TX, request, sizeof(request)));
+    time_sleep_us(delay);
+    mu_assert_int_eq(0, capture_frame(&capture, CAPTURE_RX, reply, sizeof(reply)));
+    mu_assert_int_eq(0, capture_frame(&capture, CAPTURE_RX, reply, 4));
+    mu_assert_int_eq(3, capture.frames);
+    capture_close(&capture);
+}
+
+MU_TEST(test_replay)
+{
+    struct replay replay;
+    char buffer[64];
+
+    write_capture(20000);
+    mu_assert_int_eq(0, replay_open(&replay, TEST_FILE, 1));
+    mu_assert_int_eq(3, replay.size);
+
+    /* Ответ не выдается до отправки запроса */
+    mu_assert_int_eq(-EAGAIN, replay_recv(&replay, buffer, sizeof(buffer)));
+    mu_assert_int_eq(0, replay_wait(&replay, 5));
+
+    /* Ответ выдается с записанной задержкой */
+    const int64_t start = time_monotonic_us();
+    mu_assert_int_eq(sizeof(request), replay_send(&replay, request, sizeof(request)));
+    mu_assert_int_eq(-EAGAIN, replay_recv(&replay, buffer, sizeof(buffer)));
+    mu_assert_int_eq(1, replay_wait(&replay, 1000));
+    mu_check(time_monotonic_us() - start >= 19000);
+
+    mu_assert_int_eq(sizeof(reply), replay_recv(&replay, buffer, sizeof(buffer)));
+    mu_check(memcmp(buffer, reply, sizeof(reply)) == 0);
+
+    /* Лишние байты отбрасываются, как у recv */
+    mu_assert_int_eq(2, replay_recv(&replay, buffer, 2));
+
+    /* Захват закончился */
+    mu_assert_int_eq(-EAGAIN, replay_recv(&replay, buffer, sizeof(buffer)));
+    mu_assert_int_eq(0, replay_wait(&replay, 5));
+    replay_close(&replay);
+}
+
+MU_TEST(test_link)
+{
+    struct replay replay;
+    struct link link;
+    struct link_buffer buffers[4];
+    char data[4][64];
+    size_t i;
+
+    write_capture(50000);
+
+    for(i = 0; i < 4; i++) {
+        buffers[i].data = data[i];
+        buffers[i].size = sizeof(data[i]);
+        buffers[i].len = 0;
+    }
+
+    /* Без задержек линк отвечает сразу после запроса, сокет не создается */
+    mu_assert_int_eq(0, replay_open(&replay, TEST_FILE, 0));
+    link_init_udp(&link, "127.0.0.1", 1, 100);
+    link.replay = &replay;
+    mu_assert_int_eq(0, link_up(&link));
+
+    mu_assert_int_eq(0, link_recv_batch(&link, buffers, 4));
+    mu_assert_int_eq(sizeof(request), link_send(&link, request, sizeof(request)));
+    mu_assert_int_eq(1, link_wait(&link, 0));
+    mu_assert_int_eq(2, link_recv_batch(&link, buffers, 4));
+    mu_assert_int_eq(sizeof(reply), buffers[0].len);
+    mu_assert_int_eq(4, buffers[1].len);
+
+    /* Ответов больше нет: прием ждет таймаут линка */
+    mu_assert_int_eq(-EAGAIN, link_recv(&link, data[0], sizeof(data[0])));
+    mu_assert_int_eq(1, link.stat.tx);
+    mu_assert_int_eq(2, link.stat.rx);
+    mu_assert_int_eq(0, link.stat.syscalls);
+
+    link_down(&link);
+    replay_close(&replay);
+}
+
+MU_TEST(test_invalid)
+{
+    struct replay replay;
+    FILE * file;
+
+    mu_assert_int_eq(-ENOENT, replay_open(&replay, "unit_capture.missing", 1));
+
+    file = fopen(TEST_FILE, "wb");
+    mu_check(file != NULL);
+    fputs("TKCX\x01", file);
+    fclose(file);
+    mu_assert_int_eq(-EINVAL, replay_open(&replay, TEST_FILE, 1));
+
+    /* Обрезанная запись */
+    write_capture(0);
+    file = fopen(TEST_FILE, "ab");
+    mu_check(file != NULL);
+    fputs("\x01\x00", file);
+    fclose(file);
+    mu_assert_int_eq(-EINVAL, replay_open(&replay, TEST_FILE, 1));
+
+    remove(TEST_FILE);
+}
+
+MU_TEST_SUITE(suite_capture)
+{
+    MU_RUN_TEST(test_replay);
+    MU_RUN_TEST(test_link);
+    MU_RUN_TEST(test_invalid);
+}
+
+int main()
+{
+    MU_RUN_SUITE(suite_capture);
+    MU_REPORT();
+    return mu_get_fails();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,137 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include "test/minunit.h"
+#include "tekon/trace.h"
+#include "utils/base/diag.h"
+
+#define TEST_FILE "unit_diag.bin"
+
+MU_TEST(test_options)
+{
+    struct diag diag;
+    diag_init(&diag, "unit_diag");
+
+    mu_check(diag_stats(&diag) == NULL);
+    mu_assert_int_eq(1, diag.speed);
+    mu_check(!diag_link_used(&diag));
+
+    mu_assert_int_eq(1, diag_option(&diag, DIAG_OPT_STATS, NULL));
+    mu_check(diag_stats(&diag) == &diag.stats);
+
+    mu_assert_int_eq(1, diag_option(&diag, DIAG_OPT_SPEED, "0"));
+    mu_assert_int_eq(0, diag.speed);
+    mu_assert_int_eq(0, diag_option(&diag, DIAG_OPT_SPEED, "x"));
+    mu_assert_int_eq(0, diag_option(&diag, DIAG_OPT_SPEED, "-1"));
+    mu_assert_int_eq(0, diag_option(&diag, DIAG_OPT_SPEED, "1000001"));
+
+    mu_assert_int_eq(0, diag_option(&diag, DIAG_OPT_FAULT, "bzz=1"));
+    mu_check(!diag_link_used(&diag));
+    mu_assert_int_eq(1, diag_option(&diag, DIAG_OPT_FAULT, "drop=5"));
+    mu_check(diag_link_used(&diag));
+
+    mu_assert_int_eq(TEKON_TRACE_ENABLED, diag_option(&diag, DIAG_OPT_TRACE, "trace.json"));
+
+    /* Опции утилиты и '?' не разбираются */
+    mu_assert_int_eq(-1, diag_option(&diag, 't', "100"));
+    mu_assert_int_eq(-1, diag_option(&diag, '?', NULL));
+
+    /* Таблица getopt_long покрывает все опции */
+    size_t count = 0;
+    while(diag_options[count].name)
+        count++;
+    mu_assert_int_eq(DIAG_OPT_TRACE - DIAG_OPT_FIRST + 1, count);
+}
+
+MU_TEST(test_attach)
+{
+    struct diag diag;
+    struct link link;
+
+    diag_init(&diag, "unit_diag");
+    memset(&link, 0, sizeof(link));
+
+    /* Без опций линк работает напрямую */
+    mu_assert_int_eq(0, diag_open(&diag));
+    diag_attach(&diag, &link);
+    mu_check(link.capture == NULL);
+    mu_check(link.replay == NULL);
+    mu_check(link.fault == NULL);
+    diag_close(&diag);
+
+    mu_assert_int_eq(1, diag_option(&diag, DIAG_OPT_CAPTURE, TEST_FILE));
+    mu_assert_int_eq(1, diag_option(&diag, DIAG_OPT_FAULT, "corrupt=1"));
+    mu_assert_int_eq(0, diag_open(&diag));
+    diag_attach(&diag, &link);
+    mu_check(link.capture == &diag.capture);
+    mu_check(link.replay == NULL);
+    mu_check(link.fault == &diag.fault);
+    diag_close(&diag);
+
+    /* Воспроизведение записанного файла */
+    diag_init(&diag, "unit_diag");
+    mu_assert_int_eq(1, diag_option(&diag, DIAG_OPT_REPLAY, TEST_FILE));
+    mu_assert_int_eq(0, diag_open(&diag));
+    diag_attach(&diag, &link);
+    mu_check(link.capture == NULL);
+    mu_check(link.replay == &diag.replay);
+    diag_close(&diag);
+    remove(TEST_FILE);
+
+    /* Файл воспроизведения не найден */
+    diag_init(&diag, "unit_diag");
+    mu_assert_int_eq(1, diag_option(&diag, DIAG_OPT_REPLAY, TEST_FILE));
+    mu_check(diag_open(&diag) != 0);
+}
+
+MU_TEST(test_print)
+{
+    struct diag diag;
+    char text[1024];
+
+    diag_init(&diag, "unit_diag");
+    mu_assert_int_eq(1, diag_option(&diag, DIAG_OPT_FAULT, "drop=5"));
+
+    /* Без --stats ничего не выводится */
+    FILE * out = tmpfile();
+    mu_check(out != NULL);
+    diag_print(&diag, NULL, out);
+    mu_assert_int_eq(0, ftell(out));
+    fclose(out);
+
+    mu_assert_int_eq(1, diag_option(&diag, DIAG_OPT_STATS, NULL));
+    out = tmpfile();
+    mu_check(out != NULL);
+    diag_print(&diag, NULL, out);
+    rewind(out);
+    const size_t len = fread(text, 1, sizeof(text) - 1, out);
+    text[len] = 0;
+    fclose(out);
+    mu_check(strstr(text, "fault frames: 0") != NULL);
+}
+
+MU_TEST_SUITE(suite_diag)
+{
+    MU_RUN_TEST(test_options);
+    MU_RUN_TEST(test_attach);
+    MU_RUN_TEST(test_print);
+}
+
+int main()
+{
+    MU_RUN_SUITE(suite_diag);
+    MU_REPORT();
+    return mu_get_fails();
+}
+
+#ifdef __cplusplus
+}
+#endif
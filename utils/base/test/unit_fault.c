@@ -0,0 +1,232 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include "test/minunit.h"
+#include "utils/base/capture.h"
+#include "utils/base/fault.h"
+#include "utils/base/link.h"
+
+#define TEST_FILE "unit_fault.bin"
+
+static const uint8_t reply[] = {0x68, 0x03, 0x03, 0x68, 0x40, 0x02, 0x00, 0x42, 0x16};
+
+static struct fault fault;
+
+static void init(const char * spec)
+{
+    struct fault_config config;
+    mu_check(fault_config_from_string(&config, spec));
+    fault_init(&fault, &config);
+}
+
+MU_TEST(test_config)
+{
+    struct fault_config config;
+
+    mu_check(fault_config_from_string(&config, ""));
+    mu_assert_int_eq(0, config.drop);
+    mu_assert_int_eq(1, config.seed);
+
+    mu_check(fault_config_from_string(&config, "drop=5,dup=1,reorder=0.5,truncate=100,corrupt=2,delay=10:50,seed=7"));
+    mu_assert_int_eq(50000, config.drop);
+    mu_assert_int_eq(10000, config.duplicate);
+    mu_assert_int_eq(5000, config.reorder);
+    mu_assert_int_eq(FAULT_SCALE, config.truncate);
+    mu_assert_int_eq(20000, config.corrupt);
+    mu_assert_int_eq(100000, config.delay);
+    mu_assert_int_eq(50, config.delay_max);
+    mu_assert_int_eq(7, config.seed);
+
+    mu_check(!fault_config_from_string(&config, "drop"));
+    mu_check(!fault_config_from_string(&config, "drop=101"));
+    mu_check(!fault_config_from_string(&config, "drop=-1"));
+    mu_check(!fault_config_from_string(&config, "lost=1"));
+    mu_check(!fault_config_from_string(&config, "delay=10"));
+    mu_check(!fault_config_from_string(&config, "delay=10:0"));
+    mu_check(!fault_config_from_string(&config, "drop=1;dup=1"));
+    mu_check(!fault_config_from_string(&config, "seed=x"));
+}
+
+MU_TEST(test_schedule)
+{
+    struct fault_stat first;
+    uint8_t data[sizeof(reply)];
+    size_t i;
+
+    /* Одинаковый seed - одинаковые искажения */
+    init("drop=20,dup=5,truncate=5,corrupt=5,seed=3");
+    for(i = 0; i < 1000; i++) {
+        fault_push(&fault, reply, sizeof(reply), 0);
+        while(fault_pop(&fault, data, sizeof(data), 0) > 0);
+    }
+    first = fault.stat;
+    mu_assert_int_eq(1000, first.frames);
+    mu_check(first.dropped > 150 && first.dropped < 250);
+    mu_check(first.duplicated > 0 && first.truncated > 0 && first.corrupted > 0);
+
+    init("drop=20,dup=5,truncate=5,corrupt=5,seed=3");
+    for(i = 0; i < 1000; i++) {
+        fault_push(&fault, reply, sizeof(reply), 0);
+        while(fault_pop(&fault, data, sizeof(data), 0) > 0);
+    }
+    mu_check(memcmp(&first, &fault.stat, sizeof(first)) == 0);
+
+    /* Без искажений посылки проходят как есть */
+    init("seed=3");
+    fault_push(&fault, reply, sizeof(reply), 0);
+    mu_assert_int_eq(sizeof(reply), fault_pop(&fault, data, sizeof(data), 0));
+    mu_check(memcmp(data, reply, sizeof(reply)) == 0);
+    mu_assert_int_eq(-EAGAIN, fault_pop(&fault, data, sizeof(data), 0));
+    mu_assert_int_eq(-1, fault_next(&fault));
+}
+
+MU_TEST(test_faults)
+{
+    uint8_t data[sizeof(reply)];
+    uint8_t other[sizeof(reply)];
+
+    init("drop=100");
+    fault_push(&fault, reply, sizeof(reply), 0);
+    mu_assert_int_eq(-EAGAIN, fault_pop(&fault, data, sizeof(data), 0));
+    mu_assert_int_eq(1, fault.stat.dropped);
+
+    /* Портится байт КС */
+    init("corrupt=100");
+    fault_push(&fault, reply, sizeof(reply), 0);
+    mu_assert_int_eq(sizeof(reply), fault_pop(&fault, data, sizeof(data), 0));
+    mu_assert_int_eq(reply[sizeof(reply) - 2] ^ 0xFF, data[sizeof(reply) - 2]);
+    mu_check(memcmp(data, reply, sizeof(reply) - 2) == 0);
+
+    init("truncate=100");
+    fault_push(&fault, reply, sizeof(reply), 0);
+    const ssize_t len = fault_pop(&fault, data, sizeof(data), 0);
+    mu_check(len > 0 && len < (ssize_t)sizeof(reply));
+
+    init("dup=100");
+    fault_push(&fault, reply, sizeof(reply), 0);
+    mu_assert_int_eq(sizeof(reply), fault_pop(&fault, data, sizeof(data), 0));
+    mu_assert_int_eq(sizeof(reply), fault_pop(&fault, data, sizeof(data), 0));
+    mu_assert_int_eq(-EAGAIN, fault_pop(&fault, data, sizeof(data), 0));
+
+    /* Переставленная посылка выдается после следующей */
+    init("reorder=100");
+    fault_push(&fault, reply, sizeof(reply), 0);
+    mu_assert_int_eq(-EAGAIN, fault_pop(&fault, data, sizeof(data), 0));
+    mu_assert_int_eq(-1, fault_next(&fault));
+    fault.config.reorder = 0;
+    memcpy(other, reply, sizeof(other));
+    other[4] = 0x41;
+    fault_push(&fault, other, sizeof(other), 0);
+    mu_assert_int_eq(sizeof(reply), fault_pop(&fault, data, sizeof(data), 0));
+    mu_assert_int_eq(0x41, data[4]);
+    mu_assert_int_eq(sizeof(reply), fault_pop(&fault, data, sizeof(data), 0));
+    mu_assert_int_eq(0x40, data[4]);
+
+    /* Задержанную посылку обгоняют следующие */
+    init("delay=100:10");
+    fault_push(&fault, reply, sizeof(reply), 1000);
+    mu_check(fault_next(&fault) > 1000 && fault_next(&fault) <= 11000);
+    mu_assert_int_eq(-EAGAIN, fault_pop(&fault, data, sizeof(data), 1000));
+    mu_assert_int_eq(sizeof(reply), fault_pop(&fault, data, sizeof(data), 11000));
+    mu_assert_int_eq(1, fault.stat.delayed);
+
+    /* Переполнение очереди */
+    init("reorder=100");
+    size_t i;
+    for(i = 0; i < FAULT_MAX_QUEUE + 2; i++)
+        fault_push(&fault, reply, sizeof(reply), 0);
+    mu_assert_int_eq(FAULT_MAX_QUEUE, fault.size);
+    mu_assert_int_eq(2, fault.stat.overflow);
+    fault_clear(&fault);
+    mu_assert_int_eq(0, fault.size);
+}
+
+MU_TEST(test_link)
+{
+    const uint8_t request[] = {0x10, 0x40, 0x02, 0x42, 0x16};
+    struct capture capture;
+    struct replay replay;
+    struct link link;
+    struct link_buffer buffers[4];
+    uint8_t data[4][64];
+    size_t i;
+
+    /* Источник посылок - захват с двумя ответами на один запрос */
+    mu_assert_int_eq(0, capture_open(&capture, TEST_FILE));
+    mu_assert_int_eq(0, capture_frame(&capture, CAPTURE_TX, request, sizeof(request)));
+    mu_assert_int_eq(0, capture_frame(&capture, CAPTURE_RX, reply, sizeof(reply)));
+    mu_assert_int_eq(0, capture_frame(&capture, CAPTURE_RX, reply, sizeof(reply)));
+    capture_close(&capture);
+
+    for(i = 0; i < 4; i++) {
+        buffers[i].data = data[i];
+        buffers[i].size = sizeof(data[i]);
+        buffers[i].len = 0;
+    }
+
+    /* Каждый ответ повторяется */
+    init("dup=100,delay=100:20");
+    mu_assert_int_eq(0, replay_open(&replay, TEST_FILE, 0));
+    link_init_udp(&link, "127.0.0.1", 1, 100);
+    link.replay = &replay;
+    link.fault = &fault;
+    mu_assert_int_eq(0, link_up(&link));
+
+    mu_assert_int_eq(sizeof(request), link_send(&link, request, sizeof(request)));
+    mu_assert_int_eq(0, link_recv_batch(&link, buffers, 4));
+    mu_assert_int_eq(1, link_wait(&link, 100));
+    /* Берется одна посылка: остальные копии могли уже созреть к этому моменту */
+    mu_assert_int_eq(1, link_recv_batch(&link, buffers, 1));
+    mu_assert_int_eq(sizeof(reply), buffers[0].len);
+    mu_assert_int_eq(sizeof(reply), link_recv(&link, data[0], sizeof(data[0])));
+    mu_assert_int_eq(2, fault.stat.duplicated);
+
+    link_down(&link);
+    replay_close(&replay);
+
+    /* Все ответы теряются: прием ждет таймаут линка */
+    init("drop=100");
+    mu_assert_int_eq(0, replay_open(&replay, TEST_FILE, 0));
+    link_init_udp(&link, "127.0.0.1", 1, 50);
+    link.replay = &replay;
+    link.fault = &fault;
+    mu_assert_int_eq(0, link_up(&link));
+
+    mu_assert_int_eq(sizeof(request), link_send(&link, request, sizeof(request)));
+    mu_assert_int_eq(0, link_wait(&link, 10));
+    mu_assert_int_eq(-EAGAIN, link_recv(&link, data[0], sizeof(data[0])));
+    mu_assert_int_eq(2, fault.stat.dropped);
+    mu_assert_int_eq(2, link.stat.rx);
+
+    link_down(&link);
+    replay_close(&replay);
+    remove(TEST_FILE);
+}
+
+MU_TEST_SUITE(suite_fault)
+{
+    MU_RUN_TEST(test_config);
+    MU_RUN_TEST(test_schedule);
+    MU_RUN_TEST(test_faults);
+    MU_RUN_TEST(test_link);
+}
+
+int main()
+{
+    MU_RUN_SUITE(suite_fault);
+    MU_REPORT();
+    return mu_get_fails();
+}
+
+#ifdef __cplusplus
+}
+#endif
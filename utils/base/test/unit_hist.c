@@ -0,0 +1,156 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "test/minunit.h"
+#include "utils/base/hist.h"
+
+static struct hist hist;
+
+MU_TEST(test_empty)
+{
+    hist_init(&hist);
+    mu_assert_int_eq(0, hist.count);
+    mu_assert_int_eq(0, hist_percentile(&hist, 50));
+    mu_assert_int_eq(0, hist_mean(&hist));
+}
+
+MU_TEST(test_exact)
+{
+    int64_t i;
+
+    /* Малые значения учитываются точно */
+    hist_init(&hist);
+    for(i = 1; i <= 20; i++)
+        hist_add(&hist, i);
+
+    mu_assert_int_eq(20, hist.count);
+    mu_assert_int_eq(1, hist.min);
+    mu_assert_int_eq(20, hist.max);
+    mu_assert_int_eq(10, hist_mean(&hist));
+    mu_assert_int_eq(10, hist_percentile(&hist, 50));
+    mu_assert_int_eq(19, hist_percentile(&hist, 95));
+    mu_assert_int_eq(20, hist_percentile(&hist, 100));
+    mu_assert_int_eq(1, hist_percentile(&hist, 0));
+
+    hist_add(&hist, -5);
+    mu_assert_int_eq(0, hist.min);
+}
+
+MU_TEST(test_precision)
+{
+    const int64_t values[] = {33, 100, 1000, 12345, 1000000, 123456789};
+    size_t i;
+
+    /* Погрешность не более 1/32 */
+    for(i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        hist_init(&hist);
+        hist_add(&hist, values[i]);
+        hist_add(&hist, values[i] * 4);
+        const int64_t p = hist_percentile(&hist, 50);
+        mu_check(p >= values[i]);
+        mu_check(p - values[i] <= values[i] / 32);
+    }
+
+    /* Очень большие значения попадают в последний интервал */
+    hist_init(&hist);
+    hist_add(&hist, INT64_MAX);
+    mu_assert_int_eq(1, hist.counts[HIST_SIZE - 1]);
+    mu_check(hist_percentile(&hist, 99) == INT64_MAX);
+}
+
+MU_TEST(test_percentiles)
+{
+    struct hist other;
+    int64_t i;
+
+    /* 99 быстрых ответов и один медленный */
+    hist_init(&hist);
+    hist_init(&other);
+    for(i = 0; i < 99; i++)
+        hist_add(&hist, 200);
+    hist_add(&other, 50000);
+    hist_merge(&hist, &other);
+
+    mu_assert_int_eq(100, hist.count);
+    mu_assert_int_eq(200, hist.min);
+    mu_assert_int_eq(50000, hist.max);
+    mu_check(hist_percentile(&hist, 50) >= 200 && hist_percentile(&hist, 50) < 207);
+    mu_check(hist_percentile(&hist, 99) < 207);
+    mu_assert_int_eq(50000, hist_percentile(&hist, 99.9));
+}
+
+MU_TEST(test_count_le)
+{
+    int64_t i;
+
+    hist_init(&hist);
+    mu_assert_int_eq(0, hist_count_le(&hist, 1000));
+
+    for(i = 1; i <= 10; i++)
+        hist_add(&hist, i * 1000);
+
+    mu_assert_int_eq(0, hist_count_le(&hist, -1));
+    mu_assert_int_eq(0, hist_count_le(&hist, 900));
+    mu_assert_int_eq(1, hist_count_le(&hist, 1000));
+    mu_assert_int_eq(5, hist_count_le(&hist, 5000));
+    mu_assert_int_eq(10, hist_count_le(&hist, 10000));
+    mu_assert_int_eq(10, hist_count_le(&hist, INT64_MAX));
+}
+
+MU_TEST(test_large)
+{
+    const int64_t values[] = {(int64_t)1 << 40, (int64_t)1 << 41, INT64_MAX};
+    size_t i;
+
+    /* Значения от 2^HIST_MAX_BITS попадают в последний интервал и не
+     * затирают поля за массивом интервалов */
+    for(i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        hist_init(&hist);
+        hist_add(&hist, 1);
+        hist_add(&hist, values[i]);
+
+        mu_assert_int_eq(2, hist.count);
+        mu_assert_int_eq(1, hist.counts[1]);
+        mu_assert_int_eq(1, hist.counts[HIST_SIZE - 1]);
+        mu_assert_int_eq(1, hist.min);
+        mu_check(hist.max == values[i]);
+        mu_check(hist_percentile(&hist, 100) == values[i]);
+        mu_assert_int_eq(2, hist_count_le(&hist, values[i]));
+        mu_check(hist_mean(&hist) >= values[i] / 2);
+
+        hist_merge(&hist, &hist);
+        mu_assert_int_eq(2, hist.counts[HIST_SIZE - 1]);
+    }
+
+    /* 2^HIST_MAX_BITS - 1 - последний интервал последней степени двойки */
+    hist_init(&hist);
+    hist_add(&hist, ((int64_t)1 << HIST_MAX_BITS) - 1);
+    mu_assert_int_eq(1, hist.counts[HIST_SIZE - 1]);
+}
+
+MU_TEST_SUITE(suite_hist)
+{
+    MU_RUN_TEST(test_empty);
+    MU_RUN_TEST(test_exact);
+    MU_RUN_TEST(test_precision);
+    MU_RUN_TEST(test_percentiles);
+    MU_RUN_TEST(test_count_le);
+    MU_RUN_TEST(test_large);
+}
+
+int main()
+{
+    MU_RUN_SUITE(suite_hist);
+    MU_REPORT();
+    return mu_get_fails();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -10,6 +10,9 @@ extern "C" {
 #include "test/minunit.h"
 #include "utils/base/link.h"
 #include <errno.h>
+#include <arpa/inet.h>
+#include <string.h>
+#include <unistd.h>
 
 MU_TEST(test_udp)
 {
@@ -48,6 +51,66 @@ MU_TEST(test_tcp)
 }
 
 
+MU_TEST(test_udp_batch)
+{
+    struct link link;
+    struct sockaddr_in addr;
+    socklen_t alen = sizeof(addr);
+    char frames[3][8] = {"one", "two", "three"};
+    char rx[LINK_MAX_BATCH][8];
+    struct link_buffer buffers[LINK_MAX_BATCH];
+    size_t i;
+
+    /* Сервер */
+    int server = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    mu_assert_int_eq(0, bind(server, (struct sockaddr*)&addr, sizeof(addr)));
+    getsockname(server, (struct sockaddr*)&addr, &alen);
+
+    mu_assert_int_eq(0, link_init_udp(&link, "127.0.0.1", ntohs(addr.sin_port), 100));
+    mu_assert_int_eq(0, link_up(&link));
+
+    for(i = 0; i < 3; i++) {
+        buffers[i].data = frames[i];
+        buffers[i].size = sizeof(frames[i]);
+        buffers[i].len = strlen(frames[i]);
+    }
+
+    mu_assert_int_eq(3, link_send_batch(&link, buffers, 3));
+    mu_assert_int_eq(1, link.stat.syscalls);
+    mu_assert_int_eq(3, link.stat.tx);
+
+    /* Очередь пуста */
+    for(i = 0; i < LINK_MAX_BATCH; i++) {
+        buffers[i].data = rx[i];
+        buffers[i].size = sizeof(rx[i]);
+    }
+    mu_assert_int_eq(0, link_recv_batch(&link, buffers, LINK_MAX_BATCH));
+
+    /* Эхо */
+    struct sockaddr_in peer;
+    socklen_t plen = sizeof(peer);
+    for(i = 0; i < 3; i++) {
+        char buffer[8];
+        ssize_t size = recvfrom(server, buffer, sizeof(buffer), 0, (struct sockaddr*)&peer, &plen);
+        mu_assert_int_eq(strlen(frames[i]), size);
+        sendto(server, buffer, size, 0, (struct sockaddr*)&peer, plen);
+    }
+
+    mu_check(link_wait(&link, 100) > 0);
+    mu_assert_int_eq(3, link_recv_batch(&link, buffers, LINK_MAX_BATCH));
+    mu_assert_int_eq(3, link.stat.rx);
+    for(i = 0; i < 3; i++) {
+        mu_assert_int_eq(strlen(frames[i]), buffers[i].len);
+        mu_check(memcmp(frames[i], rx[i], buffers[i].len) == 0);
+    }
+
+    link_down(&link);
+    close(server);
+}
+
 MU_TEST(test_invalid_address)
 {
     struct link link;
@@ -56,6 +119,36 @@ MU_TEST(test_invalid_address)
 }
 
 
+MU_TEST(test_tcp_short_batch)
+{
+    static char frame[1 << 20];
+    struct link link;
+    struct sockaddr_in addr;
+    socklen_t alen = sizeof(addr);
+    int size = 4096;
+
+    /* Шлюз не читает запросы, буферы малы: посылка не уходит за таймаут */
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(server, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    mu_assert_int_eq(0, bind(server, (struct sockaddr*)&addr, sizeof(addr)));
+    mu_assert_int_eq(0, getsockname(server, (struct sockaddr*)&addr, &alen));
+    mu_assert_int_eq(0, listen(server, 1));
+
+    mu_assert_int_eq(0, link_init_tcp(&link, "127.0.0.1", ntohs(addr.sin_port), 50));
+    mu_assert_int_eq(0, link_up(&link));
+    setsockopt(link.socket, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+    struct link_buffer batch[2] = {{frame, sizeof(frame), sizeof(frame)}, {frame, sizeof(frame), sizeof(frame)}};
+    mu_assert_int_eq(-EIO, link_send_batch(&link, batch, 2));
+    mu_check(link.socket == TEKON_INVALID_SOCKET);
+    mu_assert_int_eq(0, link.stat.tx);
+
+    close(server);
+}
+
 MU_TEST(test_invalid_usage)
 {
     struct link link;
@@ -68,6 +161,10 @@ MU_TEST(test_invalid_usage)
     result = link_recv(&link, buffer, sizeof(buffer));
     mu_assert_int_eq(-EBADF, result);
 
+    struct link_buffer batch = {buffer, sizeof(buffer), sizeof(buffer)};
+    mu_assert_int_eq(-EBADF, link_send_batch(&link, &batch, 1));
+    mu_assert_int_eq(-EBADF, link_recv_batch(&link, &batch, 1));
+
     link_down(&link);
 
 }
@@ -76,6 +173,8 @@ MU_TEST_SUITE(suite_base)
 {
     MU_RUN_TEST(test_udp);
     MU_RUN_TEST(test_tcp);
+    MU_RUN_TEST(test_udp_batch);
+    MU_RUN_TEST(test_tcp_short_batch);
 }
 
 MU_TEST_SUITE(suite_invalid)
@@ -0,0 +1,571 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "test/minunit.h"
+#include "utils/base/fault.h"
+#include "utils/base/pipeline.h"
+#include "utils/base/time.h"
+#include "test/sim/responder.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_GATEWAY 2
+#define TEST_CHUNK   4
+
+/* Шлюз отвечает на запросы 0x1C значением, равным индексу параметра */
+static int responder_open(struct sim_responder * self, size_t window, size_t rounds)
+{
+    return sim_responder_init(self, TEST_GATEWAY, window, rounds) &&
+           sim_responder_fill(self, 3, 0x8000, PIPELINE_MAX_WINDOW * 4 * TEST_CHUNK, 0);
+}
+
+struct table {
+    uint32_t values[PIPELINE_MAX_WINDOW * 4 * TEST_CHUNK];
+    size_t prepared;
+    size_t completed;
+    size_t failed;
+};
+
+static int prepare(void * ctx, size_t index, struct message * request)
+{
+    struct table * table = ctx;
+    uint8_t devices[TEST_CHUNK];
+    uint16_t addresses[TEST_CHUNK];
+    uint16_t indexes[TEST_CHUNK];
+    size_t i;
+
+    for(i = 0; i < TEST_CHUNK; i++) {
+        devices[i] = 3;
+        addresses[i] = 0x8000;
+        indexes[i] = index * TEST_CHUNK + i;
+    }
+    table->prepared++;
+    return tekon_req_1c(request, TEST_GATEWAY, devices, addresses, indexes, TEST_CHUNK);
+}
+
+static void complete(void * ctx, size_t index, const struct message * response)
+{
+    struct table * table = ctx;
+    size_t i;
+
+    if(!response) {
+        table->failed++;
+        return;
+    }
+
+    table->completed++;
+    for(i = 0; i < response->nelements; i++)
+        table->values[index * TEST_CHUNK + i] = response->payload.parameters[i].value;
+}
+
+static void exchange(size_t window, int stale)
+{
+    const size_t rounds = 4;
+    struct sim_responder responder;
+    struct table table;
+    struct link link;
+    struct pipeline pipeline;
+    size_t i;
+
+    memset(&table, 0, sizeof(table));
+    mu_check(responder_open(&responder, window, rounds));
+    responder.stale = stale;
+    mu_check(sim_responder_start(&responder));
+
+    mu_assert_int_eq(0, link_init_udp(&link, "127.0.0.1", responder.port, 1000));
+    mu_assert_int_eq(0, link_up(&link));
+
+    pipeline_init(&pipeline, &link, window);
+    mu_assert_int_eq(window, pipeline.window);
+
+    size_t result = pipeline_run(&pipeline, window * rounds, prepare, complete, &table);
+    mu_assert_int_eq(window * rounds, result);
+    mu_assert_int_eq(window * rounds, table.completed);
+    mu_assert_int_eq(0, table.failed);
+
+    for(i = 0; i < window * rounds * TEST_CHUNK; i++)
+        mu_assert_int_eq(i, table.values[i]);
+
+    mu_assert_int_eq(stale ? window * rounds : 0, link.stat.discarded);
+
+    link_down(&link);
+    sim_responder_close(&responder);
+}
+
+MU_TEST(test_sequential)
+{
+    exchange(1, 0);
+}
+
+MU_TEST(test_window)
+{
+    exchange(4, 0);
+}
+
+MU_TEST(test_window_max)
+{
+    exchange(PIPELINE_MAX_WINDOW, 0);
+}
+
+MU_TEST(test_window_stale)
+{
+    exchange(4, 1);
+}
+
+/* TCP шлюз: ответы на всё окно отправляются одним сегментом, последняя
+ * посылка дописывается отдельно */
+static void * tcp_responder_run(void * data)
+{
+    struct sim_responder * self = data;
+    struct tekon_stream stream;
+    uint8_t in[512];
+    uint8_t out[PIPELINE_MAX_WINDOW * 512];
+    size_t round, i;
+
+    int client = accept(self->socket, NULL, NULL);
+    if(client < 0)
+        return NULL;
+
+    tekon_stream_init(&stream);
+    for(round = 0; round < self->rounds; round++) {
+        size_t size = 0;
+
+        for(i = 0; i < self->window; i++) {
+            ssize_t len;
+            while((len = tekon_stream_pop(&stream, in, sizeof(in))) == 0) {
+                size_t room = 0;
+                void * tail = tekon_stream_reserve(&stream, &room);
+                ssize_t result = recv(client, tail, room, 0);
+                if(result <= 0)
+                    goto done;
+                tekon_stream_commit(&stream, result);
+            }
+            size += sim_process(&self->sim, in, len, out + size, sizeof(out) - size);
+        }
+
+        send(client, out, size - 3, 0);
+        usleep(10000);
+        send(client, out + size - 3, 3, 0);
+    }
+
+done:
+    close(client);
+    return NULL;
+}
+
+MU_TEST(test_tcp_window)
+{
+    const size_t window = 4;
+    const size_t rounds = 4;
+    struct sim_responder responder;
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    struct table table;
+    struct link link;
+    struct pipeline pipeline;
+    pthread_t thread;
+    size_t i;
+
+    /* Значения и порции берутся из sim_responder, сокет UDP заменяется на
+     * TCP */
+    memset(&table, 0, sizeof(table));
+    mu_check(responder_open(&responder, window, rounds));
+    close(responder.socket);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    responder.socket = socket(AF_INET, SOCK_STREAM, 0);
+    mu_assert_int_eq(0, bind(responder.socket, (struct sockaddr*)&addr, sizeof(addr)));
+    mu_assert_int_eq(0, getsockname(responder.socket, (struct sockaddr*)&addr, &len));
+    mu_assert_int_eq(0, listen(responder.socket, 1));
+    pthread_create(&thread, NULL, tcp_responder_run, &responder);
+
+    mu_assert_int_eq(0, link_init_tcp(&link, "127.0.0.1", ntohs(addr.sin_port), 1000));
+    mu_assert_int_eq(0, link_up(&link));
+
+    pipeline_init(&pipeline, &link, window);
+    mu_assert_int_eq(window, pipeline.window);
+
+    size_t result = pipeline_run(&pipeline, window * rounds, prepare, complete, &table);
+    mu_assert_int_eq(window * rounds, result);
+    mu_assert_int_eq(0, table.failed);
+
+    for(i = 0; i < window * rounds * TEST_CHUNK; i++)
+        mu_assert_int_eq(i, table.values[i]);
+
+    link_down(&link);
+    pthread_join(thread, NULL);
+    sim_responder_close(&responder);
+}
+
+MU_TEST(test_timeout)
+{
+    struct sim_responder responder;
+    struct table table;
+    struct link link;
+    struct pipeline pipeline;
+
+    memset(&table, 0, sizeof(table));
+    mu_check(responder_open(&responder, 0, 0));
+
+    link_init_udp(&link, "127.0.0.1", responder.port, 50);
+    link_up(&link);
+
+    pipeline_init(&pipeline, &link, 2);
+    size_t result = pipeline_run(&pipeline, 8, prepare, complete, &table);
+
+    /* После первой ошибки новые запросы не отправляются */
+    mu_assert_int_eq(0, result);
+    mu_assert_int_eq(2, table.prepared);
+    mu_assert_int_eq(8, table.failed);
+    mu_assert_int_eq(-ETIMEDOUT, pipeline.error);
+
+    link_down(&link);
+    sim_responder_close(&responder);
+}
+
+MU_TEST(test_retry)
+{
+    const size_t window = 4;
+    const size_t rounds = 2;
+    struct sim_responder responder;
+    struct table table;
+    struct link link;
+    struct pipeline pipeline;
+    struct stats stats;
+    size_t i;
+
+    /* Шлюз отвечает на каждый запрос сразу, но первый запрос теряется.
+     * Повторяется только он, остальные запросы окна не перезапрашиваются */
+    memset(&table, 0, sizeof(table));
+    mu_check(responder_open(&responder, 1, window * rounds));
+    responder.drop = 1;
+    mu_check(sim_responder_start(&responder));
+
+    link_init_udp(&link, "127.0.0.1", responder.port, 100);
+    link_up(&link);
+
+    pipeline_init(&pipeline, &link, window);
+    pipeline.retries = 1;
+    stats_init(&stats);
+    pipeline.stats = &stats;
+    mu_assert_int_eq(window * rounds, pipeline_run(&pipeline, window * rounds, prepare, complete, &table));
+    mu_assert_int_eq(0, table.failed);
+    mu_assert_int_eq(window * rounds, table.prepared);
+    mu_assert_int_eq(1, pipeline.resent);
+    mu_assert_int_eq(window * rounds + 1, link.stat.tx);
+
+    /* Повтор не считается новым запросом */
+    mu_assert_int_eq(window * rounds, stats.requests);
+    mu_assert_int_eq(1, stats.retries);
+    mu_assert_int_eq(1, stats.timeouts);
+    mu_assert_int_eq(0, stats.failures);
+    mu_assert_int_eq(window * rounds, stats.stage[STATS_PACK].count);
+    mu_assert_int_eq(window * rounds, stats.stage[STATS_UNPACK].count);
+    mu_assert_int_eq(window * rounds, stats.stage[STATS_TOTAL].count);
+    /* Задержка повторенного запроса считается с первой отправки */
+    mu_check(stats.stage[STATS_TOTAL].max >= 90000);
+
+    for(i = 0; i < window * rounds * TEST_CHUNK; i++)
+        mu_assert_int_eq(i, table.values[i]);
+
+    link_down(&link);
+    sim_responder_close(&responder);
+}
+
+MU_TEST(test_retry_budget)
+{
+    struct sim_responder responder;
+    struct table table;
+    struct link link;
+    struct pipeline pipeline;
+    struct stats stats;
+
+    memset(&table, 0, sizeof(table));
+    mu_check(responder_open(&responder, 0, 0));
+
+    link_init_udp(&link, "127.0.0.1", responder.port, 30);
+    link_up(&link);
+
+    pipeline_init(&pipeline, &link, 2);
+    pipeline.retries = 2;
+    stats_init(&stats);
+    pipeline.stats = &stats;
+    mu_assert_int_eq(0, pipeline_run(&pipeline, 4, prepare, complete, &table));
+    mu_assert_int_eq(-ETIMEDOUT, pipeline.error);
+    mu_assert_int_eq(2, table.prepared);
+    mu_assert_int_eq(4, table.failed);
+    mu_assert_int_eq(4, pipeline.resent);
+    mu_assert_int_eq(2, stats.requests);
+    mu_assert_int_eq(4, stats.retries);
+    mu_assert_int_eq(6, stats.timeouts);
+    mu_assert_int_eq(2, stats.failures);
+    mu_assert_int_eq(0, stats.stage[STATS_TOTAL].count);
+
+    link_down(&link);
+    sim_responder_close(&responder);
+}
+
+MU_TEST(test_fault)
+{
+    const size_t count = PIPELINE_MAX_WINDOW * 4;
+    struct sim_responder responder;
+    struct table table;
+    struct link link;
+    struct pipeline pipeline;
+    struct fault_config config;
+    struct fault fault;
+    size_t i;
+
+    /* Шлюз отвечает на каждый запрос сразу, ответы искажаются. Все запросы
+     * должны быть выполнены за счет повторов */
+    memset(&table, 0, sizeof(table));
+    mu_check(responder_open(&responder, 1, SIZE_MAX));
+    mu_check(sim_responder_start(&responder));
+
+    mu_check(fault_config_from_string(&config, "drop=20,dup=5,reorder=5,truncate=5,corrupt=5,delay=5:20,seed=7"));
+    fault_init(&fault, &config);
+    link_init_udp(&link, "127.0.0.1", responder.port, 50);
+    link.fault = &fault;
+    link_up(&link);
+
+    pipeline_init(&pipeline, &link, 4);
+    pipeline.retries = 10;
+    mu_assert_int_eq(count, pipeline_run(&pipeline, count, prepare, complete, &table));
+    mu_assert_int_eq(0, table.failed);
+    mu_check(fault.stat.dropped > 0);
+    mu_check(pipeline.resent >= fault.stat.dropped);
+
+    for(i = 0; i < count * TEST_CHUNK; i++)
+        mu_assert_int_eq(i, table.values[i]);
+
+    link_down(&link);
+    sim_responder_close(&responder);
+}
+
+MU_TEST(test_adaptive)
+{
+    struct sim_responder responder;
+    struct table table;
+    struct link link;
+    struct pipeline pipeline;
+
+    memset(&table, 0, sizeof(table));
+    mu_check(responder_open(&responder, 2, 4));
+    mu_check(sim_responder_start(&responder));
+
+    link_init_udp(&link, "127.0.0.1", responder.port, 1000);
+    rtt_init(&link.rtt, 1000, 20, 1000);
+    link_up(&link);
+
+    /* Каждый ответ обновляет оценку, таймаут уменьшается до RTT локальной сети */
+    pipeline_init(&pipeline, &link, 2);
+    mu_assert_int_eq(8, pipeline_run(&pipeline, 8, prepare, complete, &table));
+    mu_assert_int_eq(8, link.rtt.samples);
+    mu_check(rtt_timeout(&link.rtt, 0) < 1000);
+
+    link_down(&link);
+    sim_responder_close(&responder);
+}
+
+MU_TEST(test_adaptive_timeout)
+{
+    struct sim_responder responder;
+    struct table table;
+    struct link link;
+    struct pipeline pipeline;
+
+    memset(&table, 0, sizeof(table));
+    mu_check(responder_open(&responder, 0, 0));
+
+    /* Статический таймаут не используется */
+    link_init_udp(&link, "127.0.0.1", responder.port, 60000);
+    rtt_init(&link.rtt, 30, 20, 1000);
+    link_up(&link);
+
+    const int64_t start = time_monotonic_ms();
+    pipeline_init(&pipeline, &link, 1);
+    mu_assert_int_eq(0, pipeline_run(&pipeline, 1, prepare, complete, &table));
+    mu_assert_int_eq(-ETIMEDOUT, pipeline.error);
+    mu_check(time_monotonic_ms() - start < 1000);
+    mu_assert_int_eq(60, rtt_timeout(&link.rtt, 0));
+
+    link_down(&link);
+    sim_responder_close(&responder);
+}
+
+static void sink(void * ctx, size_t index, size_t element, uint32_t value, uint8_t qual)
+{
+    struct table * table = ctx;
+    table->values[index * TEST_CHUNK + element] = value + qual;
+}
+
+static void complete_sink(void * ctx, size_t index, const struct message * response)
+{
+    struct table * table = ctx;
+
+    if(!response) {
+        table->failed++;
+        return;
+    }
+
+    /* Значения уже переданы в sink, в ответе остается только заголовок */
+    table->completed++;
+    if(response->type != TEKON_MSG_READEM_PAR_LIST_1C ||
+            response->nelements != TEST_CHUNK ||
+            response->gateway != TEST_GATEWAY)
+        table->failed++;
+}
+
+MU_TEST(test_sink)
+{
+    const size_t window = 4, rounds = 2;
+    struct sim_responder responder;
+    struct table table;
+    struct link link;
+    struct pipeline pipeline;
+    size_t i;
+
+    memset(&table, 0, sizeof(table));
+    mu_check(responder_open(&responder, window, rounds));
+    mu_check(sim_responder_start(&responder));
+
+    mu_assert_int_eq(0, link_init_udp(&link, "127.0.0.1", responder.port, 1000));
+    mu_assert_int_eq(0, link_up(&link));
+    pipeline_init(&pipeline, &link, window);
+
+    size_t result = pipeline_run_sink(&pipeline, window * rounds, prepare, sink, complete_sink, &table);
+    mu_assert_int_eq(window * rounds, result);
+    mu_assert_int_eq(window * rounds, table.completed);
+    mu_assert_int_eq(0, table.failed);
+
+    for(i = 0; i < window * rounds * TEST_CHUNK; i++)
+        mu_assert_int_eq(i, table.values[i]);
+
+    link_down(&link);
+    sim_responder_close(&responder);
+}
+
+/* Запрос 1 не упаковывается (неизвестный тип) */
+static int prepare_unpackable(void * ctx, size_t index, struct message * request)
+{
+    if(!prepare(ctx, index, request))
+        return 0;
+    if(index == 1)
+        request->type = TEKON_MSG_UNK;
+    return 1;
+}
+
+MU_TEST(test_unpackable)
+{
+    const size_t window = 4;
+    struct sim_responder responder;
+    struct table table;
+    struct link link;
+    struct pipeline pipeline;
+    size_t i;
+
+    /* Запрос, который не удалось упаковать, завершается с ошибкой, остальные
+     * запросы окна уходят одним пакетом и выполняются */
+    memset(&table, 0, sizeof(table));
+    mu_check(responder_open(&responder, window - 1, 1));
+    mu_check(sim_responder_start(&responder));
+
+    mu_assert_int_eq(0, link_init_udp(&link, "127.0.0.1", responder.port, 1000));
+    mu_assert_int_eq(0, link_up(&link));
+    pipeline_init(&pipeline, &link, window);
+
+    mu_assert_int_eq(window - 1, pipeline_run(&pipeline, window, prepare_unpackable, complete, &table));
+    mu_assert_int_eq(window - 1, table.completed);
+    mu_assert_int_eq(1, table.failed);
+    mu_assert_int_eq(-EINVAL, pipeline.error);
+    mu_assert_int_eq(window - 1, link.stat.tx);
+
+    for(i = 0; i < window * TEST_CHUNK; i++)
+        mu_assert_int_eq(i / TEST_CHUNK == 1 ? 0 : i, table.values[i]);
+
+    link_down(&link);
+    sim_responder_close(&responder);
+}
+
+MU_TEST(test_read_ack)
+{
+    struct sim_responder responder;
+    struct table table;
+    struct link link;
+    struct pipeline pipeline;
+
+    /* Квитанция на чтение не подтверждает его: значений нет */
+    memset(&table, 0, sizeof(table));
+    mu_check(responder_open(&responder, 1, 1));
+    responder.ack = 1;
+    mu_check(sim_responder_start(&responder));
+
+    mu_assert_int_eq(0, link_init_udp(&link, "127.0.0.1", responder.port, 1000));
+    mu_assert_int_eq(0, link_up(&link));
+    pipeline_init(&pipeline, &link, 1);
+
+    mu_assert_int_eq(0, pipeline_run(&pipeline, 2, prepare, complete, &table));
+    mu_assert_int_eq(0, table.completed);
+    mu_assert_int_eq(2, table.failed);
+    mu_assert_int_eq(-EBADMSG, pipeline.error);
+
+    link_down(&link);
+    sim_responder_close(&responder);
+}
+
+MU_TEST(test_window_limits)
+{
+    struct link link;
+    struct pipeline pipeline;
+
+    link_init_udp(&link, "127.0.0.1", 8888, 100);
+    pipeline_init(&pipeline, &link, 0);
+    mu_assert_int_eq(1, pipeline.window);
+
+    pipeline_init(&pipeline, &link, 100);
+    mu_assert_int_eq(PIPELINE_MAX_WINDOW, pipeline.window);
+
+    link_init_tcp(&link, "127.0.0.1", 8888, 100);
+    pipeline_init(&pipeline, &link, 4);
+    mu_assert_int_eq(4, pipeline.window);
+}
+
+MU_TEST_SUITE(suite_pipeline)
+{
+    MU_RUN_TEST(test_sequential);
+    MU_RUN_TEST(test_window);
+    MU_RUN_TEST(test_window_max);
+    MU_RUN_TEST(test_window_stale);
+    MU_RUN_TEST(test_tcp_window);
+    MU_RUN_TEST(test_timeout);
+    MU_RUN_TEST(test_retry);
+    MU_RUN_TEST(test_retry_budget);
+    MU_RUN_TEST(test_fault);
+    MU_RUN_TEST(test_adaptive);
+    MU_RUN_TEST(test_adaptive_timeout);
+    MU_RUN_TEST(test_sink);
+    MU_RUN_TEST(test_unpackable);
+    MU_RUN_TEST(test_read_ack);
+    MU_RUN_TEST(test_window_limits);
+}
+
+int main()
+{
+    MU_RUN_SUITE(suite_pipeline);
+    MU_REPORT();
+    return mu_get_fails();
+}
+
+#ifdef __cplusplus
+}
+#endif
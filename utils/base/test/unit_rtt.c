@@ -0,0 +1,109 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "test/minunit.h"
+#include "utils/base/rtt.h"
+#include <string.h>
+
+MU_TEST(test_disabled)
+{
+    struct rtt rtt;
+    memset(&rtt, 0, sizeof(rtt));
+
+    mu_check(!rtt_enabled(&rtt));
+    rtt_sample(&rtt, 10);
+    rtt_backoff(&rtt);
+    mu_assert_int_eq(1000, rtt_timeout(&rtt, 1000));
+}
+
+MU_TEST(test_initial)
+{
+    struct rtt rtt;
+
+    rtt_init(&rtt, 1000, 20, 5000);
+    mu_check(rtt_enabled(&rtt));
+    mu_assert_int_eq(1000, rtt_timeout(&rtt, 0));
+
+    /* Начальное значение ограничивается границами */
+    rtt_init(&rtt, 1000, 20, 500);
+    mu_assert_int_eq(500, rtt_timeout(&rtt, 0));
+}
+
+MU_TEST(test_converge)
+{
+    struct rtt rtt;
+    int i;
+
+    /* Первый замер: srtt = 40, rttvar = 20 -> rto = 40 + 4 * 20 */
+    rtt_init(&rtt, 1000, 20, 5000);
+    rtt_sample(&rtt, 40);
+    mu_assert_int_eq(120, rtt_timeout(&rtt, 0));
+
+    /* Стабильное RTT - отклонение стремится к нулю */
+    for(i = 0; i < 100; i++)
+        rtt_sample(&rtt, 40);
+    mu_check(rtt_timeout(&rtt, 0) >= 40);
+    mu_check(rtt_timeout(&rtt, 0) <= 45);
+
+    /* Быстрый шлюз упирается в нижнюю границу */
+    for(i = 0; i < 100; i++)
+        rtt_sample(&rtt, 2);
+    mu_assert_int_eq(20, rtt_timeout(&rtt, 0));
+}
+
+MU_TEST(test_slow)
+{
+    struct rtt rtt;
+    int i;
+
+    /* GSM: RTT больше начального таймаута */
+    rtt_init(&rtt, 1000, 20, 5000);
+    for(i = 0; i < 20; i++)
+        rtt_sample(&rtt, 1500 + (i % 2) * 500);
+
+    mu_check(rtt_timeout(&rtt, 0) > 2000);
+    mu_check(rtt_timeout(&rtt, 0) <= 5000);
+}
+
+MU_TEST(test_backoff)
+{
+    struct rtt rtt;
+
+    rtt_init(&rtt, 100, 20, 500);
+    rtt_backoff(&rtt);
+    mu_assert_int_eq(200, rtt_timeout(&rtt, 0));
+    rtt_backoff(&rtt);
+    mu_assert_int_eq(400, rtt_timeout(&rtt, 0));
+    rtt_backoff(&rtt);
+    mu_assert_int_eq(500, rtt_timeout(&rtt, 0));
+
+    /* Успешный замер восстанавливает таймаут */
+    rtt_sample(&rtt, 10);
+    mu_assert_int_eq(30, rtt_timeout(&rtt, 0));
+}
+
+MU_TEST_SUITE(suite_rtt)
+{
+    MU_RUN_TEST(test_disabled);
+    MU_RUN_TEST(test_initial);
+    MU_RUN_TEST(test_converge);
+    MU_RUN_TEST(test_slow);
+    MU_RUN_TEST(test_backoff);
+}
+
+int main()
+{
+    MU_RUN_SUITE(suite_rtt);
+    MU_REPORT();
+    return mu_get_fails();
+}
+
+#ifdef __cplusplus
+}
+#endif
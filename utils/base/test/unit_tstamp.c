@@ -12,11 +12,13 @@ extern "C" {
 #include "utils/base/time.h"
 #include "tekon/time.h"
 
+static int64_t storage[TIMESTAMP_MAX_SEQ_SIZE];
 
 MU_TEST(test_month_12)
 {
     const int depth = 12;
     struct timestamp_seq seq;
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
     struct tekon_date date = {.year = 19, .month = 12, .day = 1};
     int result = timestamp_seq_month(&seq,&date, depth);
     mu_assert_int_eq(1, result);
@@ -40,6 +42,7 @@ MU_TEST(test_month_48)
 {
     const int depth = 48;
     struct timestamp_seq seq;
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
     struct tekon_date date = {.year = 19, .month = 12, .day = 1};
     int result = timestamp_seq_month(&seq,&date, depth);
     mu_assert_int_eq(1, result);
@@ -62,6 +65,7 @@ MU_TEST(test_month_cv)
      * время окончания архива: 2018/10/01 00:00:00 */
     const size_t index = 0x08;
     struct timestamp_seq seq;
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
     struct tekon_date date = {.year = 18, .month = 10, .day = 1};
 
     struct tm dt;
@@ -83,6 +87,7 @@ MU_TEST(test_month_cv)
 MU_TEST(test_day_365)
 {
     struct timestamp_seq seq;
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
     struct tekon_date date = {.year = 19, .month = 12, .day = 31};
     int result = timestamp_seq_day(&seq,&date);
     mu_assert_int_eq(1, result);
@@ -102,6 +107,7 @@ MU_TEST(test_day_366)
     /* date - дата окончания архива. Для високосного 2016 года дата окончания
      * будет 2017.01.01 (см. Т10.06.59.РД-Д1)*/
     struct timestamp_seq seq;
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
     struct tekon_date date = {.year = 17, .month = 1, .day = 1};
     int result = timestamp_seq_day(&seq,&date);
     mu_assert_int_eq(1, result);
@@ -119,6 +125,7 @@ MU_TEST(test_day_366)
 MU_TEST(test_day_trans)
 {
     struct timestamp_seq seq;
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
     struct tekon_date date = {.year = 20, .month = 6, .day = 15};
     int result = timestamp_seq_day(&seq,&date);
     mu_assert_int_eq(1, result);
@@ -141,6 +148,7 @@ MU_TEST(test_day_cv)
      * время окончания архива: 2018/05/09 00:00:00 */
     const size_t index = 0x7F;
     struct timestamp_seq seq;
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
     struct tekon_date date = {.year = 18, .month = 5, .day = 9};
 
     struct tm dt;
@@ -163,6 +171,7 @@ MU_TEST(test_hour_16)
 {
     const uint16_t depth = 384;
     struct timestamp_seq seq;
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
     struct tekon_date date = {.year = 16, .month = 12, .day = 31};
     struct tekon_time time = {.hour = 16, .minute = 12, .second = 0};
 
@@ -184,6 +193,7 @@ MU_TEST(test_hour_32)
 {
     const uint16_t depth = 768;
     struct timestamp_seq seq;
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
     struct tekon_date date = {.year = 19, .month = 6, .day = 1};
     struct tekon_time time = {.hour = 0, .minute = 0, .second = 0};
 
@@ -205,6 +215,7 @@ MU_TEST(test_hour_64)
 {
     const uint16_t depth = 1536;
     struct timestamp_seq seq;
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
     struct tekon_date date = {.year = 19, .month = 1, .day = 1};
     struct tekon_time time = {.hour = 23, .minute = 59, .second = 59};
 
@@ -232,6 +243,7 @@ MU_TEST(test_hour_cv)
     const size_t index = 0x296;
 
     struct timestamp_seq seq;
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
     struct tekon_date date = {.year = 19, .month = 3, .day = 5};
     struct tekon_time time = {.hour = 15, .minute = 0, .second = 0};
 
@@ -256,6 +268,7 @@ MU_TEST(test_interval_5)
     const uint16_t depth = 1440;
     const uint16_t interval = 5;
     struct timestamp_seq seq;
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
     struct tekon_date date = {.year = 19, .month = 1, .day = 1};
     struct tekon_time time = {.hour = 23, .minute = 59, .second = 59};
 
@@ -286,6 +299,7 @@ MU_TEST(test_interval_cv)
     const size_t depth = 1440;
     const size_t interval = 5;
     struct timestamp_seq seq;
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
     struct tekon_date date = {.year = 19, .month = 5, .day = 6};
     struct tekon_time time = {.hour = 15, .minute = 45, .second = 0};
 
@@ -304,6 +318,49 @@ MU_TEST(test_interval_cv)
     mu_assert_int_eq(tstamp, timestamp_seq_get(&seq, index));
 }
 
+MU_TEST(test_capacity)
+{
+    int64_t buffer[48];
+    struct timestamp_seq seq;
+    struct tekon_date date = {.year = 19, .month = 12, .day = 1};
+    struct tekon_time time = {.hour = 12, .minute = 0, .second = 0};
+    timestamp_seq_init(&seq, buffer, 48);
+
+    /* Буфер меньше последовательности */
+    mu_assert_int_eq(0, timestamp_seq_day(&seq, &date));
+    mu_assert_int_eq(0, timestamp_seq_size(&seq));
+    mu_assert_int_eq(0, timestamp_seq_interval(&seq, &date, &time, 49, 30));
+
+    /* Метки за пределами текущей последовательности недействительны */
+    mu_assert_int_eq(1, timestamp_seq_month(&seq, &date, 48));
+    mu_assert_int_eq(1, timestamp_seq_month(&seq, &date, 12));
+    mu_check(timestamp_seq_get(&seq, 11) != TIME_INVALID);
+    mu_assert_int_eq(TIME_INVALID, timestamp_seq_get(&seq, 12));
+    mu_assert_int_eq(TIME_INVALID, timestamp_seq_get(&seq, 47));
+}
+
+MU_TEST(test_interval_deep)
+{
+    /* Интервальный архив глубже 8192 записей: 30 суток по 2 мин */
+    const size_t depth = 21600;
+    const size_t interval = 2;
+    struct timestamp_seq seq;
+    timestamp_seq_init(&seq, storage, TIMESTAMP_MAX_SEQ_SIZE);
+    struct tekon_date date = {.year = 20, .month = 3, .day = 31};
+    struct tekon_time time = {.hour = 23, .minute = 59, .second = 0};
+    int result = timestamp_seq_interval(&seq, &date, &time, depth, interval);
+    mu_assert_int_eq(1, result);
+    mu_assert_int_eq(depth, timestamp_seq_size(&seq));
+
+    size_t i;
+    for(i = 0; i < timestamp_seq_size(&seq); i++) {
+        struct tm ldt;
+        time_local_from_utc(timestamp_seq_get(&seq, i), &ldt);
+        mu_assert_int_eq(i, tekon_interval_index(ldt.tm_year % 100, ldt.tm_mon + 1,
+                         ldt.tm_mday, ldt.tm_hour, ldt.tm_min, depth, interval));
+    }
+}
+
 MU_TEST_SUITE(suite_month)
 {
     MU_RUN_TEST(test_month_12);
@@ -331,6 +388,8 @@ MU_TEST_SUITE(suite_interval)
 {
     MU_RUN_TEST(test_interval_5);
     MU_RUN_TEST(test_interval_cv);
+    MU_RUN_TEST(test_interval_deep);
+    MU_RUN_TEST(test_capacity);
 }
 
 
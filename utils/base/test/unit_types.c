@@ -264,6 +264,36 @@ MU_TEST(test_intcfg)
     mu_assert_int_eq('i',cfg.type);
     mu_assert_int_eq(1440,cfg.depth);
     mu_assert_int_eq(5,cfg.interval);
+
+    /* Глубокие интервальные архивы */
+    result = intcfg_from_string(&cfg, "i:17280:1");
+    mu_assert_int_eq(1,result);
+    mu_assert_int_eq(17280,cfg.depth);
+
+    result = intcfg_from_string(&cfg, "i:70000:1");
+    mu_assert_int_eq(0,result);
+}
+
+MU_TEST(test_rttcfg)
+{
+    struct rttcfg cfg;
+    int result = rttcfg_from_string(&cfg, "20:5000");
+    mu_assert_int_eq(1,result);
+    mu_assert_int_eq(20,cfg.min);
+    mu_assert_int_eq(5000,cfg.max);
+
+    result = rttcfg_from_string(&cfg, " 100:100");
+    mu_assert_int_eq(1,result);
+    mu_assert_int_eq(100,cfg.min);
+    mu_assert_int_eq(100,cfg.max);
+
+    mu_assert_int_eq(0,rttcfg_from_string(&cfg, ""));
+    mu_assert_int_eq(0,rttcfg_from_string(&cfg, "100"));
+    mu_assert_int_eq(0,rttcfg_from_string(&cfg, "100:"));
+    mu_assert_int_eq(0,rttcfg_from_string(&cfg, "0:100"));
+    mu_assert_int_eq(0,rttcfg_from_string(&cfg, "200:100"));
+    mu_assert_int_eq(0,rttcfg_from_string(&cfg, "20:70000"));
+    mu_assert_int_eq(0,rttcfg_from_string(&cfg, "20:100x"));
 }
 
 MU_TEST_SUITE(suite_netaddr)
@@ -306,6 +336,11 @@ MU_TEST_SUITE(suite_intcfg)
     MU_RUN_TEST(test_intcfg);
 }
 
+MU_TEST_SUITE(suite_rttcfg)
+{
+    MU_RUN_TEST(test_rttcfg);
+}
+
 int main()
 {
     MU_RUN_SUITE(suite_netaddr);
@@ -315,6 +350,7 @@ int main()
     MU_RUN_SUITE(suite_archaddr);
     MU_RUN_SUITE(suite_dtaddr);
     MU_RUN_SUITE(suite_intcfg);
+    MU_RUN_SUITE(suite_rttcfg);
     MU_REPORT();
     return mu_get_fails();
 }
@@ -0,0 +1,146 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "test/minunit.h"
+#include "utils/base/wheel.h"
+
+struct counter {
+    int fired;
+    int64_t rearm;
+    struct wheel * wheel;
+};
+
+static void on_timer(struct wheel_timer * timer, void * data)
+{
+    struct counter * counter = data;
+    counter->fired++;
+    if(counter->rearm)
+        wheel_add(counter->wheel, timer, timer->expire + counter->rearm);
+}
+
+MU_TEST(test_fire)
+{
+    struct wheel wheel;
+    struct wheel_timer timer;
+    struct counter counter = {0};
+
+    wheel_init(&wheel, 1000);
+    wheel_timer_init(&timer, on_timer, &counter);
+    wheel_add(&wheel, &timer, 1100);
+
+    mu_assert_int_eq(1, wheel_size(&wheel));
+    mu_assert_int_eq(100, wheel_next(&wheel));
+
+    mu_assert_int_eq(0, wheel_advance(&wheel, 1050));
+    mu_assert_int_eq(0, counter.fired);
+    mu_assert_int_eq(50, wheel_next(&wheel));
+
+    mu_assert_int_eq(1, wheel_advance(&wheel, 1100));
+    mu_assert_int_eq(1, counter.fired);
+    mu_assert_int_eq(0, wheel_size(&wheel));
+    mu_assert_int_eq(-1, wheel_next(&wheel));
+    mu_check(!wheel_timer_active(&timer));
+}
+
+MU_TEST(test_cancel)
+{
+    struct wheel wheel;
+    struct wheel_timer timer;
+    struct counter counter = {0};
+
+    wheel_init(&wheel, 0);
+    wheel_timer_init(&timer, on_timer, &counter);
+    wheel_add(&wheel, &timer, 50);
+    wheel_cancel(&wheel, &timer);
+    wheel_cancel(&wheel, &timer);
+
+    mu_assert_int_eq(0, wheel_size(&wheel));
+    mu_assert_int_eq(0, wheel_advance(&wheel, 100));
+    mu_assert_int_eq(0, counter.fired);
+}
+
+MU_TEST(test_next_round)
+{
+    /* Таймер через несколько оборотов колеса не должен сработать раньше */
+    const int64_t later = WHEEL_TICK * WHEEL_SLOTS * 3 + 5;
+    struct wheel wheel;
+    struct wheel_timer timer;
+    struct counter counter = {0};
+
+    wheel_init(&wheel, 0);
+    wheel_timer_init(&timer, on_timer, &counter);
+    wheel_add(&wheel, &timer, later);
+
+    mu_assert_int_eq(later, wheel_next(&wheel));
+
+    int64_t now;
+    for(now = 0; now < later; now += WHEEL_TICK)
+        wheel_advance(&wheel, now);
+
+    mu_assert_int_eq(0, counter.fired);
+    wheel_advance(&wheel, later);
+    mu_assert_int_eq(1, counter.fired);
+}
+
+MU_TEST(test_rearm)
+{
+    struct wheel wheel;
+    struct wheel_timer timer;
+    struct counter counter = {0, 20, &wheel};
+
+    wheel_init(&wheel, 0);
+    wheel_timer_init(&timer, on_timer, &counter);
+    wheel_add(&wheel, &timer, 20);
+
+    int64_t now;
+    for(now = 0; now <= 200; now += 5)
+        wheel_advance(&wheel, now);
+
+    mu_assert_int_eq(10, counter.fired);
+    mu_assert_int_eq(1, wheel_size(&wheel));
+}
+
+MU_TEST(test_many)
+{
+    struct wheel wheel;
+    struct wheel_timer timers[1000];
+    struct counter counter = {0};
+    size_t i;
+
+    wheel_init(&wheel, 0);
+    for(i = 0; i < 1000; i++) {
+        wheel_timer_init(&timers[i], on_timer, &counter);
+        wheel_add(&wheel, &timers[i], i * 7);
+    }
+
+    /* Большой скачок времени */
+    mu_assert_int_eq(1000, wheel_advance(&wheel, 7000));
+    mu_assert_int_eq(1000, counter.fired);
+    mu_assert_int_eq(0, wheel_size(&wheel));
+}
+
+MU_TEST_SUITE(suite_wheel)
+{
+    MU_RUN_TEST(test_fire);
+    MU_RUN_TEST(test_cancel);
+    MU_RUN_TEST(test_next_round);
+    MU_RUN_TEST(test_rearm);
+    MU_RUN_TEST(test_many);
+}
+
+int main()
+{
+    MU_RUN_SUITE(suite_wheel);
+    MU_REPORT();
+    return mu_get_fails();
+}
+
+#ifdef __cplusplus
+}
+#endif
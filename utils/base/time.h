@@ -24,6 +24,15 @@ int64_t time_now_local();
 /* получить сдвиг часового пояса от UTC (сек) */
 int32_t time_tzoffset();
 
+/*Вернуть монотонное время в мс. Используется для таймаутов и замеров */
+int64_t time_monotonic_ms();
+
+/*Вернуть монотонное время в мкс. Используется для замеров задержек */
+int64_t time_monotonic_us();
+
+/*Приостановить поток на us мкс. Точность зависит от системы */
+void time_sleep_us(int64_t us);
+
 /*Сгенерировать локальную дату/время из UTC */
 int time_local_from_utc(int64_t utc, struct tm * local);
 
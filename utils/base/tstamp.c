@@ -18,10 +18,7 @@ static int timestamp_seq_add(struct timestamp_seq * self, size_t index, int64_t
 {
     assert(self);
 
-    if(index >= TIMESTAMP_MAX_SEQ_SIZE)
-        return 0;
-
-    if(self->count >= TIMESTAMP_MAX_SEQ_SIZE)
+    if(index >= self->limit)
         return 0;
 
     int64_t * pts = self->time + index;
@@ -89,14 +86,34 @@ int tekon_date_from_local(struct tekon_date * tekon, const struct tm * local)
     return 1;
 }
 
-void timestamp_seq_init(struct timestamp_seq * self)
+/* Начать новую последовательность из limit индексов.
+ * 0 - буфер слишком мал */
+static int timestamp_seq_reset(struct timestamp_seq * self, size_t limit)
 {
     assert(self);
+
+    self->count = 0;
+    self->limit = 0;
+
+    if(limit > self->capacity)
+        return 0;
+
     size_t i;
     int64_t * ts = self->time;
-    for(i = 0; i < TIMESTAMP_MAX_SEQ_SIZE; i++, ts++) {
+    for(i = 0; i < limit; i++, ts++) {
         *ts = TIME_INVALID;
     }
+    self->limit = limit;
+    return 1;
+}
+
+void timestamp_seq_init(struct timestamp_seq * self, int64_t * buffer, size_t capacity)
+{
+    assert(self);
+    assert(buffer || capacity == 0);
+    self->time = buffer;
+    self->capacity = capacity;
+    self->limit = 0;
     self->count = 0;
 }
 
@@ -104,7 +121,7 @@ int64_t timestamp_seq_get(const struct timestamp_seq * self, size_t index)
 {
     assert(self);
 
-    if(index >= TIMESTAMP_MAX_SEQ_SIZE)
+    if(index >= self->limit)
         return TIME_INVALID;
 
     return self->time[index];
@@ -120,9 +137,7 @@ int timestamp_seq_month(struct timestamp_seq * self, const struct tekon_date * d
 {
     assert(self);
 
-    timestamp_seq_init(self);
-
-    if(!(depth == 12 || depth == 48))
+    if(!(timestamp_seq_reset(self, depth) && (depth == 12 || depth == 48)))
         return 0;
 
     const int step = 3600*24*8; /* шаг 8 дней в сек. */
@@ -187,14 +202,15 @@ int timestamp_seq_day(struct timestamp_seq * self, const struct tekon_date * dat
 {
     assert(self);
 
-    timestamp_seq_init(self);
-
     const size_t size = 366;
     const int step = 8*3600;
     const int64_t limit = size * 24 * 3600;
     int64_t elapsed = 0;
     int64_t utc = 0;
 
+    if(!timestamp_seq_reset(self, size))
+        return 0;
+
     struct tm dt;
     memset(&dt, 0, sizeof(dt));
 
@@ -250,8 +266,7 @@ int timestamp_seq_hour(struct timestamp_seq * self, const struct tekon_date * da
 {
     assert(self);
 
-    timestamp_seq_init(self);
-    if (!(depth == 384 || depth == 768 || depth == 1536))
+    if (!(timestamp_seq_reset(self, depth) && (depth == 384 || depth == 768 || depth == 1536)))
         return 0;
 
     const int step = 1200;
@@ -325,11 +340,9 @@ int timestamp_seq_interval(struct timestamp_seq * self, const struct tekon_date
 {
     assert(self);
 
-    if(depth > TIMESTAMP_MAX_SEQ_SIZE)
+    if(!(timestamp_seq_reset(self, depth) && depth <= TIMESTAMP_MAX_SEQ_SIZE && interval > 0))
         return 0;
 
-    timestamp_seq_init(self);
-
     const size_t limit = depth * interval * 60; /* лимит в секундах */
     const int step = interval * 60;
 
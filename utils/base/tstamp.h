@@ -15,7 +15,8 @@ extern "C" {
 #include <time.h>
 #include "tekon/time.h"
 
-#define TIMESTAMP_MAX_SEQ_SIZE 8192
+/* Макс. размер последовательности (индексы архивов 16-битные) */
+#define TIMESTAMP_MAX_SEQ_SIZE 65535
 
 /* Генерация последовательностей с метками времени
  * Идея:
@@ -40,10 +41,17 @@ extern "C" {
  *   работают в локальном времени.
 */
 struct timestamp_seq {
-    int64_t time[TIMESTAMP_MAX_SEQ_SIZE];
+    int64_t * time;  /* буфер владельца на capacity меток */
+    size_t capacity;
+    size_t limit;    /* кол-во индексов текущей последовательности */
     size_t count;
 };
 
+/* Последовательности строятся в буфере, заданном timestamp_seq_init.
+ * Заполняются только индексы текущей последовательности (глубина архива,
+ * 366 для суточного). Если буфер меньше, то построение завершается с
+ * ошибкой */
+
 /* Месячная последовательность.
  * size - 12 или 48 */
 int timestamp_seq_month(struct timestamp_seq * self, const struct tekon_date * date, size_t depth);
@@ -59,7 +67,8 @@ int timestamp_seq_hour(struct timestamp_seq * self, const struct tekon_date * da
  * interval - минуты */
 int timestamp_seq_interval(struct timestamp_seq * self, const struct tekon_date * date, const struct tekon_time * time, size_t depth, size_t interval);
 
-void timestamp_seq_init(struct timestamp_seq * self);
+/* Задать буфер на capacity меток. Буфер не заполняется */
+void timestamp_seq_init(struct timestamp_seq * self, int64_t * buffer, size_t capacity);
 
 
 int64_t timestamp_seq_get(const struct timestamp_seq * self, size_t index);
@@ -43,7 +43,6 @@ static int intcfg_is_valid(const struct intcfg * self)
                self->depth == 64 * 24;
     case 'i':
         return self->depth > 0 &&
-               self->depth < TIMESTAMP_MAX_SEQ_SIZE &&
                self->interval > 0 &&
                self->interval < 100;
     }
@@ -412,7 +411,7 @@ int intcfg_from_string(struct intcfg * self, const char * str)
 
     struct intcfg result;
     const char * ptr = string_trim(str);
-    const size_t depthlen = 4;
+    const size_t depthlen = 5;
     const size_t intlen = 2;
 
     char buffer[128] = {0};
@@ -444,7 +443,10 @@ int intcfg_from_string(struct intcfg * self, const char * str)
 
     buffer[cnt] = '\0';
 
-    result.depth = atoi(buffer);
+    const long depth = atol(buffer);
+    if(depth < 0 || depth > TIMESTAMP_MAX_SEQ_SIZE)
+        return 0;
+    result.depth = depth;
 
     /* Прочитать интервал архива */
     ptr = string_next(ptr);
@@ -462,10 +464,33 @@ int intcfg_from_string(struct intcfg * self, const char * str)
     return 1;
 }
 
-#ifdef __cplusplus
-}
-#endif
+int rttcfg_from_string(struct rttcfg * self, const char * str)
+{
+    /*20:5000*/
+    assert(self);
+    if(string_is_term(str))
+        return 0;
 
+    const char * ptr = string_trim(str);
+    char * end = NULL;
 
+    long min = strtol(ptr, &end, 10);
+    if(end == ptr || *end != ':')
+        return 0;
 
+    ptr = end + 1;
+    long max = strtol(ptr, &end, 10);
+    if(end == ptr || !string_is_term(end))
+        return 0;
+
+    if(min <= 0 || max > 60000 || min > max)
+        return 0;
 
+    self->min = (uint16_t)min;
+    self->max = (uint16_t)max;
+    return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
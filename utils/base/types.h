@@ -53,6 +53,13 @@ struct dtaddr {
     uint16_t time;
 };
 
+/* Границы адаптивного таймаута, мс
+ * 20:5000 */
+struct rttcfg {
+    uint16_t min;
+    uint16_t max;
+};
+
 /* Описание интервала */
 struct intcfg {
     uint16_t depth;
@@ -65,6 +72,7 @@ int paraddr_from_string(struct paraddr * self, const char * str);
 int archaddr_from_string(struct paraddr * self, const char * str);
 int dtaddr_from_string(struct dtaddr * self, const char * str);
 int intcfg_from_string(struct intcfg * self, const char * str);
+int rttcfg_from_string(struct rttcfg * self, const char * str);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,171 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/base/wheel.h"
+#include <assert.h>
+#include <string.h>
+
+static struct wheel_timer * slot_of(struct wheel * self, int64_t expire)
+{
+    return &self->slot[(expire / WHEEL_TICK) % WHEEL_SLOTS];
+}
+
+void wheel_init(struct wheel * self, int64_t now)
+{
+    assert(self);
+    size_t i;
+    memset(self, 0, sizeof(*self));
+    for(i = 0; i < WHEEL_SLOTS; i++) {
+        self->slot[i].next = &self->slot[i];
+        self->slot[i].prev = &self->slot[i];
+    }
+    self->now = now;
+}
+
+void wheel_timer_init(struct wheel_timer * timer, wheel_fn callback, void * data)
+{
+    assert(timer);
+    memset(timer, 0, sizeof(*timer));
+    timer->callback = callback;
+    timer->data = data;
+}
+
+int wheel_timer_active(const struct wheel_timer * timer)
+{
+    assert(timer);
+    return timer->next != NULL;
+}
+
+void wheel_add(struct wheel * self, struct wheel_timer * timer, int64_t expire)
+{
+    assert(self);
+    assert(timer);
+
+    wheel_cancel(self, timer);
+
+    /* Просроченный таймер сработает на ближайшем шаге */
+    if(expire < self->now)
+        expire = self->now;
+
+    struct wheel_timer * head = slot_of(self, expire);
+    timer->expire = expire;
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+    self->count++;
+}
+
+void wheel_cancel(struct wheel * self, struct wheel_timer * timer)
+{
+    assert(self);
+    assert(timer);
+
+    if(!wheel_timer_active(timer))
+        return;
+
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = NULL;
+    timer->prev = NULL;
+    self->count--;
+}
+
+/* Вызвать обработчики сработавших таймеров ячейки. Список ячейки сначала
+ * переносится во временный список: таймеры следующих оборотов возвращаются
+ * обратно, а таймеры, взведенные из обработчиков, будут обработаны на
+ * следующем шаге. Обработчики могут отменять любые таймеры */
+static size_t slot_fire(struct wheel * self, struct wheel_timer * head, int64_t now)
+{
+    size_t fired = 0;
+    struct wheel_timer pending;
+
+    if(head->next == head)
+        return 0;
+
+    pending.next = head->next;
+    pending.prev = head->prev;
+    pending.next->prev = &pending;
+    pending.prev->next = &pending;
+    head->next = head;
+    head->prev = head;
+
+    while(pending.next != &pending) {
+        struct wheel_timer * timer = pending.next;
+        wheel_cancel(self, timer);
+
+        if(timer->expire <= now) {
+            fired++;
+            if(timer->callback)
+                timer->callback(timer, timer->data);
+        } else {
+            wheel_add(self, timer, timer->expire);
+        }
+    }
+    return fired;
+}
+
+size_t wheel_advance(struct wheel * self, int64_t now)
+{
+    assert(self);
+
+    if(now < self->now)
+        return 0;
+
+    size_t fired = 0;
+    int64_t tick = self->now / WHEEL_TICK;
+    const int64_t last = now / WHEEL_TICK;
+
+    /* За один оборот просматриваются все ячейки */
+    if(last - tick >= WHEEL_SLOTS)
+        tick = last - WHEEL_SLOTS + 1;
+
+    self->now = now;
+
+    for(; tick <= last; tick++)
+        fired += slot_fire(self, &self->slot[tick % WHEEL_SLOTS], now);
+
+    return fired;
+}
+
+int wheel_next(const struct wheel * self)
+{
+    assert(self);
+
+    if(self->count == 0)
+        return -1;
+
+    /* Ячейки просматриваются по порядку начиная с текущей. Таймеры следующих
+     * оборотов пропускаются */
+    const int64_t tick = self->now / WHEEL_TICK;
+    int64_t nearest = INT64_MAX;
+    int64_t i;
+    for(i = 0; i < WHEEL_SLOTS; i++) {
+        const struct wheel_timer * head = &self->slot[(tick + i) % WHEEL_SLOTS];
+        const int64_t border = (tick + i + 1) * WHEEL_TICK;
+        const struct wheel_timer * timer;
+        for(timer = head->next; timer != head; timer = timer->next) {
+            if(timer->expire < nearest)
+                nearest = timer->expire;
+        }
+        if(nearest < border)
+            break;
+    }
+    return nearest > self->now ? (int)(nearest - self->now) : 0;
+}
+
+size_t wheel_size(const struct wheel * self)
+{
+    assert(self);
+    return self->count;
+}
+
+#ifdef __cplusplus
+}
+#endif
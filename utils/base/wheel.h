@@ -0,0 +1,66 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_BASE_WHEEL_H
+#define UTILS_BASE_WHEEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Шаг колеса (мс) и кол-во ячеек. Один оборот - 2.56 сек. Таймеры с большим
+ * сроком остаются в своей ячейке и срабатывают на нужном обороте */
+#define WHEEL_TICK  10
+#define WHEEL_SLOTS 256
+
+struct wheel_timer;
+
+typedef void (*wheel_fn)(struct wheel_timer * timer, void * data);
+
+struct wheel_timer {
+    struct wheel_timer * next;
+    struct wheel_timer * prev;
+    int64_t expire;
+    wheel_fn callback;
+    void * data;
+};
+
+/* Колесо таймеров. Добавление и отмена таймера - O(1), что важно, когда
+ * таймауты взводятся на каждый запрос к сотням шлюзов одновременно */
+struct wheel {
+    struct wheel_timer slot[WHEEL_SLOTS];
+    int64_t now;
+    size_t count;
+};
+
+void wheel_init(struct wheel * self, int64_t now);
+
+void wheel_timer_init(struct wheel_timer * timer, wheel_fn callback, void * data);
+
+/* Взвести таймер на момент expire (мс). Взведенный таймер перевзводится */
+void wheel_add(struct wheel * self, struct wheel_timer * timer, int64_t expire);
+
+/* Отменить таймер. Повторная отмена допустима */
+void wheel_cancel(struct wheel * self, struct wheel_timer * timer);
+
+int wheel_timer_active(const struct wheel_timer * timer);
+
+/* Продвинуть колесо до момента now и вызвать обработчики сработавших таймеров.
+ * Возвращает кол-во сработавших таймеров */
+size_t wheel_advance(struct wheel * self, int64_t now);
+
+/* Время (мс) до ближайшей ячейки с таймерами или -1, если таймеров нет */
+int wheel_next(const struct wheel * self);
+
+size_t wheel_size(const struct wheel * self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -9,6 +9,39 @@ extern "C" {
 #include "utils/base/link.h"
 #include <assert.h>
 #include <errno.h>
+#include "utils/base/capture.h"
+
+/* Записать посылки в файл захвата, если он задан */
+static void capture(struct link * self, enum capture_dir dir, const void * data, ssize_t len)
+{
+    if(self->capture && len > 0)
+        capture_frame(self->capture, dir, data, (size_t)len);
+}
+
+/* Принять одну посылку из TCP потока, дочитывая его при необходимости.
+ * 0 - соединение закрыто */
+static ssize_t stream_recv(struct link * self, void * data, size_t len)
+{
+    for(;;) {
+        ssize_t result = tekon_stream_pop(&self->stream, data, len);
+        if(result != 0) {
+            if(result > 0)
+                self->stat.rx++;
+            return result;
+        }
+
+        size_t room = 0;
+        void * tail = tekon_stream_reserve(&self->stream, &room);
+        result = recv(self->socket, tail, (int)room, 0);
+        self->stat.syscalls++;
+
+        if(result <= 0)
+            return result == 0 ? 0 : -errno;
+
+        tekon_stream_commit(&self->stream, result);
+    }
+}
+
 /* Инициализация WSA. Про очистку (WSACleanup) я не забыл, а просто
  * проигнорировал, т.к. у нас не продпологается несколько вызовов
  * WSAStartup/WSACleanup.
@@ -86,6 +119,12 @@ int link_up(struct link * self)
 {
     assert(self);
 
+    if(self->fault)
+        return -ENOTSUP;
+
+    if(self->replay)
+        return 0;
+
     if(self->socket != TEKON_INVALID_SOCKET)
         return -EISCONN;
 
@@ -140,6 +179,7 @@ void link_down(struct link * self)
         closesocket(self->socket);
         self->socket = TEKON_INVALID_SOCKET;
     }
+    tekon_stream_init(&self->stream);
 }
 
 ssize_t link_send(struct link * self, const void * data, size_t len)
@@ -148,13 +188,23 @@ ssize_t link_send(struct link * self, const void * data, size_t len)
     assert(self);
     assert(data);
     assert(len);
+
+    if(self->replay) {
+        self->stat.tx++;
+        return replay_send(self->replay, data, len);
+    }
+
     if(self->socket == TEKON_INVALID_SOCKET)
         return -EBADF;
 
     ssize_t result = send(self->socket, data, len, 0);
+    self->stat.syscalls++;
 
-    if(result >= 0)
+    if(result >= 0) {
+        self->stat.tx++;
+        capture(self, CAPTURE_TX, data, result);
         return result;
+    }
     else
         return -errno;
 
@@ -166,10 +216,31 @@ ssize_t link_recv(struct link * self, void * data, size_t len)
     assert(data);
     assert(len);
 
+    if(self->replay) {
+        ssize_t result = replay_recv(self->replay, data, len);
+        if(result == -EAGAIN && replay_wait(self->replay, self->timeout) > 0)
+            result = replay_recv(self->replay, data, len);
+        if(result > 0)
+            self->stat.rx++;
+        return result;
+    }
+
     if(self->socket == TEKON_INVALID_SOCKET)
         return -EBADF;
 
+    if(self->type == LINK_TCP) {
+        ssize_t result = stream_recv(self, data, len);
+        capture(self, CAPTURE_RX, data, result);
+        return result;
+    }
+
     ssize_t result = recv(self->socket, data, len, 0);
+    self->stat.syscalls++;
+
+    if(result > 0) {
+        self->stat.rx++;
+        capture(self, CAPTURE_RX, data, result);
+    }
 
     if(result >= 0)
         return result;
@@ -177,6 +248,85 @@ ssize_t link_recv(struct link * self, void * data, size_t len)
         return -errno;
 }
 
+/* В Windows нет аналога sendmmsg/recvmmsg. Пакетные функции сохраняют
+ * интерфейс, но выполняют по одному вызову на посылку */
+int link_send_batch(struct link * self, const struct link_buffer * buffers, size_t count)
+{
+    assert(self);
+    assert(buffers);
+
+    size_t i;
+    for(i = 0; i < count; i++) {
+        ssize_t result = link_send(self, buffers[i].data, buffers[i].len);
+        if(result < 0)
+            return i ? (int)i : (int)result;
+
+        /* Посылка ушла в TCP поток не полностью, линк закрывается */
+        if((size_t)result != buffers[i].len) {
+            link_down(self);
+            return i ? (int)i : -EIO;
+        }
+    }
+    return (int)count;
+}
+
+int link_recv_batch(struct link * self, struct link_buffer * buffers, size_t count)
+{
+    assert(self);
+    assert(buffers);
+
+    size_t i;
+    for(i = 0; i < count; i++) {
+        int ready = link_wait(self, 0);
+        if(ready <= 0)
+            return i ? (int)i : ready;
+
+        ssize_t result = link_recv(self, buffers[i].data, buffers[i].size);
+        if(result < 0)
+            return i ? (int)i : (int)result;
+
+        if(result == 0 && self->type == LINK_TCP)
+            return -ECONNRESET;
+
+        buffers[i].len = result;
+    }
+    return (int)count;
+}
+
+int link_wait(struct link * self, int timeout)
+{
+    assert(self);
+
+    if(self->replay)
+        return replay_wait(self->replay, timeout);
+
+    if(self->socket == TEKON_INVALID_SOCKET)
+        return -EBADF;
+
+    if(self->type == LINK_TCP && tekon_stream_ready(&self->stream))
+        return 1;
+
+    if(timeout < 0)
+        timeout = 0;
+
+    fd_set rset;
+    FD_ZERO(&rset);
+    FD_SET(self->socket, &rset);
+
+    struct timeval tv = {
+        .tv_sec = timeout / 1000,
+        .tv_usec = (timeout % 1000) * 1000
+    };
+
+    int result = select(0, &rset, NULL, NULL, &tv);
+    self->stat.syscalls++;
+
+    if(result != SOCKET_ERROR)
+        return result;
+    else
+        return -WSAGetLastError();
+}
+
 #ifdef __cplusplus
 }
 #endif
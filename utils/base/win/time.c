@@ -9,6 +9,7 @@ extern "C" {
 #include "utils/base/time.h"
 #include <assert.h>
 #include <sys/timeb.h>
+#include <windows.h>
 
 int64_t time_now_utc()
 {
@@ -33,6 +34,35 @@ int32_t time_tzoffset()
     return -tb.timezone * 60;
 }
 
+int64_t time_monotonic_ms()
+{
+    /* GetTickCount64 недоступна в XP, поэтому расширяем 32-х битный счетчик
+     * вручную. Переполнение происходит раз в ~49 дней */
+    static DWORD last = 0;
+    static int64_t high = 0;
+    DWORD now = GetTickCount();
+    if(now < last)
+        high += (int64_t)1 << 32;
+    last = now;
+    return high + now;
+}
+
+int64_t time_monotonic_us()
+{
+    LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if(!QueryPerformanceFrequency(&freq) || !QueryPerformanceCounter(&now))
+        return time_monotonic_ms() * 1000;
+    return (int64_t)(now.QuadPart / freq.QuadPart) * 1000000 +
+           (int64_t)(now.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+}
+
+void time_sleep_us(int64_t us)
+{
+    if(us > 0)
+        Sleep((DWORD)((us + 999) / 1000));
+}
+
 int time_local_from_utc(int64_t utc, struct tm * local)
 {
     assert(local);
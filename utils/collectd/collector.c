@@ -0,0 +1,179 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/collectd/collector.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils/base/time.h"
+
+static void schedule(struct collector_gateway * self, int64_t when)
+{
+    wheel_add(&self->collector->reactor.wheel, &self->timer, when);
+}
+
+/* Цикл опроса завершен успешно. Линк остается подключенным */
+static void complete(struct collector_gateway * self)
+{
+    struct collector * collector = self->collector;
+    const int64_t now = time_monotonic_ms();
+    const int64_t next = self->start + collector->period;
+
+    self->error = 0;
+    self->backoff = 0;
+    self->cycles++;
+
+    /* Если цикл занял больше периода, следующий начинается сразу */
+    schedule(self, next > now ? next : now);
+
+    if(collector->callback)
+        collector->callback(collector, self->session.group, 0);
+}
+
+/* Цикл опроса завершен с ошибкой. Непрочитанные измерения получают признак
+ * ошибки связи, линк закрывается до следующей попытки */
+static void fail(struct collector_gateway * self, int error)
+{
+    struct collector * collector = self->collector;
+
+    msr_session_invalidate(&self->session, time_now_utc());
+    alink_down(&self->session.link);
+
+    if(collector->stats)
+        collector->stats->failures++;
+
+    self->error = error;
+    self->failures++;
+    self->backoff = self->backoff ? self->backoff * 2 : collector->period;
+    if(self->backoff > collector->backoff_max)
+        self->backoff = collector->backoff_max;
+
+    schedule(self, time_monotonic_ms() + self->backoff);
+
+    if(collector->callback)
+        collector->callback(collector, self->session.group, error);
+}
+
+static void on_done(struct msr_session * session, int error)
+{
+    if(error)
+        fail(session->data, error);
+    else
+        complete(session->data);
+}
+
+static void begin_cycle(struct collector_gateway * self)
+{
+    self->start = time_monotonic_ms();
+
+    switch(alink_state(&self->session.link)) {
+    case ALINK_DOWN: /* первый опрос или переподключение после ошибки */
+    case ALINK_IDLE:
+        msr_session_start(&self->session);
+        break;
+    case ALINK_CONNECTING:
+    case ALINK_WAIT:
+        /* Предыдущий цикл еще не завершен */
+        schedule(self, self->start + self->collector->period);
+        break;
+    }
+}
+
+static void on_timer(struct wheel_timer * timer, void * data)
+{
+    begin_cycle(data);
+}
+
+int collector_init(struct collector * self, struct msr_table * table, const struct msr_group * groups, size_t size,
+                   uint16_t timeout, uint32_t period, uint32_t backoff_max, collector_fn callback)
+{
+    assert(self);
+    assert(table);
+    assert(groups);
+    assert(period);
+
+    memset(self, 0, sizeof(*self));
+
+    int result = reactor_init(&self->reactor);
+    if(result != 0)
+        return result;
+
+    self->gateways = calloc(size, sizeof(*self->gateways));
+    if(!self->gateways) {
+        reactor_close(&self->reactor);
+        return -ENOMEM;
+    }
+
+    size_t i;
+    for(i = 0; i < size; i++) {
+        struct collector_gateway * gw = &self->gateways[i];
+        msr_session_init(&gw->session, table, &groups[i], on_done, gw);
+        gw->session.latency = &gw->latency;
+        gw->collector = self;
+        hist_init(&gw->latency);
+        wheel_timer_init(&gw->timer, on_timer, gw);
+    }
+
+    self->table = table;
+    self->size = size;
+    self->timeout = timeout;
+    self->period = period;
+    self->backoff_max = backoff_max < period ? period : backoff_max;
+    self->callback = callback;
+    return 0;
+}
+
+void collector_close(struct collector * self)
+{
+    assert(self);
+
+    size_t i;
+    for(i = 0; i < self->size; i++) {
+        struct collector_gateway * gw = &self->gateways[i];
+        wheel_cancel(&self->reactor.wheel, &gw->timer);
+        if(gw->session.link.reactor)
+            alink_down(&gw->session.link);
+    }
+
+    free(self->gateways);
+    self->gateways = NULL;
+    self->size = 0;
+    reactor_close(&self->reactor);
+}
+
+int collector_start(struct collector * self)
+{
+    assert(self);
+
+    const int64_t now = time_monotonic_ms();
+    size_t i;
+
+    for(i = 0; i < self->size; i++) {
+        struct collector_gateway * gw = &self->gateways[i];
+        int result = msr_session_link(&gw->session, &self->reactor, self->timeout, &self->rtt);
+        if(result != 0)
+            return result;
+
+        gw->session.retries = self->retries;
+        gw->session.stats = self->stats;
+        schedule(gw, now);
+    }
+    return 0;
+}
+
+int collector_poll(struct collector * self, int timeout)
+{
+    assert(self);
+    return reactor_poll(&self->reactor, timeout);
+}
+
+#ifdef __cplusplus
+}
+#endif
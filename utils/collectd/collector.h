@@ -0,0 +1,86 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_COLLECTD_COLLECTOR_H
+#define UTILS_COLLECTD_COLLECTOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "utils/base/hist.h"
+#include "utils/base/reactor.h"
+#include "utils/base/stats.h"
+#include "utils/base/wheel.h"
+#include "utils/msr/msr.h"
+#include "utils/msr/session.h"
+
+/* Период опроса по умолчанию, мс */
+#define COLLECTOR_PERIOD 1000
+
+/* Макс. задержка перед повторным подключением по умолчанию, мс */
+#define COLLECTOR_BACKOFF_MAX 60000
+
+struct collector;
+
+/* Опрос группы завершен. Измерения группы уже обновлены в таблице.
+ * error - 0 в случае успеха, иначе код ошибки */
+typedef void (*collector_fn)(struct collector * self, const struct msr_group * group, int error);
+
+/* Состояние опроса одного шлюза. Обмен ведет сеанс (msr_session), его
+ * счетчики запросов, повторов, таймаутов и байт выводятся в метриках */
+struct collector_gateway {
+    struct msr_session session;
+    struct wheel_timer timer; /* следующий опрос или переподключение */
+    struct collector * collector;
+    int64_t start;     /* время начала текущего цикла опроса */
+    uint32_t backoff;  /* текущая задержка переподключения */
+    int error;         /* результат последнего цикла */
+    uint64_t cycles;   /* кол-во успешных циклов */
+    uint64_t failures; /* кол-во неудачных циклов */
+    struct hist latency; /* время запроса от первой отправки до ответа, мкс */
+};
+
+/* Постоянный опрос нескольких шлюзов.
+ * Линки остаются подключенными между циклами опроса, таблица измерений
+ * хранится все время работы. Каждый шлюз опрашивается раз в period мс.
+ * После ошибки линк закрывается, и повторное подключение выполняется с
+ * задержкой, удваивающейся после каждой неудачи (от period до backoff_max) */
+struct collector {
+    struct reactor reactor;
+    struct msr_table * table;
+    struct collector_gateway * gateways;
+    size_t size;
+    uint16_t timeout;
+    uint32_t period;
+    uint32_t backoff_max;
+    struct rttcfg rtt; /* границы адаптивного таймаута. Нули - выключен */
+    size_t retries;    /* бюджет повторов на порцию. По умолчанию 0 */
+    struct stats * stats; /* статистика обмена. NULL - не собирается */
+    collector_fn callback;
+    void * data; /* данные владельца */
+};
+
+/* В случае успеха вернет 0. Иначе - код ошибки */
+int collector_init(struct collector * self, struct msr_table * table, const struct msr_group * groups, size_t size,
+                   uint16_t timeout, uint32_t period, uint32_t backoff_max, collector_fn callback);
+
+void collector_close(struct collector * self);
+
+/* Запланировать первый опрос всех шлюзов.
+ * В случае успеха вернет 0. Иначе - код ошибки */
+int collector_start(struct collector * self);
+
+/* Обработать события, ожидая их не более timeout мс.
+ * Возвращает кол-во обработанных событий или код ошибки */
+int collector_poll(struct collector * self, int timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,374 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <assert.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <getopt.h>
+#include <inttypes.h>
+
+#include "utils/base/base.h"
+#include "utils/msr/msr.h"
+#include "utils/collectd/collector.h"
+#include "utils/collectd/metrics.h"
+#include "tekon/tekon.h"
+
+#define APP_NAME "tekon_collectd"
+#define APP_ERR  LOG_ERR  APP_NAME " : ERR"
+#define APP_WARN LOG_WARN APP_NAME " : WARN"
+#define APP_INFO LOG_INFO APP_NAME " : INFO"
+
+/* Макс. кол-во повторов запроса */
+#define APP_MAX_RETRIES 10
+
+/* Длинные опции без короткого аналога. Опции диагностики общие с
+ * остальными утилитами */
+#define APP_OPT_METRICS_FILE (DIAG_OPT_LAST + 1)
+#define APP_OPT_METRICS_PORT (DIAG_OPT_LAST + 2)
+
+static const struct option options[] = {
+    DIAG_OPTIONS,
+    {"metrics-file", required_argument, NULL, APP_OPT_METRICS_FILE},
+    {"metrics-port", required_argument, NULL, APP_OPT_METRICS_PORT},
+    {NULL, 0, NULL, 0}
+};
+
+struct app {
+    struct msr_group groups[MEASURMENT_MAX_GATEWAYS];
+    size_t ngroups;
+    struct msr_table table;
+    struct collector collector;
+    int tzoffset;
+    int timeout;
+    struct rttcfg rtt;
+    int retries;
+    long period;
+    long backoff;
+    struct diag diag;
+    const char * metrics_file;
+    uint16_t metrics_port;
+    struct metrics_server metrics;
+};
+
+static volatile sig_atomic_t stop = 0;
+static volatile sig_atomic_t trace_requested = 0;
+
+static void init(struct app * self)
+{
+    assert(self);
+    memset(self, 0, sizeof(*self));
+    msr_table_init(&self->table);
+    self->tzoffset = time_tzoffset();
+    self->timeout = 1000;
+    self->period = COLLECTOR_PERIOD;
+    self->backoff = COLLECTOR_BACKOFF_MAX;
+    diag_init(&self->diag, APP_NAME);
+}
+
+static void usage()
+{
+    printf("Usage: %s -a address -p parameters [-a address -p parameters ...]\n", APP_NAME);
+    printf("                      [-i interval] [-b backoff] [-t timeout] [-T min:max] [-r retries] [--stats] [-v verbosity]\n");
+    printf("                      [--metrics-file file] [--metrics-port port] [--trace file]\n\n");
+    printf("  -a    gateway's address in [type:ip:port@gateway] format.\n");
+    printf("        Several gateways could be set. Each -a is followed by its own -p.\n\n");
+    printf("  -p    list of parameters in [device:parameter:index:type] format.\n");
+    printf("        type: \n");
+    printf("            F - 32-bit float\n");
+    printf("            U - 32-bit unsigned integer\n");
+    printf("            H - 32-bit unsigned integer (HEX)\n");
+    printf("            B - boolean\n");
+    printf("            R - raw\n");
+    printf("            D - date\n");
+    printf("            T - time\n\n");
+    printf("  -i    polling interval in milliseconds. Default is %d.\n\n", COLLECTOR_PERIOD);
+    printf("  -b    max reconnection delay in milliseconds. Default is %d.\n\n", COLLECTOR_BACKOFF_MAX);
+    printf("  -t    response timeout in milliseconds.\n\n");
+    printf("  -T    adaptive response timeout bounds in [min:max] format, ms.\n");
+    printf("        Timeout follows measured round-trip time. -t sets initial value.\n\n");
+    printf("  -r    number of retries of a failed request [0, %d]. Default is 0.\n\n", APP_MAX_RETRIES);
+    diag_usage(stdout, 0);
+    printf("  --metrics-file file\n");
+    printf("        write metrics in Prometheus text format to file every interval.\n\n");
+    printf("  --metrics-port port\n");
+    printf("        serve metrics in Prometheus text format on http://127.0.0.1:port/metrics.\n\n");
+    printf("  -v    set verbose:\n");
+    printf("        0 - silent \n");
+    printf("        1 - error\n");
+    printf("        2 - warning \n");
+    printf("        3 - info \n\n");
+    printf("Signals:\n");
+    printf("  SIGUSR1 write the --trace file without stopping.\n\n");
+    printf("Example:\n");
+    printf("  %s -a tcp:10.0.0.3:51960@2 -p '3:0x8003:0:F 3:0xF017:0:D 3:0xF018:0:T' -i 1000\n", APP_NAME);
+}
+
+/* Прочитать аргусенты командной строки
+ * 0 - в случае ошибки */
+static int read_args(struct app * app, int argc, char * const argv[])
+{
+    assert(app);
+
+    if(argc < 4)
+        return 0;
+
+    int opt;
+    struct msr_group * group = NULL;
+    struct paraddr param;
+
+    while ((opt = getopt_long(argc, argv, "t:T:a:p:r:v:i:b:", options, NULL)) != -1) {
+        switch (opt) {
+        case 't': {
+            long input  = atol(optarg);
+            if(input <= 0 || input > 60000) {
+                printf("invalid timeout %s\n\n", optarg);
+                return 0;
+            } else {
+                app->timeout = (size_t)input;
+            }
+        }
+        break;
+        case 'i': {
+            long input  = atol(optarg);
+            if(input <= 0 || input > 86400000) {
+                printf("invalid interval %s\n\n", optarg);
+                return 0;
+            } else {
+                app->period = input;
+            }
+        }
+        break;
+        case 'b': {
+            long input  = atol(optarg);
+            if(input <= 0 || input > 86400000) {
+                printf("invalid backoff %s\n\n", optarg);
+                return 0;
+            } else {
+                app->backoff = input;
+            }
+        }
+        break;
+        case 'p': {
+            if(group == NULL) {
+                printf("enter address before parameters list\n\n");
+                return 0;
+            }
+
+            char * str = optarg;
+            char * token = NULL;
+
+            while((token = strtok_r(str, " ", &str))) {
+                if(!paraddr_from_string(&param, token)) {
+                    printf("invalid parameter address %s\n\n", optarg);
+                    return 0;
+                } else {
+                    struct msr msr;
+                    msr_init(&msr, group->addr.gateway, param.device, param.address, param.index, param.type, param.hex);
+                    if(!msr_table_add(&app->table, &msr)) {
+                        printf("measurments overflow. Limit is %d\n\n", MEASURMENT_MAX_TABLE_SIZE);
+                        return 0;
+                    }
+                    group->count++;
+                }
+            }
+        }
+        break;
+        case 'a':
+            if(app->ngroups == MEASURMENT_MAX_GATEWAYS) {
+                printf("gateways overflow. Limit is %d\n\n", MEASURMENT_MAX_GATEWAYS);
+                return 0;
+            }
+            group = &app->groups[app->ngroups];
+            if(!netaddr_from_string(&group->addr, optarg)) {
+                printf("invalid network address %s\n\n", optarg);
+                return 0;
+            }
+            group->first = msr_table_size(&app->table);
+            group->count = 0;
+            app->ngroups++;
+            break;
+        case 'T':
+            if(!rttcfg_from_string(&app->rtt, optarg)) {
+                printf("invalid timeout bounds %s\n\n", optarg);
+                return 0;
+            }
+            break;
+        case 'r': {
+            long input  = atol(optarg);
+            if(input < 0 || input > APP_MAX_RETRIES || !isdigit((unsigned char)*optarg)) {
+                printf("invalid retries %s\n\n", optarg);
+                return 0;
+            } else {
+                app->retries = (int)input;
+            }
+        }
+        break;
+        case APP_OPT_METRICS_FILE:
+            app->metrics_file = optarg;
+            break;
+        case APP_OPT_METRICS_PORT: {
+            long input  = atol(optarg);
+            if(input <= 0 || input > 65535) {
+                printf("invalid metrics port %s\n\n", optarg);
+                return 0;
+            } else {
+                app->metrics_port = (uint16_t)input;
+            }
+        }
+        break;
+        case 'v':
+            log_setlevel(atoi(optarg));
+            break;
+        default: {
+            /* Опции диагностики обмена или '?' */
+            const int result = diag_option(&app->diag, opt, optarg);
+            if(result < 0)
+                printf("invalid argument %c\n\n", opt);
+            if(result <= 0)
+                return 0;
+        }
+        break;
+        }
+    }
+
+    /* Шлюзы опрашиваются через асинхронные линки, захват и искажения на них
+     * не подключаются */
+    if(diag_link_used(&app->diag)) {
+        printf("capture, replay and fault injection are not supported\n\n");
+        return 0;
+    }
+
+    /* Адрес не задан */
+    if(app->ngroups == 0) {
+        printf("please enter gateway's address\n\n");
+        return 0;
+    }
+
+    /* Параметры не заданы */
+    size_t i;
+    for(i = 0; i < app->ngroups; i++) {
+        if(app->groups[i].count == 0) {
+            printf("please enter parameters to read from %s\n\n", app->groups[i].addr.ip);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Вывести измерения группы после каждого цикла опроса */
+static void on_cycle(struct collector * collector, const struct msr_group * group, int error)
+{
+    struct app * app = collector->data;
+    char buffer[MEASURMENT_MAX_STRING];
+    size_t i;
+
+    if(error)
+        log_print(APP_ERR " : %s:%"PRIu16" exchange error %d\n", group->addr.ip, group->addr.port, error);
+
+    for(i = 0; i < group->count; i++) {
+        msr_to_string(msr_table_get(&app->table, group->first + i), app->tzoffset, buffer, sizeof(buffer));
+        printf("%s\n", buffer);
+    }
+    fflush(stdout);
+}
+
+static void sigint(int sig)
+{
+    stop = 1;
+}
+
+/* Выгрузка выполняется в цикле опроса: запись файла в обработчике сигнала
+ * небезопасна */
+static void sigusr1(int sig)
+{
+    trace_requested = 1;
+}
+
+int main(int argc, char * argv[])
+{
+    static struct app app;
+
+    init(&app);
+
+    if(!read_args(&app, argc, argv)) {
+        usage();
+        return 1;
+    }
+
+    signal(SIGINT, sigint);
+    signal(SIGTERM, sigint);
+    signal(SIGUSR1, sigusr1);
+
+    int result = collector_init(&app.collector, &app.table, app.groups, app.ngroups,
+                                app.timeout, app.period, app.backoff, on_cycle);
+    if(result != 0) {
+        log_print(APP_ERR " : init error %d\n", result);
+        return 1;
+    }
+
+    app.collector.data = &app;
+    app.collector.rtt = app.rtt;
+    app.collector.retries = app.retries;
+    app.collector.stats = diag_stats(&app.diag);
+    result = collector_start(&app.collector);
+
+    if(result == 0 && app.metrics_port) {
+        result = metrics_server_init(&app.metrics, &app.collector, app.metrics_port);
+        if(result != 0)
+            log_print(APP_ERR " : metrics port %u error %d\n", (unsigned)app.metrics_port, result);
+    }
+
+    if(result != 0)
+        log_print(APP_ERR " : start error %d\n", result);
+    else
+        log_print(APP_INFO " : started. Gateways: %u\n", (unsigned)app.ngroups);
+
+    int64_t save_at = time_monotonic_ms() + app.period;
+    while(result == 0 && !stop) {
+        TEKON_TRACE_BEGIN(TEKON_TRACE_CYCLE);
+        result = collector_poll(&app.collector, 1000);
+        TEKON_TRACE_END(TEKON_TRACE_CYCLE, result);
+        if(result > 0)
+            result = 0;
+
+        if(trace_requested) {
+            trace_requested = 0;
+            diag_trace(&app.diag);
+        }
+
+        /* Файл метрик обновляется раз в период опроса */
+        const int64_t now = time_monotonic_ms();
+        if(app.metrics_file && now >= save_at) {
+            const int error = metrics_save(&app.collector, app.metrics_file);
+            if(error != 0)
+                log_print(APP_WARN " : %s metrics writing error %d\n", app.metrics_file, error);
+            save_at = now + app.period;
+        }
+    }
+
+    if(result != 0)
+        log_print(APP_ERR " : polling error %d\n", result);
+
+    log_print(APP_INFO " : stop\n");
+    if(app.metrics_port)
+        metrics_server_close(&app.metrics);
+    collector_close(&app.collector);
+    diag_close(&app.diag);
+    diag_print(&app.diag, NULL, stderr);
+
+    return result != 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
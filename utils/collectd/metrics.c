@@ -0,0 +1,354 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/collectd/metrics.h"
+#include <arpa/inet.h>
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "utils/base/time.h"
+
+/* Счетчик шлюза, выводимый как есть */
+struct counter {
+    const char * name;
+    const char * help;
+    size_t offset; /* смещение поля uint64_t в collector_gateway */
+};
+
+static const struct counter counters[] = {
+    {"tekon_requests_total", "Requests sent to the gateway, retries excluded.", offsetof(struct collector_gateway, session.requests)},
+    {"tekon_retries_total", "Requests repeated after a timeout or an invalid reply.", offsetof(struct collector_gateway, session.resent)},
+    {"tekon_timeouts_total", "Replies not received in time.", offsetof(struct collector_gateway, session.timeouts)},
+    {"tekon_invalid_replies_total", "Replies failed length/CRC validation or decoding.", offsetof(struct collector_gateway, session.invalid)},
+    {"tekon_tx_bytes_total", "Bytes sent to the gateway.", offsetof(struct collector_gateway, session.tx_bytes)},
+    {"tekon_rx_bytes_total", "Bytes received from the gateway.", offsetof(struct collector_gateway, session.rx_bytes)},
+    {"tekon_cycles_total", "Successful polling cycles.", offsetof(struct collector_gateway, cycles)},
+    {"tekon_cycle_failures_total", "Failed polling cycles.", offsetof(struct collector_gateway, failures)},
+};
+
+/* Границы интервалов гистограммы задержек, мкс */
+static const int64_t buckets[] = {
+    1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+    1000000, 2500000, 5000000, 10000000
+};
+
+#define COUNT(array) (sizeof(array) / sizeof(array[0]))
+
+static void print_label(const struct collector_gateway * gw, FILE * out)
+{
+    const struct netaddr * addr = &gw->session.group->addr;
+    fprintf(out, "gateway=\"%s:%s:%"PRIu16"@%u\"",
+            addr->type == LINK_TCP ? "tcp" : "udp", addr->ip, addr->port, (unsigned)addr->gateway);
+}
+
+int metrics_print(const struct collector * collector, FILE * out)
+{
+    assert(collector);
+    assert(out);
+
+    size_t i;
+    size_t j;
+
+    for(i = 0; i < COUNT(counters); i++) {
+        fprintf(out, "# HELP %s %s\n# TYPE %s counter\n", counters[i].name, counters[i].help, counters[i].name);
+        for(j = 0; j < collector->size; j++) {
+            const struct collector_gateway * gw = &collector->gateways[j];
+            const uint64_t * value = (const uint64_t *)((const char *)gw + counters[i].offset);
+            fprintf(out, "%s{", counters[i].name);
+            print_label(gw, out);
+            fprintf(out, "} %"PRIu64"\n", *value);
+        }
+    }
+
+    fprintf(out, "# HELP tekon_up Result of the last polling cycle (1 - success).\n# TYPE tekon_up gauge\n");
+    for(j = 0; j < collector->size; j++) {
+        const struct collector_gateway * gw = &collector->gateways[j];
+        fprintf(out, "tekon_up{");
+        print_label(gw, out);
+        fprintf(out, "} %d\n", gw->cycles && !gw->error);
+    }
+
+    fprintf(out, "# HELP tekon_request_duration_seconds Time from the first send of a request to its reply.\n"
+            "# TYPE tekon_request_duration_seconds histogram\n");
+    for(j = 0; j < collector->size; j++) {
+        const struct collector_gateway * gw = &collector->gateways[j];
+        for(i = 0; i < COUNT(buckets); i++) {
+            fprintf(out, "tekon_request_duration_seconds_bucket{");
+            print_label(gw, out);
+            fprintf(out, ",le=\"%g\"} %"PRIu64"\n", buckets[i] / 1e6, hist_count_le(&gw->latency, buckets[i]));
+        }
+        fprintf(out, "tekon_request_duration_seconds_bucket{");
+        print_label(gw, out);
+        fprintf(out, ",le=\"+Inf\"} %"PRIu64"\n", gw->latency.count);
+        fprintf(out, "tekon_request_duration_seconds_sum{");
+        print_label(gw, out);
+        fprintf(out, "} %.6f\n", gw->latency.sum / 1e6);
+        fprintf(out, "tekon_request_duration_seconds_count{");
+        print_label(gw, out);
+        fprintf(out, "} %"PRIu64"\n", gw->latency.count);
+    }
+
+    return ferror(out) ? -EIO : 0;
+}
+
+int metrics_save(const struct collector * collector, const char * path)
+{
+    assert(collector);
+    assert(path);
+
+    char tmp[512];
+    if(snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp))
+        return -ENAMETOOLONG;
+
+    FILE * file = fopen(tmp, "w");
+    if(!file)
+        return -errno;
+
+    int result = metrics_print(collector, file);
+    if(fclose(file) != 0 && result == 0)
+        result = -errno;
+
+    if(result == 0 && rename(tmp, path) != 0)
+        result = -errno;
+
+    if(result != 0)
+        unlink(tmp);
+    return result;
+}
+
+/* Отключить клиента и освободить место */
+static void client_drop(struct metrics_client * self)
+{
+    struct reactor * reactor = &self->server->collector->reactor;
+
+    wheel_cancel(&reactor->wheel, &self->timer);
+    reactor_remove(reactor, self->socket);
+    close(self->socket);
+    free(self->response);
+    self->socket = TEKON_INVALID_SOCKET;
+    self->response = NULL;
+}
+
+static void on_client_timer(struct wheel_timer * timer, void * data)
+{
+    struct metrics_client * self = data;
+    self->server->dropped++;
+    client_drop(self);
+}
+
+/* Подготовить ответ на принятый запрос.
+ * В случае успеха вернет 0. Иначе - код ошибки */
+static int client_respond(struct metrics_client * self)
+{
+    char * body = NULL;
+    size_t size = 0;
+
+    /* Заголовки не нужны, достаточно строки запроса */
+    const int found = strncmp(self->request, "GET /metrics ", 13) == 0 ||
+                      strncmp(self->request, "GET / ", 6) == 0;
+
+    FILE * out = open_memstream(&body, &size);
+    if(!out)
+        return -errno;
+    if(found)
+        metrics_print(self->server->collector, out);
+    else
+        fprintf(out, "not found\n");
+    if(fclose(out) != 0) {
+        free(body);
+        return -EIO;
+    }
+
+    char header[256];
+    const int hlen = snprintf(header, sizeof(header),
+                              "HTTP/1.0 %s\r\n"
+                              "Content-Type: text/plain; version=0.0.4\r\n"
+                              "Content-Length: %zu\r\n"
+                              "Connection: close\r\n\r\n",
+                              found ? "200 OK" : "404 Not Found", size);
+
+    self->response = malloc(hlen + size);
+    if(!self->response) {
+        free(body);
+        return -ENOMEM;
+    }
+    memcpy(self->response, header, hlen);
+    memcpy(self->response + hlen, body, size);
+    self->size = hlen + size;
+    self->sent = 0;
+    free(body);
+
+    return reactor_modify(&self->server->collector->reactor, self->socket, REACTOR_OUT, &self->handler);
+}
+
+/* Дочитать строку запроса.
+ * 1 - запрос принят, 0 - ждать данные, иначе - код ошибки */
+static int client_read(struct metrics_client * self)
+{
+    const ssize_t len = recv(self->socket, self->request + self->received,
+                             sizeof(self->request) - 1 - self->received, MSG_DONTWAIT);
+
+    if(len < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -errno;
+    if(len == 0)
+        return -ECONNRESET;
+
+    self->received += len;
+    self->request[self->received] = 0;
+
+    /* Остаток запроса не читается */
+    return strchr(self->request, '\n') || self->received == sizeof(self->request) - 1;
+}
+
+/* Отправить очередную часть ответа.
+ * 1 - ответ отправлен, 0 - ждать готовности сокета, иначе - код ошибки */
+static int client_write(struct metrics_client * self)
+{
+    while(self->sent < self->size) {
+        const ssize_t len = send(self->socket, self->response + self->sent, self->size - self->sent,
+                                 MSG_NOSIGNAL | MSG_DONTWAIT);
+        if(len < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -errno;
+        self->sent += len;
+    }
+    return 1;
+}
+
+/* Клиент обслуживается по готовности сокета и не задерживает опрос шлюзов:
+ * чтение запроса -> отправка ответа -> отключение */
+static void on_client_event(struct reactor_handler * handler, uint32_t events)
+{
+    struct metrics_client * self = (struct metrics_client *)handler;
+    int result;
+
+    if(!self->response) {
+        result = client_read(self);
+        if(result == 1)
+            result = client_respond(self);
+        if(result != 0) {
+            client_drop(self);
+            return;
+        }
+        if(!self->response)
+            return;
+    }
+
+    result = client_write(self);
+    if(result == 1)
+        self->server->scrapes++;
+    if(result != 0)
+        client_drop(self);
+}
+
+/* Принять клиента. Если свободного места нет, подключение закрывается */
+static void client_accept(struct metrics_server * self, socket_t socket)
+{
+    struct metrics_client * client = NULL;
+    size_t i;
+
+    for(i = 0; i < METRICS_MAX_CLIENTS && !client; i++) {
+        if(self->clients[i].socket == TEKON_INVALID_SOCKET)
+            client = &self->clients[i];
+    }
+
+    struct reactor * reactor = &self->collector->reactor;
+    if(!client || reactor_add(reactor, socket, REACTOR_IN, &client->handler) != 0) {
+        self->dropped++;
+        close(socket);
+        return;
+    }
+
+    client->socket = socket;
+    client->received = 0;
+    client->request[0] = 0;
+    wheel_add(&reactor->wheel, &client->timer, time_monotonic_ms() + METRICS_CLIENT_TIMEOUT);
+}
+
+static void on_event(struct reactor_handler * handler, uint32_t events)
+{
+    struct metrics_server * self = (struct metrics_server *)handler;
+
+    for(;;) {
+        const socket_t client = accept4(self->socket, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(client == TEKON_INVALID_SOCKET)
+            return;
+        client_accept(self, client);
+    }
+}
+
+int metrics_server_init(struct metrics_server * self, struct collector * collector, uint16_t port)
+{
+    assert(self);
+    assert(collector);
+
+    struct sockaddr_in addr;
+    const int on = 1;
+    size_t i;
+
+    memset(self, 0, sizeof(*self));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    self->handler.callback = on_event;
+    self->collector = collector;
+    for(i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        struct metrics_client * client = &self->clients[i];
+        client->handler.callback = on_client_event;
+        client->server = self;
+        client->socket = TEKON_INVALID_SOCKET;
+        wheel_timer_init(&client->timer, on_client_timer, client);
+    }
+    self->socket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if(self->socket == TEKON_INVALID_SOCKET)
+        return -errno;
+
+    int result = 0;
+    if(setsockopt(self->socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0 ||
+            bind(self->socket, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+            listen(self->socket, SOMAXCONN) != 0)
+        result = -errno;
+
+    if(result == 0)
+        result = reactor_add(&collector->reactor, self->socket, REACTOR_IN, &self->handler);
+
+    if(result != 0) {
+        close(self->socket);
+        self->socket = TEKON_INVALID_SOCKET;
+    }
+    return result;
+}
+
+void metrics_server_close(struct metrics_server * self)
+{
+    assert(self);
+
+    if(self->socket == TEKON_INVALID_SOCKET)
+        return;
+
+    size_t i;
+    for(i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        if(self->clients[i].socket != TEKON_INVALID_SOCKET)
+            client_drop(&self->clients[i]);
+    }
+
+    reactor_remove(&self->collector->reactor, self->socket);
+    close(self->socket);
+    self->socket = TEKON_INVALID_SOCKET;
+}
+
+#ifdef __cplusplus
+}
+#endif
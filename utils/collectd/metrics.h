@@ -0,0 +1,78 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_COLLECTD_METRICS_H
+#define UTILS_COLLECTD_METRICS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include "utils/base/reactor.h"
+#include "utils/base/wheel.h"
+#include "utils/collectd/collector.h"
+
+/* Макс. размер HTTP запроса. Остаток запроса не читается */
+#define METRICS_MAX_REQUEST 1024
+
+/* Время на обмен с клиентом HTTP, мс. Клиент, не успевший передать запрос
+ * и принять ответ, отключается */
+#define METRICS_CLIENT_TIMEOUT 1000
+
+/* Макс. кол-во одновременно обслуживаемых клиентов HTTP. Остальные
+ * подключения сразу закрываются */
+#define METRICS_MAX_CLIENTS 4
+
+/* Вывести счетчики и гистограммы задержек шлюзов в текстовом формате
+ * Prometheus (text/plain; version=0.0.4).
+ * В случае успеха вернет 0. Иначе - код ошибки */
+int metrics_print(const struct collector * collector, FILE * out);
+
+/* Записать метрики в файл атомарно: сначала во временный файл path.tmp,
+ * затем переименовать. Читатель никогда не увидит файл частично записанным.
+ * В случае успеха вернет 0. Иначе - код ошибки */
+int metrics_save(const struct collector * collector, const char * path);
+
+struct metrics_server;
+
+/* Подключение клиента HTTP. Сокет неблокирующий, чтение запроса и отправка
+ * ответа выполняются по готовности в цикле событий коллектора */
+struct metrics_client {
+    struct reactor_handler handler;
+    struct wheel_timer timer;
+    struct metrics_server * server;
+    socket_t socket;  /* TEKON_INVALID_SOCKET - место свободно */
+    char request[METRICS_MAX_REQUEST];
+    size_t received;
+    char * response;  /* заголовок и тело ответа. NULL - запрос еще читается */
+    size_t size;
+    size_t sent;
+};
+
+/* HTTP сервер метрик на локальном адресе. Работает в цикле событий
+ * коллектора и на любой GET /metrics (или GET /) отвечает текущими
+ * метриками. Медленный клиент не задерживает опрос шлюзов */
+struct metrics_server {
+    struct reactor_handler handler;
+    socket_t socket;
+    struct collector * collector;
+    struct metrics_client clients[METRICS_MAX_CLIENTS];
+    uint64_t scrapes; /* кол-во обслуженных запросов */
+    uint64_t dropped; /* клиенты, отключенные по таймауту или без места */
+};
+
+/* Начать прием подключений на 127.0.0.1:port.
+ * В случае успеха вернет 0. Иначе - код ошибки */
+int metrics_server_init(struct metrics_server * self, struct collector * collector, uint16_t port);
+
+void metrics_server_close(struct metrics_server * self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,287 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "test/minunit.h"
+#include "utils/collectd/collector.h"
+#include "utils/collectd/metrics.h"
+#include "utils/msr/test/group.h"
+#include "tekon/tekon.h"
+#include "utils/base/time.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define TEST_CYCLES  3
+
+struct cycles {
+    int done;
+    int failed;
+    int error;
+};
+
+static void on_cycle(struct collector * collector, const struct msr_group * group, int error)
+{
+    struct cycles * cycles = collector->data;
+    if(error) {
+        cycles->failed++;
+        cycles->error = error;
+    } else {
+        cycles->done++;
+    }
+}
+
+MU_TEST(test_repoll)
+{
+    const size_t nchunks = TEST_CHUNKS;
+    struct sim_responder responder;
+    struct msr_group group;
+    struct msr_table table;
+    struct collector collector;
+    struct cycles cycles = {0};
+    size_t i;
+
+    msr_table_init(&table);
+    mu_check(sim_responder_init(&responder, TEST_GATEWAY, 1, nchunks * TEST_CYCLES));
+    mu_check(add_group(&table, &group, &responder, 0));
+    mu_check(sim_responder_start(&responder));
+
+    mu_assert_int_eq(0, collector_init(&collector, &table, &group, 1, 100, 20, 1000, on_cycle));
+    collector.data = &cycles;
+    mu_assert_int_eq(0, collector_start(&collector));
+
+    for(i = 0; i < 100 && cycles.done < TEST_CYCLES; i++)
+        collector_poll(&collector, 10);
+
+    mu_assert_int_eq(TEST_CYCLES, cycles.done);
+    mu_assert_int_eq(0, cycles.failed);
+    /* Линк не закрывается между циклами */
+    mu_assert_int_eq(ALINK_IDLE, alink_state(&collector.gateways[0].session.link));
+    mu_assert_int_eq(TEST_CYCLES, collector.gateways[0].cycles);
+
+    for(i = 0; i < TEST_PARAMS; i++) {
+        const struct msr * msr = msr_table_get(&table, i);
+        mu_assert_int_eq(Q_OK, msr->qual);
+        mu_assert_int_eq(i, msr->value.u32);
+    }
+
+    /* Счетчики шлюза для метрик */
+    const struct collector_gateway * gw = &collector.gateways[0];
+    mu_assert_int_eq(nchunks * TEST_CYCLES, gw->session.requests);
+    mu_assert_int_eq(nchunks * TEST_CYCLES, gw->latency.count);
+    mu_assert_int_eq(0, gw->session.timeouts);
+    mu_assert_int_eq(0, gw->session.invalid);
+    mu_check(gw->session.tx_bytes > 0);
+    mu_check(gw->session.rx_bytes > 0);
+
+    char * text = NULL;
+    size_t size = 0;
+    char expect[128];
+    FILE * out = open_memstream(&text, &size);
+    mu_assert_int_eq(0, metrics_print(&collector, out));
+    fclose(out);
+
+    snprintf(expect, sizeof(expect), "tekon_requests_total{gateway=\"udp:127.0.0.1:%u@2\"} %u\n",
+             (unsigned)responder.port, (unsigned)(nchunks * TEST_CYCLES));
+    mu_check(strstr(text, expect) != NULL);
+    snprintf(expect, sizeof(expect), "tekon_request_duration_seconds_bucket{gateway=\"udp:127.0.0.1:%u@2\",le=\"10\"} %u\n",
+             (unsigned)responder.port, (unsigned)(nchunks * TEST_CYCLES));
+    mu_check(strstr(text, expect) != NULL);
+    mu_check(strstr(text, "# TYPE tekon_request_duration_seconds histogram\n") != NULL);
+    mu_check(strstr(text, "tekon_up{gateway=\"udp:127.0.0.1:") != NULL);
+    free(text);
+
+    collector_close(&collector);
+    sim_responder_close(&responder);
+}
+
+MU_TEST(test_corrupt)
+{
+    const size_t nchunks = TEST_CHUNKS;
+    struct sim_responder responder;
+    struct msr_group group;
+    struct msr_table table;
+    struct collector collector;
+    struct cycles cycles = {0};
+    size_t i;
+
+    /* Первый ответ с неверной КС запрашивается повторно без разрыва связи */
+    msr_table_init(&table);
+    mu_check(sim_responder_init(&responder, TEST_GATEWAY, 1, nchunks + 1));
+    mu_check(add_group(&table, &group, &responder, 0));
+    responder.corrupt = 1;
+    mu_check(sim_responder_start(&responder));
+
+    mu_assert_int_eq(0, collector_init(&collector, &table, &group, 1, 100, 1000, 1000, on_cycle));
+    collector.data = &cycles;
+    collector.retries = 1;
+    mu_assert_int_eq(0, collector_start(&collector));
+
+    for(i = 0; i < 100 && !cycles.done && !cycles.failed; i++)
+        collector_poll(&collector, 10);
+
+    const struct collector_gateway * gw = &collector.gateways[0];
+    mu_assert_int_eq(1, cycles.done);
+    mu_assert_int_eq(0, cycles.failed);
+    mu_assert_int_eq(ALINK_IDLE, alink_state(&gw->session.link));
+    mu_assert_int_eq(nchunks, gw->session.requests);
+    mu_assert_int_eq(1, gw->session.invalid);
+    mu_assert_int_eq(1, gw->session.resent);
+    mu_assert_int_eq(0, gw->session.timeouts);
+    mu_assert_int_eq(0, gw->failures);
+
+    for(i = 0; i < TEST_PARAMS; i++) {
+        const struct msr * msr = msr_table_get(&table, i);
+        mu_assert_int_eq(Q_OK, msr->qual);
+        mu_assert_int_eq(i, msr->value.u32);
+    }
+
+    collector_close(&collector);
+    sim_responder_close(&responder);
+}
+
+MU_TEST(test_backoff)
+{
+    struct sim_responder silent;
+    struct msr_group group;
+    struct msr_table table;
+    struct collector collector;
+    struct cycles cycles = {0};
+    size_t i;
+
+    msr_table_init(&table);
+    mu_check(sim_responder_init(&silent, TEST_GATEWAY, 1, 0));
+    mu_check(add_group(&table, &group, &silent, 0));
+
+    mu_assert_int_eq(0, collector_init(&collector, &table, &group, 1, 20, 10, 40, on_cycle));
+    collector.data = &cycles;
+    mu_assert_int_eq(0, collector_start(&collector));
+
+    struct collector_gateway * gw = &collector.gateways[0];
+    uint32_t backoff[3];
+    for(i = 0; i < 3; i++) {
+        const int failed = cycles.failed;
+        int j;
+        for(j = 0; j < 100 && cycles.failed == failed; j++)
+            collector_poll(&collector, 10);
+        backoff[i] = gw->backoff;
+    }
+
+    mu_assert_int_eq(3, cycles.failed);
+    mu_assert_int_eq(-ETIMEDOUT, cycles.error);
+    mu_assert_int_eq(ALINK_DOWN, alink_state(&gw->session.link));
+    mu_assert_int_eq(10, backoff[0]);
+    mu_assert_int_eq(20, backoff[1]);
+    mu_assert_int_eq(40, backoff[2]);
+    mu_assert_int_eq(Q_NOCONN, msr_table_get(&table, 0)->qual);
+    mu_assert_int_eq(3, gw->session.timeouts);
+    mu_assert_int_eq(3, gw->failures);
+    mu_assert_int_eq(0, gw->latency.count);
+
+    collector_close(&collector);
+    sim_responder_close(&silent);
+}
+
+/* Подключиться к серверу метрик */
+static int connect_metrics(const struct metrics_server * server)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+
+    const int client = socket(AF_INET, SOCK_STREAM, 0);
+    if(client < 0)
+        return -1;
+    if(getsockname(server->socket, (struct sockaddr *)&addr, &len) != 0 ||
+            connect(client, (struct sockaddr *)&addr, len) != 0) {
+        close(client);
+        return -1;
+    }
+    return client;
+}
+
+MU_TEST(test_metrics_server)
+{
+    struct sim_responder silent;
+    struct msr_group group;
+    struct msr_table table;
+    struct collector collector;
+    struct metrics_server server;
+    struct cycles cycles = {0};
+    char reply[4096];
+    size_t received = 0;
+    ssize_t len = 0;
+    int i;
+
+    msr_table_init(&table);
+    mu_check(sim_responder_init(&silent, TEST_GATEWAY, 1, 0));
+    mu_check(add_group(&table, &group, &silent, 0));
+    mu_assert_int_eq(0, collector_init(&collector, &table, &group, 1, 100, 1000, 1000, on_cycle));
+    collector.data = &cycles;
+    mu_assert_int_eq(0, metrics_server_init(&server, &collector, 0));
+
+    /* Клиент, не передающий запрос, не задерживает остальных */
+    const int idle = connect_metrics(&server);
+    const int client = connect_metrics(&server);
+    mu_check(idle >= 0);
+    mu_check(client >= 0);
+    const char * request = "GET /metrics HTTP/1.0\r\n\r\n";
+    mu_assert_int_eq(strlen(request), send(client, request, strlen(request), 0));
+
+    const int64_t start = time_monotonic_ms();
+    for(i = 0; i < 100; i++) {
+        collector_poll(&collector, 10);
+        len = recv(client, reply + received, sizeof(reply) - 1 - received, MSG_DONTWAIT);
+        if(len == 0 || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+            break;
+        if(len > 0)
+            received += len;
+    }
+    reply[received] = 0;
+
+    mu_assert_int_eq(0, len);
+    mu_check(time_monotonic_ms() - start < METRICS_CLIENT_TIMEOUT);
+    mu_check(strncmp(reply, "HTTP/1.0 200 OK\r\n", 17) == 0);
+    mu_check(strstr(reply, "tekon_up{gateway=\"udp:127.0.0.1:") != NULL);
+    mu_assert_int_eq(1, server.scrapes);
+    mu_assert_int_eq(0, server.dropped);
+    close(client);
+
+    /* Молчащий клиент отключается по таймауту */
+    for(i = 0; i < 200 && !server.dropped; i++)
+        collector_poll(&collector, 10);
+    mu_assert_int_eq(1, server.dropped);
+    mu_assert_int_eq(0, recv(idle, reply, sizeof(reply), 0));
+    close(idle);
+
+    metrics_server_close(&server);
+    collector_close(&collector);
+    sim_responder_close(&silent);
+}
+
+MU_TEST_SUITE(suite_collector)
+{
+    MU_RUN_TEST(test_repoll);
+    MU_RUN_TEST(test_corrupt);
+    MU_RUN_TEST(test_backoff);
+    MU_RUN_TEST(test_metrics_server);
+}
+
+int main()
+{
+    MU_RUN_SUITE(suite_collector);
+    MU_REPORT();
+    return mu_get_fails();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,6 +8,7 @@ extern "C" {
 #endif
 
 #include <assert.h>
+#include <ctype.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -19,18 +20,31 @@ extern "C" {
 #include "utils/msr/msr.h"
 #include "tekon/tekon.h"
 
+#if defined(__linux__)
+#include "utils/msr/poller.h"
+#endif
+
 #define APP_NAME "tekon_msr"
 #define APP_ERR  LOG_ERR  APP_NAME " : ERR"
 #define APP_WARN LOG_WARN APP_NAME " : WARN"
 #define APP_INFO LOG_INFO APP_NAME " : INFO"
 
+/* Макс. кол-во повторов запроса */
+#define APP_MAX_RETRIES 10
+
 
 struct app {
-    struct netaddr netcfg;
+    struct msr_group groups[MEASURMENT_MAX_GATEWAYS];
+    size_t ngroups;
     struct msr_table table;
     struct link link;
+    struct pipeline pipeline;
     int tzoffset;
     int timeout;
+    struct rttcfg rtt;
+    int retries;
+    int window;
+    struct diag diag;
 };
 
 /* Установить записи качество Q_NOCONN и обновить метку времени */
@@ -50,12 +64,17 @@ static void init(struct app * self)
     msr_table_init(&self->table);
     self->tzoffset = time_tzoffset();
     self->timeout = 1000;
+    self->window = 1;
+    diag_init(&self->diag, APP_NAME);
 }
 
 static void usage()
 {
-    printf("Usage: %s -a address -p parameters [-t timeout] [-v verbosity]\n\n", APP_NAME);
-    printf("  -a    gateway's address in [type:ip:port@gateway] format.\n\n");
+    printf("Usage: %s -a address -p parameters [-a address -p parameters ...] [-t timeout] [-T min:max] [-r retries] [-w window] [--stats] [-v verbosity]\n", APP_NAME);
+    printf("                [--capture file] [--replay file [--speed N]] [--fault spec] [--trace file]\n\n");
+    printf("  -a    gateway's address in [type:ip:port@gateway] format.\n");
+    printf("        Several gateways could be set. Each -a is followed by its own -p.\n");
+    printf("        Gateways are polled simultaneously.\n\n");
     printf("  -p    list of parameters in [device:parameter:index:type] format.\n");
     printf("        type: \n");
     printf("            F - 32-bit float\n");
@@ -66,6 +85,13 @@ static void usage()
     printf("            D - date\n");
     printf("            T - time\n\n");
     printf("  -t    response timeout in milliseconds.\n\n");
+    printf("  -T    adaptive response timeout bounds in [min:max] format, ms.\n");
+    printf("        Timeout follows measured round-trip time. -t sets initial value.\n\n");
+    printf("  -r    number of retries of a failed request [0, %d]. Default is 0.\n\n", APP_MAX_RETRIES);
+    printf("  -w    number of requests in flight [1, %d]. Default is 1.\n", PIPELINE_MAX_WINDOW);
+    printf("        Several gateways are polled with one request in flight each (Linux),\n");
+    printf("        so a window above 1 requires a single gateway.\n\n");
+    diag_usage(stdout, 1);
     printf("  -v    set verbose:\n");
     printf("        0 - silent \n");
     printf("        1 - error\n");
@@ -73,147 +99,167 @@ static void usage()
     printf("        3 - info \n\n");
     printf("Example:\n");
     printf("  %s -a udp:10.0.0.3:51960@2 -p '3:0xF001:0:R 3:0x8003:0:F 3:0xF017:0:D 3:0xF018:0:T'\n", APP_NAME);
+    printf("  %s -a udp:10.0.0.3:51960@2 -p '3:0x8003:0:F' -a udp:10.0.0.4:51960@2 -p '3:0x8003:0:F'\n", APP_NAME);
 }
 
-/* Запрос-ответ
- * 0 - в случае ошибки */
-static int process_request(const struct message * request, struct message * response, struct link * link)
-{
-    assert(request);
-    assert(response);
-    assert(link);
+/* Группа измерений, читаемая через конвейер */
+struct chunk_ctx {
+    struct msr_table * table;
+    const struct msr_group * group;
+    int64_t timestamp; /* время получения текущего ответа */
+};
 
-    char in[512];
-    char out[512];
+/* Размер порции группы, начинающейся с позиции pos */
+static size_t chunk_size(size_t pos, size_t lim)
+{
+    const size_t diff = lim - pos;
+    return diff > TEKON_PROTO_PLIST_SIZE ? TEKON_PROTO_PLIST_SIZE : diff;
+}
 
-    uint8_t nin = 0;
-    static uint8_t nout = 0;
-    nout = (nout + 1) % 16;
+/* Подготовить запрос на чтение порции группы
+ * 0 - в случае ошибки */
+static int prepare_chunk(void * ctx, size_t index, struct message * request)
+{
+    const struct chunk_ctx * chunk = ctx;
+    const size_t pos = index * TEKON_PROTO_PLIST_SIZE;
+    const size_t size = chunk_size(pos, chunk->group->count);
+    const struct msr * msr = msr_table_get(chunk->table, chunk->group->first + pos);
 
-    int result = tekon_req_pack(out, sizeof(out), request, nout);
+    int result = msr_request(request, msr, size);
 
-    if(result <= 0) {
-        log_print(APP_ERR " : packing error\n");
-        return 0;
-    }
+    if(!result)
+        log_print(APP_ERR " : can't create request\n");
 
-    result = link_send(link, out, result);
-    if(result <= 0) {
-        log_print(APP_ERR " : sending error %d\n", result);
-        return 0;
-    }
+    return result;
+}
 
-    result = link_recv(link, in, sizeof(in));
-    if(result <= 0) {
-        log_print(APP_ERR " : receiving error %d\n", result);
-        return 0;
-    }
+/* Записать значение ответа прямо в измерение порции */
+static void sink_chunk(void * ctx, size_t index, size_t element, uint32_t value, uint8_t qual)
+{
+    struct chunk_ctx * chunk = ctx;
+    const size_t pos = index * TEKON_PROTO_PLIST_SIZE;
+    struct msr * msr = msr_table_get(chunk->table, chunk->group->first + pos + element);
 
-    result = tekon_resp_unpack(in, result, response, request->type, &nin);
+    if(element == 0)
+        chunk->timestamp = time_now_utc();
+    msr_update(msr, qual == 0 ? Q_OK : Q_INVALID, chunk->timestamp, &value, sizeof(value));
+}
 
-    if(result <= 0) {
-        log_print(APP_ERR " : unpacking error\n");
-        return 0;
-    }
+/* Завершить порцию группы. Значения уже записаны sink_chunk, в случае
+ * ошибки (response == NULL) порция получает признак ошибки связи */
+static void complete_chunk(void * ctx, size_t index, const struct message * response)
+{
+    const struct chunk_ctx * chunk = ctx;
+    const size_t pos = index * TEKON_PROTO_PLIST_SIZE;
+    const size_t size = chunk_size(pos, chunk->group->count);
 
-    return nin == nout && request->nelements == response->nelements;
+    if(!response)
+        msr_response(msr_table_get(chunk->table, chunk->group->first + pos), size, NULL, time_now_utc());
 }
 
-/* Прочитать набор параметров
+/* Прочитать данные одного шлюза
  * 0 - в случае ошибки */
-static int read_multiple(struct msr * msr, size_t size, struct link * link)
+static int read_group(struct app * app, const struct msr_group * group)
 {
-    assert(size <= TEKON_PROTO_PLIST_SIZE);
+    assert(app);
+    assert(group);
+    struct link * link = &app->link;
+    const struct netaddr * addr = &group->addr;
+    const size_t nchunks = (group->count + TEKON_PROTO_PLIST_SIZE - 1) / TEKON_PROTO_PLIST_SIZE;
+    struct chunk_ctx ctx = {&app->table, group, TIME_INVALID};
 
-    uint8_t gateway = msr->gateway;
-    uint8_t devices[TEKON_PROTO_PLIST_SIZE];
-    uint16_t addresses[TEKON_PROTO_PLIST_SIZE];
-    uint16_t indexes[TEKON_PROTO_PLIST_SIZE];
+    if(addr->type == LINK_TCP)
+        link_init_tcp(link, addr->ip, addr->port, app->timeout);
+    else if(addr->type == LINK_UDP)
+        link_init_udp(link, addr->ip, addr->port, app->timeout);
 
-    struct message msg_in;
-    struct message msg_out;
+    if(app->rtt.max)
+        rtt_init(&link->rtt, app->timeout, app->rtt.min, app->rtt.max);
 
-    size_t i;
-    int64_t tstamp = TIME_INVALID;
+    diag_attach(&app->diag, link);
+    int result = link_up(link);
 
-    for(i = 0; i < size; i++) {
-        devices[i] = msr[i].device;
-        addresses[i] = msr[i].address;
-        indexes[i] = msr[i].index;
+    if(result != 0) {
+        log_print(APP_ERR " : %s:%"PRIu16" connecting error %d\n", addr->ip, addr->port, result);
+        return 0;
     }
 
-    int result = tekon_req_1c(&msg_out, gateway, devices, addresses, indexes, size);
+    /* Группа читается порциями по TEKON_PROTO_PLIST_SIZE параметров. В сети
+     * одновременно может находиться до window запросов. Если порция была
+     * прочитана с ошибкой, то остальные порции не запрашиваются и остаются
+     * с ошибкой связи. */
+    pipeline_init(&app->pipeline, link, app->window);
+    app->pipeline.retries = app->retries;
+    app->pipeline.stats = diag_stats(&app->diag);
+    const size_t done = pipeline_run_sink(&app->pipeline, nchunks, prepare_chunk, sink_chunk, complete_chunk, &ctx);
+    link_down(link);
+
+    if(link->stat.discarded)
+        log_print(APP_WARN " : %s:%"PRIu16" discarded replies %"PRIu64"\n", addr->ip, addr->port, link->stat.discarded);
 
-    if(!result) {
-        log_print(APP_NAME " : can't create request\n");
+    if(done != nchunks) {
+        log_print(APP_ERR " : %s:%"PRIu16" exchange error %d\n", addr->ip, addr->port, app->pipeline.error);
         return 0;
     }
+    return 1;
+}
 
-    result = process_request(&msg_out, &msg_in, link);
+#if defined(__linux__)
+/* Опросить все шлюзы одновременно
+ * 0 - в случае ошибки */
+static int read_groups(struct app * app)
+{
+    struct poller poller;
 
-    const struct tekon_parameter * param = msg_in.payload.parameters;
-    tstamp = time_now_utc();
+    int result = poller_init(&poller, &app->table, app->groups, app->ngroups, app->timeout);
+    if(result != 0) {
+        log_print(APP_ERR " : poller error %d\n", result);
+        return 0;
+    }
 
-    for(i = 0; i < size; i++, param++) {
-        const uint32_t * value = NULL;
-        enum quality qual = Q_NOCONN;
-        size_t len = 0;
-        if(result > 0 ) {
-            value = &param->value;
-            qual = param->qual == 0 ? Q_OK : Q_INVALID;
-            len = 4;
-        }
-        msr_update(msr + i, qual, tstamp,
-                   value, len);
+    poller.rtt = app->rtt;
+    poller.retries = app->retries;
+    poller.stats = diag_stats(&app->diag);
+
+    const size_t done = poller_run(&poller);
+
+    size_t i;
+    for(i = 0; i < app->ngroups; i++) {
+        const struct poller_gateway * gw = &poller.gateways[i];
+        if(gw->error != 0)
+            log_print(APP_ERR " : %s:%"PRIu16" exchange error %d\n", gw->session.group->addr.ip, gw->session.group->addr.port, gw->error);
     }
+
+    poller_close(&poller);
+    return done == app->ngroups;
+}
+#else
+/* Опросить шлюзы последовательно
+ * 0 - в случае ошибки */
+static int read_groups(struct app * app)
+{
+    int result = 1;
+    size_t i;
+    for(i = 0; i < app->ngroups; i++)
+        result &= read_group(app, &app->groups[i]);
     return result;
 }
+#endif
 
-/* Прочитать данные из устройства
+/* Прочитать данные из устройств
  * 0 - в случае ошибки */
 static int read_data(struct app * app)
 {
     assert(app);
-    struct msr_table * table = &app->table;
-    struct link * link = &app->link;
-    const struct netaddr * addr = &app->netcfg;
-    const size_t lim = msr_table_size(table);
-    size_t pos = 0;
-
-    if(addr->type == LINK_TCP)
-        link_init_tcp(link, addr->ip, addr->port, app->timeout);
-    else if(addr->type == LINK_UDP)
-        link_init_udp(link, addr->ip, addr->port, app->timeout);
-
-    int result = link_up(link);
 
     int64_t now = time_now_utc();
-    msr_table_foreach(table, apply_noconn, &now);
-
-    if(result != 0) {
-        log_print(APP_ERR " : connecting error %d\n", result);
-        return 0;
-    }
-
-    while(pos < lim) {
-        const size_t diff = lim - pos;
-        const size_t chunk = diff == 1 ? 1 :
-                             diff > TEKON_PROTO_PLIST_SIZE ? TEKON_PROTO_PLIST_SIZE :
-                             diff;
+    msr_table_foreach(&app->table, apply_noconn, &now);
 
-
-        /* Если порция данных была прочитана с ошибкой, то нет смысла читать
-         остальные. Просто стивим всем оставшимся ошибку связи. Чтобы
-         сделать это с минимальным трудом, кладем коннект и пытаемся
-         вычитать данные на отключенном линке. */
-        if(!read_multiple(msr_table_get(table, pos), chunk, link)) {
-            link_down(link);
-            return 0;
-        }
-        pos += chunk;
-    }
-    link_down(link);
-    return 1;
+    /* Один шлюз опрашивается через конвейер, несколько - одновременно, каждый
+     * в своем сеансе */
+    return app->ngroups == 1 ?
+           read_group(app, &app->groups[0]) :
+           read_groups(app);
 }
 
 /* Прочитать аргусенты командной строки
@@ -226,10 +272,10 @@ static int read_args(struct app * app, int argc, char * const argv[])
         return 0;
 
     int opt;
-    uint8_t gateway = 0;
+    struct msr_group * group = NULL;
     struct paraddr param;
 
-    while ((opt = getopt(argc, argv, "t:a:p:v:")) != -1) {
+    while ((opt = getopt_long(argc, argv, "t:T:a:p:r:v:w:", diag_options, NULL)) != -1) {
         switch (opt) {
         case 't': {
             long input  = atol(optarg);
@@ -241,8 +287,18 @@ static int read_args(struct app * app, int argc, char * const argv[])
             }
         }
         break;
+        case 'w': {
+            long input  = atol(optarg);
+            if(input <= 0 || input > PIPELINE_MAX_WINDOW) {
+                printf("invalid window %s\n\n", optarg);
+                return 0;
+            } else {
+                app->window = (int)input;
+            }
+        }
+        break;
         case 'p': {
-            if(gateway == 0) {
+            if(group == NULL) {
                 printf("enter address before parameters list\n\n");
                 return 0;
             }
@@ -256,42 +312,90 @@ static int read_args(struct app * app, int argc, char * const argv[])
                     return 0;
                 } else {
                     struct msr msr;
-                    msr_init(&msr, gateway, param.device, param.address, param.index, param.type, param.hex);
+                    msr_init(&msr, group->addr.gateway, param.device, param.address, param.index, param.type, param.hex);
                     if(!msr_table_add(&app->table, &msr)) {
                         printf("measurments overflow. Limit is %d\n\n", MEASURMENT_MAX_TABLE_SIZE);
                         return 0;
                     }
+                    group->count++;
                 }
             }
         }
         break;
         case 'a':
-            if(!netaddr_from_string(&app->netcfg, optarg)) {
+            if(app->ngroups == MEASURMENT_MAX_GATEWAYS) {
+                printf("gateways overflow. Limit is %d\n\n", MEASURMENT_MAX_GATEWAYS);
+                return 0;
+            }
+            group = &app->groups[app->ngroups];
+            if(!netaddr_from_string(&group->addr, optarg)) {
                 printf("invalid network address %s\n\n", optarg);
                 return 0;
             }
-            gateway = app->netcfg.gateway;
+            group->first = msr_table_size(&app->table);
+            group->count = 0;
+            app->ngroups++;
+            break;
+        case 'T':
+            if(!rttcfg_from_string(&app->rtt, optarg)) {
+                printf("invalid timeout bounds %s\n\n", optarg);
+                return 0;
+            }
             break;
+        case 'r': {
+            long input  = atol(optarg);
+            if(input < 0 || input > APP_MAX_RETRIES || !isdigit((unsigned char)*optarg)) {
+                printf("invalid retries %s\n\n", optarg);
+                return 0;
+            } else {
+                app->retries = (int)input;
+            }
+        }
+        break;
         case 'v':
             log_setlevel(atoi(optarg));
             break;
-        default: /* '?' */
-            printf("invalid argument %c\n\n", opt);
-            return 0;
+        default: {
+            /* Опции диагностики обмена или '?' */
+            const int result = diag_option(&app->diag, opt, optarg);
+            if(result < 0)
+                printf("invalid argument %c\n\n", opt);
+            if(result <= 0)
+                return 0;
+        }
+        break;
         }
     }
 
     /* Адрес не задан */
-    if(app->netcfg.port == 0) {
+    if(app->ngroups == 0) {
         printf("please enter gateway's address\n\n");
         return 0;
     }
 
-    /* Параметры не заданы */
-    if(msr_table_size(&app->table) == 0) {
-        printf("please enter parameters to read\n\n");
+    /* Захват и искажения работают на линке одного шлюза */
+    if(app->ngroups > 1 && diag_link_used(&app->diag)) {
+        printf("capture, replay and fault injection support a single gateway only\n\n");
+        return 0;
+    }
+
+#if defined(__linux__)
+    /* Одновременный опрос держит в сети один запрос на шлюз, окно не
+     * поддерживается */
+    if(app->ngroups > 1 && app->window > 1) {
+        printf("window above 1 supports a single gateway only\n\n");
         return 0;
     }
+#endif
+
+    /* Параметры не заданы */
+    size_t i;
+    for(i = 0; i < app->ngroups; i++) {
+        if(app->groups[i].count == 0) {
+            printf("please enter parameters to read from %s\n\n", app->groups[i].addr.ip);
+            return 0;
+        }
+    }
 
     return 1;
 }
@@ -302,100 +406,9 @@ void print(struct msr * self, void * data)
     assert(data);
 
     const struct app * app = data;
-    char buffer[512] = {0};
-    size_t remain = sizeof(buffer);
-    char * ptr = buffer;
-
-    /* Добавить адрес шлюза */
-    int result = snprintf(ptr, remain, "%"PRIu8":",self->gateway);
-    assert(result > 0);
-    ptr += result;
-    remain -= result;
-
-    /* Добавить адрес устройства */
-    result = snprintf(ptr, remain, "%"PRIu8":",self->device);
-    assert(result > 0);
-    ptr += result;
-    remain -= result;
-
-    /* Добавить адрес параметра */
-    result = self->hex ?
-             snprintf(ptr, remain, "0x%x:", self->address) :
-             snprintf(ptr, remain, "%"PRIu16":", self->address);
-    assert(result > 0);
-    ptr += result;
-    remain -= result;
-
-    result = snprintf(ptr, remain, "%"PRIu16" ", self->index);
-    assert(result > 0);
-    ptr += result;
-    remain -= result;
-
-
-    /* Добавить значение */
-    switch(self->type) {
-    case TEKON_PARAM_RAW:
-        result = snprintf(ptr, remain, "R 0x%02x%02x%02x%02x ",self->value.byte[0], self->value.byte[1], self->value.byte[2], self->value.byte[3]);
-        break;
-    case TEKON_PARAM_HEX:
-        result = snprintf(ptr, remain, "H 0x%x ",self->value.u32);
-        break;
-    case TEKON_PARAM_U32:
-        result = snprintf(ptr, remain, "U %"PRIu32" ",self->value.u32);
-        break;
-    case TEKON_PARAM_F32:
-        result = snprintf(ptr, remain, "F %f ",self->value.f32);
-        break;
-    case TEKON_PARAM_BOOL:
-        result = snprintf(ptr, remain, "B %s ",self->value.u32 > 0 ? "TRUE" : "FALSE");
-        break;
-    case TEKON_PARAM_TIME: {
-        struct tekon_time tt;
-        tekon_time_unpack(&tt, &self->value.u32, sizeof(self->value.u32));
-        result = snprintf(ptr, remain, "T %02d:%02d:%02d ", tt.hour, tt.minute, tt.second);
-    }
-    break;
-    case TEKON_PARAM_DATE: {
-        struct tekon_date td;
-        tekon_date_unpack(&td, &self->value.u32, sizeof(self->value.u32));
-        result = snprintf(ptr, remain, "D %d-%02d-%02d ", td.year + 2000, td.month, td.day);
-    }
-    break;
-    }
-    assert(result > 0);
-    ptr += result;
-    remain -= result;
-
-    /* Добавить качество */
-    switch(self->qual) {
-    case Q_INVALID:
-        result = snprintf(ptr, remain, "INV ");
-        break;
-    case Q_NOCONN:
-        result = snprintf(ptr, remain, "COM ");
-        break;
-    case Q_UNK:
-        result = snprintf(ptr, remain, "UNK ");
-        break;
-    case Q_OK:
-        result = snprintf(ptr, remain, "OK ");
-        break;
-    }
-    assert(result > 0);
-    ptr += result;
-    remain -= result;
-
-    /* Добавить метку времени */
-    result = snprintf(ptr, remain, "%"PRIi64" ", self->timestamp);
-    assert(result > 0);
-    ptr += result;
-    remain -= result;
+    char buffer[MEASURMENT_MAX_STRING];
 
-    /* Добавить информацию о сдвиге часового пояса */
-    result = snprintf(ptr, remain, "%"PRIi32, app->tzoffset);
-    assert(result > 0);
-
-    /* Вывести */
+    msr_to_string(self, app->tzoffset, buffer, sizeof(buffer));
     printf("%s\n", buffer);
 }
 
@@ -407,7 +420,7 @@ static void sigint(int sig)
 int main(int argc, char * argv[])
 {
 
-    struct app app;
+    static struct app app;
 
     init(&app);
 
@@ -418,8 +431,18 @@ int main(int argc, char * argv[])
         return 1;
     }
 
+    if(diag_open(&app.diag) != 0)
+        return 1;
+
+    TEKON_TRACE_BEGIN(TEKON_TRACE_CYCLE);
     int result = read_data(&app);
+    TEKON_TRACE_END(TEKON_TRACE_CYCLE, result);
+    diag_close(&app.diag);
     msr_table_foreach(&app.table, print, &app);
+
+    /* Счетчики линка есть только при опросе одного шлюза */
+    diag_print(&app.diag, app.ngroups == 1 ? &app.link.stat : NULL, stderr);
+
     return result == 0;
 
 }
@@ -9,7 +9,10 @@ extern "C" {
 
 #include "utils/msr/msr.h"
 #include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
 #include <string.h>
+#include "tekon/time.h"
 #include "utils/base/time.h"
 
 void msr_init(struct msr * self, uint8_t gateway, uint8_t device, uint16_t address, uint16_t index, enum tekon_parameter_type type, char hex)
@@ -39,6 +42,180 @@ void msr_update(struct msr * self, enum quality qual, int64_t timestamp, const v
     }
 }
 
+int msr_request(struct message * request, const struct msr * msr, size_t size)
+{
+    assert(request);
+    assert(msr);
+
+    if(size == 0 || size > TEKON_PROTO_PLIST_SIZE)
+        return 0;
+
+    uint8_t devices[TEKON_PROTO_PLIST_SIZE];
+    uint16_t addresses[TEKON_PROTO_PLIST_SIZE];
+    uint16_t indexes[TEKON_PROTO_PLIST_SIZE];
+
+    size_t i;
+    for(i = 0; i < size; i++) {
+        devices[i] = msr[i].device;
+        addresses[i] = msr[i].address;
+        indexes[i] = msr[i].index;
+    }
+
+    return tekon_req_1c(request, msr->gateway, devices, addresses, indexes, size);
+}
+
+int msr_request_soa(struct message_soa * request, const struct msr * msr, size_t size)
+{
+    assert(request);
+    assert(msr);
+
+    if(size == 0 || size > TEKON_PROTO_PLIST_SIZE ||
+            msr->gateway == TEKON_INVALID_DEV_ADDR)
+        return 0;
+
+    size_t i;
+    for(i = 0; i < size; i++) {
+        if(msr[i].device == TEKON_INVALID_DEV_ADDR)
+            return 0;
+        request->devices[i] = msr[i].device;
+        request->addresses[i] = msr[i].address;
+        request->indexes[i] = msr[i].index;
+    }
+
+    request->gateway = msr->gateway;
+    request->dir = TEKON_DIR_OUT;
+    request->type = TEKON_MSG_READEM_PAR_LIST_1C;
+    request->nelements = size;
+    return 1;
+}
+
+void msr_response(struct msr * msr, size_t size, const struct message * response, int64_t timestamp)
+{
+    assert(msr);
+
+    size_t i;
+    for(i = 0; i < size; i++) {
+        const uint32_t * value = NULL;
+        enum quality qual = Q_NOCONN;
+        size_t len = 0;
+        if(response) {
+            const struct tekon_parameter * param = &response->payload.parameters[i];
+            value = &param->value;
+            qual = param->qual == 0 ? Q_OK : Q_INVALID;
+            len = 4;
+        }
+        msr_update(msr + i, qual, timestamp,
+                   value, len);
+    }
+}
+
+void msr_sink_value(void * ctx, size_t index, uint32_t value, uint8_t qual)
+{
+    const struct msr_sink * sink = ctx;
+    assert(sink);
+    msr_update(sink->msr + index, qual == 0 ? Q_OK : Q_INVALID, sink->timestamp, &value, sizeof(value));
+}
+
+int msr_to_string(const struct msr * self, int32_t tzoffset, char * buffer, size_t size)
+{
+    assert(self);
+    assert(buffer);
+    assert(size >= MEASURMENT_MAX_STRING);
+
+    size_t remain = size;
+    char * ptr = buffer;
+
+    /* Добавить адрес шлюза */
+    int result = snprintf(ptr, remain, "%"PRIu8":",self->gateway);
+    assert(result > 0);
+    ptr += result;
+    remain -= result;
+
+    /* Добавить адрес устройства */
+    result = snprintf(ptr, remain, "%"PRIu8":",self->device);
+    assert(result > 0);
+    ptr += result;
+    remain -= result;
+
+    /* Добавить адрес параметра */
+    result = self->hex ?
+             snprintf(ptr, remain, "0x%x:", self->address) :
+             snprintf(ptr, remain, "%"PRIu16":", self->address);
+    assert(result > 0);
+    ptr += result;
+    remain -= result;
+
+    result = snprintf(ptr, remain, "%"PRIu16" ", self->index);
+    assert(result > 0);
+    ptr += result;
+    remain -= result;
+
+
+    /* Добавить значение */
+    switch(self->type) {
+    case TEKON_PARAM_RAW:
+        result = snprintf(ptr, remain, "R 0x%02x%02x%02x%02x ",self->value.byte[0], self->value.byte[1], self->value.byte[2], self->value.byte[3]);
+        break;
+    case TEKON_PARAM_HEX:
+        result = snprintf(ptr, remain, "H 0x%x ",self->value.u32);
+        break;
+    case TEKON_PARAM_U32:
+        result = snprintf(ptr, remain, "U %"PRIu32" ",self->value.u32);
+        break;
+    case TEKON_PARAM_F32:
+        result = snprintf(ptr, remain, "F %f ",self->value.f32);
+        break;
+    case TEKON_PARAM_BOOL:
+        result = snprintf(ptr, remain, "B %s ",self->value.u32 > 0 ? "TRUE" : "FALSE");
+        break;
+    case TEKON_PARAM_TIME: {
+        struct tekon_time tt;
+        tekon_time_unpack(&tt, &self->value.u32, sizeof(self->value.u32));
+        result = snprintf(ptr, remain, "T %02d:%02d:%02d ", tt.hour, tt.minute, tt.second);
+    }
+    break;
+    case TEKON_PARAM_DATE: {
+        struct tekon_date td;
+        tekon_date_unpack(&td, &self->value.u32, sizeof(self->value.u32));
+        result = snprintf(ptr, remain, "D %d-%02d-%02d ", td.year + 2000, td.month, td.day);
+    }
+    break;
+    }
+    assert(result > 0);
+    ptr += result;
+    remain -= result;
+
+    /* Добавить качество */
+    switch(self->qual) {
+    case Q_INVALID:
+        result = snprintf(ptr, remain, "INV ");
+        break;
+    case Q_NOCONN:
+        result = snprintf(ptr, remain, "COM ");
+        break;
+    case Q_UNK:
+        result = snprintf(ptr, remain, "UNK ");
+        break;
+    case Q_OK:
+        result = snprintf(ptr, remain, "OK ");
+        break;
+    }
+    assert(result > 0);
+    ptr += result;
+    remain -= result;
+
+    /* Добавить метку времени */
+    result = snprintf(ptr, remain, "%"PRIi64" ", self->timestamp);
+    assert(result > 0);
+    ptr += result;
+    remain -= result;
+
+    /* Добавить информацию о сдвиге часового пояса */
+    result = snprintf(ptr, remain, "%"PRIi32, tzoffset);
+    assert(result > 0);
+
+    return (int)(ptr - buffer) + result;
+}
 
 void msr_table_init(struct msr_table * self)
 {
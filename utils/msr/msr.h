@@ -12,11 +12,18 @@ extern "C" {
 
 #include <stdint.h>
 #include "tekon/proto.h"
+#include "tekon/message.h"
 #include "utils/base/types.h"
 
 /* Макс. кол-вол измерений, которое может быть запрошено
- * за один сеанс. */
-#define MEASURMENT_MAX_TABLE_SIZE 1024
+ * за один сеанс (со всех шлюзов). */
+#define MEASURMENT_MAX_TABLE_SIZE 16384
+
+/* Макс. кол-во шлюзов, опрашиваемых за один сеанс */
+#define MEASURMENT_MAX_GATEWAYS 512
+
+/* Макс. длина текстового представления измерения */
+#define MEASURMENT_MAX_STRING 128
 
 struct msr {
     uint8_t gateway;
@@ -38,6 +45,35 @@ void msr_init(struct msr * self, uint8_t gateway, uint8_t device, uint16_t addre
 
 void msr_update(struct msr * self, enum quality qual, int64_t timestamp, const void * data, size_t size);
 
+/* Сформировать запрос 0x1C на чтение size измерений одного шлюза
+ * 1 - успешно
+ * 0 - ошибка */
+int msr_request(struct message * request, const struct msr * msr, size_t size);
+
+/* То же в компактном представлении: поля измерений копируются прямо в
+ * массивы запроса */
+int msr_request_soa(struct message_soa * request, const struct msr * msr, size_t size);
+
+/* Обновить size измерений по ответу на запрос msr_request.
+ * response == NULL - ошибка связи */
+void msr_response(struct msr * msr, size_t size, const struct message * response, int64_t timestamp);
+
+/* Приемник значений ответа на запрос msr_request для
+ * tekon_resp_unpack_sink: значения записываются прямо в измерения */
+struct msr_sink {
+    struct msr * msr;  /* первое измерение порции */
+    int64_t timestamp;
+};
+
+/* tekon_sink_fn, ctx - struct msr_sink */
+void msr_sink_value(void * ctx, size_t index, uint32_t value, uint8_t qual);
+
+/* Текстовое представление измерения
+ * gateway:device:address:index type value quality timestamp tzoffset
+ * Буфер должен вмещать не менее MEASURMENT_MAX_STRING символов.
+ * Возвращает длину строки */
+int msr_to_string(const struct msr * self, int32_t tzoffset, char * buffer, size_t size);
+
 
 struct msr_table {
     struct msr msr[MEASURMENT_MAX_TABLE_SIZE];
@@ -56,6 +92,14 @@ size_t msr_table_size(const struct msr_table * self);
 
 void msr_table_foreach(struct msr_table * self, void (*visitor)(struct msr * msr, void * data), void * data);
 
+/* Группа измерений одного шлюза. Измерения группы занимают непрерывный
+ * участок таблицы [first, first + count) */
+struct msr_group {
+    struct netaddr addr;
+    size_t first;
+    size_t count;
+};
+
 #ifdef __cplusplus
 }
 #endif
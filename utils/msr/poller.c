@@ -0,0 +1,113 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/msr/poller.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Завершить опрос шлюза */
+static void finish(struct poller_gateway * self, int error)
+{
+    if(error && self->poller->stats)
+        self->poller->stats->failures++;
+
+    self->error = error;
+    self->busy = 0;
+    self->poller->active--;
+    alink_down(&self->session.link);
+}
+
+static void on_done(struct msr_session * session, int error)
+{
+    finish(session->data, error);
+}
+
+static void start(struct poller_gateway * self)
+{
+    struct poller * poller = self->poller;
+    struct msr_session * session = &self->session;
+
+    self->error = msr_session_link(session, &poller->reactor, poller->timeout, &poller->rtt);
+    if(self->error != 0)
+        return;
+
+    session->retries = poller->retries;
+    session->stats = poller->stats;
+    self->busy = 1;
+    poller->active++;
+    msr_session_start(session);
+}
+
+int poller_init(struct poller * self, struct msr_table * table, const struct msr_group * groups, size_t size, uint16_t timeout)
+{
+    assert(self);
+    assert(table);
+    assert(groups);
+
+    memset(self, 0, sizeof(*self));
+
+    int result = reactor_init(&self->reactor);
+    if(result != 0)
+        return result;
+
+    self->gateways = calloc(size, sizeof(*self->gateways));
+    if(!self->gateways) {
+        reactor_close(&self->reactor);
+        return -ENOMEM;
+    }
+
+    size_t i;
+    for(i = 0; i < size; i++) {
+        struct poller_gateway * gw = &self->gateways[i];
+        msr_session_init(&gw->session, table, &groups[i], on_done, gw);
+        gw->poller = self;
+    }
+
+    self->table = table;
+    self->size = size;
+    self->timeout = timeout;
+    return 0;
+}
+
+void poller_close(struct poller * self)
+{
+    assert(self);
+    free(self->gateways);
+    self->gateways = NULL;
+    reactor_close(&self->reactor);
+}
+
+size_t poller_run(struct poller * self)
+{
+    assert(self);
+
+    size_t i;
+    for(i = 0; i < self->size; i++)
+        start(&self->gateways[i]);
+
+    while(self->active) {
+        if(reactor_poll(&self->reactor, -1) < 0)
+            break;
+    }
+
+    size_t done = 0;
+    for(i = 0; i < self->size; i++) {
+        if(self->gateways[i].busy)
+            finish(&self->gateways[i], -EINTR);
+        if(self->gateways[i].error == 0)
+            done++;
+    }
+    return done;
+}
+
+#ifdef __cplusplus
+}
+#endif
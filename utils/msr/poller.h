@@ -0,0 +1,60 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_MSR_POLLER_H
+#define UTILS_MSR_POLLER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "utils/base/stats.h"
+#include "utils/base/reactor.h"
+#include "utils/msr/msr.h"
+#include "utils/msr/session.h"
+
+struct poller;
+
+/* Состояние опроса одного шлюза */
+struct poller_gateway {
+    struct msr_session session;
+    struct poller * poller;
+    int busy;          /* опрос не завершен */
+    int error;         /* код последней ошибки */
+};
+
+/* Одновременный опрос нескольких шлюзов в одном цикле событий.
+ * Каждый шлюз опрашивается своим сеансом (msr_session), после опроса линк
+ * закрывается.
+ * Недоступные шлюзы не задерживают опрос остальных: время опроса
+ * определяется самым медленным шлюзом, а не суммой таймаутов. */
+struct poller {
+    struct reactor reactor;
+    struct msr_table * table;
+    struct poller_gateway * gateways;
+    size_t size;
+    size_t active;
+    uint16_t timeout;
+    struct rttcfg rtt; /* границы адаптивного таймаута. Нули - выключен */
+    size_t retries;    /* бюджет повторов на порцию. По умолчанию 0 */
+    struct stats * stats; /* статистика обмена. NULL - не собирается */
+};
+
+/* В случае успеха вернет 0. Иначе - код ошибки */
+int poller_init(struct poller * self, struct msr_table * table, const struct msr_group * groups, size_t size, uint16_t timeout);
+
+void poller_close(struct poller * self);
+
+/* Опросить все шлюзы один раз.
+ * Возвращает кол-во успешно опрошенных шлюзов */
+size_t poller_run(struct poller * self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,228 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "utils/msr/session.h"
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include "tekon/tekon.h"
+#include "utils/base/time.h"
+
+static void send_chunk(struct msr_session * self);
+
+static size_t chunk_count(const struct msr_group * group)
+{
+    return (group->count + TEKON_PROTO_PLIST_SIZE - 1) / TEKON_PROTO_PLIST_SIZE;
+}
+
+static size_t chunk_size(const struct msr_group * group, size_t chunk)
+{
+    const size_t pos = chunk * TEKON_PROTO_PLIST_SIZE;
+    const size_t diff = group->count - pos;
+    return diff > TEKON_PROTO_PLIST_SIZE ? TEKON_PROTO_PLIST_SIZE : diff;
+}
+
+static struct msr * chunk_msr(struct msr_session * self, size_t chunk)
+{
+    return msr_table_get(self->table, self->group->first + chunk * TEKON_PROTO_PLIST_SIZE);
+}
+
+/* Повторить порцию, не разрывая связь.
+ * 1 - порция отправлена повторно (или опрос завершен ошибкой отправки)
+ * 0 - бюджет повторов исчерпан */
+static int retry_chunk(struct msr_session * self)
+{
+    if(self->attempts >= self->retries)
+        return 0;
+
+    self->attempts++;
+    self->resent++;
+    if(self->stats)
+        self->stats->retries++;
+    send_chunk(self);
+    return 1;
+}
+
+static void on_reply(struct alink * link, int error, const void * data, size_t len)
+{
+    struct msr_session * self = link->data;
+    struct stats * stats = self->stats;
+
+    if(error) {
+        if(error == -ETIMEDOUT) {
+            self->timeouts++;
+            if(stats)
+                stats->timeouts++;
+            rtt_backoff(&link->link.rtt);
+            if(retry_chunk(self))
+                return;
+        }
+        self->done(self, error);
+        return;
+    }
+
+    self->rx_bytes += len;
+
+    /* Ответ на другой запрос (например, опоздавший) - ждать дальше */
+    uint8_t number = 0;
+    if(tekon_resp_number(data, len, &number) && number != self->number) {
+        link->link.stat.discarded++;
+        if(alink_resume(link) != 0)
+            self->done(self, -EIO);
+        return;
+    }
+
+    /* Для повторенной порции RTT не учитывается (алгоритм Карна) */
+    if(!self->attempts)
+        rtt_sample(&link->link.rtt, time_monotonic_ms() - link->sent);
+
+    /* Значения записываются в измерения прямо из посылки */
+    struct msr_sink sink = {chunk_msr(self, self->chunk), time_now_utc()};
+    const int64_t start = stats_now(stats);
+    const ssize_t unpacked = tekon_resp_unpack_sink(data, len, TEKON_MSG_READEM_PAR_LIST_1C, self->nelements,
+                             msr_sink_value, &sink, NULL);
+    stats_stage(stats, STATS_UNPACK, start);
+
+    /* Поврежденный или короткий ответ повторяется так же, как пропавший */
+    if(unpacked <= 0) {
+        self->invalid++;
+        if(!retry_chunk(self))
+            self->done(self, -EBADMSG);
+        return;
+    }
+
+    if(self->latency)
+        hist_add(self->latency, time_monotonic_us() - self->sent);
+    stats_stage(stats, STATS_TOTAL, self->sent);
+
+    self->chunk++;
+    self->attempts = 0;
+    if(self->chunk < chunk_count(self->group))
+        send_chunk(self);
+    else
+        self->done(self, 0);
+}
+
+static void send_chunk(struct msr_session * self)
+{
+    struct message_soa request;
+    const size_t size = chunk_size(self->group, self->chunk);
+
+    if(!msr_request_soa(&request, chunk_msr(self, self->chunk), size)) {
+        self->done(self, -EINVAL);
+        return;
+    }
+
+    self->number = (self->number + 1) % 16;
+    self->nelements = size;
+
+    /* Для гистограммы задержек время замеряется и без статистики */
+    struct stats * stats = self->stats;
+    const int64_t start = self->latency ? time_monotonic_us() : stats_now(stats);
+    ssize_t len = tekon_soa_req_pack(self->tx, sizeof(self->tx), &request, self->number);
+    stats_stage(stats, STATS_PACK, start);
+
+    /* Время порции учитывается с первой отправки */
+    if(!self->attempts) {
+        self->sent = start;
+        self->requests++;
+        if(stats)
+            stats->requests++;
+    }
+    int result = len > 0 ?
+                 alink_request(&self->link, self->tx, len, on_reply) :
+                 -EINVAL;
+
+    if(result != 0) {
+        self->done(self, result);
+        return;
+    }
+    self->tx_bytes += len;
+}
+
+static void on_up(struct alink * link, int error, const void * data, size_t len)
+{
+    struct msr_session * self = link->data;
+
+    if(error) {
+        self->done(self, error);
+        return;
+    }
+
+    send_chunk(self);
+}
+
+void msr_session_init(struct msr_session * self, struct msr_table * table, const struct msr_group * group,
+                      msr_session_fn done, void * data)
+{
+    assert(self);
+    assert(table);
+    assert(group);
+    assert(done);
+
+    memset(self, 0, sizeof(*self));
+    self->link.link.socket = TEKON_INVALID_SOCKET;
+    self->table = table;
+    self->group = group;
+    self->done = done;
+    self->data = data;
+}
+
+int msr_session_link(struct msr_session * self, struct reactor * reactor, uint16_t timeout, const struct rttcfg * rtt)
+{
+    assert(self);
+    assert(reactor);
+
+    const struct netaddr * addr = &self->group->addr;
+    struct alink * link = &self->link;
+
+    int result = addr->type == LINK_TCP ?
+                 alink_init_tcp(link, reactor, addr->ip, addr->port, timeout) :
+                 alink_init_udp(link, reactor, addr->ip, addr->port, timeout);
+    if(result != 0)
+        return result;
+
+    if(rtt && rtt->max)
+        rtt_init(&link->link.rtt, timeout, rtt->min, rtt->max);
+
+    link->data = self;
+    return 0;
+}
+
+void msr_session_start(struct msr_session * self)
+{
+    assert(self);
+
+    self->chunk = 0;
+    self->attempts = 0;
+
+    if(alink_state(&self->link) != ALINK_DOWN) {
+        send_chunk(self);
+        return;
+    }
+
+    int result = alink_up(&self->link, on_up);
+    if(result != 0)
+        self->done(self, result);
+}
+
+void msr_session_invalidate(struct msr_session * self, int64_t tstamp)
+{
+    assert(self);
+
+    const size_t nchunks = chunk_count(self->group);
+    size_t i;
+
+    for(i = self->chunk; i < nchunks; i++)
+        msr_response(chunk_msr(self, i), chunk_size(self->group, i), NULL, tstamp);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,84 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifndef UTILS_MSR_SESSION_H
+#define UTILS_MSR_SESSION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "utils/base/alink.h"
+#include "utils/base/hist.h"
+#include "utils/base/reactor.h"
+#include "utils/base/stats.h"
+#include "utils/base/types.h"
+#include "utils/msr/msr.h"
+
+struct msr_session;
+
+/* Опрос группы завершен. error - 0 в случае успеха, иначе код ошибки.
+ * Линк не закрывается: это решает владелец */
+typedef void (*msr_session_fn)(struct msr_session * self, int error);
+
+/* Опрос группы измерений одного шлюза порциями по TEKON_PROTO_PLIST_SIZE
+ * параметров (запросы 0x1C) через асинхронный линк:
+ * подключение (если линк закрыт) -> запрос порции -> ответ -> ... -> done.
+ *
+ * Ответ с чужим номером посылки (например, опоздавший) отбрасывается, ответ
+ * ожидается дальше. По истекшему таймауту и на поврежденный ответ порция
+ * повторяется до retries раз без разрыва связи. Значения пишутся в измерения
+ * прямо из посылки.
+ *
+ * Общая часть tekon_msr (poller) и tekon_collectd (collector): владелец
+ * отвечает только за расписание опросов и свои метрики. */
+struct msr_session {
+    struct alink link;
+    const struct msr_group * group;
+    struct msr_table * table;
+    msr_session_fn done;
+    void * data;           /* данные владельца */
+    size_t retries;        /* бюджет повторов на порцию. По умолчанию 0 */
+    struct stats * stats;  /* статистика обмена. NULL - не собирается */
+    struct hist * latency; /* время запроса от первой отправки до ответа, мкс.
+                            * NULL - не ведется */
+    size_t chunk;      /* текущая порция группы */
+    size_t attempts;   /* кол-во повторов текущей порции */
+    uint8_t number;    /* номер посылки текущего запроса */
+    uint8_t nelements; /* кол-во параметров в текущем запросе */
+    int64_t sent;      /* время первой отправки порции, мкс */
+    uint64_t requests; /* кол-во запросов (без повторов) */
+    uint64_t resent;   /* кол-во повторов */
+    uint64_t timeouts; /* кол-во истекших ожиданий ответа */
+    uint64_t invalid;  /* ответы, не прошедшие проверку длины/КС или разбор */
+    uint64_t tx_bytes;
+    uint64_t rx_bytes;
+    char tx[512];
+};
+
+void msr_session_init(struct msr_session * self, struct msr_table * table, const struct msr_group * group,
+                      msr_session_fn done, void * data);
+
+/* Подготовить линк к адресу группы (без подключения). Если rtt задан и
+ * rtt->max не 0, таймаут подбирается по RTT в этих границах.
+ * В случае успеха вернет 0. Иначе - код ошибки */
+int msr_session_link(struct msr_session * self, struct reactor * reactor, uint16_t timeout, const struct rttcfg * rtt);
+
+/* Опросить группу с первой порции. Закрытый линк предварительно
+ * подключается. Линк не должен быть занят (ALINK_CONNECTING, ALINK_WAIT).
+ * По завершении вызывается done, в том числе сразу при ошибке отправки */
+void msr_session_start(struct msr_session * self);
+
+/* Записать признак ошибки связи в измерения группы, еще не прочитанные в
+ * текущем опросе */
+void msr_session_invalidate(struct msr_session * self, int64_t tstamp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,44 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+/* Общая часть тестов опроса групп (unit_poller, unit_collector) */
+
+#ifndef UTILS_MSR_TEST_GROUP_H
+#define UTILS_MSR_TEST_GROUP_H
+
+#include <string.h>
+#include "test/sim/responder.h"
+#include "utils/msr/msr.h"
+
+#define TEST_GATEWAY 2
+#define TEST_PARAMS  50
+
+/* Кол-во запросов на опрос группы */
+#define TEST_CHUNKS ((TEST_PARAMS + TEKON_PROTO_PLIST_SIZE - 1) / TEKON_PROTO_PLIST_SIZE)
+
+/* Добавить в таблицу группу из TEST_PARAMS измерений шлюза responder.
+ * Шлюз возвращает для измерения индекс параметра, увеличенный на base.
+ * 1 - успешно
+ * 0 - ошибка */
+static int add_group(struct msr_table * table, struct msr_group * group, struct sim_responder * responder, uint32_t base)
+{
+    size_t i;
+    memset(group, 0, sizeof(*group));
+    strcpy(group->addr.ip, "127.0.0.1");
+    group->addr.port = responder->port;
+    group->addr.type = LINK_UDP;
+    group->addr.gateway = TEST_GATEWAY;
+    group->first = msr_table_size(table);
+
+    for(i = 0; i < TEST_PARAMS; i++) {
+        struct msr msr;
+        msr_init(&msr, TEST_GATEWAY, 3, 0x8000, i, TEKON_PARAM_U32, 0);
+        msr_table_add(table, &msr);
+        group->count++;
+    }
+    return sim_responder_fill(responder, 3, 0x8000, TEST_PARAMS, base);
+}
+
+#endif
@@ -9,6 +9,8 @@ extern "C" {
 
 #include "test/minunit.h"
 #include "utils/msr/msr.h"
+#include "tekon/pack.h"
+#include <string.h>
 
 MU_TEST(test_msr)
 {
@@ -97,10 +99,118 @@ MU_TEST(test_msr_table_foreach)
     mu_assert_int_eq(MEASURMENT_MAX_TABLE_SIZE, cnt);
 }
 
+MU_TEST(test_msr_request)
+{
+    struct msr msr[3];
+    struct message request;
+    size_t i;
+
+    for(i = 0; i < 3; i++)
+        msr_init(&msr[i], 2, 3, 0x8000 + i, i, TEKON_PARAM_F32, 0);
+
+    mu_assert_int_eq(1, msr_request(&request, msr, 3));
+    mu_assert_int_eq(TEKON_MSG_READEM_PAR_LIST_1C, request.type);
+    mu_assert_int_eq(2, request.gateway);
+    mu_assert_int_eq(3, request.nelements);
+    mu_assert_int_eq(0x8002, request.payload.parameters[2].address);
+    mu_assert_int_eq(2, request.payload.parameters[2].index);
+
+    mu_assert_int_eq(0, msr_request(&request, msr, 0));
+    mu_assert_int_eq(0, msr_request(&request, msr, TEKON_PROTO_PLIST_SIZE + 1));
+}
+
+MU_TEST(test_msr_request_soa)
+{
+    struct msr msr[2];
+    struct message request;
+    struct message_soa soa;
+    uint8_t expected[64];
+    uint8_t buffer[64];
+
+    msr_init(&msr[0], 2, 3, 0x8000, 0, TEKON_PARAM_U32, 0);
+    msr_init(&msr[1], 2, 4, 0xF017, 5, TEKON_PARAM_U32, 0);
+
+    mu_check(msr_request(&request, msr, 2));
+    mu_check(msr_request_soa(&soa, msr, 2));
+    mu_assert_int_eq(2, soa.nelements);
+    mu_assert_int_eq(4, soa.devices[1]);
+    mu_assert_int_eq(5, soa.indexes[1]);
+
+    const ssize_t len = tekon_req_pack(expected, sizeof(expected), &request, 1);
+    mu_assert_int_eq(len, tekon_soa_req_pack(buffer, sizeof(buffer), &soa, 1));
+    mu_check(memcmp(expected, buffer, len) == 0);
+
+    mu_assert_int_eq(0, msr_request_soa(&soa, msr, 0));
+    mu_assert_int_eq(0, msr_request_soa(&soa, msr, TEKON_PROTO_PLIST_SIZE + 1));
+}
+
+MU_TEST(test_msr_response)
+{
+    struct msr msr[2];
+    struct message response;
+    const uint32_t values[2] = {10, 20};
+    const uint8_t quals[2] = {0, 1};
+
+    msr_init(&msr[0], 2, 3, 0x8000, 0, TEKON_PARAM_U32, 0);
+    msr_init(&msr[1], 2, 3, 0x8001, 0, TEKON_PARAM_U32, 0);
+    tekon_resp_1c(&response, 2, values, quals, 2);
+
+    msr_response(msr, 2, &response, 123);
+    mu_assert_int_eq(Q_OK, msr[0].qual);
+    mu_assert_int_eq(10, msr[0].value.u32);
+    mu_assert_int_eq(Q_INVALID, msr[1].qual);
+    mu_assert_int_eq(20, msr[1].value.u32);
+    mu_assert_int_eq(123, msr[1].timestamp);
+
+    msr_response(msr, 2, NULL, 456);
+    mu_assert_int_eq(Q_NOCONN, msr[0].qual);
+    mu_assert_int_eq(10, msr[0].value.u32);
+    mu_assert_int_eq(456, msr[0].timestamp);
+}
+
+MU_TEST(test_msr_sink)
+{
+    struct msr msr[2];
+    struct msr_sink sink = {msr, 789};
+
+    msr_init(&msr[0], 2, 3, 0x8000, 0, TEKON_PARAM_U32, 0);
+    msr_init(&msr[1], 2, 3, 0x8001, 0, TEKON_PARAM_U32, 0);
+
+    msr_sink_value(&sink, 0, 30, 0);
+    msr_sink_value(&sink, 1, 40, 1);
+    mu_assert_int_eq(Q_OK, msr[0].qual);
+    mu_assert_int_eq(30, msr[0].value.u32);
+    mu_assert_int_eq(789, msr[0].timestamp);
+    mu_assert_int_eq(Q_INVALID, msr[1].qual);
+    mu_assert_int_eq(40, msr[1].value.u32);
+}
+
+MU_TEST(test_msr_to_string)
+{
+    struct msr msr;
+    char buffer[MEASURMENT_MAX_STRING];
+    const uint32_t value = 42;
+
+    msr_init(&msr, 2, 3, 0x8001, 1, TEKON_PARAM_U32, 1);
+    msr_update(&msr, Q_OK, 1000, &value, sizeof(value));
+    mu_assert_int_eq(29, msr_to_string(&msr, 180, buffer, sizeof(buffer)));
+    mu_assert_string_eq("2:3:0x8001:1 U 42 OK 1000 180", buffer);
+
+    msr_init(&msr, 2, 3, 100, 0, TEKON_PARAM_F32, 0);
+    msr_update(&msr, Q_NOCONN, 1000, NULL, 0);
+    msr_to_string(&msr, 0, buffer, sizeof(buffer));
+    mu_assert_string_eq("2:3:100:0 F 0.000000 COM 1000 0", buffer);
+}
+
 MU_TEST_SUITE(suite_msr)
 {
     MU_RUN_TEST(test_msr);
     MU_RUN_TEST(test_msr_update);
+    MU_RUN_TEST(test_msr_request);
+    MU_RUN_TEST(test_msr_request_soa);
+    MU_RUN_TEST(test_msr_response);
+    MU_RUN_TEST(test_msr_sink);
+    MU_RUN_TEST(test_msr_to_string);
 }
 
 MU_TEST_SUITE(suite_msr_table)
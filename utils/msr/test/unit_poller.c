@@ -0,0 +1,138 @@
+/* Copyright (c) 2019
+ * Alexander Shirokov
+ * Schneider Electric
+ * See LICENSE for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "test/minunit.h"
+#include "utils/msr/poller.h"
+#include "utils/msr/test/group.h"
+#include "tekon/tekon.h"
+#include <errno.h>
+#include <string.h>
+
+MU_TEST(test_poll_many)
+{
+    struct sim_responder responders[3];
+    struct msr_group groups[3];
+    struct msr_table table;
+    struct poller poller;
+    size_t i, j;
+
+    msr_table_init(&table);
+
+    /* Третий шлюз не отвечает */
+    for(i = 0; i < 3; i++) {
+        mu_check(sim_responder_init(&responders[i], TEST_GATEWAY, 1, i < 2 ? TEST_CHUNKS : 0));
+        mu_check(add_group(&table, &groups[i], &responders[i], i * 1000));
+        mu_check(sim_responder_start(&responders[i]));
+    }
+
+    mu_assert_int_eq(0, poller_init(&poller, &table, groups, 3, 100));
+    mu_assert_int_eq(2, poller_run(&poller));
+    mu_assert_int_eq(0, poller.gateways[0].error);
+    mu_assert_int_eq(0, poller.gateways[1].error);
+    mu_assert_int_eq(-ETIMEDOUT, poller.gateways[2].error);
+    poller_close(&poller);
+
+    for(i = 0; i < 3; i++)
+        sim_responder_close(&responders[i]);
+
+    for(i = 0; i < 2; i++) {
+        for(j = 0; j < TEST_PARAMS; j++) {
+            const struct msr * msr = msr_table_get(&table, groups[i].first + j);
+            mu_assert_int_eq(Q_OK, msr->qual);
+            mu_assert_int_eq(i * 1000 + j, msr->value.u32);
+        }
+    }
+
+    for(j = 0; j < TEST_PARAMS; j++)
+        mu_check(msr_table_get(&table, groups[2].first + j)->qual != Q_OK);
+}
+
+MU_TEST(test_poll_corrupt)
+{
+    struct sim_responder responder;
+    struct msr_group group;
+    struct msr_table table;
+    struct poller poller;
+    size_t i;
+
+    /* Первый ответ с неверной КС запрашивается повторно */
+    msr_table_init(&table);
+    mu_check(sim_responder_init(&responder, TEST_GATEWAY, 1, TEST_CHUNKS + 1));
+    mu_check(add_group(&table, &group, &responder, 0));
+    responder.corrupt = 1;
+    mu_check(sim_responder_start(&responder));
+
+    mu_assert_int_eq(0, poller_init(&poller, &table, &group, 1, 100));
+    poller.retries = 1;
+    mu_assert_int_eq(1, poller_run(&poller));
+    mu_assert_int_eq(0, poller.gateways[0].error);
+    mu_assert_int_eq(1, poller.gateways[0].session.invalid);
+    mu_assert_int_eq(1, poller.gateways[0].session.resent);
+    mu_assert_int_eq(0, poller.gateways[0].session.timeouts);
+    poller_close(&poller);
+    sim_responder_close(&responder);
+
+    for(i = 0; i < TEST_PARAMS; i++) {
+        const struct msr * msr = msr_table_get(&table, group.first + i);
+        mu_assert_int_eq(Q_OK, msr->qual);
+        mu_assert_int_eq(i, msr->value.u32);
+    }
+
+    /* Без повторов опрос завершается ошибкой */
+    msr_table_init(&table);
+    mu_check(sim_responder_init(&responder, TEST_GATEWAY, 1, TEST_CHUNKS));
+    mu_check(add_group(&table, &group, &responder, 0));
+    responder.corrupt = 1;
+    mu_check(sim_responder_start(&responder));
+
+    mu_assert_int_eq(0, poller_init(&poller, &table, &group, 1, 100));
+    mu_assert_int_eq(0, poller_run(&poller));
+    mu_assert_int_eq(-EBADMSG, poller.gateways[0].error);
+    mu_assert_int_eq(1, poller.gateways[0].session.invalid);
+    mu_assert_int_eq(0, poller.gateways[0].session.resent);
+    poller_close(&poller);
+    sim_responder_close(&responder);
+}
+
+MU_TEST(test_poll_refused)
+{
+    struct sim_responder silent;
+    struct msr_group group;
+    struct msr_table table;
+    struct poller poller;
+
+    msr_table_init(&table);
+    mu_check(sim_responder_init(&silent, TEST_GATEWAY, 1, 0));
+    mu_check(add_group(&table, &group, &silent, 0));
+    strcpy(group.addr.ip, "bbzzz");
+
+    mu_assert_int_eq(0, poller_init(&poller, &table, &group, 1, 100));
+    mu_assert_int_eq(0, poller_run(&poller));
+    mu_assert_int_eq(-EINVAL, poller.gateways[0].error);
+    poller_close(&poller);
+    sim_responder_close(&silent);
+}
+
+MU_TEST_SUITE(suite_poller)
+{
+    MU_RUN_TEST(test_poll_many);
+    MU_RUN_TEST(test_poll_corrupt);
+    MU_RUN_TEST(test_poll_refused);
+}
+
+int main()
+{
+    MU_RUN_SUITE(suite_poller);
+    MU_REPORT();
+    return mu_get_fails();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,6 +8,7 @@ extern "C" {
 #endif
 
 #include <assert.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -33,8 +34,12 @@ struct app {
     int64_t newtime; /* Устанавливаемое время (UTC) */
     int allow_diff;
     int timeout;
+    struct diag diag;
 };
 
+/* Статистика обмена. NULL - не собирается */
+static struct stats * stats = NULL;
+
 
 static void init(struct app * self)
 {
@@ -43,12 +48,14 @@ static void init(struct app * self)
     checks_init(&self->checks);
     self->timeout = 1000;
     self->newtime = time_now_utc();
+    diag_init(&self->diag, APP_NAME);
 }
 
 static void usage()
 {
     printf("Usage: %s -a address -d date/time -p password\n", APP_NAME);
-    printf("                  [-t timeout] [-u time] [-c checks] [-v verbosity]\n\n");
+    printf("                  [-t timeout] [-u time] [-c checks] [--stats] [-v verbosity]\n");
+    printf("                  [--capture file] [--replay file [--speed N]] [--fault spec] [--trace file]\n\n");
     printf("  -a    gateway's address in [type:ip:port@gateway] format.\n\n");
     printf("  -d    date/time addresses in [device:dateaddr:timeaddr] format.\n\n");
     printf("  -t    response timeout in milliseconds.\n\n");
@@ -62,6 +69,7 @@ static void usage()
     printf("        time not more than N seconds.\n\n");
     printf("        minutes:N - ensures that new time doesn't break interval\n");
     printf("        of N-minutes.\n\n");
+    diag_usage(stdout, 1);
     printf("  -v    set verbose:\n");
     printf("        0 - silent\n");
     printf("        1 - error [default]\n");
@@ -89,32 +97,67 @@ static int process_request(const struct message * request, struct message * resp
     static uint8_t nout = 0;
     nout = (nout + 1) % 16;
 
+    const int64_t begin = stats_now(stats);
     int result = tekon_req_pack(out, sizeof(out), request, nout);
+    stats_stage(stats, STATS_PACK, begin);
+
+    if(stats)
+        stats->requests++;
 
     if(result <= 0) {
         log_print(APP_ERR " : packing error\n");
-        return 0;
+        goto fail;
     }
 
+    int64_t start = stats_now(stats);
     result = link_send(link, out, result);
+    stats_stage(stats, STATS_SEND, start);
+
     if(result <= 0) {
         log_print(APP_ERR " : sending error %d\n", result);
-        return 0;
+        goto fail;
     }
 
-    result = link_recv(link, in, sizeof(in));
-    if(result <= 0) {
-        log_print(APP_ERR " : receiving error %d\n", result);
-        return 0;
+    /* Опоздавший ответ на предыдущий запрос (например, по которому истек
+     * таймаут) отбрасывается, ожидание продолжается до истечения таймаута */
+    const int64_t deadline = time_monotonic_ms() + link->timeout;
+    start = stats_now(stats);
+    for(;;) {
+        const int64_t left = deadline - time_monotonic_ms();
+        result = left > 0 ? link_wait(link, (int)left) : 0;
+        if(result == 0)
+            result = -ETIMEDOUT;
+
+        if(result > 0)
+            result = link_recv(link, in, sizeof(in));
+
+        if(result <= 0) {
+            log_print(APP_ERR " : receiving error %d\n", result);
+            if(stats && result == -ETIMEDOUT)
+                stats->timeouts++;
+            goto fail;
+        }
+
+        if(!tekon_resp_number(in, result, &nin) || nin == nout)
+            break;
+
+        link->stat.discarded++;
+        log_print(APP_WARN " : discarded reply #%u, expected #%u\n", (unsigned)nin, (unsigned)nout);
     }
 
+    stats_stage(stats, STATS_WAIT, start);
+
+    start = stats_now(stats);
     result = tekon_resp_unpack(in, result, response, request->type, &nin);
+    stats_stage(stats, STATS_UNPACK, start);
 
     if(result <= 0) {
         log_print(APP_ERR " : unpacking error\n");
-        return 0;
+        goto fail;
     }
 
+    stats_stage(stats, STATS_TOTAL, begin);
+
     if(response->type == TEKON_MSG_POS_ACK)
         return 1;
 
@@ -122,6 +165,11 @@ static int process_request(const struct message * request, struct message * resp
         return nin == nout;
 
     return  nin == nout && request->nelements == response->nelements;
+
+fail:
+    if(stats)
+        stats->failures++;
+    return 0;
 }
 
 /* Чтение времени из устройства
@@ -267,6 +315,7 @@ static int sync_time(struct app * app)
     else if(addr->type == LINK_UDP)
         link_init_udp(link, addr->ip, addr->port, app->timeout);
 
+    diag_attach(&app->diag, link);
     int result = link_up(link);
 
     if(result != 0) {
@@ -350,7 +399,7 @@ static int read_args(struct app * app, int argc, char * const argv[])
 
     int opt;
     int passread = 0;
-    while ((opt = getopt(argc, argv, "t:a:d:p:v:u:c:")) != -1) {
+    while ((opt = getopt_long(argc, argv, "t:a:d:p:v:u:c:", diag_options, NULL)) != -1) {
         switch (opt) {
         case 't': {
             long input  = atol(optarg);
@@ -401,9 +450,15 @@ static int read_args(struct app * app, int argc, char * const argv[])
         case 'v':
             log_setlevel(atoi(optarg));
             break;
-        default: /* '?' */
-            printf("invalid argument %c\n\n", opt);
-            return 0;
+        default: {
+            /* Опции диагностики обмена или '?' */
+            const int result = diag_option(&app->diag, opt, optarg);
+            if(result < 0)
+                printf("invalid argument %c\n\n", opt);
+            if(result <= 0)
+                return 0;
+        }
+        break;
         }
     }
 
@@ -443,7 +498,7 @@ static void sigint(int sig)
 
 int main(int argc, char * argv[])
 {
-    struct app app;
+    static struct app app;
 
     init(&app);
 
@@ -454,7 +509,18 @@ int main(int argc, char * argv[])
         return 1;
     }
 
+    stats = diag_stats(&app.diag);
+
+    if(diag_open(&app.diag) != 0)
+        return 1;
+
+    TEKON_TRACE_BEGIN(TEKON_TRACE_CYCLE);
     int result = sync_time(&app);
+    TEKON_TRACE_END(TEKON_TRACE_CYCLE, result);
+    diag_close(&app.diag);
+
+    diag_print(&app.diag, &app.link.stat, stderr);
+
     return result == 0;
 }
 